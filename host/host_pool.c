@@ -0,0 +1,196 @@
+#include "host_pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HOST_POOL_QUEUE_INITIAL 16
+
+typedef struct {
+    HostPoolTask task;
+    void* context;
+} HostPoolItem;
+
+/* Live items are [head, tail): the owner pops at the tail, thieves at the head */
+typedef struct {
+    pthread_mutex_t mutex;
+    HostPoolItem* items;
+    size_t head;
+    size_t tail;
+    size_t capacity;
+} HostPoolQueue;
+
+typedef struct {
+    HostPool* pool;
+    uint32_t index;
+} HostPoolWorker;
+
+struct HostPool {
+    uint32_t workers;
+    pthread_t* threads;
+    HostPoolWorker* contexts;
+    HostPoolQueue* queues;
+
+    /* Guards the counters; taken before a queue's mutex, never after */
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    size_t queued; /* in the queues */
+    size_t pending; /* queued or running */
+    uint32_t next;
+    bool stopping;
+};
+
+static _Thread_local HostPoolWorker* host_pool_self = NULL;
+
+// -------------------------------------------------------------------
+// Queue ends
+// -------------------------------------------------------------------
+static void host_pool_queue_push(HostPoolQueue* queue, HostPoolItem item) {
+    pthread_mutex_lock(&queue->mutex);
+    if(queue->tail == queue->capacity) {
+        if(queue->head > 0) {
+            memmove(
+                queue->items,
+                queue->items + queue->head,
+                (queue->tail - queue->head) * sizeof(HostPoolItem));
+            queue->tail -= queue->head;
+            queue->head = 0;
+        } else {
+            queue->capacity = queue->capacity ? queue->capacity * 2 : HOST_POOL_QUEUE_INITIAL;
+            queue->items = realloc(queue->items, queue->capacity * sizeof(HostPoolItem));
+        }
+    }
+    queue->items[queue->tail++] = item;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static bool host_pool_queue_take(HostPoolQueue* queue, bool newest, HostPoolItem* out) {
+    pthread_mutex_lock(&queue->mutex);
+    bool found = queue->head < queue->tail;
+    if(found) *out = newest ? queue->items[--queue->tail] : queue->items[queue->head++];
+    if(queue->head == queue->tail) queue->head = queue->tail = 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return found;
+}
+
+// -------------------------------------------------------------------
+// Own queue first, then steal, starting from the next worker along
+// -------------------------------------------------------------------
+static bool host_pool_take(HostPool* pool, uint32_t index, HostPoolItem* out) {
+    bool found = host_pool_queue_take(&pool->queues[index], true, out);
+    for(uint32_t i = 1; !found && i < pool->workers; i++) {
+        found = host_pool_queue_take(&pool->queues[(index + i) % pool->workers], false, out);
+    }
+
+    if(found) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->queued--;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return found;
+}
+
+static void* host_pool_worker(void* context) {
+    HostPoolWorker* worker = context;
+    HostPool* pool = worker->pool;
+    host_pool_self = worker;
+
+    while(true) {
+        HostPoolItem item;
+        if(!host_pool_take(pool, worker->index, &item)) {
+            pthread_mutex_lock(&pool->mutex);
+            while(pool->queued == 0 && !pool->stopping) {
+                pthread_cond_wait(&pool->work, &pool->mutex);
+            }
+            bool done = pool->queued == 0;
+            pthread_mutex_unlock(&pool->mutex);
+            if(done) break;
+            continue;
+        }
+
+        item.task(item.context);
+
+        pthread_mutex_lock(&pool->mutex);
+        if(--pool->pending == 0) pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return NULL;
+}
+
+// ===================================================================
+// API
+// ===================================================================
+HostPool* host_pool_alloc(uint32_t workers) {
+    if(workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (uint32_t)online : 1;
+    }
+
+    HostPool* pool = calloc(1, sizeof(HostPool));
+    pool->workers = workers;
+    pool->threads = calloc(workers, sizeof(pthread_t));
+    pool->contexts = calloc(workers, sizeof(HostPoolWorker));
+    pool->queues = calloc(workers, sizeof(HostPoolQueue));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for(uint32_t i = 0; i < workers; i++) {
+        pthread_mutex_init(&pool->queues[i].mutex, NULL);
+    }
+    for(uint32_t i = 0; i < workers; i++) {
+        pool->contexts[i] = (HostPoolWorker){.pool = pool, .index = i};
+        pthread_create(&pool->threads[i], NULL, host_pool_worker, &pool->contexts[i]);
+    }
+    return pool;
+}
+
+uint32_t host_pool_get_workers(HostPool* pool) {
+    return pool->workers;
+}
+
+void host_pool_submit(HostPool* pool, HostPoolTask task, void* context) {
+    pthread_mutex_lock(&pool->mutex);
+    uint32_t index = host_pool_self && host_pool_self->pool == pool ?
+                         host_pool_self->index :
+                         pool->next++ % pool->workers;
+    host_pool_queue_push(&pool->queues[index], (HostPoolItem){task, context});
+    pool->queued++;
+    pool->pending++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void host_pool_wait(HostPool* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    while(pool->pending > 0) {
+        pthread_cond_wait(&pool->idle, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void host_pool_free(HostPool* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+
+    /* All of them first: a worker still running may steal from any queue */
+    for(uint32_t i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for(uint32_t i = 0; i < pool->workers; i++) {
+        pthread_mutex_destroy(&pool->queues[i].mutex);
+        free(pool->queues[i].items);
+    }
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->queues);
+    free(pool->contexts);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Work-stealing thread pool for the host tool. Each worker owns a queue:
+ * it takes its own newest task first, and once that is empty steals the
+ * oldest task of another worker, so long and short jobs even out across
+ * cores without a shared queue everyone contends on. Tasks submitted
+ * from a worker go on that worker's queue; others are dealt round-robin. */
+
+typedef struct HostPool HostPool;
+
+typedef void (*HostPoolTask)(void* context);
+
+/* workers == 0: one per online CPU */
+HostPool* host_pool_alloc(uint32_t workers);
+uint32_t host_pool_get_workers(HostPool* pool);
+void host_pool_submit(HostPool* pool, HostPoolTask task, void* context);
+/* Until every submitted task, and any they submitted, has run */
+void host_pool_wait(HostPool* pool);
+/* Waits for queued tasks, then joins the workers */
+void host_pool_free(HostPool* pool);
@@ -0,0 +1,154 @@
+#include <toolbox/compress.h>
+
+/* Heatshrink decoder, bit-compatible with the firmware's: a tag bit,
+ * then either a literal byte (1) or a back-reference (0) of window_sz2
+ * bits of offset and lookahead_sz2 bits of length, both stored minus
+ * one. Input is whole buffers here, so no streaming state machine. */
+
+#define COMPRESS_HEADER_SIZE 4 /* is_compressed, reserved, u16 size */
+
+const CompressConfigHeatshrink compress_config_heatshrink_default = {
+    .window_sz2 = 8,
+    .lookahead_sz2 = 4,
+    .input_buffer_sz = 128,
+};
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t bit;
+} BitReader;
+
+static bool bit_reader_get(BitReader* reader, uint8_t count, uint16_t* out) {
+    if(reader->bit + count > reader->size * 8) return false;
+    uint16_t value = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t byte = reader->data[reader->bit / 8];
+        value = (value << 1) | ((byte >> (7 - reader->bit % 8)) & 1);
+        reader->bit++;
+    }
+    *out = value;
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Decode in to out. Trailing bits too short for a whole token are the
+// encoder's padding. False on a reference before the start of the
+// output or on overflow
+// -------------------------------------------------------------------
+static bool heatshrink_decode(
+    const CompressConfigHeatshrink* config,
+    const uint8_t* in,
+    size_t in_size,
+    uint8_t* out,
+    size_t out_size,
+    size_t* out_len) {
+    BitReader reader = {.data = in, .size = in_size, .bit = 0};
+    size_t len = 0;
+    uint16_t tag;
+
+    while(bit_reader_get(&reader, 1, &tag)) {
+        uint16_t value;
+        if(tag) {
+            if(!bit_reader_get(&reader, 8, &value)) break;
+            if(len == out_size) return false;
+            out[len++] = (uint8_t)value;
+            continue;
+        }
+
+        uint16_t count;
+        if(!bit_reader_get(&reader, config->window_sz2, &value)) break;
+        if(!bit_reader_get(&reader, config->lookahead_sz2, &count)) break;
+        size_t offset = (size_t)value + 1;
+        count++;
+        if(offset > len || len + count > out_size) return false;
+        for(uint16_t i = 0; i < count; i++, len++) {
+            out[len] = out[len - offset];
+        }
+    }
+
+    *out_len = len;
+    return true;
+}
+
+// ===================================================================
+// Icons
+// ===================================================================
+struct CompressIcon {
+    uint8_t* buffer;
+    size_t size;
+};
+
+CompressIcon* compress_icon_alloc(size_t decode_buf_size) {
+    CompressIcon* instance = malloc(sizeof(CompressIcon));
+    instance->buffer = malloc(decode_buf_size);
+    instance->size = decode_buf_size;
+    return instance;
+}
+
+void compress_icon_free(CompressIcon* instance) {
+    free(instance->buffer);
+    free(instance);
+}
+
+// -------------------------------------------------------------------
+// Raw icons point past their header; compressed ones decode into the
+// instance buffer. NULL if the data doesn't decode (the firmware
+// crashes there instead)
+// -------------------------------------------------------------------
+void compress_icon_decode(CompressIcon* instance, const uint8_t* icon_data, uint8_t** output) {
+    if(icon_data[0] != 0x01) {
+        *output = (uint8_t*)&icon_data[1];
+        return;
+    }
+
+    uint16_t size = icon_data[2] | (icon_data[3] << 8);
+    size_t decoded = 0;
+    bool ok = heatshrink_decode(
+        &compress_config_heatshrink_default,
+        &icon_data[COMPRESS_HEADER_SIZE],
+        size,
+        instance->buffer,
+        instance->size,
+        &decoded);
+    *output = ok ? instance->buffer : NULL;
+}
+
+// ===================================================================
+// Buffers
+// ===================================================================
+struct Compress {
+    CompressConfigHeatshrink config;
+};
+
+Compress* compress_alloc(CompressType type, const void* config) {
+    furi_check(type == CompressTypeHeatshrink);
+    Compress* compress = malloc(sizeof(Compress));
+    compress->config = *(const CompressConfigHeatshrink*)config;
+    return compress;
+}
+
+void compress_free(Compress* compress) {
+    free(compress);
+}
+
+bool compress_decode(
+    Compress* compress,
+    uint8_t* data_in,
+    size_t data_in_size,
+    uint8_t* data_out,
+    size_t data_out_size,
+    size_t* data_res_size) {
+    if(data_in_size < COMPRESS_HEADER_SIZE || data_in[0] != 0x01) return false;
+
+    size_t size = data_in[2] | (data_in[3] << 8);
+    if(size > data_in_size - COMPRESS_HEADER_SIZE) return false;
+
+    return heatshrink_decode(
+        &compress->config,
+        &data_in[COMPRESS_HEADER_SIZE],
+        size,
+        data_out,
+        data_out_size,
+        data_res_size);
+}
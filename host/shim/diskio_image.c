@@ -0,0 +1,135 @@
+#include "diskio_image.h"
+
+#include "ff.h"
+#include "diskio.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define IMAGE_SECTOR_SIZE 512
+
+typedef struct {
+    bool opened;
+    int fd;
+    bool read_only;
+    LBA_t sectors;
+} DiskImage;
+
+/* Only touched by the thread owning the drive's volume */
+static DiskImage images[FF_VOLUMES];
+
+bool disk_image_open(BYTE pdrv, const char* path) {
+    DiskImage* image = &images[pdrv];
+    image->read_only = false;
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if(fd < 0 && (errno == EACCES || errno == EROFS)) {
+        image->read_only = true;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < IMAGE_SECTOR_SIZE) {
+        close(fd);
+        return false;
+    }
+    image->opened = true;
+    image->fd = fd;
+    image->sectors = (LBA_t)(st.st_size / IMAGE_SECTOR_SIZE);
+    return true;
+}
+
+void disk_image_close(BYTE pdrv) {
+    DiskImage* image = &images[pdrv];
+    if(!image->opened) return;
+    if(!image->read_only) fsync(image->fd);
+    close(image->fd);
+    image->opened = false;
+}
+
+// ===================================================================
+// FatFs disk interface
+// ===================================================================
+DSTATUS disk_status(BYTE pdrv) {
+    if(pdrv >= FF_VOLUMES || !images[pdrv].opened) return STA_NOINIT;
+    return images[pdrv].read_only ? STA_PROTECT : 0;
+}
+
+DSTATUS disk_initialize(BYTE pdrv) {
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE* buff, LBA_t sector, UINT count) {
+    if(disk_status(pdrv) & STA_NOINIT) return RES_NOTRDY;
+    DiskImage* image = &images[pdrv];
+    if(sector + count > image->sectors) return RES_PARERR;
+
+    size_t size = (size_t)count * IMAGE_SECTOR_SIZE;
+    off_t offset = (off_t)sector * IMAGE_SECTOR_SIZE;
+    for(size_t done = 0; done < size;) {
+        ssize_t got = pread(image->fd, buff + done, size - done, offset + done);
+        if(got < 0 && errno == EINTR) continue;
+        if(got <= 0) return RES_ERROR;
+        done += (size_t)got;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count) {
+    DSTATUS status = disk_status(pdrv);
+    if(status & STA_NOINIT) return RES_NOTRDY;
+    if(status & STA_PROTECT) return RES_WRPRT;
+    DiskImage* image = &images[pdrv];
+    if(sector + count > image->sectors) return RES_PARERR;
+
+    size_t size = (size_t)count * IMAGE_SECTOR_SIZE;
+    off_t offset = (off_t)sector * IMAGE_SECTOR_SIZE;
+    for(size_t done = 0; done < size;) {
+        ssize_t put = pwrite(image->fd, buff + done, size - done, offset + done);
+        if(put < 0 && errno == EINTR) continue;
+        if(put <= 0) return RES_ERROR;
+        done += (size_t)put;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void* buff) {
+    if(disk_status(pdrv) & STA_NOINIT) return RES_NOTRDY;
+    DiskImage* image = &images[pdrv];
+
+    switch(cmd) {
+    case CTRL_SYNC:
+        return image->read_only || fdatasync(image->fd) == 0 ? RES_OK : RES_ERROR;
+    case GET_SECTOR_COUNT:
+        *(LBA_t*)buff = image->sectors;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD*)buff = IMAGE_SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD*)buff = 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+// -------------------------------------------------------------------
+// File times: now, or SOURCE_DATE_EPOCH when set, so a scripted image
+// build can be made reproducible
+// -------------------------------------------------------------------
+DWORD get_fattime(void) {
+    const char* epoch = getenv("SOURCE_DATE_EPOCH");
+    time_t now = epoch ? (time_t)strtoll(epoch, NULL, 10) : time(NULL);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    if(tm.tm_year < 80) return (DWORD)(1 << 21) | (1 << 16); /* 1980-01-01 */
+
+    return (DWORD)(tm.tm_year - 80) << 25 | (DWORD)(tm.tm_mon + 1) << 21 |
+           (DWORD)tm.tm_mday << 16 | (DWORD)tm.tm_hour << 11 | (DWORD)tm.tm_min << 5 |
+           (DWORD)(tm.tm_sec / 2);
+}
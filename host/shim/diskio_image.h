@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdbool.h>
+
+/* FatFs disk layer over image files: each drive is one whole file, in
+ * 512-byte sectors. Opened read-write if allowed, else write-protected */
+
+bool disk_image_open(unsigned char pdrv, const char* path);
+void disk_image_close(unsigned char pdrv);
@@ -0,0 +1,53 @@
+/* FatFs R0.15 configuration for the host image build (see Makefile):
+ * read/write, long names in UTF-8, FAT12/16/32 and exFAT, 512-byte
+ * sectors, one volume per open image. No reentrancy: calls on different
+ * volumes are safe anyway, storage_fatfs.c serializes those on one */
+
+#define FFCONF_DEF 80286 /* Revision ID */
+
+/* Function configurations */
+#define FF_FS_READONLY  0
+#define FF_FS_MINIMIZE  0
+#define FF_USE_FIND     0
+#define FF_USE_MKFS     0
+#define FF_USE_FASTSEEK 0
+#define FF_USE_EXPAND   1
+#define FF_USE_CHMOD    0
+#define FF_USE_LABEL    1
+#define FF_USE_FORWARD  0
+#define FF_USE_STRFUNC  0
+#define FF_PRINT_LLI    0
+#define FF_PRINT_FLOAT  0
+#define FF_STRF_ENCODE  0
+
+/* Locale and namespace configurations */
+#define FF_CODE_PAGE   437
+#define FF_USE_LFN     2 /* LFN working buffer on the stack */
+#define FF_MAX_LFN     255
+#define FF_LFN_UNICODE 2 /* UTF-8 */
+#define FF_LFN_BUF     255
+#define FF_SFN_BUF     12
+#define FF_FS_RPATH    0
+
+/* Drive/volume configurations */
+#define FF_VOLUMES         10
+#define FF_STR_VOLUME_ID   0
+#define FF_VOLUME_STRS     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9"
+#define FF_MULTI_PARTITION 0 /* first FAT volume: whole-card images have an MBR */
+#define FF_MIN_SS          512
+#define FF_MAX_SS          512
+#define FF_LBA64           0
+#define FF_MIN_GPT         0x10000000
+#define FF_USE_TRIM        0
+
+/* System configurations */
+#define FF_FS_TINY      0
+#define FF_FS_EXFAT     1
+#define FF_FS_NORTC     0 /* get_fattime in diskio_image.c */
+#define FF_NORTC_MON    1
+#define FF_NORTC_MDAY   1
+#define FF_NORTC_YEAR   2024
+#define FF_FS_NOFSINFO  0
+#define FF_FS_LOCK      0
+#define FF_FS_REENTRANT 0
+#define FF_FS_TIMEOUT   1000
@@ -0,0 +1,138 @@
+#pragma once
+
+/* The part of the furi API the theme core uses, on top of libc. Only
+ * what host builds need: strings, logging, ticks, heap figures, and
+ * threads with message queues for the frame prefetcher. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <assert.h>
+
+#define UNUSED(x)   (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#define CLAMP(x, upper, lower) (MIN(upper, MAX(x, lower)))
+#define FURI_PACKED            __attribute__((packed))
+
+#define furi_assert(x) assert(x)
+#define furi_check(x)  assert(x)
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+/* On the device long is 32 bits and uint32_t is unsigned long, so the
+ * sources print and scan uint32_t with %lu. Formatting here goes
+ * through wrappers that read a single l length modifier as none, which
+ * is what it amounts to there. Include system headers before this one */
+int furi_posix_printf(const char* format, ...);
+int furi_posix_snprintf(char* out, size_t out_size, const char* format, ...);
+int furi_posix_sscanf(const char* str, const char* format, ...);
+#define printf   furi_posix_printf
+#define snprintf furi_posix_snprintf
+#define sscanf   furi_posix_sscanf
+
+/* Logging: to stderr, up to the level set with furi_log_set_level */
+typedef enum {
+    FuriLogLevelNone = 0,
+    FuriLogLevelError = 1,
+    FuriLogLevelWarn = 2,
+    FuriLogLevelInfo = 3,
+    FuriLogLevelDebug = 4,
+    FuriLogLevelTrace = 5,
+} FuriLogLevel;
+
+void furi_log_set_level(FuriLogLevel level);
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...);
+
+#define FURI_LOG_E(tag, format, ...) \
+    furi_log_print_format(FuriLogLevelError, tag, format, ##__VA_ARGS__)
+#define FURI_LOG_W(tag, format, ...) \
+    furi_log_print_format(FuriLogLevelWarn, tag, format, ##__VA_ARGS__)
+#define FURI_LOG_I(tag, format, ...) \
+    furi_log_print_format(FuriLogLevelInfo, tag, format, ##__VA_ARGS__)
+#define FURI_LOG_D(tag, format, ...) \
+    furi_log_print_format(FuriLogLevelDebug, tag, format, ##__VA_ARGS__)
+#define FURI_LOG_T(tag, format, ...) \
+    furi_log_print_format(FuriLogLevelTrace, tag, format, ##__VA_ARGS__)
+
+/* Strings */
+#define FURI_STRING_FAILURE ((size_t)-1)
+
+typedef struct FuriString FuriString;
+
+FuriString* furi_string_alloc(void);
+FuriString* furi_string_alloc_set(const FuriString* source);
+FuriString* furi_string_alloc_set_str(const char* cstr);
+FuriString* furi_string_alloc_printf(const char* format, ...);
+void furi_string_free(FuriString* string);
+
+void furi_string_reset(FuriString* string);
+void furi_string_set(FuriString* string, const FuriString* source);
+void furi_string_set_str(FuriString* string, const char* cstr);
+int furi_string_printf(FuriString* string, const char* format, ...);
+int furi_string_cat_printf(FuriString* string, const char* format, ...);
+void furi_string_cat(FuriString* string, const FuriString* tail);
+void furi_string_cat_str(FuriString* string, const char* tail);
+
+const char* furi_string_get_cstr(const FuriString* string);
+size_t furi_string_size(const FuriString* string);
+bool furi_string_empty(const FuriString* string);
+char furi_string_get_char(const FuriString* string, size_t index);
+int furi_string_cmp_str(const FuriString* string, const char* cstr);
+
+size_t furi_string_search_char(const FuriString* string, char c, size_t start);
+size_t furi_string_search_rchar(const FuriString* string, char c, size_t start);
+size_t furi_string_search_str(const FuriString* string, const char* needle, size_t start);
+
+void furi_string_left(FuriString* string, size_t index);
+void furi_string_right(FuriString* string, size_t index);
+void furi_string_replace_at(FuriString* string, size_t pos, size_t len, const char* replace);
+void furi_string_replace_all_str(FuriString* string, const char* find, const char* replace);
+void furi_string_trim(FuriString* string, const char* chars);
+
+/* Records: a name -> pointer table, filled by the host program */
+void furi_record_create(const char* name, void* data);
+bool furi_record_destroy(const char* name);
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
+
+/* Time and heap */
+uint32_t furi_get_tick(void); /* milliseconds */
+void furi_delay_ms(uint32_t ms);
+size_t memmgr_heap_get_max_free_block(void);
+
+/* Threads and message queues on pthreads. Timeouts are in milliseconds,
+ * a tick here */
+typedef enum {
+    FuriStatusOk = 0,
+    FuriStatusErrorTimeout = -2,
+} FuriStatus;
+
+typedef int32_t (*FuriThreadCallback)(void* context);
+typedef struct FuriThread FuriThread;
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context);
+void furi_thread_free(FuriThread* thread);
+void furi_thread_start(FuriThread* thread);
+bool furi_thread_join(FuriThread* thread);
+
+typedef struct FuriMessageQueue FuriMessageQueue;
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size);
+void furi_message_queue_free(FuriMessageQueue* queue);
+FuriStatus furi_message_queue_put(FuriMessageQueue* queue, const void* msg_ptr, uint32_t timeout);
+FuriStatus furi_message_queue_get(FuriMessageQueue* queue, void* msg_ptr, uint32_t timeout);
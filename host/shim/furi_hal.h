@@ -0,0 +1,17 @@
+#pragma once
+
+/* The DWT cycle counter the copy probe times with. The host counts
+ * microseconds and calls each one an instruction, so elapsed cycles
+ * divided by instructions per microsecond come out the same */
+
+#include <furi.h>
+
+typedef struct {
+    uint32_t CYCCNT;
+} DWT_Type;
+
+uint32_t furi_hal_host_cycles(void);
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+
+/* Every read of DWT->CYCCNT samples the clock */
+#define DWT (&(DWT_Type){.CYCCNT = furi_hal_host_cycles()})
@@ -0,0 +1,508 @@
+#include <furi.h>
+#include <furi_hal.h>
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/* furi on libc: a FuriString is a growable, NUL-terminated buffer */
+
+#undef printf
+#undef snprintf
+#undef sscanf
+
+struct FuriString {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+static FuriLogLevel log_level = FuriLogLevelNone;
+
+// -------------------------------------------------------------------
+// Device format to host format: %lu, %08lX, %ld... lose their l, %llu
+// and everything else stay. Returns a buffer owned by the thread
+// -------------------------------------------------------------------
+static const char* furi_posix_format(const char* format) {
+    static _Thread_local char buffer[1024];
+    size_t out = 0;
+    const char* c = format;
+
+    while(*c && out < sizeof(buffer) - 1) {
+        buffer[out++] = *c;
+        if(*c++ != '%') continue;
+        if(*c == '%') {
+            buffer[out++] = *c++;
+            continue;
+        }
+
+        /* Flags, width, precision, then the length modifier */
+        while(*c && strchr("-+ #0123456789.*", *c) && out < sizeof(buffer) - 1) {
+            buffer[out++] = *c++;
+        }
+        if(c[0] == 'l' && c[1] && strchr("diouxX", c[1])) c++;
+    }
+    buffer[out] = '\0';
+    return buffer;
+}
+
+int furi_posix_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = vprintf(furi_posix_format(format), args);
+    va_end(args);
+    return result;
+}
+
+int furi_posix_snprintf(char* out, size_t out_size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf(out, out_size, furi_posix_format(format), args);
+    va_end(args);
+    return result;
+}
+
+int furi_posix_sscanf(const char* str, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = vsscanf(str, furi_posix_format(format), args);
+    va_end(args);
+    return result;
+}
+
+void furi_log_set_level(FuriLogLevel level) {
+    log_level = level;
+}
+
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...) {
+    static const char* const letters = "-EWIDT";
+    if(level > log_level) return;
+
+    /* One line at a time when batch jobs log from several threads */
+    flockfile(stderr);
+    fprintf(stderr, "[%c][%s] ", letters[level], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, furi_posix_format(format), args);
+    va_end(args);
+    fputc('\n', stderr);
+    funlockfile(stderr);
+}
+
+// -------------------------------------------------------------------
+// FuriString
+// -------------------------------------------------------------------
+static void furi_string_reserve(FuriString* string, size_t size) {
+    if(size + 1 <= string->capacity) return;
+    size_t capacity = string->capacity ? string->capacity : 16;
+    while(capacity < size + 1)
+        capacity *= 2;
+    string->data = realloc(string->data, capacity);
+    furi_check(string->data);
+    string->capacity = capacity;
+}
+
+static void
+    furi_string_vprintf_at(FuriString* string, size_t at, const char* format, va_list args) {
+    format = furi_posix_format(format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    furi_check(len >= 0);
+
+    furi_string_reserve(string, at + (size_t)len);
+    vsnprintf(string->data + at, (size_t)len + 1, format, args);
+    string->size = at + (size_t)len;
+}
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = calloc(1, sizeof(FuriString));
+    furi_string_reserve(string, 0);
+    string->data[0] = '\0';
+    return string;
+}
+
+FuriString* furi_string_alloc_set(const FuriString* source) {
+    return furi_string_alloc_set_str(source->data);
+}
+
+FuriString* furi_string_alloc_set_str(const char* cstr) {
+    FuriString* string = furi_string_alloc();
+    furi_string_set_str(string, cstr);
+    return string;
+}
+
+FuriString* furi_string_alloc_printf(const char* format, ...) {
+    FuriString* string = furi_string_alloc();
+    va_list args;
+    va_start(args, format);
+    furi_string_vprintf_at(string, 0, format, args);
+    va_end(args);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+void furi_string_reset(FuriString* string) {
+    string->size = 0;
+    string->data[0] = '\0';
+}
+
+void furi_string_set(FuriString* string, const FuriString* source) {
+    if(string != source) furi_string_set_str(string, source->data);
+}
+
+void furi_string_set_str(FuriString* string, const char* cstr) {
+    size_t len = strlen(cstr);
+    furi_string_reserve(string, len);
+    memmove(string->data, cstr, len + 1);
+    string->size = len;
+}
+
+int furi_string_printf(FuriString* string, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    furi_string_vprintf_at(string, 0, format, args);
+    va_end(args);
+    return (int)string->size;
+}
+
+int furi_string_cat_printf(FuriString* string, const char* format, ...) {
+    size_t at = string->size;
+    va_list args;
+    va_start(args, format);
+    furi_string_vprintf_at(string, at, format, args);
+    va_end(args);
+    return (int)(string->size - at);
+}
+
+void furi_string_cat(FuriString* string, const FuriString* tail) {
+    furi_string_cat_str(string, tail->data);
+}
+
+void furi_string_cat_str(FuriString* string, const char* tail) {
+    size_t len = strlen(tail);
+    furi_string_reserve(string, string->size + len);
+    memmove(string->data + string->size, tail, len + 1);
+    string->size += len;
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->size;
+}
+
+bool furi_string_empty(const FuriString* string) {
+    return string->size == 0;
+}
+
+char furi_string_get_char(const FuriString* string, size_t index) {
+    furi_check(index < string->size);
+    return string->data[index];
+}
+
+int furi_string_cmp_str(const FuriString* string, const char* cstr) {
+    return strcmp(string->data, cstr);
+}
+
+size_t furi_string_search_char(const FuriString* string, char c, size_t start) {
+    if(start >= string->size) return FURI_STRING_FAILURE;
+    const char* found = memchr(string->data + start, c, string->size - start);
+    return found ? (size_t)(found - string->data) : FURI_STRING_FAILURE;
+}
+
+size_t furi_string_search_rchar(const FuriString* string, char c, size_t start) {
+    for(size_t i = string->size; i > start; i--) {
+        if(string->data[i - 1] == c) return i - 1;
+    }
+    return FURI_STRING_FAILURE;
+}
+
+size_t furi_string_search_str(const FuriString* string, const char* needle, size_t start) {
+    if(start > string->size) return FURI_STRING_FAILURE;
+    const char* found = strstr(string->data + start, needle);
+    return found ? (size_t)(found - string->data) : FURI_STRING_FAILURE;
+}
+
+void furi_string_left(FuriString* string, size_t index) {
+    if(index < string->size) {
+        string->size = index;
+        string->data[index] = '\0';
+    }
+}
+
+void furi_string_right(FuriString* string, size_t index) {
+    if(index >= string->size) {
+        furi_string_reset(string);
+        return;
+    }
+    memmove(string->data, string->data + index, string->size - index + 1);
+    string->size -= index;
+}
+
+void furi_string_replace_at(FuriString* string, size_t pos, size_t len, const char* replace) {
+    furi_check(pos + len <= string->size);
+    size_t replace_len = strlen(replace);
+    size_t tail = string->size - pos - len;
+
+    furi_string_reserve(string, string->size - len + replace_len);
+    memmove(string->data + pos + replace_len, string->data + pos + len, tail + 1);
+    memcpy(string->data + pos, replace, replace_len);
+    string->size = string->size - len + replace_len;
+}
+
+void furi_string_replace_all_str(FuriString* string, const char* find, const char* replace) {
+    size_t find_len = strlen(find);
+    size_t replace_len = strlen(replace);
+    size_t pos = 0;
+    if(!find_len) return;
+
+    while((pos = furi_string_search_str(string, find, pos)) != FURI_STRING_FAILURE) {
+        furi_string_replace_at(string, pos, find_len, replace);
+        pos += replace_len;
+    }
+}
+
+void furi_string_trim(FuriString* string, const char* chars) {
+    size_t end = string->size;
+    while(end && strchr(chars, string->data[end - 1]))
+        end--;
+    furi_string_left(string, end);
+
+    size_t start = 0;
+    while(start < string->size && strchr(chars, string->data[start]))
+        start++;
+    furi_string_right(string, start);
+}
+
+// -------------------------------------------------------------------
+// Records, time, heap
+// -------------------------------------------------------------------
+#define FURI_RECORDS_MAX 8
+
+static struct {
+    const char* name;
+    void* data;
+} furi_records[FURI_RECORDS_MAX];
+static pthread_mutex_t furi_records_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void furi_record_create(const char* name, void* data) {
+    pthread_mutex_lock(&furi_records_mutex);
+    size_t i = 0;
+    while(i < FURI_RECORDS_MAX && furi_records[i].name)
+        i++;
+    furi_check(i < FURI_RECORDS_MAX);
+    furi_records[i].name = name;
+    furi_records[i].data = data;
+    pthread_mutex_unlock(&furi_records_mutex);
+}
+
+bool furi_record_destroy(const char* name) {
+    bool found = false;
+    pthread_mutex_lock(&furi_records_mutex);
+    for(size_t i = 0; i < FURI_RECORDS_MAX && !found; i++) {
+        if(furi_records[i].name && strcmp(furi_records[i].name, name) == 0) {
+            furi_records[i].name = NULL;
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&furi_records_mutex);
+    return found;
+}
+
+// -------------------------------------------------------------------
+// No waiting for a record to appear, as the firmware does: on the host
+// they all exist before the core runs
+// -------------------------------------------------------------------
+void* furi_record_open(const char* name) {
+    void* data = NULL;
+    pthread_mutex_lock(&furi_records_mutex);
+    for(size_t i = 0; i < FURI_RECORDS_MAX && !data; i++) {
+        if(furi_records[i].name && strcmp(furi_records[i].name, name) == 0) {
+            data = furi_records[i].data;
+        }
+    }
+    pthread_mutex_unlock(&furi_records_mutex);
+    furi_check(data);
+    return data;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+uint32_t furi_get_tick(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+uint32_t furi_hal_host_cycles(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 1;
+}
+
+void furi_delay_ms(uint32_t ms) {
+    usleep(ms * 1000);
+}
+
+size_t memmgr_heap_get_max_free_block(void) {
+    /* Plenty: the copy engine takes its largest buffer */
+    return 1024 * 1024;
+}
+
+// -------------------------------------------------------------------
+// Threads: the stack size is the platform's, the name is only kept
+// -------------------------------------------------------------------
+struct FuriThread {
+    const char* name;
+    FuriThreadCallback callback;
+    void* context;
+    pthread_t thread;
+    bool started;
+};
+
+static void* furi_thread_body(void* context) {
+    FuriThread* thread = context;
+    thread->callback(thread->context);
+    return NULL;
+}
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context) {
+    UNUSED(stack_size);
+    FuriThread* thread = calloc(1, sizeof(FuriThread));
+    thread->name = name;
+    thread->callback = callback;
+    thread->context = context;
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    furi_check(!thread->started);
+    free(thread);
+}
+
+void furi_thread_start(FuriThread* thread) {
+    furi_check(!thread->started);
+    furi_check(pthread_create(&thread->thread, NULL, furi_thread_body, thread) == 0);
+    thread->started = true;
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    if(thread->started) {
+        pthread_join(thread->thread, NULL);
+        thread->started = false;
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Message queues: a ring of fixed-size messages, FIFO, blocking on
+// full and empty up to the timeout
+// -------------------------------------------------------------------
+struct FuriMessageQueue {
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t* buffer;
+    uint32_t msg_count;
+    uint32_t msg_size;
+    uint32_t head;
+    uint32_t used;
+};
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size) {
+    furi_check(msg_count > 0 && msg_size > 0);
+    FuriMessageQueue* queue = calloc(1, sizeof(FuriMessageQueue));
+    queue->buffer = malloc((size_t)msg_count * msg_size);
+    queue->msg_count = msg_count;
+    queue->msg_size = msg_size;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    return queue;
+}
+
+void furi_message_queue_free(FuriMessageQueue* queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue->buffer);
+    free(queue);
+}
+
+static void furi_message_queue_deadline(struct timespec* deadline, uint32_t timeout) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += timeout / 1000;
+    deadline->tv_nsec += (long)(timeout % 1000) * 1000000;
+    if(deadline->tv_nsec >= 1000000000) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+FuriStatus furi_message_queue_put(FuriMessageQueue* queue, const void* msg_ptr, uint32_t timeout) {
+    struct timespec deadline;
+    if(timeout != FuriWaitForever) furi_message_queue_deadline(&deadline, timeout);
+
+    pthread_mutex_lock(&queue->mutex);
+    while(queue->used == queue->msg_count) {
+        if(timeout == FuriWaitForever) {
+            pthread_cond_wait(&queue->not_full, &queue->mutex);
+        } else if(pthread_cond_timedwait(&queue->not_full, &queue->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+
+    FuriStatus status = FuriStatusErrorTimeout;
+    if(queue->used < queue->msg_count) {
+        uint32_t tail = (queue->head + queue->used) % queue->msg_count;
+        memcpy(queue->buffer + (size_t)tail * queue->msg_size, msg_ptr, queue->msg_size);
+        queue->used++;
+        pthread_cond_signal(&queue->not_empty);
+        status = FuriStatusOk;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return status;
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue* queue, void* msg_ptr, uint32_t timeout) {
+    struct timespec deadline;
+    if(timeout != FuriWaitForever) furi_message_queue_deadline(&deadline, timeout);
+
+    pthread_mutex_lock(&queue->mutex);
+    while(queue->used == 0) {
+        if(timeout == FuriWaitForever) {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        } else if(pthread_cond_timedwait(&queue->not_empty, &queue->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+
+    FuriStatus status = FuriStatusErrorTimeout;
+    if(queue->used > 0) {
+        memcpy(msg_ptr, queue->buffer + (size_t)queue->head * queue->msg_size, queue->msg_size);
+        queue->head = (queue->head + 1) % queue->msg_count;
+        queue->used--;
+        pthread_cond_signal(&queue->not_full);
+        status = FuriStatusOk;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return status;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <furi.h>
+
+/* Storage API on the host. The card is a directory (storage_posix.c) or
+ * a FAT image file (storage_fatfs.c, over FatFs); the backend is picked
+ * at link time. Flipper paths are mapped into it: /ext/x is x on the
+ * card, APP_DATA_PATH and APP_ASSETS_PATH are the app's folders under
+ * apps_data and apps_assets, as on the device. FAT behaviour the core
+ * relies on is kept: rename doesn't replace an existing target, and
+ * directories list in a stable order. */
+
+#define RECORD_STORAGE "storage"
+
+#define STORAGE_EXT_PATH_PREFIX "/ext"
+#define EXT_PATH(path)          "/ext/" path
+#define APP_DATA_PATH(path)     "/data/" path
+#define APP_ASSETS_PATH(path)   "/assets/" path
+
+typedef struct Storage Storage;
+typedef struct File File;
+
+typedef enum {
+    FSAM_READ = (1 << 0),
+    FSAM_WRITE = (1 << 1),
+    FSAM_READ_WRITE = FSAM_READ | FSAM_WRITE,
+} FS_AccessMode;
+
+typedef enum {
+    FSOM_OPEN_EXISTING = 1,
+    FSOM_OPEN_ALWAYS = 2,
+    FSOM_OPEN_APPEND = 4,
+    FSOM_CREATE_NEW = 8,
+    FSOM_CREATE_ALWAYS = 16,
+} FS_OpenMode;
+
+typedef enum {
+    FSE_OK,
+    FSE_NOT_READY,
+    FSE_EXIST,
+    FSE_NOT_EXIST,
+    FSE_INVALID_PARAMETER,
+    FSE_DENIED,
+    FSE_INVALID_NAME,
+    FSE_INTERNAL,
+    FSE_NOT_IMPLEMENTED,
+    FSE_ALREADY_OPEN,
+} FS_Error;
+
+typedef enum {
+    FSF_DIRECTORY = (1 << 0),
+} FS_Flags;
+
+typedef struct {
+    uint32_t flags;
+    uint64_t size;
+} FileInfo;
+
+typedef enum {
+    FST_UNKNOWN,
+    FST_FAT12,
+    FST_FAT16,
+    FST_FAT32,
+    FST_EXFAT,
+} SDFsType;
+
+typedef struct {
+    SDFsType fs_type;
+    uint32_t kb_total;
+    uint32_t kb_free;
+    uint16_t cluster_size;
+    uint16_t sector_size;
+    char label[34];
+    uint8_t manufacturer_id;
+    char oem_id[3];
+    char product_name[6];
+    uint8_t product_revision_major;
+    uint8_t product_revision_minor;
+    uint32_t product_serial_number;
+    uint8_t manufacturing_month;
+    uint16_t manufacturing_year;
+} SDInfo;
+
+/* Host only. Each card opened is its own Storage, so one process can
+ * work on several; app_id names the folders behind /data and /assets.
+ * storage_host_mount opens the one furi_record_open(RECORD_STORAGE)
+ * returns. NULL / false if the card can't be opened */
+Storage* storage_host_open(const char* target, const char* app_id);
+void storage_host_close(Storage* storage);
+bool storage_host_mount(const char* target, const char* app_id);
+void storage_host_unmount(void);
+
+File* storage_file_alloc(Storage* storage);
+void storage_file_free(File* file);
+bool storage_file_open(
+    File* file,
+    const char* path,
+    FS_AccessMode access_mode,
+    FS_OpenMode open_mode);
+bool storage_file_close(File* file);
+bool storage_file_is_open(File* file);
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read);
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write);
+bool storage_file_seek(File* file, uint32_t offset, bool from_start);
+uint64_t storage_file_tell(File* file);
+uint64_t storage_file_size(File* file);
+/* Allocate size bytes for an empty file, in one contiguous run */
+bool storage_file_expand(File* file, uint64_t size);
+bool storage_file_exists(Storage* storage, const char* path);
+
+bool storage_dir_open(File* file, const char* path);
+bool storage_dir_close(File* file);
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length);
+bool storage_dir_rewind(File* file);
+bool storage_dir_exists(Storage* storage, const char* path);
+
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp);
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo);
+FS_Error storage_common_remove(Storage* storage, const char* path);
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path);
+FS_Error storage_common_mkdir(Storage* storage, const char* path);
+bool storage_common_exists(Storage* storage, const char* path);
+FS_Error storage_sd_info(Storage* storage, SDInfo* info);
+
+bool storage_simply_remove(Storage* storage, const char* path);
+bool storage_simply_remove_recursive(Storage* storage, const char* path);
+bool storage_simply_mkdir(Storage* storage, const char* path);
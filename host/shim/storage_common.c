@@ -0,0 +1,66 @@
+#include <storage/storage.h>
+
+/* The part of the Storage API built on the backend's primitives, the
+ * same for every backend */
+
+bool storage_host_mount(const char* target, const char* app_id) {
+    Storage* storage = storage_host_open(target, app_id);
+    if(storage) furi_record_create(RECORD_STORAGE, storage);
+    return storage != NULL;
+}
+
+void storage_host_unmount(void) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    furi_record_close(RECORD_STORAGE);
+    furi_record_destroy(RECORD_STORAGE);
+    storage_host_close(storage);
+}
+
+bool storage_file_exists(Storage* storage, const char* path) {
+    FileInfo info;
+    return storage_common_stat(storage, path, &info) == FSE_OK &&
+           !(info.flags & FSF_DIRECTORY);
+}
+
+bool storage_dir_exists(Storage* storage, const char* path) {
+    FileInfo info;
+    return storage_common_stat(storage, path, &info) == FSE_OK &&
+           (info.flags & FSF_DIRECTORY);
+}
+
+bool storage_common_exists(Storage* storage, const char* path) {
+    return storage_common_stat(storage, path, NULL) == FSE_OK;
+}
+
+// ===================================================================
+// Simply
+// ===================================================================
+bool storage_simply_remove(Storage* storage, const char* path) {
+    FS_Error error = storage_common_remove(storage, path);
+    return error == FSE_OK || error == FSE_NOT_EXIST;
+}
+
+bool storage_simply_remove_recursive(Storage* storage, const char* path) {
+    if(!storage_dir_exists(storage, path)) return storage_simply_remove(storage, path);
+
+    File* dir = storage_file_alloc(storage);
+    FuriString* child = furi_string_alloc();
+    char name[256];
+    FileInfo info;
+    bool ok = storage_dir_open(dir, path);
+
+    while(ok && storage_dir_read(dir, &info, name, sizeof(name))) {
+        furi_string_printf(child, "%s/%s", path, name);
+        ok = storage_simply_remove_recursive(storage, furi_string_get_cstr(child));
+    }
+
+    storage_dir_close(dir);
+    storage_file_free(dir);
+    furi_string_free(child);
+    return ok && storage_simply_remove(storage, path);
+}
+
+bool storage_simply_mkdir(Storage* storage, const char* path) {
+    FS_Error error = storage_common_mkdir(storage, path);
+    return error == FSE_OK || error == FSE_EXIST;
+}
@@ -0,0 +1,399 @@
+#include <storage/storage.h>
+
+#include "ff.h"
+#include "diskio_image.h"
+
+#include <pthread.h>
+#include <time.h>
+
+/* Storage API inside FAT images, through FatFs: the code the firmware
+ * itself runs, so names, directory order and cluster allocation come
+ * out as they would on the card. Each open image is a FatFs volume (up
+ * to FF_VOLUMES at once; opening more waits for one to close). FatFs is
+ * built without reentrancy, which is safe across volumes; a lock per
+ * volume serializes calls on one */
+
+#define FATFS_PATH_MAX 512
+
+typedef enum {
+    FileTypeClosed,
+    FileTypeFile,
+    FileTypeDir,
+} FileType;
+
+struct Storage {
+    FATFS fs;
+    BYTE drive;
+    char app_id[64];
+    pthread_mutex_t mutex;
+};
+
+struct File {
+    Storage* storage;
+    FileType type;
+    FIL file;
+    DIR dir;
+};
+
+static Storage* volumes[FF_VOLUMES];
+static pthread_mutex_t volumes_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t volumes_free = PTHREAD_COND_INITIALIZER;
+
+#define FATFS_CALL(storage, call)                \
+    ({                                           \
+        pthread_mutex_lock(&(storage)->mutex);   \
+        FRESULT fatfs_result = (call);           \
+        pthread_mutex_unlock(&(storage)->mutex); \
+        fatfs_result;                            \
+    })
+
+// -------------------------------------------------------------------
+// Take a free drive number, open the image on it and mount it
+// -------------------------------------------------------------------
+Storage* storage_host_open(const char* target, const char* app_id) {
+    Storage* storage = calloc(1, sizeof(Storage));
+    snprintf(storage->app_id, sizeof(storage->app_id), "%s", app_id);
+    pthread_mutex_init(&storage->mutex, NULL);
+
+    pthread_mutex_lock(&volumes_mutex);
+    while(true) {
+        for(storage->drive = 0; storage->drive < FF_VOLUMES; storage->drive++) {
+            if(!volumes[storage->drive]) break;
+        }
+        if(storage->drive < FF_VOLUMES) break;
+        pthread_cond_wait(&volumes_free, &volumes_mutex);
+    }
+    volumes[storage->drive] = storage;
+    pthread_mutex_unlock(&volumes_mutex);
+
+    /* f_mount is the one call that isn't safe across volumes */
+    char volume[4];
+    snprintf(volume, sizeof(volume), "%u:", storage->drive);
+    bool ok = disk_image_open(storage->drive, target);
+    pthread_mutex_lock(&volumes_mutex);
+    ok = ok && f_mount(&storage->fs, volume, 1) == FR_OK;
+    pthread_mutex_unlock(&volumes_mutex);
+
+    if(!ok) {
+        storage_host_close(storage);
+        return NULL;
+    }
+    return storage;
+}
+
+void storage_host_close(Storage* storage) {
+    char volume[4];
+    snprintf(volume, sizeof(volume), "%u:", storage->drive);
+
+    pthread_mutex_lock(&volumes_mutex);
+    f_mount(NULL, volume, 0);
+    disk_image_close(storage->drive);
+    volumes[storage->drive] = NULL;
+    pthread_cond_signal(&volumes_free);
+    pthread_mutex_unlock(&volumes_mutex);
+
+    pthread_mutex_destroy(&storage->mutex);
+    free(storage);
+}
+
+// -------------------------------------------------------------------
+// Flipper path -> path on the volume; /ext is its root
+// -------------------------------------------------------------------
+static bool storage_fatfs_map(Storage* storage, const char* path, char* out) {
+    static const struct {
+        const char* prefix;
+        const char* dir;
+    } mounts[] = {
+        {"/ext", ""},
+        {"/data", "/apps_data/"},
+        {"/assets", "/apps_assets/"},
+    };
+
+    for(size_t i = 0; i < COUNT_OF(mounts); i++) {
+        size_t len = strlen(mounts[i].prefix);
+        if(strncmp(path, mounts[i].prefix, len) != 0) continue;
+        if(path[len] != '\0' && path[len] != '/') continue;
+
+        int written = snprintf(
+            out,
+            FATFS_PATH_MAX,
+            "%u:%s%s%s",
+            storage->drive,
+            mounts[i].dir,
+            mounts[i].dir[0] ? storage->app_id : "",
+            path[len] ? path + len : "/");
+        return written > 0 && written < FATFS_PATH_MAX;
+    }
+    return false;
+}
+
+static bool storage_fatfs_is_root(const char* fatfs_path) {
+    return strcmp(strchr(fatfs_path, ':') + 1, "/") == 0;
+}
+
+static FS_Error storage_fatfs_error(FRESULT result) {
+    switch(result) {
+    case FR_OK:
+        return FSE_OK;
+    case FR_NO_FILE:
+    case FR_NO_PATH:
+        return FSE_NOT_EXIST;
+    case FR_EXIST:
+        return FSE_EXIST;
+    case FR_INVALID_NAME:
+        return FSE_INVALID_NAME;
+    case FR_DENIED:
+    case FR_WRITE_PROTECTED:
+        return FSE_DENIED;
+    case FR_INVALID_OBJECT:
+    case FR_INVALID_PARAMETER:
+        return FSE_INVALID_PARAMETER;
+    case FR_NOT_READY:
+    case FR_INVALID_DRIVE:
+    case FR_NOT_ENABLED:
+    case FR_NO_FILESYSTEM:
+        return FSE_NOT_READY;
+    case FR_LOCKED:
+    case FR_TOO_MANY_OPEN_FILES:
+        return FSE_ALREADY_OPEN;
+    default:
+        return FSE_INTERNAL;
+    }
+}
+
+// ===================================================================
+// Files
+// ===================================================================
+File* storage_file_alloc(Storage* storage) {
+    File* file = calloc(1, sizeof(File));
+    file->storage = storage;
+    return file;
+}
+
+void storage_file_free(File* file) {
+    if(file->type == FileTypeFile) storage_file_close(file);
+    if(file->type == FileTypeDir) storage_dir_close(file);
+    free(file);
+}
+
+bool storage_file_open(
+    File* file,
+    const char* path,
+    FS_AccessMode access_mode,
+    FS_OpenMode open_mode) {
+    char fatfs_path[FATFS_PATH_MAX];
+    if(file->type != FileTypeClosed || !storage_fatfs_map(file->storage, path, fatfs_path)) {
+        return false;
+    }
+
+    BYTE mode = (access_mode & FSAM_READ ? FA_READ : 0) |
+                (access_mode & FSAM_WRITE ? FA_WRITE : 0);
+    switch(open_mode) {
+    case FSOM_OPEN_EXISTING:
+        mode |= FA_OPEN_EXISTING;
+        break;
+    case FSOM_OPEN_ALWAYS:
+        mode |= FA_OPEN_ALWAYS;
+        break;
+    case FSOM_OPEN_APPEND:
+        mode |= FA_OPEN_APPEND;
+        break;
+    case FSOM_CREATE_NEW:
+        mode |= FA_CREATE_NEW;
+        break;
+    case FSOM_CREATE_ALWAYS:
+        mode |= FA_CREATE_ALWAYS;
+        break;
+    }
+
+    FRESULT result = FATFS_CALL(file->storage, f_open(&file->file, fatfs_path, mode));
+    if(result != FR_OK) return false;
+    file->type = FileTypeFile;
+    return true;
+}
+
+bool storage_file_close(File* file) {
+    if(file->type != FileTypeFile) return false;
+    file->type = FileTypeClosed;
+    return FATFS_CALL(file->storage, f_close(&file->file)) == FR_OK;
+}
+
+bool storage_file_is_open(File* file) {
+    return file->type == FileTypeFile;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    UINT done = 0;
+    if(file->type != FileTypeFile) return 0;
+    FATFS_CALL(file->storage, f_read(&file->file, buff, (UINT)bytes_to_read, &done));
+    return done;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    UINT done = 0;
+    if(file->type != FileTypeFile) return 0;
+    FATFS_CALL(file->storage, f_write(&file->file, buff, (UINT)bytes_to_write, &done));
+    return done;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    if(file->type != FileTypeFile) return false;
+    FSIZE_t position = from_start ? offset : f_tell(&file->file) + offset;
+    return FATFS_CALL(file->storage, f_lseek(&file->file, position)) == FR_OK;
+}
+
+uint64_t storage_file_tell(File* file) {
+    return file->type == FileTypeFile ? f_tell(&file->file) : 0;
+}
+
+uint64_t storage_file_size(File* file) {
+    return file->type == FileTypeFile ? f_size(&file->file) : 0;
+}
+
+/* f_expand with opt 1, as the firmware's storage_file_expand calls it */
+bool storage_file_expand(File* file, uint64_t size) {
+    if(file->type != FileTypeFile) return false;
+    return FATFS_CALL(file->storage, f_expand(&file->file, (FSIZE_t)size, 1)) == FR_OK;
+}
+
+// ===================================================================
+// Directories: FatFs lists in on-disk order, as the device does
+// ===================================================================
+bool storage_dir_open(File* file, const char* path) {
+    char fatfs_path[FATFS_PATH_MAX];
+    if(file->type != FileTypeClosed || !storage_fatfs_map(file->storage, path, fatfs_path)) {
+        return false;
+    }
+    FRESULT result = FATFS_CALL(file->storage, f_opendir(&file->dir, fatfs_path));
+    if(result != FR_OK) return false;
+    file->type = FileTypeDir;
+    return true;
+}
+
+bool storage_dir_close(File* file) {
+    if(file->type != FileTypeDir) return false;
+    file->type = FileTypeClosed;
+    return FATFS_CALL(file->storage, f_closedir(&file->dir)) == FR_OK;
+}
+
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length) {
+    FILINFO info;
+    if(file->type != FileTypeDir) return false;
+    FRESULT result = FATFS_CALL(file->storage, f_readdir(&file->dir, &info));
+    if(result != FR_OK || info.fname[0] == '\0') return false;
+
+    if(fileinfo) {
+        fileinfo->flags = (info.fattrib & AM_DIR) ? FSF_DIRECTORY : 0;
+        fileinfo->size = (info.fattrib & AM_DIR) ? 0 : info.fsize;
+    }
+    if(name && name_length) snprintf(name, name_length, "%s", info.fname);
+    return true;
+}
+
+bool storage_dir_rewind(File* file) {
+    if(file->type != FileTypeDir) return false;
+    return FATFS_CALL(file->storage, f_readdir(&file->dir, NULL)) == FR_OK;
+}
+
+// ===================================================================
+// Common
+// ===================================================================
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    char fatfs_path[FATFS_PATH_MAX];
+    FILINFO info;
+    if(!storage_fatfs_map(storage, path, fatfs_path)) return FSE_INVALID_NAME;
+    if(storage_fatfs_is_root(fatfs_path)) return FSE_INVALID_PARAMETER;
+
+    FRESULT result = FATFS_CALL(storage, f_stat(fatfs_path, &info));
+    if(result != FR_OK) return storage_fatfs_error(result);
+
+    /* FAT time is local time without a zone; the device reads it as UTC */
+    struct tm tm = {
+        .tm_year = ((info.fdate >> 9) & 0x7F) + 80,
+        .tm_mon = ((info.fdate >> 5) & 0x0F) - 1,
+        .tm_mday = info.fdate & 0x1F,
+        .tm_hour = (info.ftime >> 11) & 0x1F,
+        .tm_min = (info.ftime >> 5) & 0x3F,
+        .tm_sec = (info.ftime & 0x1F) * 2,
+    };
+    *timestamp = (uint32_t)timegm(&tm);
+    return FSE_OK;
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    char fatfs_path[FATFS_PATH_MAX];
+    FILINFO info;
+    if(!storage_fatfs_map(storage, path, fatfs_path)) return FSE_INVALID_NAME;
+
+    /* FatFs has no entry for the root to stat */
+    if(storage_fatfs_is_root(fatfs_path)) {
+        if(fileinfo) {
+            fileinfo->flags = FSF_DIRECTORY;
+            fileinfo->size = 0;
+        }
+        return FSE_OK;
+    }
+
+    FRESULT result = FATFS_CALL(storage, f_stat(fatfs_path, &info));
+    if(result != FR_OK) return storage_fatfs_error(result);
+    if(fileinfo) {
+        fileinfo->flags = (info.fattrib & AM_DIR) ? FSF_DIRECTORY : 0;
+        fileinfo->size = (info.fattrib & AM_DIR) ? 0 : info.fsize;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    char fatfs_path[FATFS_PATH_MAX];
+    if(!storage_fatfs_map(storage, path, fatfs_path)) return FSE_INVALID_NAME;
+    return storage_fatfs_error(FATFS_CALL(storage, f_unlink(fatfs_path)));
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    char fatfs_old[FATFS_PATH_MAX];
+    char fatfs_new[FATFS_PATH_MAX];
+    if(!storage_fatfs_map(storage, old_path, fatfs_old) ||
+       !storage_fatfs_map(storage, new_path, fatfs_new)) {
+        return FSE_INVALID_NAME;
+    }
+    return storage_fatfs_error(FATFS_CALL(storage, f_rename(fatfs_old, fatfs_new)));
+}
+
+FS_Error storage_common_mkdir(Storage* storage, const char* path) {
+    char fatfs_path[FATFS_PATH_MAX];
+    if(!storage_fatfs_map(storage, path, fatfs_path)) return FSE_INVALID_NAME;
+    if(storage_fatfs_is_root(fatfs_path)) return FSE_EXIST;
+    return storage_fatfs_error(FATFS_CALL(storage, f_mkdir(fatfs_path)));
+}
+
+// -------------------------------------------------------------------
+// Volume figures from FatFs. An image has no CID, so those are zero
+// -------------------------------------------------------------------
+FS_Error storage_sd_info(Storage* storage, SDInfo* info) {
+    static const SDFsType fs_types[] = {
+        [FS_FAT12] = FST_FAT12,
+        [FS_FAT16] = FST_FAT16,
+        [FS_FAT32] = FST_FAT32,
+        [FS_EXFAT] = FST_EXFAT,
+    };
+    FATFS* fs;
+    DWORD free_clusters;
+    memset(info, 0, sizeof(SDInfo));
+
+    char volume[4];
+    snprintf(volume, sizeof(volume), "%u:", storage->drive);
+
+    pthread_mutex_lock(&storage->mutex);
+    FRESULT result = f_getfree(volume, &free_clusters, &fs);
+    if(result == FR_OK) {
+        info->fs_type = fs->fs_type < COUNT_OF(fs_types) ? fs_types[fs->fs_type] : FST_UNKNOWN;
+        info->cluster_size = fs->csize;
+        info->sector_size = FF_MAX_SS;
+        info->kb_total = (uint32_t)((uint64_t)(fs->n_fatent - 2) * fs->csize * FF_MAX_SS / 1024);
+        info->kb_free = (uint32_t)((uint64_t)free_clusters * fs->csize * FF_MAX_SS / 1024);
+        f_getlabel(volume, info->label, NULL);
+    }
+    pthread_mutex_unlock(&storage->mutex);
+
+    return storage_fatfs_error(result);
+}
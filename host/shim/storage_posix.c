@@ -0,0 +1,379 @@
+#include <storage/storage.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Storage API over a host directory, keeping the FAT behaviour the
+ * theme core depends on (see storage.h). Listings are sorted by name,
+ * as the order on the host disk means nothing on the card */
+
+#define HOST_PATH_MAX 1024
+
+typedef enum {
+    FileTypeClosed,
+    FileTypeFile,
+    FileTypeDir,
+} FileType;
+
+struct Storage {
+    char root[HOST_PATH_MAX];
+    char app_id[64];
+};
+
+struct File {
+    Storage* storage;
+    FileType type;
+    int fd;
+    /* Directory: all names, sorted, read back one by one */
+    char** names;
+    size_t name_count;
+    size_t name_index;
+    char dir_path[HOST_PATH_MAX];
+};
+
+Storage* storage_host_open(const char* target, const char* app_id) {
+    struct stat st;
+    if(stat(target, &st) != 0 || !S_ISDIR(st.st_mode)) return NULL;
+
+    Storage* storage = calloc(1, sizeof(Storage));
+    snprintf(storage->root, sizeof(storage->root), "%s", target);
+    snprintf(storage->app_id, sizeof(storage->app_id), "%s", app_id);
+    return storage;
+}
+
+void storage_host_close(Storage* storage) {
+    free(storage);
+}
+
+// -------------------------------------------------------------------
+// Flipper path -> host path. Anything outside /ext, /data and /assets
+// (the internal flash) doesn't exist here
+// -------------------------------------------------------------------
+static bool storage_posix_map(Storage* storage, const char* path, char* out) {
+    static const struct {
+        const char* prefix;
+        const char* dir;
+    } mounts[] = {
+        {"/ext", ""},
+        {"/data", "/apps_data/"},
+        {"/assets", "/apps_assets/"},
+    };
+
+    for(size_t i = 0; i < COUNT_OF(mounts); i++) {
+        size_t len = strlen(mounts[i].prefix);
+        if(strncmp(path, mounts[i].prefix, len) != 0) continue;
+        if(path[len] != '\0' && path[len] != '/') continue;
+
+        int written = snprintf(
+            out,
+            HOST_PATH_MAX,
+            "%s%s%s%s",
+            storage->root,
+            mounts[i].dir,
+            mounts[i].dir[0] ? storage->app_id : "",
+            path + len);
+        return written > 0 && written < HOST_PATH_MAX;
+    }
+    return false;
+}
+
+static FS_Error storage_posix_error(int error) {
+    switch(error) {
+    case 0:
+        return FSE_OK;
+    case ENOENT:
+    case ENOTDIR:
+        return FSE_NOT_EXIST;
+    case EEXIST:
+        return FSE_EXIST;
+    case EACCES:
+    case EPERM:
+    case ENOTEMPTY:
+    case EROFS:
+        return FSE_DENIED;
+    case ENAMETOOLONG:
+    case EINVAL:
+        return FSE_INVALID_NAME;
+    default:
+        return FSE_INTERNAL;
+    }
+}
+
+// ===================================================================
+// Files
+// ===================================================================
+File* storage_file_alloc(Storage* storage) {
+    File* file = calloc(1, sizeof(File));
+    file->storage = storage;
+    file->fd = -1;
+    return file;
+}
+
+void storage_file_free(File* file) {
+    if(file->type == FileTypeFile) storage_file_close(file);
+    if(file->type == FileTypeDir) storage_dir_close(file);
+    free(file);
+}
+
+bool storage_file_open(
+    File* file,
+    const char* path,
+    FS_AccessMode access_mode,
+    FS_OpenMode open_mode) {
+    char host_path[HOST_PATH_MAX];
+    if(file->type != FileTypeClosed || !storage_posix_map(file->storage, path, host_path)) {
+        return false;
+    }
+
+    int flags = access_mode == FSAM_READ_WRITE ? O_RDWR :
+                access_mode == FSAM_WRITE      ? O_WRONLY :
+                                                 O_RDONLY;
+    switch(open_mode) {
+    case FSOM_OPEN_EXISTING:
+        break;
+    case FSOM_OPEN_ALWAYS:
+    case FSOM_OPEN_APPEND:
+        flags |= O_CREAT;
+        break;
+    case FSOM_CREATE_NEW:
+        flags |= O_CREAT | O_EXCL;
+        break;
+    case FSOM_CREATE_ALWAYS:
+        flags |= O_CREAT | O_TRUNC;
+        break;
+    }
+
+    int fd = open(host_path, flags | O_CLOEXEC, 0644);
+    if(fd < 0) return false;
+
+    /* FAT opens files only */
+    struct stat st;
+    if(fstat(fd, &st) != 0 || S_ISDIR(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    if(open_mode == FSOM_OPEN_APPEND) lseek(fd, 0, SEEK_END);
+
+    file->type = FileTypeFile;
+    file->fd = fd;
+    return true;
+}
+
+bool storage_file_close(File* file) {
+    if(file->type != FileTypeFile) return false;
+    bool ok = close(file->fd) == 0;
+    file->fd = -1;
+    file->type = FileTypeClosed;
+    return ok;
+}
+
+bool storage_file_is_open(File* file) {
+    return file->type == FileTypeFile;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    if(file->type != FileTypeFile) return 0;
+    size_t done = 0;
+    while(done < bytes_to_read) {
+        ssize_t got = read(file->fd, (uint8_t*)buff + done, bytes_to_read - done);
+        if(got < 0 && errno == EINTR) continue;
+        if(got <= 0) break;
+        done += (size_t)got;
+    }
+    return done;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    if(file->type != FileTypeFile) return 0;
+    size_t done = 0;
+    while(done < bytes_to_write) {
+        ssize_t put = write(file->fd, (const uint8_t*)buff + done, bytes_to_write - done);
+        if(put < 0 && errno == EINTR) continue;
+        if(put <= 0) break;
+        done += (size_t)put;
+    }
+    return done;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    if(file->type != FileTypeFile) return false;
+    return lseek(file->fd, offset, from_start ? SEEK_SET : SEEK_CUR) >= 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    if(file->type != FileTypeFile) return 0;
+    off_t position = lseek(file->fd, 0, SEEK_CUR);
+    return position < 0 ? 0 : (uint64_t)position;
+}
+
+uint64_t storage_file_size(File* file) {
+    struct stat st;
+    if(file->type != FileTypeFile || fstat(file->fd, &st) != 0) return 0;
+    return (uint64_t)st.st_size;
+}
+
+/* The host file system picks the layout; the size is what the app sees */
+bool storage_file_expand(File* file, uint64_t size) {
+    if(file->type != FileTypeFile || storage_file_size(file) != 0) return false;
+    return posix_fallocate(file->fd, 0, (off_t)size) == 0;
+}
+
+// ===================================================================
+// Directories
+// ===================================================================
+static int storage_posix_name_cmp(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// -------------------------------------------------------------------
+// The whole listing is taken at open, sorted, so walks see the same
+// order on every run and entries added meanwhile don't show up
+// -------------------------------------------------------------------
+bool storage_dir_open(File* file, const char* path) {
+    if(file->type != FileTypeClosed || !storage_posix_map(file->storage, path, file->dir_path)) {
+        return false;
+    }
+
+    DIR* dir = opendir(file->dir_path);
+    if(!dir) return false;
+
+    size_t capacity = 0;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL) {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if(file->name_count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            file->names = realloc(file->names, capacity * sizeof(char*));
+        }
+        file->names[file->name_count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+
+    qsort(file->names, file->name_count, sizeof(char*), storage_posix_name_cmp);
+    file->name_index = 0;
+    file->type = FileTypeDir;
+    return true;
+}
+
+bool storage_dir_close(File* file) {
+    if(file->type != FileTypeDir) return false;
+    for(size_t i = 0; i < file->name_count; i++) {
+        free(file->names[i]);
+    }
+    free(file->names);
+    file->names = NULL;
+    file->name_count = 0;
+    file->type = FileTypeClosed;
+    return true;
+}
+
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length) {
+    if(file->type != FileTypeDir) return false;
+
+    while(file->name_index < file->name_count) {
+        const char* entry = file->names[file->name_index++];
+        char host_path[HOST_PATH_MAX];
+        struct stat st;
+        snprintf(host_path, sizeof(host_path), "%s/%s", file->dir_path, entry);
+        if(stat(host_path, &st) != 0) continue; /* removed since open */
+
+        if(fileinfo) {
+            fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+            fileinfo->size = S_ISDIR(st.st_mode) ? 0 : (uint64_t)st.st_size;
+        }
+        if(name && name_length) snprintf(name, name_length, "%s", entry);
+        return true;
+    }
+    return false;
+}
+
+/* The listing taken at open, from the top again */
+bool storage_dir_rewind(File* file) {
+    if(file->type != FileTypeDir) return false;
+    file->name_index = 0;
+    return true;
+}
+
+// ===================================================================
+// Common
+// ===================================================================
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    char host_path[HOST_PATH_MAX];
+    struct stat st;
+    if(!storage_posix_map(storage, path, host_path)) return FSE_INVALID_NAME;
+    if(stat(host_path, &st) != 0) return storage_posix_error(errno);
+
+    /* The device reads FAT's zoneless local time as UTC, where a vfat
+     * mount converted it with the local zone: undo that, so theme stamps
+     * match the app's */
+    struct tm tm;
+    localtime_r(&st.st_mtime, &tm);
+    *timestamp = (uint32_t)timegm(&tm);
+    return FSE_OK;
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    char host_path[HOST_PATH_MAX];
+    struct stat st;
+    if(!storage_posix_map(storage, path, host_path)) return FSE_INVALID_NAME;
+    if(stat(host_path, &st) != 0) return storage_posix_error(errno);
+    if(fileinfo) {
+        fileinfo->flags = S_ISDIR(st.st_mode) ? FSF_DIRECTORY : 0;
+        fileinfo->size = S_ISDIR(st.st_mode) ? 0 : (uint64_t)st.st_size;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    char host_path[HOST_PATH_MAX];
+    struct stat st;
+    if(!storage_posix_map(storage, path, host_path)) return FSE_INVALID_NAME;
+    if(lstat(host_path, &st) != 0) return storage_posix_error(errno);
+    int result = S_ISDIR(st.st_mode) ? rmdir(host_path) : unlink(host_path);
+    return result == 0 ? FSE_OK : storage_posix_error(errno);
+}
+
+// -------------------------------------------------------------------
+// FAT rename never replaces: the core removes the target first where it
+// means to, and relies on the failure everywhere else
+// -------------------------------------------------------------------
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    char host_old[HOST_PATH_MAX];
+    char host_new[HOST_PATH_MAX];
+    struct stat st;
+    if(!storage_posix_map(storage, old_path, host_old) ||
+       !storage_posix_map(storage, new_path, host_new)) {
+        return FSE_INVALID_NAME;
+    }
+    if(lstat(host_old, &st) != 0) return storage_posix_error(errno);
+    if(lstat(host_new, &st) == 0) return FSE_EXIST;
+    return rename(host_old, host_new) == 0 ? FSE_OK : storage_posix_error(errno);
+}
+
+FS_Error storage_common_mkdir(Storage* storage, const char* path) {
+    char host_path[HOST_PATH_MAX];
+    if(!storage_posix_map(storage, path, host_path)) return FSE_INVALID_NAME;
+    return mkdir(host_path, 0755) == 0 ? FSE_OK : storage_posix_error(errno);
+}
+
+// -------------------------------------------------------------------
+// Capacity from the host filesystem. There is no card to read a CID
+// from, so those fields are zero
+// -------------------------------------------------------------------
+FS_Error storage_sd_info(Storage* storage, SDInfo* info) {
+    struct statvfs vfs;
+    memset(info, 0, sizeof(SDInfo));
+    if(statvfs(storage->root, &vfs) != 0) return storage_posix_error(errno);
+
+    info->fs_type = FST_UNKNOWN;
+    info->kb_total = (uint32_t)((uint64_t)vfs.f_blocks * vfs.f_frsize / 1024);
+    info->kb_free = (uint32_t)((uint64_t)vfs.f_bavail * vfs.f_frsize / 1024);
+    info->sector_size = 512;
+    info->cluster_size = (uint16_t)(vfs.f_bsize / 512);
+    return FSE_OK;
+}
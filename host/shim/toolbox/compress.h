@@ -0,0 +1,37 @@
+#pragma once
+
+#include <furi.h>
+
+/* Heatshrink decoding as the SDK's compress API does it: the icon
+ * decoder (header byte, then raw or compressed data) and the plain
+ * buffer decoder. No encoder; host tools don't recompress frames. */
+
+typedef struct CompressIcon CompressIcon;
+
+CompressIcon* compress_icon_alloc(size_t decode_buf_size);
+void compress_icon_free(CompressIcon* instance);
+void compress_icon_decode(CompressIcon* instance, const uint8_t* icon_data, uint8_t** output);
+
+typedef enum {
+    CompressTypeHeatshrink = 0,
+} CompressType;
+
+typedef struct {
+    uint16_t window_sz2;
+    uint16_t lookahead_sz2;
+    uint16_t input_buffer_sz;
+} CompressConfigHeatshrink;
+
+extern const CompressConfigHeatshrink compress_config_heatshrink_default;
+
+typedef struct Compress Compress;
+
+Compress* compress_alloc(CompressType type, const void* config);
+void compress_free(Compress* compress);
+bool compress_decode(
+    Compress* compress,
+    uint8_t* data_in,
+    size_t data_in_size,
+    uint8_t* data_out,
+    size_t data_out_size,
+    size_t* data_res_size);
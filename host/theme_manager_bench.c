@@ -0,0 +1,727 @@
+#include "../theme_manager_core.h"
+#include "../theme_manager_cache.h"
+#include "../theme_manager_bitmap.h"
+
+#include <toolbox/compress.h>
+#include <time.h>
+
+/* theme_manager_bench: the per-frame kernels timed in isolation on
+ * generated frames, each next to the alternatives that could replace it.
+ *
+ *   decode     .bm frame to bitmap: compress_icon_decode (heatshrink, one
+ *              bit at a time) against a 32-bit bit buffer; raw frames
+ *              copied out as theme_manager_decode_frame does, or used
+ *              in place
+ *   downscale  a pixel at a time into the thumbnail box, as the app
+ *              used to, against stepped and column-table versions
+ *              without the divisions, and theme_manager_bitmap_downscale
+ *   draw       the info view's former preview loop (a division, a bounds
+ *              check and a bit test per dot) against a column table, and
+ *              against the kernel's downscale then a row blit, as
+ *              canvas_draw_xbm does now
+ *   equal      memcmp of a frame against theme_manager_bitmap_equal
+ *
+ * Every alternative is checked against the reference on every frame
+ * first. Frames are sprite-like (sparse shapes, compress well) or noise
+ * (half the bits set, don't), at sizes up to 128x64. Times are the best
+ * of BENCH_REPEATS runs: ns per frame and frame bytes per second
+ * (decoded bytes for decode, source bitmap bytes otherwise). These are
+ * the host's numbers; they rank implementations, the device's own
+ * benchmark gives absolute times. */
+
+#define BENCH_REPEATS      5
+#define BENCH_DEFAULT_US   10000
+#define BENCH_SWEEP_US     50
+#define BENCH_ENCODED_MAX  (FRAME_MAX_SIZE * 2 + 16)
+#define BENCH_SCREEN_BYTES ((128 / 8) * 64)
+
+#define BENCH_DRAW_X 2
+#define BENCH_DRAW_Y 2
+#define BENCH_DRAW_W 48 /* the info view's PREVIEW_DRAW_* box */
+#define BENCH_DRAW_H 32
+
+typedef enum {
+    BenchContentSprite,
+    BenchContentNoise,
+} BenchContent;
+
+static const char* const bench_content_names[] = {"sprite", "noise"};
+
+/* One generated frame, as a bitmap and as both .bm encodings */
+typedef struct {
+    uint8_t w;
+    uint8_t h;
+    BenchContent content;
+    size_t size; /* decoded bytes */
+    uint8_t bitmap[FRAME_MAX_SIZE];
+    uint8_t raw_bm[FRAME_MAX_SIZE + 1];
+    uint8_t packed_bm[BENCH_ENCODED_MAX];
+} BenchFrame;
+
+typedef struct {
+    uint8_t out[FRAME_MAX_SIZE];
+    uint8_t screen[BENCH_SCREEN_BYTES];
+    uint8_t scratch[FRAME_MAX_SIZE];
+    uint8_t expected[FRAME_MAX_SIZE];
+    CompressIcon* icon;
+} BenchState;
+
+typedef void (*BenchKernel)(BenchState* state, const BenchFrame* frame);
+
+typedef struct {
+    const char* kernel;
+    const char* input; /* "packed" or "raw" for decode, "" otherwise */
+    const char* impl;
+    BenchKernel run;
+    BenchKernel check; /* what leaves run's output, if run itself doesn't */
+    size_t out_size; /* bytes of out (or screen) compared; 0 for the frame size */
+    bool screen;
+} BenchImpl;
+
+static volatile uint32_t bench_sink;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// ===================================================================
+// Frames
+// ===================================================================
+static uint32_t bench_random(uint32_t* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static void bench_set(BenchFrame* frame, int x, int y) {
+    if(x < 0 || y < 0 || x >= frame->w || y >= frame->h) return;
+    frame->bitmap[y * ((frame->w + 7) / 8) + x / 8] |= 1 << (x % 8);
+}
+
+// -------------------------------------------------------------------
+// Heatshrink encoder for the fixtures (window 8, lookahead 4, the
+// firmware's icon settings): greedy longest match, a back-reference
+// from two bytes on. Returns the encoded size after the header
+// -------------------------------------------------------------------
+typedef struct {
+    uint8_t* out;
+    size_t bit;
+} BenchBitWriter;
+
+static void bench_put_bits(BenchBitWriter* writer, uint16_t value, uint8_t count) {
+    while(count--) {
+        if(writer->bit % 8 == 0) writer->out[writer->bit / 8] = 0;
+        if((value >> count) & 1) writer->out[writer->bit / 8] |= 0x80 >> (writer->bit % 8);
+        writer->bit++;
+    }
+}
+
+static size_t bench_encode(const uint8_t* in, size_t size, uint8_t* out) {
+    BenchBitWriter writer = {.out = out, .bit = 0};
+    const uint8_t window_sz2 = compress_config_heatshrink_default.window_sz2;
+    const uint8_t lookahead_sz2 = compress_config_heatshrink_default.lookahead_sz2;
+    size_t window = 1 << window_sz2;
+    size_t lookahead = 1 << lookahead_sz2;
+
+    for(size_t pos = 0; pos < size;) {
+        size_t best_len = 0;
+        size_t best_offset = 0;
+        for(size_t offset = 1; offset <= window && offset <= pos; offset++) {
+            size_t len = 0;
+            while(len < lookahead && pos + len < size &&
+                  in[pos + len] == in[pos + len - offset]) {
+                len++;
+            }
+            if(len > best_len) {
+                best_len = len;
+                best_offset = offset;
+            }
+        }
+
+        if(best_len >= 2) {
+            bench_put_bits(&writer, 0, 1);
+            bench_put_bits(&writer, best_offset - 1, window_sz2);
+            bench_put_bits(&writer, best_len - 1, lookahead_sz2);
+            pos += best_len;
+        } else {
+            bench_put_bits(&writer, 1, 1);
+            bench_put_bits(&writer, in[pos], 8);
+            pos++;
+        }
+    }
+    return (writer.bit + 7) / 8;
+}
+
+// -------------------------------------------------------------------
+// Same seed, same frame: sprites are a few filled circles and lines
+// -------------------------------------------------------------------
+static void bench_frame_make(BenchFrame* frame, uint8_t w, uint8_t h, BenchContent content) {
+    uint32_t seed = 0x9E3779B9u ^ ((uint32_t)w << 8) ^ h ^ ((uint32_t)content << 16);
+    frame->w = w;
+    frame->h = h;
+    frame->content = content;
+    frame->size = (size_t)((w + 7) / 8) * h;
+    memset(frame->bitmap, 0, sizeof(frame->bitmap));
+
+    if(content == BenchContentNoise) {
+        for(size_t i = 0; i < frame->size; i++) {
+            frame->bitmap[i] = (uint8_t)bench_random(&seed);
+        }
+        /* Padding bits past w stay clear, as in converted frames */
+        uint8_t tail = w % 8;
+        for(size_t row = 0; tail && row < h; row++) {
+            frame->bitmap[row * ((w + 7) / 8) + w / 8] &= (1 << tail) - 1;
+        }
+    } else {
+        for(uint8_t shape = 0; shape < 4; shape++) {
+            int cx = bench_random(&seed) % w;
+            int cy = bench_random(&seed) % h;
+            int r = 1 + bench_random(&seed) % (1 + (w < h ? w : h) / 4);
+            for(int y = -r; y <= r; y++) {
+                for(int x = -r; x <= r; x++) {
+                    if(x * x + y * y <= r * r) bench_set(frame, cx + x, cy + y);
+                }
+            }
+            int x0 = bench_random(&seed) % w;
+            for(int y = 0; y < h; y++) {
+                bench_set(frame, x0 + (y * 3) / 4, y);
+            }
+        }
+    }
+
+    frame->raw_bm[0] = 0x00;
+    memcpy(frame->raw_bm + 1, frame->bitmap, frame->size);
+
+    size_t packed = bench_encode(frame->bitmap, frame->size, frame->packed_bm + 4);
+    frame->packed_bm[0] = 0x01;
+    frame->packed_bm[1] = 0x00;
+    frame->packed_bm[2] = packed & 0xFF;
+    frame->packed_bm[3] = packed >> 8;
+}
+
+// ===================================================================
+// decode
+// ===================================================================
+static void bench_decode_sdk(BenchState* state, const BenchFrame* frame) {
+    uint8_t* decoded = NULL;
+    compress_icon_decode(state->icon, frame->packed_bm, &decoded);
+    memcpy(state->out, decoded, frame->size);
+}
+
+// -------------------------------------------------------------------
+// The same stream through a 32-bit buffer refilled a byte at a time,
+// so each token costs a few shifts instead of a loop per bit
+// -------------------------------------------------------------------
+static void bench_decode_word(BenchState* state, const BenchFrame* frame) {
+    const uint8_t window_sz2 = compress_config_heatshrink_default.window_sz2;
+    const uint8_t lookahead_sz2 = compress_config_heatshrink_default.lookahead_sz2;
+    const uint8_t* in = frame->packed_bm + 4;
+    size_t in_size = frame->packed_bm[2] | (frame->packed_bm[3] << 8);
+    uint8_t* out = state->out;
+    size_t pos = 0;
+    size_t len = 0;
+    uint32_t bits = 0;
+    uint8_t avail = 0;
+
+#define BENCH_NEED(n)                     \
+    while(avail < (n) && pos < in_size) { \
+        bits = (bits << 8) | in[pos++];   \
+        avail += 8;                       \
+    }                                     \
+    if(avail < (n)) break;
+#define BENCH_TAKE(n) ((bits >> (avail -= (n))) & ((1u << (n)) - 1))
+
+    /* A token too short for the bits left is the encoder's padding */
+    while(true) {
+        BENCH_NEED(1 + 8);
+        if((bits >> (avail - 1)) & 1) {
+            avail -= 1;
+            if(len == frame->size) break;
+            out[len++] = (uint8_t)BENCH_TAKE(8);
+            continue;
+        }
+        BENCH_NEED(1 + window_sz2 + lookahead_sz2);
+        avail -= 1;
+        size_t offset = BENCH_TAKE(window_sz2) + 1;
+        size_t count = BENCH_TAKE(lookahead_sz2) + 1;
+        if(offset > len || len + count > frame->size) break;
+        for(; count; count--, len++) {
+            out[len] = out[len - offset];
+        }
+    }
+
+#undef BENCH_TAKE
+#undef BENCH_NEED
+}
+
+static void bench_decode_copy(BenchState* state, const BenchFrame* frame) {
+    uint8_t* decoded = NULL;
+    compress_icon_decode(state->icon, frame->raw_bm, &decoded);
+    memcpy(state->out, decoded, frame->size);
+}
+
+/* Only the pointer is taken: the bitmap is read where it was loaded */
+static void bench_decode_inplace(BenchState* state, const BenchFrame* frame) {
+    uint8_t* decoded = NULL;
+    compress_icon_decode(state->icon, frame->raw_bm, &decoded);
+    bench_sink = decoded[0];
+}
+
+static void bench_decode_inplace_check(BenchState* state, const BenchFrame* frame) {
+    uint8_t* decoded = NULL;
+    compress_icon_decode(state->icon, frame->raw_bm, &decoded);
+    memcpy(state->out, decoded, frame->size);
+}
+
+// ===================================================================
+// downscale
+// ===================================================================
+static void bench_downscale_pixel(BenchState* state, const BenchFrame* frame) {
+    uint8_t dst_w = frame->w < THUMB_MAX_W ? frame->w : THUMB_MAX_W;
+    uint8_t dst_h = frame->h < THUMB_MAX_H ? frame->h : THUMB_MAX_H;
+    uint8_t src_row_bytes = (frame->w + 7) / 8;
+    uint8_t dst_row_bytes = (dst_w + 7) / 8;
+
+    memset(state->out, 0, (size_t)dst_row_bytes * dst_h);
+    for(uint8_t py = 0; py < dst_h; py++) {
+        uint8_t sy = (frame->h > THUMB_MAX_H) ? (uint8_t)(py * frame->h / THUMB_MAX_H) : py;
+        const uint8_t* src_row = frame->bitmap + (uint32_t)sy * src_row_bytes;
+        uint8_t* dst_row = state->out + (uint32_t)py * dst_row_bytes;
+
+        for(uint8_t px = 0; px < dst_w; px++) {
+            uint8_t sx = (frame->w > THUMB_MAX_W) ? (uint8_t)(px * frame->w / THUMB_MAX_W) : px;
+            if(src_row[sx / 8] & (1 << (sx % 8))) dst_row[px / 8] |= 1 << (px % 8);
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Nearest neighbour by stepping: the source coordinate is floor(p *
+// src / max), kept as a whole part and a remainder, so no divisions
+// -------------------------------------------------------------------
+static void bench_downscale_step(BenchState* state, const BenchFrame* frame) {
+    uint8_t dst_w = frame->w < THUMB_MAX_W ? frame->w : THUMB_MAX_W;
+    uint8_t dst_h = frame->h < THUMB_MAX_H ? frame->h : THUMB_MAX_H;
+    uint8_t src_row_bytes = (frame->w + 7) / 8;
+    uint8_t dst_row_bytes = (dst_w + 7) / 8;
+    uint8_t step_x = frame->w > THUMB_MAX_W ? frame->w / THUMB_MAX_W : 1;
+    uint8_t rem_x = frame->w > THUMB_MAX_W ? frame->w % THUMB_MAX_W : 0;
+    uint8_t step_y = frame->h > THUMB_MAX_H ? frame->h / THUMB_MAX_H : 1;
+    uint8_t rem_y = frame->h > THUMB_MAX_H ? frame->h % THUMB_MAX_H : 0;
+
+    memset(state->out, 0, (size_t)dst_row_bytes * dst_h);
+
+    uint8_t sy = 0;
+    uint8_t fy = 0;
+    for(uint8_t py = 0; py < dst_h; py++) {
+        const uint8_t* src_row = frame->bitmap + (uint32_t)sy * src_row_bytes;
+        uint8_t* dst_row = state->out + (uint32_t)py * dst_row_bytes;
+
+        uint8_t sx = 0;
+        uint8_t fx = 0;
+        for(uint8_t px = 0; px < dst_w; px++) {
+            if(src_row[sx / 8] & (1 << (sx % 8))) dst_row[px / 8] |= 1 << (px % 8);
+            sx += step_x;
+            fx += rem_x;
+            if(fx >= THUMB_MAX_W) {
+                fx -= THUMB_MAX_W;
+                sx++;
+            }
+        }
+
+        sy += step_y;
+        fy += rem_y;
+        if(fy >= THUMB_MAX_H) {
+            fy -= THUMB_MAX_H;
+            sy++;
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Column table: source byte and mask per output column, computed once
+// per frame size and reused by every row
+// -------------------------------------------------------------------
+static void bench_downscale_table(BenchState* state, const BenchFrame* frame) {
+    uint8_t dst_w = frame->w < THUMB_MAX_W ? frame->w : THUMB_MAX_W;
+    uint8_t dst_h = frame->h < THUMB_MAX_H ? frame->h : THUMB_MAX_H;
+    uint8_t src_row_bytes = (frame->w + 7) / 8;
+    uint8_t dst_row_bytes = (dst_w + 7) / 8;
+    uint8_t column_byte[THUMB_MAX_W];
+    uint8_t column_mask[THUMB_MAX_W];
+
+    for(uint8_t px = 0; px < dst_w; px++) {
+        uint8_t sx = (frame->w > THUMB_MAX_W) ? (uint8_t)(px * frame->w / THUMB_MAX_W) : px;
+        column_byte[px] = sx / 8;
+        column_mask[px] = 1 << (sx % 8);
+    }
+
+    memset(state->out, 0, (size_t)dst_row_bytes * dst_h);
+    for(uint8_t py = 0; py < dst_h; py++) {
+        uint8_t sy = (frame->h > THUMB_MAX_H) ? (uint8_t)(py * frame->h / THUMB_MAX_H) : py;
+        const uint8_t* src_row = frame->bitmap + (uint32_t)sy * src_row_bytes;
+        uint8_t* dst_row = state->out + (uint32_t)py * dst_row_bytes;
+
+        for(uint8_t px = 0; px < dst_w; px++) {
+            if(src_row[column_byte[px]] & column_mask[px]) dst_row[px / 8] |= 1 << (px % 8);
+        }
+    }
+}
+
+static void bench_downscale_kernel(BenchState* state, const BenchFrame* frame) {
+    uint8_t w, h;
+    theme_manager_bitmap_downscale(
+        frame->bitmap, frame->w, frame->h, state->out, THUMB_MAX_W, THUMB_MAX_H, &w, &h);
+}
+
+// ===================================================================
+// draw: into a 128x64 1 bpp screen; the dot is out of line, like
+// canvas_draw_dot
+// ===================================================================
+static void __attribute__((noinline)) bench_dot(BenchState* state, uint8_t x, uint8_t y) {
+    state->screen[y * 16 + x / 8] |= 1 << (x % 8);
+}
+
+// -------------------------------------------------------------------
+// theme_manager_info_draw's preview loop before it drew pre-scaled
+// frames with canvas_draw_xbm
+// -------------------------------------------------------------------
+static void bench_draw_ref(BenchState* state, const BenchFrame* frame) {
+    uint8_t src_w = frame->w;
+    uint8_t src_h = frame->h;
+    uint8_t src_row_bytes = (src_w + 7) / 8;
+
+    uint8_t x_offset = (src_w < BENCH_DRAW_W) ? (BENCH_DRAW_W - src_w) / 2 : 0;
+    uint8_t y_offset = (src_h < BENCH_DRAW_H) ? (BENCH_DRAW_H - src_h) / 2 : 0;
+
+    uint8_t draw_w = (src_w < BENCH_DRAW_W) ? src_w : BENCH_DRAW_W;
+    uint8_t draw_h = (src_h < BENCH_DRAW_H) ? src_h : BENCH_DRAW_H;
+
+    memset(state->screen, 0, sizeof(state->screen));
+    for(uint8_t py = 0; py < draw_h; py++) {
+        uint8_t sy = (src_h > BENCH_DRAW_H) ? (uint8_t)(py * src_h / BENCH_DRAW_H) : py;
+
+        for(uint8_t px = 0; px < draw_w; px++) {
+            uint8_t sx = (src_w > BENCH_DRAW_W) ? (uint8_t)(px * src_w / BENCH_DRAW_W) : px;
+
+            uint32_t byte_idx = (uint32_t)sy * src_row_bytes + sx / 8;
+            if(byte_idx < frame->size) {
+                if(frame->bitmap[byte_idx] & (1 << (sx % 8))) {
+                    bench_dot(state, BENCH_DRAW_X + x_offset + px, BENCH_DRAW_Y + y_offset + py);
+                }
+            }
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Same dots from a column table; rows are always in range, so the
+// bounds check goes too
+// -------------------------------------------------------------------
+static void bench_draw_table(BenchState* state, const BenchFrame* frame) {
+    uint8_t draw_w = (frame->w < BENCH_DRAW_W) ? frame->w : BENCH_DRAW_W;
+    uint8_t draw_h = (frame->h < BENCH_DRAW_H) ? frame->h : BENCH_DRAW_H;
+    uint8_t x = BENCH_DRAW_X + ((frame->w < BENCH_DRAW_W) ? (BENCH_DRAW_W - frame->w) / 2 : 0);
+    uint8_t y = BENCH_DRAW_Y + ((frame->h < BENCH_DRAW_H) ? (BENCH_DRAW_H - frame->h) / 2 : 0);
+    uint8_t src_row_bytes = (frame->w + 7) / 8;
+    uint8_t column_byte[BENCH_DRAW_W];
+    uint8_t column_mask[BENCH_DRAW_W];
+
+    for(uint8_t px = 0; px < draw_w; px++) {
+        uint8_t sx = (frame->w > BENCH_DRAW_W) ? (uint8_t)(px * frame->w / BENCH_DRAW_W) : px;
+        column_byte[px] = sx / 8;
+        column_mask[px] = 1 << (sx % 8);
+    }
+
+    memset(state->screen, 0, sizeof(state->screen));
+    for(uint8_t py = 0; py < draw_h; py++) {
+        uint8_t sy = (frame->h > BENCH_DRAW_H) ? (uint8_t)(py * frame->h / BENCH_DRAW_H) : py;
+        const uint8_t* src_row = frame->bitmap + (uint32_t)sy * src_row_bytes;
+        for(uint8_t px = 0; px < draw_w; px++) {
+            if(src_row[column_byte[px]] & column_mask[px]) bench_dot(state, x + px, y + py);
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Downscale into the box, then one row copy per line, as
+// canvas_draw_xbm does with the preview's frame
+// -------------------------------------------------------------------
+static void bench_draw_xbm(BenchState* state, const BenchFrame* frame) {
+    uint8_t w, h;
+    theme_manager_bitmap_downscale(
+        frame->bitmap, frame->w, frame->h, state->scratch, BENCH_DRAW_W, BENCH_DRAW_H, &w, &h);
+    uint8_t x = BENCH_DRAW_X + (BENCH_DRAW_W - w) / 2;
+    uint8_t y = BENCH_DRAW_Y + (BENCH_DRAW_H - h) / 2;
+    uint8_t row_bytes = (w + 7) / 8;
+    uint8_t shift = x % 8;
+
+    memset(state->screen, 0, sizeof(state->screen));
+    for(uint8_t row = 0; row < h; row++) {
+        const uint8_t* src = state->scratch + (uint32_t)row * row_bytes;
+        uint8_t* dst = state->screen + (uint32_t)(y + row) * 16 + x / 8;
+        for(uint8_t i = 0; i < row_bytes; i++) {
+            uint16_t bits = (uint16_t)src[i] << shift;
+            dst[i] |= bits & 0xFF;
+            if(bits >> 8) dst[i + 1] |= bits >> 8;
+        }
+    }
+}
+
+// ===================================================================
+// equal: a frame against its copy in the raw .bm, as the optimizer's
+// duplicate check and the compressor's round trip see them. Equal
+// frames are the worst case, every byte is read. The host's memcmp is
+// vectorised and wins here; the firmware's newlib one goes a byte at a
+// time when the two are not both word aligned, which raw + 1 never is
+// ===================================================================
+static void bench_equal_memcmp(BenchState* state, const BenchFrame* frame) {
+    state->out[0] = memcmp(frame->bitmap, frame->raw_bm + 1, frame->size) == 0;
+}
+
+static void bench_equal_word(BenchState* state, const BenchFrame* frame) {
+    state->out[0] = theme_manager_bitmap_equal(frame->bitmap, frame->raw_bm + 1, frame->size);
+}
+
+// ===================================================================
+// Runner
+// ===================================================================
+static const BenchImpl bench_impls[] = {
+    {"decode", "packed", "sdk", bench_decode_sdk, NULL, 0, false},
+    {"decode", "packed", "word", bench_decode_word, NULL, 0, false},
+    {"decode", "raw", "copy", bench_decode_copy, NULL, 0, false},
+    {"decode", "raw", "inplace", bench_decode_inplace, bench_decode_inplace_check, 0, false},
+    {"downscale", "", "pixel", bench_downscale_pixel, NULL, THUMB_MAX_SIZE, false},
+    {"downscale", "", "step", bench_downscale_step, NULL, THUMB_MAX_SIZE, false},
+    {"downscale", "", "table", bench_downscale_table, NULL, THUMB_MAX_SIZE, false},
+    {"downscale", "", "kernel", bench_downscale_kernel, NULL, THUMB_MAX_SIZE, false},
+    {"draw", "", "ref", bench_draw_ref, NULL, BENCH_SCREEN_BYTES, true},
+    {"draw", "", "table", bench_draw_table, NULL, BENCH_SCREEN_BYTES, true},
+    {"draw", "", "xbm", bench_draw_xbm, NULL, BENCH_SCREEN_BYTES, true},
+    {"equal", "", "memcmp", bench_equal_memcmp, NULL, 1, false},
+    {"equal", "", "word", bench_equal_word, NULL, 1, false},
+};
+
+/* The first of a kernel/input group is its reference */
+static bool bench_is_reference(size_t i) {
+    return i == 0 || strcmp(bench_impls[i].kernel, bench_impls[i - 1].kernel) != 0 ||
+           strcmp(bench_impls[i].input, bench_impls[i - 1].input) != 0;
+}
+
+// -------------------------------------------------------------------
+// Output of impl i against its group's reference on this frame
+// -------------------------------------------------------------------
+static bool bench_check(BenchState* state, size_t reference, size_t i, const BenchFrame* frame) {
+    const BenchImpl* impl = &bench_impls[i];
+    size_t size = impl->out_size ? impl->out_size : frame->size;
+    uint8_t* out = impl->screen ? state->screen : state->out;
+
+    memset(state->out, 0, sizeof(state->out));
+    bench_impls[reference].run(state, frame);
+    memcpy(state->expected, out, size);
+    /* Decoders have the generated bitmap to match too */
+    if(!impl->out_size && memcmp(state->expected, frame->bitmap, size) != 0) return false;
+
+    memset(state->out, 0, sizeof(state->out));
+    (impl->check ? impl->check : impl->run)(state, frame);
+    return memcmp(state->expected, out, size) == 0;
+}
+
+// -------------------------------------------------------------------
+// Best of BENCH_REPEATS runs, each long enough to last target_ns
+// -------------------------------------------------------------------
+static double
+    bench_time(BenchState* state, BenchKernel run, const BenchFrame* frame, uint64_t target_ns) {
+    uint32_t iterations = 1;
+    while(true) {
+        uint64_t start = bench_now_ns();
+        for(uint32_t i = 0; i < iterations; i++) {
+            run(state, frame);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        if(elapsed >= target_ns / BENCH_REPEATS || iterations >= (1u << 30)) break;
+        iterations *= 2;
+    }
+
+    double best = 0;
+    for(uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        uint64_t start = bench_now_ns();
+        for(uint32_t i = 0; i < iterations; i++) {
+            run(state, frame);
+        }
+        double ns = (double)(bench_now_ns() - start) / iterations;
+        if(repeat == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+static bool bench_selected(const char* kernel, int argc, char** argv) {
+    if(argc == 0) return true;
+    for(int i = 0; i < argc; i++) {
+        if(strcmp(argv[i], kernel) == 0) return true;
+    }
+    return false;
+}
+
+// -------------------------------------------------------------------
+// Representative sizes, one line per implementation. Odd widths have
+// padded rows; 48x32 is the preview box, 128x64 the screen
+// -------------------------------------------------------------------
+static const uint8_t bench_sizes[][2] = {
+    {8, 8},
+    {13, 11},
+    {32, 32},
+    {48, 32},
+    {61, 45},
+    {64, 64},
+    {97, 53},
+    {128, 64},
+};
+
+static bool bench_run_sizes(BenchState* state, uint64_t target_ns, int argc, char** argv) {
+    BenchFrame* frame = malloc(sizeof(BenchFrame));
+    bool ok = true;
+
+    printf("# kernel\tinput\tsize\tcontent\timpl\tns/frame\tbytes/s\tvs ref\n");
+    for(size_t s = 0; ok && s < COUNT_OF(bench_sizes); s++) {
+        for(uint8_t content = 0; ok && content < COUNT_OF(bench_content_names); content++) {
+            bench_frame_make(frame, bench_sizes[s][0], bench_sizes[s][1], content);
+
+            double reference_ns = 0;
+            size_t reference = 0;
+            for(size_t i = 0; ok && i < COUNT_OF(bench_impls); i++) {
+                const BenchImpl* impl = &bench_impls[i];
+                if(bench_is_reference(i)) reference = i;
+                if(!bench_selected(impl->kernel, argc, argv)) continue;
+
+                if(!bench_check(state, reference, i, frame)) {
+                    printf(
+                        "error\t%s %s differs at %ux%u %s\n",
+                        impl->kernel,
+                        impl->impl,
+                        frame->w,
+                        frame->h,
+                        bench_content_names[content]);
+                    ok = false;
+                    break;
+                }
+
+                double ns = bench_time(state, impl->run, frame, target_ns);
+                if(i == reference) reference_ns = ns;
+                printf(
+                    "%s\t%s\t%ux%u\t%s\t%s\t%.1f\t%.0f\t%.2fx\n",
+                    impl->kernel,
+                    impl->input[0] ? impl->input : "-",
+                    frame->w,
+                    frame->h,
+                    bench_content_names[content],
+                    impl->impl,
+                    ns,
+                    frame->size * 1e9 / ns,
+                    reference_ns / ns);
+            }
+        }
+    }
+
+    free(frame);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// --all: every size from 1x1 to 128x64, both contents; one line per
+// implementation with the mean time over all of them
+// -------------------------------------------------------------------
+static bool bench_run_sweep(BenchState* state, uint64_t target_ns, int argc, char** argv) {
+    BenchFrame* frame = malloc(sizeof(BenchFrame));
+    double total_ns[COUNT_OF(bench_impls)] = {0};
+    uint64_t total_bytes = 0;
+    uint32_t frames = 0;
+    bool ok = true;
+
+    for(uint8_t h = 1; ok && h <= 64; h++) {
+        for(uint8_t w = 1; ok && w <= 128; w++) {
+            for(uint8_t content = 0; ok && content < COUNT_OF(bench_content_names); content++) {
+                bench_frame_make(frame, w, h, content);
+                size_t reference = 0;
+                for(size_t i = 0; ok && i < COUNT_OF(bench_impls); i++) {
+                    if(bench_is_reference(i)) reference = i;
+                    if(!bench_selected(bench_impls[i].kernel, argc, argv)) continue;
+                    ok = bench_check(state, reference, i, frame);
+                    if(!ok) {
+                        printf(
+                            "error\t%s %s differs at %ux%u %s\n",
+                            bench_impls[i].kernel,
+                            bench_impls[i].impl,
+                            w,
+                            h,
+                            bench_content_names[content]);
+                        break;
+                    }
+                    total_ns[i] += bench_time(state, bench_impls[i].run, frame, target_ns);
+                }
+                total_bytes += frame->size;
+                frames++;
+            }
+        }
+    }
+
+    if(ok) {
+        printf("# kernel\tinput\tsizes\timpl\tns/frame\tbytes/s\tvs ref\n");
+        size_t reference = 0;
+        for(size_t i = 0; i < COUNT_OF(bench_impls); i++) {
+            if(bench_is_reference(i)) reference = i;
+            if(!bench_selected(bench_impls[i].kernel, argc, argv)) continue;
+            printf(
+                "%s\t%s\tall\t%s\t%.1f\t%.0f\t%.2fx\n",
+                bench_impls[i].kernel,
+                bench_impls[i].input[0] ? bench_impls[i].input : "-",
+                bench_impls[i].impl,
+                total_ns[i] / frames,
+                total_bytes * 1e9 / total_ns[i],
+                total_ns[reference] / total_ns[i]);
+        }
+    }
+
+    free(frame);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t target_us = 0;
+    bool sweep = false;
+    int arg = 1;
+
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            target_us = strtoul(argv[++arg], NULL, 10);
+        } else if(strcmp(argv[arg], "--all") == 0) {
+            sweep = true;
+        } else {
+            fprintf(
+                stderr, "Usage: %s [-t us] [--all] [decode|downscale|draw|equal]...\n", argv[0]);
+            fprintf(
+                stderr,
+                "  -t     time per measurement (default %u us, %u with --all)\n",
+                BENCH_DEFAULT_US,
+                BENCH_SWEEP_US);
+            fprintf(stderr, "  --all  every size up to 128x64, averaged, instead of a table\n");
+            return 2;
+        }
+    }
+    if(target_us == 0) target_us = sweep ? BENCH_SWEEP_US : BENCH_DEFAULT_US;
+
+    BenchState* state = calloc(1, sizeof(BenchState));
+    state->icon = compress_icon_alloc(FRAME_MAX_SIZE);
+    uint64_t target_ns = (uint64_t)target_us * 1000;
+
+    bool ok = sweep ? bench_run_sweep(state, target_ns, argc - arg, &argv[arg]) :
+                      bench_run_sizes(state, target_ns, argc - arg, &argv[arg]);
+
+    compress_icon_free(state->icon);
+    free(state);
+    if(ok) printf("ok\n");
+    return ok ? 0 : 1;
+}
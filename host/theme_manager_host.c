@@ -0,0 +1,931 @@
+#include "../theme_manager_core.h"
+#include "../theme_manager_cache.h"
+
+#include "host_pool.h"
+
+#include <signal.h>
+
+/* theme_manager_host: the theme core on a PC, over an SD card mounted
+ * (or copied) at a directory, or inside an SD card image for the FatFs
+ * build (theme_manager_host_fat). The same sources as the app, so scans,
+ * installs and rewrites follow the same format rules and write the same
+ * bytes; only storage, strings and logging are the host shims.
+ *
+ * Output follows the device's `theme` CLI command: one tab-separated
+ * record per line, then "ok" or "error\t<reason>". Exit status is 0 on
+ * ok. Logs go to stderr with -v. */
+
+#define HOST_APP_ID "theme_manager"
+
+#ifdef HOST_STORAGE_FATFS
+#define HOST_SD_KIND "image"
+#define HOST_SD_HELP "<image> is an SD card image (FAT32 or exFAT), whole card or partition"
+#else
+#define HOST_SD_KIND "dir"
+#define HOST_SD_HELP "<dir> is the root of the SD card (what the device calls /ext)"
+#endif
+
+typedef struct {
+    Storage* storage;
+    char names[MAX_THEMES][MAX_NAME_LEN];
+    ThemeType types[MAX_THEMES];
+    uint32_t count;
+    uint32_t workers; /* batch threads, 0 for one per CPU */
+} HostApp;
+
+typedef int (*HostCommandCallback)(HostApp* app, int argc, char** argv);
+
+typedef struct {
+    const char* name;
+    const char* args;
+    const char* help;
+    int argc; /* arguments after the command */
+    HostCommandCallback callback;
+} HostCommand;
+
+static volatile sig_atomic_t host_interrupted = 0;
+
+static void host_on_signal(int signal) {
+    UNUSED(signal);
+    host_interrupted = 1;
+}
+
+static bool host_stop_callback(void* context) {
+    UNUSED(context);
+    return host_interrupted;
+}
+
+static int host_ok(void) {
+    printf("ok\n");
+    return 0;
+}
+
+static int host_error(const char* reason) {
+    printf("error\t%s\n", reason);
+    return 1;
+}
+
+// -------------------------------------------------------------------
+// Look a theme up in the scanned list
+// -------------------------------------------------------------------
+static bool host_find(HostApp* app, const char* name, ThemeType* out_type) {
+    for(uint32_t i = 0; i < app->count; i++) {
+        if(strcmp(app->names[i], name) == 0) {
+            *out_type = app->types[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// -------------------------------------------------------------------
+// A theme was rewritten in place: drop its index entry, thumbnail and
+// verify result, as the app's jobs do
+// -------------------------------------------------------------------
+static void host_invalidate(HostApp* app, const char* name) {
+    ThemeIndex* index = malloc(sizeof(ThemeIndex));
+    theme_manager_index_load(app->storage, index);
+    theme_manager_index_invalidate(index, name);
+    if(index->dirty) theme_manager_index_save(app->storage, index);
+    free(index);
+
+    theme_manager_thumb_remove(app->storage, name);
+    theme_manager_verify_cache_remove(app->storage, name);
+}
+
+// ===================================================================
+// Commands
+// ===================================================================
+static int host_list(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    UNUSED(argv);
+
+    for(uint32_t i = 0; i < app->count && !host_interrupted; i++) {
+        uint32_t anims = 0;
+        uint64_t size = 0;
+        if(app->types[i] == ThemeTypeSingle) {
+            anims = 1;
+        } else if(app->types[i] != ThemeTypeArchive && app->types[i] != ThemeTypeContainer) {
+            theme_manager_foreach_manifest_anim(
+                app->storage,
+                ANIMATION_PACKS_PATH,
+                app->names[i],
+                app->types[i],
+                NULL,
+                NULL,
+                &anims);
+        }
+        theme_manager_get_theme_size(
+            app->storage,
+            ANIMATION_PACKS_PATH,
+            app->names[i],
+            app->types[i],
+            host_stop_callback,
+            NULL,
+            &size);
+        printf(
+            "%s\t%s\t%lu\t%llu\n",
+            app->names[i],
+            theme_manager_type_name(app->types[i]),
+            anims,
+            (unsigned long long)size);
+    }
+    return host_interrupted ? host_error("cancelled") : host_ok();
+}
+
+static int host_info(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    ThemeType type;
+    if(!host_find(app, argv[0], &type)) return host_error("no such theme");
+
+    uint32_t anims = 0;
+    uint64_t size = 0;
+    if(type == ThemeTypeSingle) {
+        anims = 1;
+    } else if(type == ThemeTypeContainer) {
+        ThemeContainerInfo info;
+        FuriString* path = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, argv[0]);
+        if(theme_manager_container_read_info(
+               app->storage, furi_string_get_cstr(path), &info, NULL)) {
+            anims = info.anim_count;
+        }
+        furi_string_free(path);
+    } else if(type != ThemeTypeArchive) {
+        theme_manager_foreach_manifest_anim(
+            app->storage, ANIMATION_PACKS_PATH, argv[0], type, NULL, NULL, &anims);
+    }
+    theme_manager_get_theme_size(
+        app->storage, ANIMATION_PACKS_PATH, argv[0], type, NULL, NULL, &size);
+
+    printf("name\t%s\n", argv[0]);
+    printf("type\t%s\n", theme_manager_type_name(type));
+    printf("anims\t%lu\n", anims);
+    printf("size\t%llu\n", (unsigned long long)size);
+    return host_ok();
+}
+
+static int host_verify(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    ThemeType type;
+    if(!host_find(app, argv[0], &type)) return host_error("no such theme");
+
+    ThemeVerifyStats stats;
+    FuriString* report = furi_string_alloc();
+    uint32_t stamp;
+    bool ok = theme_manager_theme_stamp(
+                  app->storage,
+                  ANIMATION_PACKS_PATH,
+                  argv[0],
+                  type,
+                  host_stop_callback,
+                  NULL,
+                  &stamp) &&
+              theme_manager_verify_theme(
+                  app->storage,
+                  ANIMATION_PACKS_PATH,
+                  argv[0],
+                  type,
+                  &stats,
+                  report,
+                  NULL,
+                  host_stop_callback,
+                  NULL);
+
+    if(ok) {
+        /* The app shows this result without verifying again */
+        theme_manager_verify_cache_save(app->storage, argv[0], stamp, &stats, report);
+        printf("anims\t%lu\n", stats.anims_checked);
+        printf("anims_bad\t%lu\n", stats.anims_bad);
+        printf("frames\t%lu\n", stats.frames_checked);
+        printf("problems\t%lu\n", stats.errors);
+        furi_string_trim(report, "\n");
+        furi_string_replace_all_str(report, "\n", "\n# ");
+        if(furi_string_size(report)) printf("# %s\n", furi_string_get_cstr(report));
+    }
+
+    furi_string_free(report);
+    return ok ? host_ok() : host_error("cancelled");
+}
+
+static int host_backup(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    UNUSED(argv);
+    return theme_manager_backup_dolphin(app->storage) ? host_ok() : host_error("backup failed");
+}
+
+static int host_apply(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    ThemeType type;
+    if(!host_find(app, argv[0], &type)) return host_error("no such theme");
+    if(type == ThemeTypeArchive) return host_error("bundle: import it first");
+
+    if(!theme_manager_backup_dolphin(app->storage)) return host_error("backup failed");
+    bool ok = theme_manager_install_theme(
+        app->storage, ANIMATION_PACKS_PATH, argv[0], type, DOLPHIN_PATH);
+    return ok ? host_ok() : host_error("install failed");
+}
+
+static int host_restore(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    UNUSED(argv);
+    return theme_manager_restore_backup(app->storage) ? host_ok() : host_error("no backup");
+}
+
+// -------------------------------------------------------------------
+// Optimize a theme, or the installed dolphin with --installed
+// -------------------------------------------------------------------
+static int host_optimize(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    FuriString* pack_dir = furi_string_alloc();
+    bool installed = strcmp(argv[0], "--installed") == 0;
+
+    if(installed) {
+        furi_string_set_str(pack_dir, DOLPHIN_PATH);
+    } else {
+        ThemeType type;
+        if(!host_find(app, argv[0], &type)) {
+            furi_string_free(pack_dir);
+            return host_error("no such theme");
+        }
+        /* Store entries are shared and named by content: leave them alone */
+        if(type == ThemeTypeLibrary || type == ThemeTypeArchive || type == ThemeTypeContainer) {
+            furi_string_free(pack_dir);
+            return host_error("not a folder theme");
+        }
+        theme_manager_get_pack_dir(pack_dir, ANIMATION_PACKS_PATH, argv[0], type);
+    }
+
+    ThemeOptimizeStats stats = {0};
+    bool ok = theme_manager_optimize_pack(
+        app->storage, furi_string_get_cstr(pack_dir), NULL, host_stop_callback, NULL, &stats);
+    furi_string_free(pack_dir);
+    if(!installed) host_invalidate(app, argv[0]);
+
+    printf("anims_changed\t%lu\n", stats.anims_changed);
+    printf("files_removed\t%lu\n", stats.files_removed);
+    printf("bytes_saved\t%llu\n", (unsigned long long)stats.bytes_saved);
+    return ok ? host_ok() : host_error("cancelled");
+}
+
+static void host_print_patch_stats(const ThemePatchStats* stats) {
+    printf("added\t%lu\n", stats->added);
+    printf("changed\t%lu\n", stats->changed);
+    printf("deltas\t%lu\n", stats->deltas);
+    printf("removed\t%lu\n", stats->removed);
+    printf("bytes\t%lu\n", stats->bytes);
+}
+
+// -------------------------------------------------------------------
+// <name>.tpatch next to the themes, taking <name> to <new>
+// -------------------------------------------------------------------
+static int host_patch_create(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    ThemeType type;
+    ThemeType new_type;
+    if(!host_find(app, argv[0], &type) || !host_find(app, argv[1], &new_type)) {
+        return host_error("no such theme");
+    }
+
+    FuriString* old_dir = furi_string_alloc();
+    FuriString* new_dir = furi_string_alloc();
+    FuriString* path =
+        furi_string_alloc_printf("%s/%s%s", ANIMATION_PACKS_PATH, argv[0], PATCH_EXTENSION);
+    ThemePatchStats stats;
+
+    theme_manager_get_pack_dir(old_dir, ANIMATION_PACKS_PATH, argv[0], type);
+    theme_manager_get_pack_dir(new_dir, ANIMATION_PACKS_PATH, argv[1], new_type);
+    bool ok = theme_manager_patch_create(
+        app->storage,
+        furi_string_get_cstr(old_dir),
+        furi_string_get_cstr(new_dir),
+        furi_string_get_cstr(path),
+        &stats);
+
+    if(ok) {
+        printf("patch\t%s\n", furi_string_get_cstr(path));
+        host_print_patch_stats(&stats);
+    }
+
+    furi_string_free(path);
+    furi_string_free(new_dir);
+    furi_string_free(old_dir);
+    return ok ? host_ok() : host_error("patch failed");
+}
+
+// -------------------------------------------------------------------
+// Apply <name>.tpatch as Apply update does: the theme, then the
+// installed copy if it is the same version, then trash the patch
+// -------------------------------------------------------------------
+static int host_patch_apply(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    ThemeType type;
+    if(!host_find(app, argv[0], &type)) return host_error("no such theme");
+
+    FuriString* pack_dir = furi_string_alloc();
+    FuriString* path =
+        furi_string_alloc_printf("%s/%s%s", ANIMATION_PACKS_PATH, argv[0], PATCH_EXTENSION);
+    const char* patch_path = furi_string_get_cstr(path);
+    ThemePatchStats stats;
+    bool checked = false;
+    bool ok = false;
+    bool installed = false;
+    bool installed_ok = true;
+
+    theme_manager_get_pack_dir(pack_dir, ANIMATION_PACKS_PATH, argv[0], type);
+    checked =
+        theme_manager_patch_check(app->storage, patch_path, furi_string_get_cstr(pack_dir));
+    if(checked) {
+        installed = type != ThemeTypeSingle &&
+                    theme_manager_patch_check(app->storage, patch_path, DOLPHIN_PATH);
+        ok = theme_manager_patch_apply(
+            app->storage, patch_path, furi_string_get_cstr(pack_dir), &stats);
+        if(ok && installed) {
+            ThemePatchStats installed_stats;
+            installed_ok = theme_manager_patch_apply(
+                app->storage, patch_path, DOLPHIN_PATH, &installed_stats);
+        }
+    }
+    if(checked) host_invalidate(app, argv[0]);
+    if(ok) {
+        theme_manager_trash_move(app->storage, patch_path);
+        host_print_patch_stats(&stats);
+        const char* state = "skipped";
+        if(installed) state = installed_ok ? "updated" : "failed";
+        printf("installed\t%s\n", state);
+    }
+
+    furi_string_free(path);
+    furi_string_free(pack_dir);
+    if(!checked) return host_error("patch doesn't match");
+    if(!ok) return host_error("patch failed part way, the theme needs restoring");
+    if(!installed_ok) return host_error("installed copy half patched, apply the theme again");
+    return host_ok();
+}
+
+// ===================================================================
+// Precompute: warm the app's caches from the PC
+// ===================================================================
+/* One theme's derived data, computed on a pool thread. known is the
+ * card's index entry (flags 0 if none): what it already has is skipped */
+typedef struct {
+    HostApp* app;
+    uint32_t theme;
+    const ThemeCostModel* model;
+    ThemeIndexEntry known;
+    ThemeIndexEntry entry;
+    bool verify_cached;
+    bool verified;
+    ThemeVerifyStats verify;
+    uint32_t ms;
+} HostPrecompute;
+
+// -------------------------------------------------------------------
+// Everything the idle pass would compute for one theme, in its order
+// (index, sizes, thumbs, cost), plus the verify result the info
+// screen's Verify action shows without running again
+// -------------------------------------------------------------------
+static void host_precompute_run(void* context) {
+    HostPrecompute* job = context;
+    Storage* storage = job->app->storage;
+    const char* name = job->app->names[job->theme];
+    ThemeType type = job->app->types[job->theme];
+    ThemeIndexEntry* entry = &job->entry;
+    uint32_t start = furi_get_tick();
+
+    *entry = job->known;
+    strncpy(entry->name, name, MAX_NAME_LEN - 1);
+    if(!theme_manager_theme_stamp(
+           storage, ANIMATION_PACKS_PATH, name, type, host_stop_callback, NULL, &entry->stamp)) {
+        return;
+    }
+    if(entry->stamp != job->known.stamp) {
+        entry->anim_count = 0;
+        entry->size = 0;
+        entry->load_ms = 0;
+        entry->flags = 0;
+    }
+    if(host_interrupted) return;
+
+    FuriString* path = furi_string_alloc();
+    if(!(entry->flags & ThemeIndexHasCount)) {
+        if(theme_manager_get_manifest_path(path, ANIMATION_PACKS_PATH, name, type)) {
+            theme_manager_parse_manifest(storage, furi_string_get_cstr(path), &entry->anim_count);
+        } else if(type == ThemeTypeSingle) {
+            entry->anim_count = 1;
+        } else if(type == ThemeTypeContainer) {
+            ThemeContainerInfo container;
+            furi_string_printf(path, "%s/%s", ANIMATION_PACKS_PATH, name);
+            if(theme_manager_container_read_info(
+                   storage, furi_string_get_cstr(path), &container, NULL)) {
+                entry->anim_count = container.anim_count;
+            }
+        }
+        entry->flags |= ThemeIndexHasCount;
+    }
+    furi_string_free(path);
+
+    if(!(entry->flags & ThemeIndexHasSize) &&
+       theme_manager_get_theme_size(
+           storage, ANIMATION_PACKS_PATH, name, type, host_stop_callback, NULL, &entry->size)) {
+        entry->flags |= ThemeIndexHasSize;
+    }
+
+    if(!(entry->flags & ThemeIndexHasThumb) &&
+       theme_manager_thumb_build(
+           storage, ANIMATION_PACKS_PATH, name, type, entry->stamp, host_stop_callback, NULL)) {
+        entry->flags |= ThemeIndexHasThumb;
+    }
+
+    /* Bundles and containers have no frame files to load or check */
+    bool frames = type != ThemeTypeArchive && type != ThemeTypeContainer;
+    if(frames && !(entry->flags & ThemeIndexHasCost)) {
+        ThemePackCost cost;
+        if(theme_manager_cost_estimate(
+               storage,
+               ANIMATION_PACKS_PATH,
+               name,
+               type,
+               job->model,
+               &cost,
+               NULL,
+               NULL,
+               host_stop_callback,
+               NULL)) {
+            entry->load_ms = cost.max_ms;
+            if(cost.heavy_anims) entry->flags |= ThemeIndexCostHeavy;
+            entry->flags |= ThemeIndexHasCost;
+        }
+    }
+
+    if(frames) {
+        FuriString* report = furi_string_alloc();
+        job->verify_cached =
+            theme_manager_verify_cache_load(storage, name, entry->stamp, &job->verify, report);
+        if(!job->verify_cached) {
+            furi_string_reset(report);
+            job->verified = theme_manager_verify_theme(
+                storage,
+                ANIMATION_PACKS_PATH,
+                name,
+                type,
+                &job->verify,
+                report,
+                NULL,
+                host_stop_callback,
+                NULL);
+            if(job->verified) {
+                theme_manager_verify_cache_save(storage, name, entry->stamp, &job->verify, report);
+            }
+        }
+        furi_string_free(report);
+    }
+
+    job->ms = furi_get_tick() - start;
+}
+
+// -------------------------------------------------------------------
+// Every theme on the pool, then one index write with all of them.
+// Report: name, anims, size, load ms, thumb, problems (- if not
+// verifiable, "cached" if it already was), ms
+// -------------------------------------------------------------------
+static int host_precompute(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    UNUSED(argv);
+
+    ThemeIndex* index = malloc(sizeof(ThemeIndex));
+    ThemeCostModel model;
+    HostPrecompute* jobs = calloc(app->count ? app->count : 1, sizeof(HostPrecompute));
+    theme_manager_index_load(app->storage, index);
+    theme_manager_cost_load_model(app->storage, &model);
+    storage_simply_mkdir(app->storage, THEME_THUMBS_DIR);
+    storage_simply_mkdir(app->storage, VERIFY_CACHE_DIR);
+
+    uint32_t start = furi_get_tick();
+    HostPool* pool = host_pool_alloc(app->workers);
+    for(uint32_t i = 0; i < app->count; i++) {
+        jobs[i] = (HostPrecompute){.app = app, .theme = i, .model = &model};
+        ThemeIndexEntry* known = theme_manager_index_find(index, app->names[i]);
+        if(known) jobs[i].known = *known;
+        host_pool_submit(pool, host_precompute_run, &jobs[i]);
+    }
+    host_pool_wait(pool);
+    uint32_t workers = host_pool_get_workers(pool);
+    host_pool_free(pool);
+    uint32_t ms = furi_get_tick() - start;
+
+    theme_manager_index_prune(index, app->names, app->count);
+    for(uint32_t i = 0; i < app->count && !host_interrupted; i++) {
+        const ThemeIndexEntry* result = &jobs[i].entry;
+        ThemeIndexEntry* entry = theme_manager_index_update(index, app->names[i], result->stamp);
+        if(entry && memcmp(entry, result, sizeof(ThemeIndexEntry)) != 0) {
+            *entry = *result;
+            index->dirty = true;
+        }
+
+        char problems[16] = "-";
+        if(jobs[i].verify_cached) {
+            snprintf(problems, sizeof(problems), "cached");
+        } else if(jobs[i].verified) {
+            snprintf(problems, sizeof(problems), "%lu", jobs[i].verify.errors);
+        }
+        printf(
+            "%s\t%lu\t%llu\t%lu\t%s\t%s\t%lu\n",
+            app->names[i],
+            result->anim_count,
+            (unsigned long long)result->size,
+            result->load_ms,
+            (result->flags & ThemeIndexHasThumb) ? "thumb" : "-",
+            problems,
+            jobs[i].ms);
+    }
+
+    bool saved = host_interrupted || !index->dirty ||
+                 theme_manager_index_save(app->storage, index);
+    if(!host_interrupted) {
+        printf("themes\t%lu\n", app->count);
+        printf("workers\t%lu\n", workers);
+        printf("ms\t%lu\n", ms);
+    }
+
+    free(jobs);
+    free(index);
+    if(host_interrupted) return host_error("cancelled");
+    return saved ? host_ok() : host_error("can't write index");
+}
+
+// ===================================================================
+// Batch: provision many cards at once
+// ===================================================================
+#define HOST_BATCH_LINE_MAX 1024
+
+/* One installed theme held in memory, in walk order so each folder
+ * comes before what it holds. Paths are relative to the dolphin folder */
+typedef struct {
+    char* path;
+    bool is_dir;
+    uint8_t* data;
+    size_t size;
+} HostTreeEntry;
+
+typedef struct {
+    char name[MAX_NAME_LEN];
+    HostTreeEntry* entries;
+    size_t count;
+    size_t capacity;
+    size_t bytes;
+} HostTree;
+
+typedef struct {
+    char* target;
+    HostTree* tree;
+    const char* error; /* NULL once provisioned */
+    uint32_t ms;
+} HostJob;
+
+static HostTreeEntry* host_tree_add(HostTree* tree, const char* path, bool is_dir) {
+    if(tree->count == tree->capacity) {
+        tree->capacity = tree->capacity ? tree->capacity * 2 : 64;
+        tree->entries = realloc(tree->entries, tree->capacity * sizeof(HostTreeEntry));
+    }
+    HostTreeEntry* entry = &tree->entries[tree->count++];
+    *entry = (HostTreeEntry){.path = strdup(path), .is_dir = is_dir};
+    return entry;
+}
+
+static void host_tree_free(HostTree* tree) {
+    for(size_t i = 0; i < tree->count; i++) {
+        free(tree->entries[i].path);
+        free(tree->entries[i].data);
+    }
+    free(tree->entries);
+}
+
+// -------------------------------------------------------------------
+// Read <root>/<rel> and everything under it into the tree
+// -------------------------------------------------------------------
+static bool host_tree_load(Storage* storage, const char* root, const char* rel, HostTree* tree) {
+    FuriString* path = furi_string_alloc_printf("%s%s%s", root, rel[0] ? "/" : "", rel);
+    FuriString* child = furi_string_alloc();
+    File* dir = storage_file_alloc(storage);
+    File* file = storage_file_alloc(storage);
+    char name[MAX_NAME_LEN * 2];
+    FileInfo info;
+
+    bool ok = storage_dir_open(dir, furi_string_get_cstr(path));
+    while(ok && storage_dir_read(dir, &info, name, sizeof(name))) {
+        furi_string_printf(child, "%s%s%s", rel, rel[0] ? "/" : "", name);
+        if(info.flags & FSF_DIRECTORY) {
+            host_tree_add(tree, furi_string_get_cstr(child), true);
+            ok = host_tree_load(storage, root, furi_string_get_cstr(child), tree);
+            continue;
+        }
+
+        HostTreeEntry* entry = host_tree_add(tree, furi_string_get_cstr(child), false);
+        furi_string_printf(child, "%s/%s", furi_string_get_cstr(path), name);
+        ok = storage_file_open(
+            file, furi_string_get_cstr(child), FSAM_READ, FSOM_OPEN_EXISTING);
+        if(ok) {
+            entry->size = storage_file_size(file);
+            entry->data = malloc(entry->size ? entry->size : 1);
+            ok = storage_file_read(file, entry->data, entry->size) == entry->size;
+            tree->bytes += entry->size;
+        }
+        storage_file_close(file);
+    }
+
+    storage_dir_close(dir);
+    storage_file_free(file);
+    storage_file_free(dir);
+    furi_string_free(child);
+    furi_string_free(path);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Install the theme once into a staging folder on the library card,
+// keep the result in memory and drop the folder. Every job installing
+// this theme then writes the same bytes without touching the library
+// -------------------------------------------------------------------
+static bool host_tree_stage(HostApp* app, const char* name, uint32_t index, HostTree* tree) {
+    ThemeType type;
+    if(!host_find(app, name, &type) || type == ThemeTypeArchive) return false;
+    snprintf(tree->name, sizeof(tree->name), "%s", name);
+
+    FuriString* stage = furi_string_alloc_printf("%s/%lu", APP_DATA_PATH("stage"), index);
+    const char* stage_dir = furi_string_get_cstr(stage);
+    storage_simply_mkdir(app->storage, APP_DATA_PATH("stage"));
+    storage_simply_remove_recursive(app->storage, stage_dir);
+
+    bool ok =
+        theme_manager_install_theme(app->storage, ANIMATION_PACKS_PATH, name, type, stage_dir) &&
+        host_tree_load(app->storage, stage_dir, "", tree);
+
+    storage_simply_remove_recursive(app->storage, stage_dir);
+    storage_simply_remove(app->storage, APP_DATA_PATH("stage"));
+    furi_string_free(stage);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// One card: back up its dolphin folder, then write the staged theme
+// -------------------------------------------------------------------
+static const char* host_job_provision(Storage* storage, const HostTree* tree) {
+    storage_simply_mkdir(storage, EXT_PATH("apps_data"));
+    storage_simply_mkdir(storage, APP_DATA_PATH(""));
+    if(!theme_manager_backup_dolphin(storage)) return "backup failed";
+
+    FuriString* path = furi_string_alloc();
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_simply_mkdir(storage, DOLPHIN_PATH);
+
+    for(size_t i = 0; ok && i < tree->count; i++) {
+        const HostTreeEntry* entry = &tree->entries[i];
+        furi_string_printf(path, "%s/%s", DOLPHIN_PATH, entry->path);
+        if(entry->is_dir) {
+            ok = storage_simply_mkdir(storage, furi_string_get_cstr(path));
+            continue;
+        }
+        ok = storage_file_open(
+                 file, furi_string_get_cstr(path), FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+             storage_file_write(file, entry->data, entry->size) == entry->size;
+        storage_file_close(file);
+        if(host_interrupted) break;
+    }
+
+    storage_file_free(file);
+    furi_string_free(path);
+    if(host_interrupted) return "cancelled";
+    return ok ? NULL : "write failed";
+}
+
+static void host_job_run(void* context) {
+    HostJob* job = context;
+    uint32_t start = furi_get_tick();
+
+    if(host_interrupted) {
+        job->error = "cancelled";
+        return;
+    }
+
+    Storage* storage = storage_host_open(job->target, HOST_APP_ID);
+    if(storage) {
+        job->error = host_job_provision(storage, job->tree);
+        storage_host_close(storage);
+    } else {
+        job->error = "can't open " HOST_SD_KIND;
+    }
+    job->ms = furi_get_tick() - start;
+}
+
+// -------------------------------------------------------------------
+// <target>\t<theme> per line; blank lines and # comments are skipped.
+// Each theme is staged once however many targets it goes to
+// -------------------------------------------------------------------
+static bool host_batch_parse(
+    HostApp* app,
+    FILE* list,
+    HostJob** out_jobs,
+    size_t* out_count,
+    HostTree** out_trees,
+    size_t* out_tree_count,
+    FuriString* error) {
+    HostJob* jobs = NULL;
+    HostTree* trees = calloc(app->count, sizeof(HostTree));
+    size_t count = 0;
+    size_t tree_count = 0;
+    char line[HOST_BATCH_LINE_MAX];
+    bool ok = true;
+
+    for(uint32_t number = 1; ok && fgets(line, sizeof(line), list); number++) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if(line[0] == '\0' || line[0] == '#') continue;
+
+        char* theme = strchr(line, '\t');
+        if(!theme) {
+            furi_string_printf(error, "line %lu: expected <target>\\t<theme>", number);
+            ok = false;
+            break;
+        }
+        *theme++ = '\0';
+
+        for(size_t i = 0; i < count; i++) {
+            if(strcmp(jobs[i].target, line) == 0) {
+                furi_string_printf(error, "line %lu: %s listed twice", number, line);
+                ok = false;
+            }
+        }
+
+        HostTree* tree = NULL;
+        for(size_t i = 0; ok && i < tree_count && !tree; i++) {
+            if(strcmp(trees[i].name, theme) == 0) tree = &trees[i];
+        }
+        if(ok && !tree) {
+            /* Every distinct theme is in the scanned list, so there's room */
+            tree = tree_count < app->count ? &trees[tree_count++] : NULL;
+            if(!tree || !host_tree_stage(app, theme, tree_count - 1, tree)) {
+                furi_string_printf(error, "line %lu: can't stage %s", number, theme);
+                ok = false;
+            }
+        }
+        if(!ok) break;
+
+        jobs = realloc(jobs, (count + 1) * sizeof(HostJob));
+        jobs[count++] = (HostJob){.target = strdup(line), .tree = tree};
+    }
+
+    *out_jobs = jobs;
+    *out_count = count;
+    *out_trees = trees;
+    *out_tree_count = tree_count;
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Run a job list on the pool, report per job in list order, then totals
+// -------------------------------------------------------------------
+static int host_batch(HostApp* app, int argc, char** argv) {
+    UNUSED(argc);
+    FILE* list = strcmp(argv[0], "-") == 0 ? stdin : fopen(argv[0], "r");
+    if(!list) return host_error("can't open job list");
+
+    HostJob* jobs;
+    HostTree* trees;
+    size_t count;
+    size_t tree_count;
+    FuriString* error = furi_string_alloc();
+    bool ok = host_batch_parse(app, list, &jobs, &count, &trees, &tree_count, error);
+    if(list != stdin) fclose(list);
+
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    if(ok) {
+        uint32_t start = furi_get_tick();
+        HostPool* pool = host_pool_alloc(app->workers);
+        for(size_t i = 0; i < count; i++) {
+            host_pool_submit(pool, host_job_run, &jobs[i]);
+        }
+        host_pool_wait(pool);
+        uint32_t workers = host_pool_get_workers(pool);
+        host_pool_free(pool);
+        uint32_t ms = furi_get_tick() - start;
+
+        for(size_t i = 0; i < count; i++) {
+            printf(
+                "%s\t%s\t%s\t%lu\n",
+                jobs[i].target,
+                jobs[i].tree->name,
+                jobs[i].error ? jobs[i].error : "ok",
+                jobs[i].ms);
+            if(jobs[i].error) {
+                failed++;
+            } else {
+                bytes += jobs[i].tree->bytes;
+            }
+        }
+        printf("jobs\t%lu\n", (uint32_t)count);
+        printf("failed\t%lu\n", (uint32_t)failed);
+        printf("workers\t%lu\n", workers);
+        printf("bytes\t%llu\n", (unsigned long long)bytes);
+        printf("ms\t%lu\n", ms);
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        free(jobs[i].target);
+    }
+    for(size_t i = 0; i < tree_count; i++) {
+        host_tree_free(&trees[i]);
+    }
+    free(jobs);
+    free(trees);
+
+    int status;
+    if(!ok) {
+        status = host_error(furi_string_get_cstr(error));
+    } else if(host_interrupted) {
+        status = host_error("cancelled");
+    } else {
+        status = failed ? host_error("some jobs failed") : host_ok();
+    }
+    furi_string_free(error);
+    return status;
+}
+
+static const HostCommand host_commands[] = {
+    {"list", "", "themes: name, type, anims, size", 0, host_list},
+    {"info", "<name>", "type, animations and size of one theme", 1, host_info},
+    {"verify", "<name>", "decode every frame, report problems", 1, host_verify},
+    {"apply", "<name>", "back up the dolphin folder, then install", 1, host_apply},
+    {"backup", "", "move the dolphin folder to the backup", 0, host_backup},
+    {"restore", "", "put the backup back", 0, host_restore},
+    {"optimize", "<name|--installed>", "drop duplicate and unused frames", 1, host_optimize},
+    {"patch-create", "<name> <new>", "write <name>.tpatch updating name to new", 2,
+     host_patch_create},
+    {"patch-apply", "<name>", "apply <name>.tpatch to the theme and the installed copy", 1,
+     host_patch_apply},
+    {"precompute", "", "index, thumbnails, load cost and verify for the app", 0,
+     host_precompute},
+    {"batch", "<jobs|->", "install themes onto many cards in parallel", 1, host_batch},
+};
+
+static void host_print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-v] [-j N] --sd <%s> <cmd> <args>\n", program, HOST_SD_KIND);
+    fprintf(stderr, "  " HOST_SD_HELP "\n");
+    fprintf(
+        stderr, "  batch reads <target>\\t<theme> lines, targets being %ss too;\n", HOST_SD_KIND);
+    fprintf(stderr, "  -j sets its worker threads (default: one per CPU)\n");
+    fprintf(stderr, "Cmd list:\n");
+    for(size_t i = 0; i < COUNT_OF(host_commands); i++) {
+        fprintf(
+            stderr,
+            "  %-13s %-19s %s\n",
+            host_commands[i].name,
+            host_commands[i].args,
+            host_commands[i].help);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* sd = NULL;
+    uint32_t workers = 0;
+    int arg = 1;
+
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(strcmp(argv[arg], "-v") == 0) {
+            furi_log_set_level(FuriLogLevelInfo);
+        } else if(strcmp(argv[arg], "--sd") == 0 && arg + 1 < argc) {
+            sd = argv[++arg];
+        } else if(strcmp(argv[arg], "-j") == 0 && arg + 1 < argc) {
+            workers = strtoul(argv[++arg], NULL, 10);
+        } else {
+            break;
+        }
+    }
+
+    const HostCommand* command = NULL;
+    for(size_t i = 0; arg < argc && i < COUNT_OF(host_commands); i++) {
+        if(strcmp(argv[arg], host_commands[i].name) == 0) command = &host_commands[i];
+    }
+    if(!sd || !command || argc - arg - 1 != command->argc) {
+        host_print_usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, host_on_signal);
+    signal(SIGTERM, host_on_signal);
+    if(!storage_host_mount(sd, HOST_APP_ID)) return host_error("can't open " HOST_SD_KIND);
+
+    HostApp* app = calloc(1, sizeof(HostApp));
+    app->workers = workers;
+    app->storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_mkdir(app->storage, EXT_PATH("apps_data"));
+    storage_simply_mkdir(app->storage, APP_DATA_PATH(""));
+    app->count = theme_manager_scan_dir(
+        app->storage, ANIMATION_PACKS_PATH, app->names, app->types, MAX_THEMES);
+
+    int status = command->callback(app, argc - arg - 1, &argv[arg + 1]);
+
+    furi_record_close(RECORD_STORAGE);
+    free(app);
+    storage_host_unmount();
+    return status;
+}
@@ -0,0 +1,20 @@
+#include "../theme_manager_plugin.h"
+
+#include <flipper_application/flipper_application.h>
+
+/* Theme bundles: .tar / .tar.heatshrink import and export */
+
+static const ThemeArchivePlugin archive_plugin = {
+    .import = theme_manager_archive_import,
+    .export = theme_manager_archive_export,
+};
+
+static const FlipperAppPluginDescriptor plugin_descriptor = {
+    .appid = THEME_MANAGER_PLUGIN_APP_ID,
+    .ep_api_version = THEME_MANAGER_PLUGIN_API_VERSION,
+    .entry_point = &archive_plugin,
+};
+
+const FlipperAppPluginDescriptor* theme_manager_archive_plugin_ep(void) {
+    return &plugin_descriptor;
+}
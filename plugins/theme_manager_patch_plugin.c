@@ -0,0 +1,21 @@
+#include "../theme_manager_plugin.h"
+
+#include <flipper_application/flipper_application.h>
+
+/* Theme update patches (.tpatch) */
+
+static const ThemePatchPlugin patch_plugin = {
+    .create = theme_manager_patch_create,
+    .check = theme_manager_patch_check,
+    .apply = theme_manager_patch_apply,
+};
+
+static const FlipperAppPluginDescriptor plugin_descriptor = {
+    .appid = THEME_MANAGER_PLUGIN_APP_ID,
+    .ep_api_version = THEME_MANAGER_PLUGIN_API_VERSION,
+    .entry_point = &patch_plugin,
+};
+
+const FlipperAppPluginDescriptor* theme_manager_patch_plugin_ep(void) {
+    return &plugin_descriptor;
+}
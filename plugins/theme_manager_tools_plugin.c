@@ -0,0 +1,21 @@
+#include "../theme_manager_plugin.h"
+
+#include <flipper_application/flipper_application.h>
+
+/* Pack rewriting: frame dedup and heatshrink recompression */
+
+static const ThemeToolsPlugin tools_plugin = {
+    .optimize_pack = theme_manager_optimize_pack,
+    .compress_tune = theme_manager_compress_tune,
+    .compress_pack = theme_manager_compress_pack,
+};
+
+static const FlipperAppPluginDescriptor plugin_descriptor = {
+    .appid = THEME_MANAGER_PLUGIN_APP_ID,
+    .ep_api_version = THEME_MANAGER_PLUGIN_API_VERSION,
+    .entry_point = &tools_plugin,
+};
+
+const FlipperAppPluginDescriptor* theme_manager_tools_plugin_ep(void) {
+    return &plugin_descriptor;
+}
@@ -0,0 +1,19 @@
+#include "../theme_manager_plugin.h"
+
+#include <flipper_application/flipper_application.h>
+
+/* Pack validator */
+
+static const ThemeVerifyPlugin verify_plugin = {
+    .verify_theme = theme_manager_verify_theme,
+};
+
+static const FlipperAppPluginDescriptor plugin_descriptor = {
+    .appid = THEME_MANAGER_PLUGIN_APP_ID,
+    .ep_api_version = THEME_MANAGER_PLUGIN_API_VERSION,
+    .entry_point = &verify_plugin,
+};
+
+const FlipperAppPluginDescriptor* theme_manager_verify_plugin_ep(void) {
+    return &plugin_descriptor;
+}
@@ -1,726 +1,62 @@
-#include <furi.h>
-#include <furi_hal.h>
-#include <gui/gui.h>
-#include <gui/view_dispatcher.h>
-#include <gui/modules/submenu.h>
-#include <gui/modules/dialog_ex.h>
-#include <gui/modules/popup.h>
-#include <gui/modules/loading.h>
-#include <gui/view.h>
-#include <storage/storage.h>
-#include <toolbox/compress.h>
-
-#define TAG "ThemeManager"
-
-/* Paths — override at compile time for custom firmwares:
- *   ufbt CFLAGS='-DCUSTOM_ANIMATION_PACKS_PATH=EXT_PATH("my_anims")' */
-#ifndef CUSTOM_ANIMATION_PACKS_PATH
-#define ANIMATION_PACKS_PATH EXT_PATH("animation_packs")
-#else
-#define ANIMATION_PACKS_PATH CUSTOM_ANIMATION_PACKS_PATH
-#endif
-
-#ifndef CUSTOM_DOLPHIN_PATH
-#define DOLPHIN_PATH EXT_PATH("dolphin")
-#else
-#define DOLPHIN_PATH CUSTOM_DOLPHIN_PATH
-#endif
-
-#define MANIFEST_FILENAME   "manifest.txt"
-#define META_FILENAME       "meta.txt"
-#define ANIMS_DIRNAME       "Anims"
-#define DOLPHIN_MANIFEST    DOLPHIN_PATH "/" MANIFEST_FILENAME
-#define DOLPHIN_BACKUP_PATH EXT_PATH("dolphin_backup")
-#define MANIFEST_HEADER     "Filetype: Flipper Animation Manifest"
-
-#define MAX_THEMES    64
-#define MAX_NAME_LEN  64
-#define MAX_LABEL_LEN 32
-
-#define MENU_INDEX_RESTORE (MAX_THEMES + 1)
-
-#define PREVIEW_MAX_BM_SIZE 2048 /* max .bm file size (compressed or raw) */
-#define PREVIEW_DRAW_X      2
-#define PREVIEW_DRAW_Y      2
-#define PREVIEW_DRAW_W      48
-#define PREVIEW_DRAW_H      32
-
-typedef enum {
-    ThemeTypePack,
-    ThemeTypeAnimsPack,
-    ThemeTypeSingle,
-} ThemeType;
-
-typedef enum {
-    ThemeManagerViewSubmenu,
-    ThemeManagerViewInfo,
-    ThemeManagerViewConfirm,
-    ThemeManagerViewReboot,
-    ThemeManagerViewDeleteConfirm,
-    ThemeManagerViewPopup,
-    ThemeManagerViewLoading,
-} ThemeManagerView;
-
-typedef struct {
-    char name[MAX_NAME_LEN];
-    char type_label[16];
-    uint32_t anim_count;
-    char size_str[16];
-
-    uint8_t* frame_data;
-    uint32_t frame_size;
-    uint8_t frame_w;
-    uint8_t frame_h;
-    bool preview_loaded;
-} InfoViewModel;
-
-typedef struct {
-    Storage* storage;
-    Gui* gui;
-
-    ViewDispatcher* view_dispatcher;
-    Submenu* submenu;
-    View* info_view;
-    DialogEx* confirm_dialog;
-    DialogEx* reboot_dialog;
-    DialogEx* delete_dialog;
-    Popup* popup;
-    Loading* loading;
-
-    char theme_names[MAX_THEMES][MAX_NAME_LEN];
-    char menu_labels[MAX_THEMES][MAX_LABEL_LEN];
-    ThemeType theme_types[MAX_THEMES];
-    uint32_t theme_count;
-    uint32_t selected_index;
-    bool has_backup;
-
-    FuriString* dialog_text;
-} ThemeManagerApp;
+#include "theme_manager_i.h"
 
 static void theme_manager_scan_themes(ThemeManagerApp* app);
-static bool theme_manager_apply_pack(ThemeManagerApp* app, const char* merge_src_dir);
-static bool theme_manager_apply_single(ThemeManagerApp* app, const char* theme_name);
-static bool theme_manager_restore_backup(ThemeManagerApp* app);
-static bool theme_manager_backup_dolphin(ThemeManagerApp* app);
-static bool
-    theme_manager_parse_manifest(ThemeManagerApp* app, const char* path, uint32_t* out_count);
 
 static void theme_manager_submenu_callback(void* context, uint32_t index);
 static void theme_manager_confirm_callback(DialogExResult result, void* context);
 static void theme_manager_reboot_callback(DialogExResult result, void* context);
 static void theme_manager_delete_callback(DialogExResult result, void* context);
 static void theme_manager_popup_callback(void* context);
-static void theme_manager_show_error(ThemeManagerApp* app, const char* message);
 static void theme_manager_show_info(ThemeManagerApp* app, uint32_t index);
-static bool theme_manager_delete_theme(ThemeManagerApp* app, uint32_t index);
 static void theme_manager_populate_submenu(ThemeManagerApp* app);
 
 static void theme_manager_info_draw(Canvas* canvas, void* model);
 static bool theme_manager_info_input(InputEvent* event, void* context);
+static void theme_manager_info_enter(void* context);
+static void theme_manager_info_exit(void* context);
 
 static uint32_t theme_manager_nav_exit(void* context);
 static uint32_t theme_manager_nav_submenu(void* context);
 
-// -------------------------------------------------------------------
-// Parse manifest.txt — validate header and count "Name:" entries
-// Returns true if manifest is valid, writes animation count to *out_count
-// -------------------------------------------------------------------
-static bool
-    theme_manager_parse_manifest(ThemeManagerApp* app, const char* path, uint32_t* out_count) {
-    *out_count = 0;
-
-    File* file = storage_file_alloc(app->storage);
-    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
-        storage_file_free(file);
-        return false;
-    }
-
-    FuriString* accum = furi_string_alloc();
-    char buf[128];
-    uint16_t bytes_read;
-
-    while((bytes_read = storage_file_read(file, buf, sizeof(buf) - 1)) > 0) {
-        buf[bytes_read] = '\0';
-        furi_string_cat_str(accum, buf);
-    }
-
-    storage_file_close(file);
-    storage_file_free(file);
-
-    const char* str = furi_string_get_cstr(accum);
-
-    if(strstr(str, MANIFEST_HEADER) == NULL) {
-        furi_string_free(accum);
-        return false;
-    }
-
-    const char* ptr = str;
-    while((ptr = strstr(ptr, "Name:")) != NULL) {
-        if(ptr == str || *(ptr - 1) == '\n') {
-            (*out_count)++;
-        }
-        ptr += 5;
-    }
-
-    furi_string_free(accum);
-    return true;
-}
-
-// -------------------------------------------------------------------
-// Parse meta.txt — extract Width and Height values
-// Returns true if both dimensions found
-// -------------------------------------------------------------------
-static bool theme_manager_parse_meta_dimensions(
-    ThemeManagerApp* app,
-    const char* path,
-    uint8_t* out_w,
-    uint8_t* out_h) {
-    *out_w = 0;
-    *out_h = 0;
-
-    File* file = storage_file_alloc(app->storage);
-    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
-        storage_file_free(file);
-        return false;
-    }
-
-    FuriString* accum = furi_string_alloc();
-    char buf[128];
-    uint16_t bytes_read;
-
-    while((bytes_read = storage_file_read(file, buf, sizeof(buf) - 1)) > 0) {
-        buf[bytes_read] = '\0';
-        furi_string_cat_str(accum, buf);
-    }
-
-    storage_file_close(file);
-    storage_file_free(file);
-
-    const char* text = furi_string_get_cstr(accum);
-    bool found_w = false;
-    bool found_h = false;
-
-    const char* w_ptr = strstr(text, "Width:");
-    if(w_ptr) {
-        uint32_t val = 0;
-        if(sscanf(w_ptr, "Width: %lu", &val) == 1 && val > 0 && val <= 128) {
-            *out_w = (uint8_t)val;
-            found_w = true;
-        }
-    }
-
-    const char* h_ptr = strstr(text, "Height:");
-    if(h_ptr) {
-        uint32_t val = 0;
-        if(sscanf(h_ptr, "Height: %lu", &val) == 1 && val > 0 && val <= 64) {
-            *out_h = (uint8_t)val;
-            found_h = true;
-        }
-    }
-
-    furi_string_free(accum);
-    return found_w && found_h;
-}
-
-// -------------------------------------------------------------------
-// Get the first animation name from manifest.txt
-// Returns true if found, writes name to out_name
-// -------------------------------------------------------------------
-static bool theme_manager_get_first_anim_name(
-    ThemeManagerApp* app,
-    const char* manifest_path,
-    char* out_name,
-    size_t out_name_size) {
-    File* file = storage_file_alloc(app->storage);
-    if(!storage_file_open(file, manifest_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
-        storage_file_free(file);
-        return false;
-    }
-
-    FuriString* accum = furi_string_alloc();
-    char buf[128];
-    uint16_t bytes_read;
-
-    while((bytes_read = storage_file_read(file, buf, sizeof(buf) - 1)) > 0) {
-        buf[bytes_read] = '\0';
-        furi_string_cat_str(accum, buf);
-    }
-
-    storage_file_close(file);
-    storage_file_free(file);
-
-    const char* text = furi_string_get_cstr(accum);
-    const char* name_ptr = strstr(text, "Name:");
-    bool found = false;
-
-    if(name_ptr) {
-        name_ptr += 5; /* skip "Name:" */
-        while(*name_ptr == ' ')
-            name_ptr++; /* skip spaces */
-
-        size_t i = 0;
-        while(name_ptr[i] != '\0' && name_ptr[i] != '\n' && name_ptr[i] != '\r' &&
-              i < out_name_size - 1) {
-            out_name[i] = name_ptr[i];
-            i++;
-        }
-        out_name[i] = '\0';
-        if(i > 0) found = true;
-    }
-
-    furi_string_free(accum);
-    return found;
-}
-
-// -------------------------------------------------------------------
-// Load preview frame (frame_0.bm) for a theme
-// Determines path based on theme type, loads raw XBM data
-// -------------------------------------------------------------------
-static void theme_manager_load_preview(ThemeManagerApp* app, uint32_t index) {
-    with_view_model(
-        app->info_view,
-        InfoViewModel * model,
-        {
-            if(model->frame_data) {
-                free(model->frame_data);
-                model->frame_data = NULL;
-            }
-            model->preview_loaded = false;
-            model->frame_w = 0;
-            model->frame_h = 0;
-            model->frame_size = 0;
-        },
-        false);
-
-    if(index >= app->theme_count) return;
-
-    const char* name = app->theme_names[index];
-    ThemeType type = app->theme_types[index];
-
-    FuriString* meta_path = furi_string_alloc();
-    FuriString* frame_path = furi_string_alloc();
-
-    switch(type) {
-    case ThemeTypeSingle:
-        furi_string_printf(meta_path, "%s/%s/%s", ANIMATION_PACKS_PATH, name, META_FILENAME);
-        furi_string_printf(frame_path, "%s/%s/frame_0.bm", ANIMATION_PACKS_PATH, name);
-        break;
-
-    case ThemeTypePack: {
-        FuriString* manifest =
-            furi_string_alloc_printf("%s/%s/%s", ANIMATION_PACKS_PATH, name, MANIFEST_FILENAME);
-        char first_anim[MAX_NAME_LEN];
-        if(theme_manager_get_first_anim_name(
-               app, furi_string_get_cstr(manifest), first_anim, sizeof(first_anim))) {
-            furi_string_printf(
-                meta_path, "%s/%s/%s/%s", ANIMATION_PACKS_PATH, name, first_anim, META_FILENAME);
-            furi_string_printf(
-                frame_path, "%s/%s/%s/frame_0.bm", ANIMATION_PACKS_PATH, name, first_anim);
-        }
-        furi_string_free(manifest);
-        break;
-    }
-
-    case ThemeTypeAnimsPack: {
-        FuriString* manifest = furi_string_alloc_printf(
-            "%s/%s/%s/%s", ANIMATION_PACKS_PATH, name, ANIMS_DIRNAME, MANIFEST_FILENAME);
-        char first_anim[MAX_NAME_LEN];
-        if(theme_manager_get_first_anim_name(
-               app, furi_string_get_cstr(manifest), first_anim, sizeof(first_anim))) {
-            furi_string_printf(
-                meta_path,
-                "%s/%s/%s/%s/%s",
-                ANIMATION_PACKS_PATH,
-                name,
-                ANIMS_DIRNAME,
-                first_anim,
-                META_FILENAME);
-            furi_string_printf(
-                frame_path,
-                "%s/%s/%s/%s/frame_0.bm",
-                ANIMATION_PACKS_PATH,
-                name,
-                ANIMS_DIRNAME,
-                first_anim);
-        }
-        furi_string_free(manifest);
-        break;
-    }
-    }
-
-    uint8_t w = 0, h = 0;
-    if(furi_string_size(meta_path) == 0 ||
-       !theme_manager_parse_meta_dimensions(app, furi_string_get_cstr(meta_path), &w, &h)) {
-        FURI_LOG_W(TAG, "Preview: can't parse meta for %s", name);
-        furi_string_free(meta_path);
-        furi_string_free(frame_path);
-        return;
-    }
-
-    File* file = storage_file_alloc(app->storage);
-    if(!storage_file_open(file, furi_string_get_cstr(frame_path), FSAM_READ, FSOM_OPEN_EXISTING)) {
-        FURI_LOG_W(TAG, "Preview: can't open %s", furi_string_get_cstr(frame_path));
-        storage_file_free(file);
-        furi_string_free(meta_path);
-        furi_string_free(frame_path);
-        return;
-    }
-
-    FileInfo file_info;
-    storage_common_stat(app->storage, furi_string_get_cstr(frame_path), &file_info);
-
-    if(file_info.size > PREVIEW_MAX_BM_SIZE || file_info.size < 2) {
-        FURI_LOG_W(TAG, "Preview: bad size %llu", file_info.size);
-        storage_file_close(file);
-        storage_file_free(file);
-        furi_string_free(meta_path);
-        furi_string_free(frame_path);
-        return;
-    }
-
-    uint8_t* raw = malloc(file_info.size);
-    uint16_t read_bytes = storage_file_read(file, raw, file_info.size);
-    storage_file_close(file);
-    storage_file_free(file);
-
-    if(read_bytes != file_info.size) {
-        FURI_LOG_E(TAG, "Preview: read failed");
-        free(raw);
-        furi_string_free(meta_path);
-        furi_string_free(frame_path);
-        return;
-    }
-
-    uint32_t decoded_size = ((uint32_t)((w + 7) / 8)) * h;
-    CompressIcon* compress = compress_icon_alloc(decoded_size);
-
-    uint8_t* decoded = NULL;
-    compress_icon_decode(compress, raw, &decoded);
-    free(raw);
-
-    if(!decoded) {
-        FURI_LOG_W(TAG, "Preview: decompress failed for %s", name);
-        compress_icon_free(compress);
-        furi_string_free(meta_path);
-        furi_string_free(frame_path);
-        return;
-    }
-
-    uint8_t* xbm_data = malloc(decoded_size);
-    memcpy(xbm_data, decoded, decoded_size);
-    compress_icon_free(compress);
-
-    with_view_model(
-        app->info_view,
-        InfoViewModel * model,
-        {
-            model->frame_data = xbm_data;
-            model->frame_size = decoded_size;
-            model->frame_w = w;
-            model->frame_h = h;
-            model->preview_loaded = true;
-        },
-        false);
-
-    FURI_LOG_I(TAG, "Preview loaded: %s (%ux%u, %lu bytes)", name, w, h, decoded_size);
-
-    furi_string_free(meta_path);
-    furi_string_free(frame_path);
-}
-
-// -------------------------------------------------------------------
-// Calculate total size of a directory (recursive)
-// -------------------------------------------------------------------
-static uint64_t theme_manager_get_dir_size(ThemeManagerApp* app, const char* path) {
-    uint64_t total = 0;
-    File* dir = storage_file_alloc(app->storage);
-
-    if(!storage_dir_open(dir, path)) {
-        storage_file_free(dir);
-        return 0;
-    }
-
-    FileInfo file_info;
-    char name[MAX_NAME_LEN];
-    FuriString* child_path = furi_string_alloc();
-
-    while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
-        furi_string_printf(child_path, "%s/%s", path, name);
-        if(file_info.flags & FSF_DIRECTORY) {
-            total += theme_manager_get_dir_size(app, furi_string_get_cstr(child_path));
-        } else {
-            total += file_info.size;
-        }
-    }
-
-    furi_string_free(child_path);
-    storage_dir_close(dir);
-    storage_file_free(dir);
-
-    return total;
-}
-
 // -------------------------------------------------------------------
 // Scan /ext/animation_packs/ for all 3 formats
 // -------------------------------------------------------------------
 static void theme_manager_scan_themes(ThemeManagerApp* app) {
-    app->theme_count = 0;
     app->has_backup = storage_dir_exists(app->storage, DOLPHIN_BACKUP_PATH);
 
-    if(!storage_dir_exists(app->storage, ANIMATION_PACKS_PATH)) {
-        FURI_LOG_W(TAG, "Directory %s not found", ANIMATION_PACKS_PATH);
-        return;
-    }
-
-    File* dir = storage_file_alloc(app->storage);
-
-    if(!storage_dir_open(dir, ANIMATION_PACKS_PATH)) {
-        FURI_LOG_E(TAG, "Failed to open %s", ANIMATION_PACKS_PATH);
-        storage_file_free(dir);
-        return;
-    }
-
-    FileInfo file_info;
-    char name[MAX_NAME_LEN];
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    app->theme_count = theme_manager_scan_dir(
+        app->storage, ANIMATION_PACKS_PATH, app->theme_names, app->theme_types, MAX_THEMES);
+    furi_mutex_release(app->index_mutex);
 
-    FuriString* check_path = furi_string_alloc();
-
-    while(app->theme_count < MAX_THEMES && storage_dir_read(dir, &file_info, name, sizeof(name))) {
-        if(!(file_info.flags & FSF_DIRECTORY)) continue;
-
-        ThemeType detected_type;
-        bool found = false;
-
-        furi_string_printf(check_path, "%s/%s/%s", ANIMATION_PACKS_PATH, name, MANIFEST_FILENAME);
-        if(storage_file_exists(app->storage, furi_string_get_cstr(check_path))) {
-            detected_type = ThemeTypePack;
-            found = true;
-            FURI_LOG_I(TAG, "[Pack] %s", name);
-        }
-
-        if(!found) {
-            furi_string_printf(
-                check_path,
-                "%s/%s/%s/%s",
-                ANIMATION_PACKS_PATH,
-                name,
-                ANIMS_DIRNAME,
-                MANIFEST_FILENAME);
-            if(storage_file_exists(app->storage, furi_string_get_cstr(check_path))) {
-                detected_type = ThemeTypeAnimsPack;
-                found = true;
-                FURI_LOG_I(TAG, "[AnimsPack] %s", name);
-            }
-        }
-
-        if(!found) {
-            furi_string_printf(check_path, "%s/%s/%s", ANIMATION_PACKS_PATH, name, META_FILENAME);
-            if(storage_file_exists(app->storage, furi_string_get_cstr(check_path))) {
-                detected_type = ThemeTypeSingle;
-                found = true;
-                FURI_LOG_I(TAG, "[Single] %s", name);
-            }
-        }
-
-        if(found) {
-            strncpy(app->theme_names[app->theme_count], name, MAX_NAME_LEN - 1);
-            app->theme_names[app->theme_count][MAX_NAME_LEN - 1] = '\0';
-            app->theme_types[app->theme_count] = detected_type;
-            app->theme_count++;
-        } else {
-            FURI_LOG_W(TAG, "Skipping %s (unknown format)", name);
-        }
-    }
-
-    furi_string_free(check_path);
-
-    storage_dir_close(dir);
-    storage_file_free(dir);
+    theme_manager_idle_rescan(app->idle);
 
     FURI_LOG_I(
         TAG, "Total: %lu themes, backup: %s", app->theme_count, app->has_backup ? "yes" : "no");
 }
 
 // -------------------------------------------------------------------
-// Backup entire /ext/dolphin/ → /ext/dolphin_backup/
-// Uses rename (fast on FAT32 — just a metadata change)
-// -------------------------------------------------------------------
-static bool theme_manager_backup_dolphin(ThemeManagerApp* app) {
-    if(!storage_dir_exists(app->storage, DOLPHIN_PATH)) {
-        return true;
-    }
-
-    if(storage_dir_exists(app->storage, DOLPHIN_BACKUP_PATH)) {
-        storage_simply_remove_recursive(app->storage, DOLPHIN_BACKUP_PATH);
-    }
-
-    FS_Error err = storage_common_rename(app->storage, DOLPHIN_PATH, DOLPHIN_BACKUP_PATH);
-    if(err != FSE_OK) {
-        FURI_LOG_E(TAG, "Backup rename failed (err %d)", err);
-        return false;
-    }
-
-    app->has_backup = true;
-    FURI_LOG_I(TAG, "Backed up /ext/dolphin/ -> /ext/dolphin_backup/");
-    return true;
-}
-
-// -------------------------------------------------------------------
-// Apply Pack theme (format A or B): merge directory into /ext/dolphin/
-// -------------------------------------------------------------------
-static bool theme_manager_apply_pack(ThemeManagerApp* app, const char* merge_src_dir) {
-    FS_Error err = storage_common_merge(app->storage, merge_src_dir, DOLPHIN_PATH);
-
-    if(err != FSE_OK) {
-        FURI_LOG_E(TAG, "Merge failed: %s -> %s (err %d)", merge_src_dir, DOLPHIN_PATH, err);
-        return false;
-    }
-
-    FURI_LOG_I(TAG, "Merged: %s -> %s", merge_src_dir, DOLPHIN_PATH);
-    return true;
-}
-
-// -------------------------------------------------------------------
-// Apply Single animation (format C):
-//   1. Copy animation folder to /ext/dolphin/<name>/
-//   2. Generate manifest.txt with single Name: entry
-// -------------------------------------------------------------------
-static bool theme_manager_apply_single(ThemeManagerApp* app, const char* theme_name) {
-    FuriString* src_dir = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, theme_name);
-    FuriString* dst_dir = furi_string_alloc_printf("%s/%s", DOLPHIN_PATH, theme_name);
-
-    storage_common_mkdir(app->storage, furi_string_get_cstr(dst_dir));
-
-    FS_Error err = storage_common_merge(
-        app->storage, furi_string_get_cstr(src_dir), furi_string_get_cstr(dst_dir));
-
-    furi_string_free(src_dir);
-    furi_string_free(dst_dir);
-
-    if(err != FSE_OK) {
-        FURI_LOG_E(TAG, "Copy single anim failed (err %d)", err);
-        return false;
-    }
-
-    File* manifest = storage_file_alloc(app->storage);
-    if(!storage_file_open(manifest, DOLPHIN_MANIFEST, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
-        FURI_LOG_E(TAG, "Failed to create manifest");
-        storage_file_free(manifest);
-        return false;
-    }
-
-    FuriString* content = furi_string_alloc_printf(
-        "Filetype: Flipper Animation Manifest\n"
-        "Version: 1\n"
-        "\n"
-        "Name: %s\n"
-        "Min butthurt: 0\n"
-        "Max butthurt: 14\n"
-        "Min level: 1\n"
-        "Max level: 30\n"
-        "Weight: 5\n",
-        theme_name);
-
-    const char* str = furi_string_get_cstr(content);
-    uint16_t len = strlen(str);
-    uint16_t written = storage_file_write(manifest, str, len);
-
-    if(written != len) {
-        FURI_LOG_E(TAG, "Manifest write incomplete (%u/%u bytes)", written, len);
-        furi_string_free(content);
-        storage_file_close(manifest);
-        storage_file_free(manifest);
-        return false;
-    }
-
-    furi_string_free(content);
-    storage_file_close(manifest);
-    storage_file_free(manifest);
-
-    FURI_LOG_I(TAG, "Applied single animation: %s (manifest generated)", theme_name);
-    return true;
-}
-
-// -------------------------------------------------------------------
-// Main apply dispatcher — routes to correct handler based on type
+// Main apply dispatcher — backup, then install into /ext/dolphin/
 // -------------------------------------------------------------------
 static bool theme_manager_apply_theme(ThemeManagerApp* app, uint32_t index) {
     if(index >= app->theme_count) return false;
 
-    if(!theme_manager_backup_dolphin(app)) {
-        FURI_LOG_E(TAG, "Backup failed, aborting apply");
-        return false;
-    }
-
-    storage_common_mkdir(app->storage, DOLPHIN_PATH);
-
-    const char* name = app->theme_names[index];
-    ThemeType type = app->theme_types[index];
-
-    FuriString* src = furi_string_alloc();
-    bool success = false;
-
-    switch(type) {
-    case ThemeTypePack:
-        furi_string_printf(src, "%s/%s", ANIMATION_PACKS_PATH, name);
-        success = theme_manager_apply_pack(app, furi_string_get_cstr(src));
-        break;
-
-    case ThemeTypeAnimsPack:
-        furi_string_printf(src, "%s/%s/%s", ANIMATION_PACKS_PATH, name, ANIMS_DIRNAME);
-        success = theme_manager_apply_pack(app, furi_string_get_cstr(src));
-        break;
-
-    case ThemeTypeSingle:
-        success = theme_manager_apply_single(app, name);
-        break;
-    }
-
-    furi_string_free(src);
-    return success;
-}
-
-// -------------------------------------------------------------------
-// Restore backup: swap /ext/dolphin_backup/ → /ext/dolphin/
-// -------------------------------------------------------------------
-static bool theme_manager_restore_backup(ThemeManagerApp* app) {
-    if(!storage_dir_exists(app->storage, DOLPHIN_BACKUP_PATH)) {
-        return false;
-    }
-
-    if(storage_dir_exists(app->storage, DOLPHIN_PATH)) {
-        storage_simply_remove_recursive(app->storage, DOLPHIN_PATH);
-    }
-
-    FS_Error err = storage_common_rename(app->storage, DOLPHIN_BACKUP_PATH, DOLPHIN_PATH);
-    if(err != FSE_OK) {
-        FURI_LOG_E(TAG, "Restore rename failed (err %d)", err);
-        return false;
-    }
-
-    app->has_backup = false;
-    FURI_LOG_I(TAG, "Restored /ext/dolphin_backup/ -> /ext/dolphin/");
-    return true;
-}
-
-// -------------------------------------------------------------------
-// Delete theme from SD card
-// -------------------------------------------------------------------
-static bool theme_manager_delete_theme(ThemeManagerApp* app, uint32_t index) {
-    if(index >= app->theme_count) return false;
-
-    FuriString* theme_path =
-        furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, app->theme_names[index]);
-
-    bool success = storage_simply_remove_recursive(app->storage, furi_string_get_cstr(theme_path));
+    theme_manager_idle_set_busy(app->idle, true);
 
+    bool success = theme_manager_backup_dolphin(app->storage);
     if(success) {
-        FURI_LOG_I(TAG, "Deleted theme: %s", app->theme_names[index]);
+        app->has_backup = storage_dir_exists(app->storage, DOLPHIN_BACKUP_PATH);
+        success = theme_manager_install_theme(
+            app->storage,
+            ANIMATION_PACKS_PATH,
+            app->theme_names[index],
+            app->theme_types[index],
+            DOLPHIN_PATH);
     } else {
-        FURI_LOG_E(TAG, "Failed to delete: %s", app->theme_names[index]);
+        FURI_LOG_E(TAG, "Backup failed, aborting apply");
     }
 
-    furi_string_free(theme_path);
+    theme_manager_idle_set_busy(app->idle, false);
     return success;
 }
 
@@ -737,35 +73,17 @@ static void theme_manager_info_draw(Canvas* canvas, void* _model) {
     canvas_draw_frame(
         canvas, PREVIEW_DRAW_X - 1, PREVIEW_DRAW_Y - 1, PREVIEW_DRAW_W + 2, PREVIEW_DRAW_H + 2);
 
-    if(model->preview_loaded && model->frame_data) {
-        uint8_t src_w = model->frame_w;
-        uint8_t src_h = model->frame_h;
-        uint8_t src_row_bytes = (src_w + 7) / 8;
-
-        uint8_t x_offset = (src_w < PREVIEW_DRAW_W) ? (PREVIEW_DRAW_W - src_w) / 2 : 0;
-        uint8_t y_offset = (src_h < PREVIEW_DRAW_H) ? (PREVIEW_DRAW_H - src_h) / 2 : 0;
-
-        uint8_t draw_w = (src_w < PREVIEW_DRAW_W) ? src_w : PREVIEW_DRAW_W;
-        uint8_t draw_h = (src_h < PREVIEW_DRAW_H) ? src_h : PREVIEW_DRAW_H;
-
-        for(uint8_t py = 0; py < draw_h; py++) {
-            uint8_t sy = (src_h > PREVIEW_DRAW_H) ? (uint8_t)(py * src_h / PREVIEW_DRAW_H) : py;
-
-            for(uint8_t px = 0; px < draw_w; px++) {
-                uint8_t sx = (src_w > PREVIEW_DRAW_W) ? (uint8_t)(px * src_w / PREVIEW_DRAW_W) :
-                                                        px;
-
-                uint32_t byte_idx = (uint32_t)sy * src_row_bytes + sx / 8;
-                if(byte_idx < model->frame_size) {
-                    if(model->frame_data[byte_idx] & (1 << (sx % 8))) {
-                        canvas_draw_dot(
-                            canvas,
-                            PREVIEW_DRAW_X + x_offset + px,
-                            PREVIEW_DRAW_Y + y_offset + py);
-                    }
-                }
-            }
-        }
+    /* Latest complete frame from the preview decoder — never blocks */
+    const PreviewFrame* frame = theme_manager_preview_acquire(model->preview);
+
+    if(frame->w > 0) {
+        canvas_draw_xbm(
+            canvas,
+            PREVIEW_DRAW_X + (PREVIEW_DRAW_W - frame->w) / 2,
+            PREVIEW_DRAW_Y + (PREVIEW_DRAW_H - frame->h) / 2,
+            frame->w,
+            frame->h,
+            frame->data);
     } else {
         canvas_set_font(canvas, FontSecondary);
         canvas_draw_str_aligned(
@@ -794,26 +112,54 @@ static void theme_manager_info_draw(Canvas* canvas, void* _model) {
     canvas_draw_str(canvas, text_x, PREVIEW_DRAW_Y + 18, model->type_label);
 
     char anim_str[20];
-    snprintf(anim_str, sizeof(anim_str), "Anims: %lu", model->anim_count);
+    if(model->anim_count) {
+        snprintf(anim_str, sizeof(anim_str), "Anims: %lu", model->anim_count);
+    } else {
+        snprintf(anim_str, sizeof(anim_str), "Anims: ?");
+    }
     canvas_draw_str(canvas, text_x, PREVIEW_DRAW_Y + 27, anim_str);
 
     char size_line[24];
     snprintf(size_line, sizeof(size_line), "Size: %s", model->size_str);
     canvas_draw_str(canvas, text_x, PREVIEW_DRAW_Y + 36, size_line);
 
+    if(model->cost_str[0]) {
+        char cost_line[24];
+        snprintf(cost_line, sizeof(cost_line), "Load: %s", model->cost_str);
+        canvas_draw_str(canvas, text_x, PREVIEW_DRAW_Y + 45, cost_line);
+    }
+
     /* Bottom buttons */
     canvas_set_font(canvas, FontSecondary);
 
     canvas_draw_str_aligned(canvas, 2, 63, AlignLeft, AlignBottom, "<Back");
 
-    canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, "Del[OK]");
+    canvas_draw_str_aligned(canvas, 64, 63, AlignCenter, AlignBottom, "More[OK]");
 
-    canvas_draw_str_aligned(canvas, 126, 63, AlignRight, AlignBottom, "Apply>");
+    canvas_draw_str_aligned(
+        canvas, 126, 63, AlignRight, AlignBottom, model->is_archive ? "Import>" : "Apply>");
+}
+
+// -------------------------------------------------------------------
+// Custom Info View — enter/exit callbacks
+// The preview decoder only runs while the info view is on screen
+// -------------------------------------------------------------------
+static void theme_manager_info_enter(void* context) {
+    ThemeManagerApp* app = context;
+    uint32_t index = app->selected_index;
+    if(index >= app->theme_count) return;
+
+    theme_manager_preview_load(app->preview, app->theme_names[index], app->theme_types[index]);
+}
+
+static void theme_manager_info_exit(void* context) {
+    ThemeManagerApp* app = context;
+    theme_manager_preview_stop(app->preview);
 }
 
 // -------------------------------------------------------------------
 // Custom Info View — input callback
-// Handles Back (left), Apply (right), Delete (OK)
+// Handles Back (left), Apply or Import (right), Actions menu (OK)
 // -------------------------------------------------------------------
 static bool theme_manager_info_input(InputEvent* event, void* context) {
     ThemeManagerApp* app = context;
@@ -828,6 +174,12 @@ static bool theme_manager_info_input(InputEvent* event, void* context) {
         uint32_t index = app->selected_index;
         if(index >= app->theme_count) return true;
 
+        /* A bundle has to be unpacked into a theme folder first */
+        if(app->theme_types[index] == ThemeTypeArchive) {
+            theme_manager_actions_import(app);
+            return true;
+        }
+
         dialog_ex_set_header(
             app->confirm_dialog, app->theme_names[index], 64, 0, AlignCenter, AlignTop);
 
@@ -847,25 +199,7 @@ static bool theme_manager_info_input(InputEvent* event, void* context) {
         return true;
 
     } else if(event->key == InputKeyOk) {
-        uint32_t index = app->selected_index;
-        if(index >= app->theme_count) return true;
-
-        dialog_ex_set_header(app->delete_dialog, "Delete Theme?", 64, 0, AlignCenter, AlignTop);
-
-        furi_string_printf(
-            app->dialog_text, "%s\nThis cannot be undone!", app->theme_names[index]);
-        dialog_ex_set_text(
-            app->delete_dialog,
-            furi_string_get_cstr(app->dialog_text),
-            64,
-            26,
-            AlignCenter,
-            AlignTop);
-
-        dialog_ex_set_left_button_text(app->delete_dialog, "Cancel");
-        dialog_ex_set_right_button_text(app->delete_dialog, "Delete");
-
-        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewDeleteConfirm);
+        theme_manager_actions_show(app);
         return true;
     }
 
@@ -884,50 +218,103 @@ static void theme_manager_show_info(ThemeManagerApp* app, uint32_t index) {
     ThemeType type = app->theme_types[index];
 
     const char* type_label;
-    uint32_t anim_count = 0;
-
     switch(type) {
-    case ThemeTypePack: {
+    case ThemeTypePack:
         type_label = "Pack";
-        FuriString* mpath =
-            furi_string_alloc_printf("%s/%s/%s", ANIMATION_PACKS_PATH, name, MANIFEST_FILENAME);
-        theme_manager_parse_manifest(app, furi_string_get_cstr(mpath), &anim_count);
-        furi_string_free(mpath);
         break;
-    }
-    case ThemeTypeAnimsPack: {
+    case ThemeTypeAnimsPack:
         type_label = "Anim Pack";
-        FuriString* mpath = furi_string_alloc_printf(
-            "%s/%s/%s/%s", ANIMATION_PACKS_PATH, name, ANIMS_DIRNAME, MANIFEST_FILENAME);
-        theme_manager_parse_manifest(app, furi_string_get_cstr(mpath), &anim_count);
-        furi_string_free(mpath);
         break;
-    }
     case ThemeTypeSingle:
         type_label = "Single";
-        anim_count = 1;
+        break;
+    case ThemeTypeLibrary:
+        type_label = "Library";
+        break;
+    case ThemeTypeArchive:
+        type_label = "Archive";
+        break;
+    case ThemeTypeContainer:
+        type_label = "Packed";
         break;
     default:
         type_label = "Unknown";
         break;
     }
 
-    FuriString* theme_dir = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, name);
-    uint64_t size_bytes = theme_manager_get_dir_size(app, furi_string_get_cstr(theme_dir));
-    furi_string_free(theme_dir);
+    /* Counts and sizes come from the index; whatever is missing is
+     * computed here and stored for next time. Checking the stamp walks
+     * the whole theme, so that is left to the idle pass: the entry's own
+     * stamp is kept, and a new entry gets THEME_STAMP_UNKNOWN, which the
+     * idle pass replaces */
+    uint32_t anim_count = 0;
+    uint64_t size_bytes = 0;
+    uint32_t load_ms = 0;
+    uint8_t cached = 0;
+
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    ThemeIndexEntry* entry = theme_manager_index_find(app->index, name);
+    uint32_t stamp = entry ? entry->stamp : THEME_STAMP_UNKNOWN;
+    entry = theme_manager_index_update(app->index, name, stamp);
+    if(entry) {
+        cached = entry->flags;
+        anim_count = entry->anim_count;
+        size_bytes = entry->size;
+        load_ms = entry->load_ms;
+    }
+    furi_mutex_release(app->index_mutex);
+
+    FuriString* path = furi_string_alloc();
+
+    if(!(cached & ThemeIndexHasCount)) {
+        if(theme_manager_get_manifest_path(path, ANIMATION_PACKS_PATH, name, type)) {
+            theme_manager_parse_manifest(app->storage, furi_string_get_cstr(path), &anim_count);
+        } else if(type == ThemeTypeSingle) {
+            anim_count = 1;
+        } else if(type == ThemeTypeContainer) {
+            ThemeContainerInfo container;
+            furi_string_printf(path, "%s/%s", ANIMATION_PACKS_PATH, name);
+            if(theme_manager_container_read_info(
+                   app->storage, furi_string_get_cstr(path), &container, NULL)) {
+                anim_count = container.anim_count;
+            }
+        }
+    }
+
+    if(!(cached & ThemeIndexHasSize)) {
+        size_bytes = 0;
+        theme_manager_get_theme_size(
+            app->storage, ANIMATION_PACKS_PATH, name, type, NULL, NULL, &size_bytes);
+    }
+
+    furi_string_free(path);
+
+    if((cached & (ThemeIndexHasCount | ThemeIndexHasSize)) !=
+       (ThemeIndexHasCount | ThemeIndexHasSize)) {
+        /* Unless the idle pass restamped the entry meanwhile */
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        entry = theme_manager_index_find(app->index, name);
+        if(entry && entry->stamp == stamp) {
+            entry->anim_count = anim_count;
+            entry->size = size_bytes;
+            entry->flags |= ThemeIndexHasCount | ThemeIndexHasSize;
+            app->index->dirty = true;
+        }
+        furi_mutex_release(app->index_mutex);
+    }
 
     char size_str[16];
-    if(size_bytes >= 1024 * 1024) {
+    theme_manager_format_size(size_bytes, size_str, sizeof(size_str));
+
+    /* Load cost is estimated at idle time or from the actions menu */
+    char cost_str[16] = "";
+    if(cached & ThemeIndexHasCost) {
         snprintf(
-            size_str,
-            sizeof(size_str),
-            "%lu.%lu MB",
-            (uint32_t)(size_bytes / (1024 * 1024)),
-            (uint32_t)((size_bytes % (1024 * 1024)) * 10 / (1024 * 1024)));
-    } else if(size_bytes >= 1024) {
-        snprintf(size_str, sizeof(size_str), "%lu KB", (uint32_t)(size_bytes / 1024));
-    } else {
-        snprintf(size_str, sizeof(size_str), "%lu B", (uint32_t)size_bytes);
+            cost_str,
+            sizeof(cost_str),
+            "~%lu ms%s",
+            load_ms,
+            (cached & ThemeIndexCostHeavy) ? " !" : "");
     }
 
     with_view_model(
@@ -940,11 +327,11 @@ static void theme_manager_show_info(ThemeManagerApp* app, uint32_t index) {
             model->anim_count = anim_count;
             strncpy(model->size_str, size_str, sizeof(model->size_str) - 1);
             model->size_str[sizeof(model->size_str) - 1] = '\0';
+            strncpy(model->cost_str, cost_str, sizeof(model->cost_str));
+            model->is_archive = type == ThemeTypeArchive;
         },
         false);
 
-    theme_manager_load_preview(app, index);
-
     view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewInfo);
 }
 
@@ -955,7 +342,8 @@ static void theme_manager_submenu_callback(void* context, uint32_t index) {
     ThemeManagerApp* app = context;
 
     if(index == MENU_INDEX_RESTORE) {
-        if(theme_manager_restore_backup(app)) {
+        if(theme_manager_restore_backup(app->storage)) {
+            app->has_backup = false;
             dialog_ex_set_header(
                 app->reboot_dialog, "Backup Restored!", 64, 0, AlignCenter, AlignTop);
             dialog_ex_set_text(
@@ -974,6 +362,31 @@ static void theme_manager_submenu_callback(void* context, uint32_t index) {
         return;
     }
 
+    if(index == MENU_INDEX_BENCHMARK) {
+        theme_manager_benchmark_start(app);
+        return;
+    }
+
+    if(index == MENU_INDEX_OPTIMIZE_INSTALLED) {
+        theme_manager_actions_optimize_installed(app);
+        return;
+    }
+
+    if(index == MENU_INDEX_CLEANUP_INSTALLED) {
+        theme_manager_actions_cleanup_installed(app);
+        return;
+    }
+
+    if(index == MENU_INDEX_EXPORT_INSTALLED) {
+        theme_manager_actions_export_installed(app);
+        return;
+    }
+
+    if(index == MENU_INDEX_SAVE_INSTALLED) {
+        theme_manager_actions_save_installed(app);
+        return;
+    }
+
     if(index >= app->theme_count) return;
 
     theme_manager_show_info(app, index);
@@ -1000,6 +413,14 @@ static void theme_manager_confirm_callback(DialogExResult result, void* context)
             case ThemeTypeSingle:
                 type_str = "Anim + manifest";
                 break;
+            case ThemeTypeLibrary:
+                type_str = "Library anims";
+                break;
+            case ThemeTypeContainer:
+                type_str = "Container unpacked";
+                break;
+            case ThemeTypeArchive:
+                break;
             }
 
             dialog_ex_set_header(
@@ -1029,6 +450,14 @@ static void theme_manager_confirm_callback(DialogExResult result, void* context)
     }
 }
 
+// -------------------------------------------------------------------
+// Rescan after a job changed the theme folders
+// -------------------------------------------------------------------
+void theme_manager_refresh_themes(ThemeManagerApp* app) {
+    theme_manager_scan_themes(app);
+    theme_manager_populate_submenu(app);
+}
+
 // -------------------------------------------------------------------
 // Reboot callback
 // -------------------------------------------------------------------
@@ -1044,6 +473,28 @@ static void theme_manager_reboot_callback(DialogExResult result, void* context)
     }
 }
 
+// -------------------------------------------------------------------
+// Ask before deleting the selected theme
+// -------------------------------------------------------------------
+void theme_manager_show_delete_confirm(ThemeManagerApp* app) {
+    uint32_t index = app->selected_index;
+    if(index >= app->theme_count) return;
+
+    dialog_ex_set_header(app->delete_dialog, "Delete Theme?", 64, 0, AlignCenter, AlignTop);
+
+    furi_string_printf(
+        app->dialog_text,
+        "%s\nGoes to the trash, which is\nemptied at idle time",
+        app->theme_names[index]);
+    dialog_ex_set_text(
+        app->delete_dialog, furi_string_get_cstr(app->dialog_text), 64, 26, AlignCenter, AlignTop);
+
+    dialog_ex_set_left_button_text(app->delete_dialog, "Cancel");
+    dialog_ex_set_right_button_text(app->delete_dialog, "Delete");
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewDeleteConfirm);
+}
+
 // -------------------------------------------------------------------
 // Delete confirmation callback
 // -------------------------------------------------------------------
@@ -1051,7 +502,14 @@ static void theme_manager_delete_callback(DialogExResult result, void* context)
     ThemeManagerApp* app = context;
 
     if(result == DialogExResultRight) {
-        if(theme_manager_delete_theme(app, app->selected_index)) {
+        ThemeType type = app->theme_types[app->selected_index];
+        if(theme_manager_delete_theme(
+               app->storage, ANIMATION_PACKS_PATH, app->theme_names[app->selected_index])) {
+            /* Store entries only this theme referenced are garbage now */
+            if(type == ThemeTypeLibrary) {
+                ThemeLibraryStats library;
+                theme_manager_library_scan(app->storage, ANIMATION_PACKS_PATH, true, &library);
+            }
             theme_manager_scan_themes(app);
             theme_manager_populate_submenu(app);
 
@@ -1081,7 +539,7 @@ static void theme_manager_popup_callback(void* context) {
 // -------------------------------------------------------------------
 // Error popup
 // -------------------------------------------------------------------
-static void theme_manager_show_error(ThemeManagerApp* app, const char* message) {
+void theme_manager_show_error(ThemeManagerApp* app, const char* message) {
     popup_set_header(app->popup, "Error", 64, 0, AlignCenter, AlignTop);
     popup_set_text(app->popup, message, 64, 32, AlignCenter, AlignCenter);
     popup_set_timeout(app->popup, 3000);
@@ -1091,6 +549,31 @@ static void theme_manager_show_error(ThemeManagerApp* app, const char* message)
     view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewPopup);
 }
 
+// -------------------------------------------------------------------
+// Show app->text_box_text in a scrollable text box (Back → submenu)
+// -------------------------------------------------------------------
+void theme_manager_show_text(ThemeManagerApp* app) {
+    text_box_reset(app->text_box);
+    text_box_set_font(app->text_box, TextBoxFontText);
+    text_box_set_text(app->text_box, furi_string_get_cstr(app->text_box_text));
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewTextBox);
+}
+
+// -------------------------------------------------------------------
+// Custom events from worker threads
+// -------------------------------------------------------------------
+static bool theme_manager_custom_event_callback(void* context, uint32_t event) {
+    ThemeManagerApp* app = context;
+    bool consumed = theme_manager_job_custom_event(app, event);
+
+    /* A CLI request waits until no job runs */
+    if(event == ThemeManagerEventJobDone || event == ThemeManagerEventCliRequest) {
+        theme_manager_cli_start_pending(app->cli);
+        consumed = true;
+    }
+    return consumed;
+}
+
 // -------------------------------------------------------------------
 // Populate submenu with type labels
 // -------------------------------------------------------------------
@@ -1116,6 +599,15 @@ static void theme_manager_populate_submenu(ThemeManagerApp* app) {
             case ThemeTypeSingle:
                 prefix = "[S] ";
                 break;
+            case ThemeTypeLibrary:
+                prefix = "[L] ";
+                break;
+            case ThemeTypeArchive:
+                prefix = "[T] ";
+                break;
+            case ThemeTypeContainer:
+                prefix = "[K] ";
+                break;
             default:
                 prefix = "";
                 break;
@@ -1143,6 +635,43 @@ static void theme_manager_populate_submenu(ThemeManagerApp* app) {
             theme_manager_submenu_callback,
             app);
     }
+
+    if(storage_file_exists(app->storage, DOLPHIN_MANIFEST)) {
+        submenu_add_item(
+            app->submenu,
+            ">> Optimize Installed <<",
+            MENU_INDEX_OPTIMIZE_INSTALLED,
+            theme_manager_submenu_callback,
+            app);
+        submenu_add_item(
+            app->submenu,
+            ">> Clean Up Installed <<",
+            MENU_INDEX_CLEANUP_INSTALLED,
+            theme_manager_submenu_callback,
+            app);
+        submenu_add_item(
+            app->submenu,
+            ">> Export Installed <<",
+            MENU_INDEX_EXPORT_INSTALLED,
+            theme_manager_submenu_callback,
+            app);
+        submenu_add_item(
+            app->submenu,
+            ">> Save Installed as Theme <<",
+            MENU_INDEX_SAVE_INSTALLED,
+            theme_manager_submenu_callback,
+            app);
+    }
+
+    /* Hidden unless Settings > System > Debug is enabled */
+    if(furi_hal_rtc_is_flag_set(FuriHalRtcFlagDebug)) {
+        submenu_add_item(
+            app->submenu,
+            ">> Benchmark <<",
+            MENU_INDEX_BENCHMARK,
+            theme_manager_submenu_callback,
+            app);
+    }
 }
 
 // -------------------------------------------------------------------
@@ -1167,12 +696,15 @@ int32_t theme_manager_app(void* p) {
     ThemeManagerApp* app = malloc(sizeof(ThemeManagerApp));
     memset(app, 0, sizeof(ThemeManagerApp));
     app->dialog_text = furi_string_alloc();
+    app->text_box_text = furi_string_alloc();
 
     app->storage = furi_record_open(RECORD_STORAGE);
     app->gui = furi_record_open(RECORD_GUI);
 
     app->view_dispatcher = view_dispatcher_alloc();
     view_dispatcher_set_event_callback_context(app->view_dispatcher, app);
+    view_dispatcher_set_custom_event_callback(
+        app->view_dispatcher, theme_manager_custom_event_callback);
     view_dispatcher_attach_to_gui(app->view_dispatcher, app->gui, ViewDispatcherTypeFullscreen);
 
     app->submenu = submenu_alloc();
@@ -1180,24 +712,23 @@ int32_t theme_manager_app(void* p) {
     view_dispatcher_add_view(
         app->view_dispatcher, ThemeManagerViewSubmenu, submenu_get_view(app->submenu));
 
-    /* Custom Info view with preview */
+    /* Custom Info view with preview. The model needs no lock: its text is
+     * only written by show_info before the view is switched to, and the
+     * preview frame comes through the decoder's triple buffer */
     app->info_view = view_alloc();
-    view_allocate_model(app->info_view, ViewModelTypeLocking, sizeof(InfoViewModel));
+    view_allocate_model(app->info_view, ViewModelTypeLockFree, sizeof(InfoViewModel));
     view_set_draw_callback(app->info_view, theme_manager_info_draw);
     view_set_input_callback(app->info_view, theme_manager_info_input);
     view_set_context(app->info_view, app);
     view_set_previous_callback(app->info_view, theme_manager_nav_submenu);
     view_dispatcher_add_view(app->view_dispatcher, ThemeManagerViewInfo, app->info_view);
 
-    /* Initialize model */
+    /* Preview decoder thread, running only while the info view is shown */
+    app->preview = theme_manager_preview_alloc(app->storage, app->info_view);
+    view_set_enter_callback(app->info_view, theme_manager_info_enter);
+    view_set_exit_callback(app->info_view, theme_manager_info_exit);
     with_view_model(
-        app->info_view,
-        InfoViewModel * model,
-        {
-            model->frame_data = NULL;
-            model->preview_loaded = false;
-        },
-        false);
+        app->info_view, InfoViewModel * model, { model->preview = app->preview; }, false);
 
     app->confirm_dialog = dialog_ex_alloc();
     dialog_ex_set_result_callback(app->confirm_dialog, theme_manager_confirm_callback);
@@ -1231,24 +762,42 @@ int32_t theme_manager_app(void* p) {
     view_dispatcher_add_view(
         app->view_dispatcher, ThemeManagerViewLoading, loading_get_view(app->loading));
 
+    app->text_box = text_box_alloc();
+    view_set_previous_callback(text_box_get_view(app->text_box), theme_manager_nav_submenu);
+    view_dispatcher_add_view(
+        app->view_dispatcher, ThemeManagerViewTextBox, text_box_get_view(app->text_box));
+
+    theme_manager_job_init(app);
+    theme_manager_actions_init(app);
+
+    /* Theme index and the idle maintenance thread that keeps it fresh */
+    app->index = malloc(sizeof(ThemeIndex));
+    app->index_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    theme_manager_index_load(app->storage, app->index);
+    app->idle = theme_manager_idle_alloc(app);
+
     theme_manager_scan_themes(app);
     theme_manager_populate_submenu(app);
+    app->cli = theme_manager_cli_alloc(app);
 
     view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSubmenu);
     view_dispatcher_run(app->view_dispatcher);
 
-    /* Cleanup: free preview data */
-    with_view_model(
-        app->info_view,
-        InfoViewModel * model,
-        {
-            if(model->frame_data) {
-                free(model->frame_data);
-                model->frame_data = NULL;
-            }
-        },
-        false);
+    /* Before the job engine: fails a CLI request that can't start or finish now */
+    theme_manager_cli_free(app->cli);
+
+    /* Cleanup: stop the preview decoder before its view goes away */
+    theme_manager_preview_free(app->preview);
+
+    /* The idle thread saves the index on exit */
+    theme_manager_idle_free(app->idle);
+    furi_mutex_free(app->index_mutex);
+    free(app->index);
+
+    theme_manager_actions_deinit(app);
+    theme_manager_job_deinit(app);
 
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewTextBox);
     view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewLoading);
     view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewPopup);
     view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewDeleteConfirm);
@@ -1257,6 +806,7 @@ int32_t theme_manager_app(void* p) {
     view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewInfo);
     view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewSubmenu);
 
+    text_box_free(app->text_box);
     loading_free(app->loading);
     popup_free(app->popup);
     dialog_ex_free(app->delete_dialog);
@@ -1269,6 +819,7 @@ int32_t theme_manager_app(void* p) {
     furi_record_close(RECORD_GUI);
     furi_record_close(RECORD_STORAGE);
 
+    furi_string_free(app->text_box_text);
     furi_string_free(app->dialog_text);
     free(app);
 
@@ -0,0 +1,1211 @@
+#include "theme_manager_i.h"
+#include "theme_manager_plugin.h"
+
+#include <toolbox/path.h>
+
+/* Actions menu of the info screen (OK) and the maintenance jobs behind
+ * it. Jobs run on the job thread with the progress view; results are
+ * shown in the text box. Jobs backed by a plugin load it on the job
+ * thread and free it before returning. */
+
+typedef enum {
+    ActionsIndexOptimize,
+    ActionsIndexCompress,
+    ActionsIndexLibrary,
+    ActionsIndexVerify,
+    ActionsIndexCost,
+    ActionsIndexImport,
+    ActionsIndexExport,
+    ActionsIndexExportCompressed,
+    ActionsIndexContainer,
+    ActionsIndexPatch,
+    ActionsIndexDelete,
+} ActionsIndex;
+
+/* What Apply update did to the installed copy */
+typedef enum {
+    PatchInstalledSkipped, /* not installed, or another version */
+    PatchInstalledUpdated,
+    PatchInstalledFailed, /* checked out, then failed part way */
+} PatchInstalled;
+
+/* A job on one pack directory: a library theme, or the installed one */
+typedef struct {
+    FuriString* pack_dir;
+    char name[MAX_NAME_LEN]; /* library theme, empty for the installed one */
+
+    ThemeOptimizeStats optimize;
+
+    ThemeCompressParams compress_params;
+    ThemeCompressStats compress;
+    bool compress_resume;
+
+    ThemeType type;
+    ThemeLibraryImportStats import;
+    ThemeLibraryStats library;
+
+    uint32_t stamp;
+    bool verify_cached;
+    ThemeVerifyStats verify;
+    FuriString* report;
+
+    bool cleanup_apply;
+    ThemeCleanupStats cleanup;
+
+    ThemeCostModel cost_model;
+    ThemePackCost cost;
+    bool cost_calibrated; /* calibrated during this job */
+
+    char imported[MAX_NAME_LEN]; /* theme folder made from a bundle */
+
+    bool export_compress;
+    FuriString* export_root; /* folder holding the exported theme */
+    char exported[MAX_NAME_LEN]; /* bundle file name */
+    ThemeExportStats export;
+
+    bool save_move;
+    bool save_moved;
+
+    char container_name[MAX_NAME_LEN];
+    ThemeContainerInfo container;
+
+    FuriString* patch_path;
+    ThemePatchStats patch;
+    bool patch_checked; /* the theme matched the patch */
+    PatchInstalled patch_installed;
+} PackJob;
+
+static PackJob* theme_manager_pack_job_alloc(const char* pack_dir, const char* name) {
+    PackJob* job = malloc(sizeof(PackJob));
+    memset(job, 0, sizeof(PackJob));
+    job->pack_dir = furi_string_alloc_set_str(pack_dir);
+    if(name) strncpy(job->name, name, MAX_NAME_LEN - 1);
+    return job;
+}
+
+static void theme_manager_pack_job_free(PackJob* job) {
+    if(job->report) furi_string_free(job->report);
+    if(job->export_root) furi_string_free(job->export_root);
+    if(job->patch_path) furi_string_free(job->patch_path);
+    furi_string_free(job->pack_dir);
+    free(job);
+}
+
+// -------------------------------------------------------------------
+// Common end of a pack job: the content changed in place, which the
+// theme stamp may not notice, so drop the cached index entry and any
+// verify result
+// -------------------------------------------------------------------
+static void theme_manager_pack_job_finish(ThemeManagerApp* app, PackJob* job) {
+    if(job->name[0]) {
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        theme_manager_index_invalidate(app->index, job->name);
+        furi_mutex_release(app->index_mutex);
+        theme_manager_verify_cache_remove(app->storage, job->name);
+        theme_manager_idle_kick(app->idle);
+    }
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+static void theme_manager_pack_job_start(
+    ThemeManagerApp* app,
+    const char* title,
+    ThemeManagerJobCallback callback,
+    ThemeManagerJobDoneCallback done_callback,
+    PackJob* job) {
+    if(!theme_manager_job_start(app, title, callback, done_callback, job)) {
+        theme_manager_pack_job_free(job);
+    }
+}
+
+// -------------------------------------------------------------------
+// Optimize pack: frame dedup + unreferenced frame removal
+// -------------------------------------------------------------------
+static bool theme_manager_actions_optimize_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginTools);
+    if(!plugin) return false;
+
+    const ThemeToolsPlugin* tools = theme_manager_plugin_get(plugin);
+    bool ok = tools->optimize_pack(
+        app->storage,
+        furi_string_get_cstr(job->pack_dir),
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app,
+        &job->optimize);
+
+    theme_manager_plugin_free(plugin);
+    return ok;
+}
+
+static void
+    theme_manager_actions_optimize_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    char saved[16];
+    theme_manager_format_size(job->optimize.bytes_saved, saved, sizeof(saved));
+
+    furi_string_printf(
+        app->text_box_text,
+        "%s\n\n"
+        "Animations changed: %lu\n"
+        "Files removed: %lu\n"
+        "Space saved: %s\n",
+        success ? "Optimize complete" : "Optimize cancelled",
+        job->optimize.anims_changed,
+        job->optimize.files_removed,
+        saved);
+
+    theme_manager_pack_job_finish(app, job);
+}
+
+void theme_manager_actions_optimize_installed(ThemeManagerApp* app) {
+    theme_manager_pack_job_start(
+        app,
+        "Optimizing",
+        theme_manager_actions_optimize_job,
+        theme_manager_actions_optimize_done,
+        theme_manager_pack_job_alloc(DOLPHIN_PATH, NULL));
+}
+
+// -------------------------------------------------------------------
+// Clean up installed: orphaned folders and dangling manifest entries.
+// A read-only scan first, then a confirmation, then the cleanup
+// -------------------------------------------------------------------
+static bool theme_manager_actions_cleanup_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    theme_manager_job_set_progress(
+        app, 0, 0, job->cleanup_apply ? "Removing orphans" : "Checking manifest");
+    return theme_manager_cleanup_dolphin(
+        app->storage,
+        furi_string_get_cstr(job->pack_dir),
+        job->cleanup_apply,
+        &job->cleanup,
+        job->report,
+        theme_manager_job_stop_callback,
+        app);
+}
+
+static void
+    theme_manager_actions_cleanup_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    char orphan_size[16];
+    theme_manager_format_size(job->cleanup.orphan_bytes, orphan_size, sizeof(orphan_size));
+
+    bool found = job->cleanup.orphan_dirs > 0 || job->cleanup.dangling_entries > 0;
+    if(success && found && !job->cleanup_apply) {
+        furi_string_printf(
+            app->dialog_text,
+            "%lu orphaned folders (%s)\n%lu dangling entries",
+            job->cleanup.orphan_dirs,
+            orphan_size,
+            job->cleanup.dangling_entries);
+        theme_manager_pack_job_free(job);
+
+        dialog_ex_set_header(app->cleanup_dialog, "Clean Up?", 64, 0, AlignCenter, AlignTop);
+        dialog_ex_set_text(
+            app->cleanup_dialog,
+            furi_string_get_cstr(app->dialog_text),
+            64,
+            26,
+            AlignCenter,
+            AlignTop);
+        dialog_ex_set_left_button_text(app->cleanup_dialog, "Cancel");
+        dialog_ex_set_right_button_text(app->cleanup_dialog, "Clean");
+        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewCleanupConfirm);
+        return;
+    }
+
+    const char* status;
+    if(!success) {
+        status = job->cleanup_apply ? "Cleanup failed" : "Check cancelled";
+    } else if(job->cleanup_apply) {
+        status = "Cleanup complete";
+    } else {
+        status = "Nothing to clean up";
+    }
+
+    furi_string_printf(
+        app->text_box_text,
+        "%s\n\n"
+        "Manifest entries: %lu\n"
+        "Dangling removed: %lu\n"
+        "Orphaned folders: %lu\n"
+        "Space freed: %s\n",
+        status,
+        job->cleanup.manifest_entries,
+        job->cleanup_apply ? job->cleanup.dangling_entries : 0,
+        job->cleanup.orphan_dirs,
+        job->cleanup_apply && success ? orphan_size : "0 B");
+    if(furi_string_size(job->report)) {
+        furi_string_cat_printf(app->text_box_text, "\n%s", furi_string_get_cstr(job->report));
+    }
+
+    /* Trashed folders are deleted for real at idle time */
+    if(job->cleanup_apply) theme_manager_idle_kick(app->idle);
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+static void theme_manager_actions_cleanup_start(ThemeManagerApp* app, bool apply) {
+    PackJob* job = theme_manager_pack_job_alloc(DOLPHIN_PATH, NULL);
+    job->report = furi_string_alloc();
+    job->cleanup_apply = apply;
+    theme_manager_pack_job_start(
+        app,
+        apply ? "Cleaning up" : "Checking",
+        theme_manager_actions_cleanup_job,
+        theme_manager_actions_cleanup_done,
+        job);
+}
+
+static void theme_manager_actions_cleanup_confirm(DialogExResult result, void* context) {
+    ThemeManagerApp* app = context;
+
+    if(result == DialogExResultRight) {
+        theme_manager_actions_cleanup_start(app, true);
+    } else {
+        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSubmenu);
+    }
+}
+
+void theme_manager_actions_cleanup_installed(ThemeManagerApp* app) {
+    theme_manager_actions_cleanup_start(app, false);
+}
+
+// -------------------------------------------------------------------
+// Compress pack: heatshrink raw frames, resumable
+// -------------------------------------------------------------------
+static bool theme_manager_actions_compress_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    const char* pack_dir = furi_string_get_cstr(job->pack_dir);
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginTools);
+    if(!plugin) return false;
+    const ThemeToolsPlugin* tools = theme_manager_plugin_get(plugin);
+
+    if(!job->compress_resume) {
+        theme_manager_job_set_progress(app, 0, 0, "Sampling frames");
+        tools->compress_tune(app->storage, pack_dir, &job->compress_params);
+    }
+
+    bool ok = tools->compress_pack(
+        app->storage,
+        pack_dir,
+        &job->compress_params,
+        &job->compress,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+
+    theme_manager_plugin_free(plugin);
+    return ok;
+}
+
+static void
+    theme_manager_actions_compress_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    char before[16];
+    char after[16];
+    theme_manager_format_size(job->compress.bytes_before, before, sizeof(before));
+    theme_manager_format_size(job->compress.bytes_after, after, sizeof(after));
+
+    furi_string_printf(
+        app->text_box_text,
+        "%s\n\n"
+        "Frames compressed: %lu\n"
+        "Kept raw: %lu\n"
+        "Frames: %s -> %s\n"
+        "Min gain: %u%%\n",
+        success ? "Compress complete" : "Compress paused\nRun it again to resume",
+        job->compress.frames_compressed,
+        job->compress.frames_raw,
+        before,
+        after,
+        job->compress_params.min_gain_pct);
+
+    theme_manager_pack_job_finish(app, job);
+}
+
+// -------------------------------------------------------------------
+// Move to library: share animation folders with other library themes
+// -------------------------------------------------------------------
+static bool theme_manager_actions_library_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+
+    bool success = theme_manager_library_import(
+        app->storage,
+        ANIMATION_PACKS_PATH,
+        job->name,
+        job->type,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app,
+        &job->import);
+
+    theme_manager_job_set_progress(app, 0, 0, "Scanning library");
+    theme_manager_library_scan(app->storage, ANIMATION_PACKS_PATH, false, &job->library);
+    return success;
+}
+
+static void
+    theme_manager_actions_library_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    char reclaimed[16];
+    char stored[16];
+    char saved[16];
+    theme_manager_format_size(job->import.bytes_reclaimed, reclaimed, sizeof(reclaimed));
+    theme_manager_format_size(job->library.stored_bytes, stored, sizeof(stored));
+    theme_manager_format_size(
+        job->library.logical_bytes - job->library.stored_bytes, saved, sizeof(saved));
+
+    furi_string_printf(
+        app->text_box_text,
+        "%s\n\n"
+        "New in library: %lu\n"
+        "Already shared: %lu\n"
+        "Space reclaimed: %s\n\n"
+        "Library: %lu anims, %s\n"
+        "Saved by sharing: %s\n",
+        success ? "Moved to library" : "Move cancelled\nTheme left unchanged",
+        job->import.anims_stored,
+        job->import.anims_shared,
+        reclaimed,
+        job->library.entries,
+        stored,
+        saved);
+
+    /* The theme changed type: rescan so the list and info follow */
+    if(success) theme_manager_refresh_themes(app);
+
+    theme_manager_pack_job_finish(app, job);
+}
+
+// -------------------------------------------------------------------
+// Verify: every frame of every animation through the decoder
+// -------------------------------------------------------------------
+static bool theme_manager_actions_verify_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+
+    /* The stamp walks the theme too, so it is taken here, off the GUI */
+    theme_manager_job_set_progress(app, 0, 0, "Checking cache");
+    if(!theme_manager_theme_stamp(
+           app->storage,
+           ANIMATION_PACKS_PATH,
+           job->name,
+           job->type,
+           theme_manager_job_stop_callback,
+           app,
+           &job->stamp)) {
+        return false;
+    }
+    job->verify_cached = theme_manager_verify_cache_load(
+        app->storage, job->name, job->stamp, &job->verify, job->report);
+    if(job->verify_cached) return true;
+
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginVerify);
+    if(!plugin) return false;
+
+    const ThemeVerifyPlugin* verify = theme_manager_plugin_get(plugin);
+    bool ok = verify->verify_theme(
+        app->storage,
+        ANIMATION_PACKS_PATH,
+        job->name,
+        job->type,
+        &job->verify,
+        job->report,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+
+    theme_manager_plugin_free(plugin);
+    return ok;
+}
+
+static void theme_manager_actions_verify_show(ThemeManagerApp* app, PackJob* job, bool cached) {
+    furi_string_printf(
+        app->text_box_text,
+        "%s%s\n\n"
+        "Animations: %lu (%lu bad)\n"
+        "Frames decoded: %lu\n"
+        "Problems: %lu\n",
+        job->verify.errors ? "Verify: problems found" : "Verify: OK",
+        cached ? " (cached)" : "",
+        job->verify.anims_checked,
+        job->verify.anims_bad,
+        job->verify.frames_checked,
+        job->verify.errors);
+    if(furi_string_size(job->report)) {
+        furi_string_cat_printf(app->text_box_text, "\n%s", furi_string_get_cstr(job->report));
+    }
+
+    /* Nothing changed on SD: no index invalidation */
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+static void
+    theme_manager_actions_verify_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        if(!job->verify_cached) {
+            theme_manager_verify_cache_save(
+                app->storage, job->name, job->stamp, &job->verify, job->report);
+        }
+        theme_manager_actions_verify_show(app, job, job->verify_cached);
+    } else {
+        furi_string_printf(
+            app->text_box_text,
+            "Verify cancelled\n\n"
+            "Checked %lu animations, %lu bad so far\n\n%s",
+            job->verify.anims_checked,
+            job->verify.anims_bad,
+            furi_string_get_cstr(job->report));
+        theme_manager_pack_job_free(job);
+        theme_manager_show_text(app);
+    }
+}
+
+static void theme_manager_actions_verify(ThemeManagerApp* app, PackJob* job) {
+    job->report = furi_string_alloc();
+    theme_manager_pack_job_start(
+        app,
+        "Verifying",
+        theme_manager_actions_verify_job,
+        theme_manager_actions_verify_done,
+        job);
+}
+
+// -------------------------------------------------------------------
+// Load cost: per-animation estimate, calibrated on first use
+// -------------------------------------------------------------------
+static bool theme_manager_actions_cost_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+
+    if(!theme_manager_theme_stamp(
+           app->storage,
+           ANIMATION_PACKS_PATH,
+           job->name,
+           job->type,
+           theme_manager_job_stop_callback,
+           app,
+           &job->stamp)) {
+        return false;
+    }
+
+    theme_manager_cost_load_model(app->storage, &job->cost_model);
+    if(!job->cost_model.calibrated) {
+        theme_manager_job_set_progress(app, 0, 0, "Calibrating");
+        job->cost_calibrated = theme_manager_cost_calibrate(
+            app->storage, ANIMATION_PACKS_PATH, job->name, job->type, &job->cost_model);
+    }
+
+    return theme_manager_cost_estimate(
+        app->storage,
+        ANIMATION_PACKS_PATH,
+        job->name,
+        job->type,
+        &job->cost_model,
+        &job->cost,
+        job->report,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+}
+
+static void theme_manager_actions_cost_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        ThemeIndexEntry* entry = theme_manager_index_update(app->index, job->name, job->stamp);
+        if(entry) {
+            entry->load_ms = job->cost.max_ms;
+            entry->flags &= ~ThemeIndexCostHeavy;
+            entry->flags |= ThemeIndexHasCost;
+            if(job->cost.heavy_anims) entry->flags |= ThemeIndexCostHeavy;
+            app->index->dirty = true;
+        }
+        furi_mutex_release(app->index_mutex);
+    }
+
+    char bytes[16];
+    theme_manager_format_size(job->cost.bytes, bytes, sizeof(bytes));
+
+    furi_string_printf(
+        app->text_box_text,
+        "%s\n\n"
+        "Slowest: %lu ms (%s)\n"
+        "Average: %lu ms\n"
+        "Heavy (!): %lu\n"
+        "Frames: %lu, %s\n"
+        "Decode buffer: %lu B\n"
+        "Model: open %lu us, read %lu ns/B, decode %lu ns/B%s\n\n%s",
+        success ? "Estimated load cost" : "Estimate cancelled",
+        job->cost.max_ms,
+        job->cost.heaviest,
+        job->cost.anims ? job->cost.total_ms / job->cost.anims : 0,
+        job->cost.heavy_anims,
+        job->cost.frames,
+        bytes,
+        job->cost.max_decoded,
+        job->cost_model.open_us,
+        job->cost_model.read_ns,
+        job->cost_model.decode_ns,
+        job->cost_model.calibrated ? (job->cost_calibrated ? " (just calibrated)" : "") :
+                                     " (defaults)",
+        furi_string_get_cstr(job->report));
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+// -------------------------------------------------------------------
+// Import bundle: unpack a .tar / .tar.heatshrink into a theme folder
+// -------------------------------------------------------------------
+static bool theme_manager_actions_import_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginArchive);
+    if(!plugin) return false;
+
+    const ThemeArchivePlugin* archive = theme_manager_plugin_get(plugin);
+    bool ok = archive->import(
+        app->storage,
+        ANIMATION_PACKS_PATH,
+        job->name,
+        job->imported,
+        sizeof(job->imported),
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+
+    theme_manager_plugin_free(plugin);
+    return ok;
+}
+
+static void
+    theme_manager_actions_import_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        furi_string_printf(
+            app->text_box_text,
+            "Import complete\n\n"
+            "%s\n-> %s\n\n"
+            "The archive was kept; delete it\nonce the theme looks right.\n",
+            job->name,
+            job->imported);
+        theme_manager_refresh_themes(app);
+        theme_manager_idle_kick(app->idle);
+    } else {
+        furi_string_printf(
+            app->text_box_text,
+            "Import failed\n\n"
+            "%s\n\n"
+            "Cancelled, unreadable, or no\ntheme folder in the archive.\n",
+            job->name);
+    }
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+void theme_manager_actions_import(ThemeManagerApp* app) {
+    uint32_t theme = app->selected_index;
+    if(theme >= app->theme_count) return;
+
+    PackJob* job = theme_manager_pack_job_alloc(ANIMATION_PACKS_PATH, app->theme_names[theme]);
+    job->type = ThemeTypeArchive;
+    theme_manager_pack_job_start(
+        app,
+        "Importing",
+        theme_manager_actions_import_job,
+        theme_manager_actions_import_done,
+        job);
+}
+
+// -------------------------------------------------------------------
+// Export: a theme, or the installed dolphin, as one bundle file
+// -------------------------------------------------------------------
+static bool theme_manager_actions_export_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginArchive);
+    if(!plugin) return false;
+
+    const ThemeArchivePlugin* archive = theme_manager_plugin_get(plugin);
+    theme_manager_job_set_progress(app, 0, 0, "Measuring");
+    bool ok = archive->export(
+        app->storage,
+        furi_string_get_cstr(job->export_root),
+        job->name,
+        job->type,
+        job->export_compress,
+        job->exported,
+        sizeof(job->exported),
+        &job->export,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+
+    theme_manager_plugin_free(plugin);
+    return ok;
+}
+
+static void
+    theme_manager_actions_export_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    char size_in[16];
+    char size_out[16];
+    theme_manager_format_size(job->export.bytes_in, size_in, sizeof(size_in));
+    theme_manager_format_size(job->export.bytes_out, size_out, sizeof(size_out));
+
+    if(success) {
+        furi_string_printf(
+            app->text_box_text,
+            "Export complete\n\n"
+            "%s\n\n"
+            "Files: %lu\n"
+            "Size: %s -> %s\n",
+            job->exported,
+            job->export.files,
+            size_in,
+            size_out);
+        /* The bundle shows up in the list */
+        theme_manager_refresh_themes(app);
+    } else {
+        furi_string_printf(
+            app->text_box_text,
+            "Export failed\n\n"
+            "%s\n\n"
+            "Cancelled, out of space, or a\npath too long for tar.\n",
+            job->name);
+    }
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+static void theme_manager_actions_export(ThemeManagerApp* app, PackJob* job, bool compress) {
+    if(!job->export_root) job->export_root = furi_string_alloc_set_str(ANIMATION_PACKS_PATH);
+    job->export_compress = compress;
+    theme_manager_pack_job_start(
+        app,
+        "Exporting",
+        theme_manager_actions_export_job,
+        theme_manager_actions_export_done,
+        job);
+}
+
+void theme_manager_actions_export_installed(ThemeManagerApp* app) {
+    PackJob* job = theme_manager_pack_job_alloc(DOLPHIN_PATH, NULL);
+    FuriString* name = furi_string_alloc();
+
+    job->export_root = furi_string_alloc();
+    path_extract_dirname(DOLPHIN_PATH, job->export_root);
+    path_extract_basename(DOLPHIN_PATH, name);
+    strncpy(job->name, furi_string_get_cstr(name), MAX_NAME_LEN - 1);
+    job->type = ThemeTypePack;
+    furi_string_free(name);
+
+    theme_manager_actions_export(app, job, true);
+}
+
+// -------------------------------------------------------------------
+// Pack into a container: one file, read directly for list and preview
+// -------------------------------------------------------------------
+static bool theme_manager_actions_container_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    theme_manager_job_set_progress(app, 0, 0, "Measuring");
+    return theme_manager_container_create(
+        app->storage,
+        ANIMATION_PACKS_PATH,
+        job->name,
+        job->type,
+        job->container_name,
+        sizeof(job->container_name),
+        &job->container,
+        theme_manager_job_progress_callback,
+        theme_manager_job_stop_callback,
+        app);
+}
+
+static void
+    theme_manager_actions_container_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        char size[16];
+        theme_manager_format_size(job->container.data_size, size, sizeof(size));
+        furi_string_printf(
+            app->text_box_text,
+            "Packed\n\n"
+            "%s\n\n"
+            "Animations: %u\n"
+            "Files: %u, %s\n\n"
+            "The folder was kept; delete it\nonce the container looks right.\n",
+            job->container_name,
+            job->container.anim_count,
+            job->container.entry_count,
+            size);
+        theme_manager_refresh_themes(app);
+        theme_manager_idle_kick(app->idle);
+    } else {
+        furi_string_printf(
+            app->text_box_text,
+            "Pack failed\n\n"
+            "%s\n\n"
+            "Cancelled, out of space, or a\npath over 55 characters.\n",
+            job->name);
+    }
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+// -------------------------------------------------------------------
+// Apply update: <name>.tpatch next to the theme, to the theme and, when
+// it is the installed one, to the dolphin folder as well
+// -------------------------------------------------------------------
+static bool theme_manager_actions_patch_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    const char* patch_path = furi_string_get_cstr(job->patch_path);
+    const char* pack_dir = furi_string_get_cstr(job->pack_dir);
+    ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginPatch);
+    if(!plugin) return false;
+    const ThemePatchPlugin* patch = theme_manager_plugin_get(plugin);
+    bool ok = false;
+
+    theme_manager_job_set_progress(app, 0, 2, "Checking");
+    job->patch_checked = patch->check(app->storage, patch_path, pack_dir);
+    if(job->patch_checked) {
+        bool installed = job->type != ThemeTypeSingle &&
+                         patch->check(app->storage, patch_path, DOLPHIN_PATH);
+
+        theme_manager_job_set_progress(app, 1, 2, "Patching");
+        ok = patch->apply(app->storage, patch_path, pack_dir, &job->patch);
+        if(ok && installed) {
+            ThemePatchStats stats;
+            job->patch_installed =
+                patch->apply(app->storage, patch_path, DOLPHIN_PATH, &stats) ?
+                    PatchInstalledUpdated :
+                    PatchInstalledFailed;
+        }
+    }
+
+    theme_manager_plugin_free(plugin);
+    if(ok) theme_manager_trash_move(app->storage, patch_path);
+    return ok;
+}
+
+static void theme_manager_actions_patch_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        char size[16];
+        theme_manager_format_size(job->patch.bytes, size, sizeof(size));
+        furi_string_printf(
+            app->text_box_text,
+            "Update applied\n\n"
+            "%s\n\n"
+            "Added: %lu\n"
+            "Changed: %lu (%lu as delta)\n"
+            "Removed: %lu\n"
+            "Patch data: %s\n\n",
+            job->name,
+            job->patch.added,
+            job->patch.changed,
+            job->patch.deltas,
+            job->patch.removed,
+            size);
+
+        switch(job->patch_installed) {
+        case PatchInstalledSkipped:
+            furi_string_cat_str(
+                app->text_box_text, "Installed copy: not this\nversion, skipped\n");
+            break;
+        case PatchInstalledUpdated:
+            furi_string_cat_str(app->text_box_text, "Installed copy: updated\n");
+            break;
+        case PatchInstalledFailed:
+            furi_string_cat_str(
+                app->text_box_text,
+                "ERROR: updating the installed\ncopy failed part way, it is\n"
+                "broken. Apply the theme again\nto restore it.\n");
+            break;
+        }
+    } else if(!job->patch_checked) {
+        furi_string_printf(
+            app->text_box_text,
+            "Update failed\n\n"
+            "%s\n\n"
+            "The patch is for another version\nof this theme, or is damaged.\n"
+            "Nothing was changed.\n",
+            job->name);
+    } else {
+        furi_string_printf(
+            app->text_box_text,
+            "Update failed\n\n"
+            "%s\n\n"
+            "Writing the update failed part\nway. Run Verify: the theme may\n"
+            "need restoring.\n",
+            job->name);
+    }
+
+    theme_manager_pack_job_finish(app, job);
+}
+
+static void theme_manager_patch_path(FuriString* out, const char* name) {
+    furi_string_printf(out, "%s/%s%s", ANIMATION_PACKS_PATH, name, PATCH_EXTENSION);
+}
+
+// -------------------------------------------------------------------
+// Save installed as theme: name it, then move or copy the dolphin
+// folder into a new pack
+// -------------------------------------------------------------------
+static bool theme_manager_actions_save_job(ThemeManagerApp* app, void* context) {
+    PackJob* job = context;
+    theme_manager_job_set_progress(app, 0, 0, job->save_move ? "Moving" : "Copying");
+    return theme_manager_snapshot_dolphin(
+        app->storage, ANIMATION_PACKS_PATH, job->name, job->save_move, &job->save_moved);
+}
+
+static void theme_manager_actions_save_done(ThemeManagerApp* app, bool success, void* context) {
+    PackJob* job = context;
+
+    if(success) {
+        furi_string_printf(
+            app->text_box_text,
+            "Saved as theme\n\n"
+            "%s\n%s\n",
+            job->name,
+            job->save_moved ? "Moved: nothing is installed now,\n"
+                              "apply a theme or reboot for\nthe built-in animations." :
+                              "Copied: the installed theme\nis unchanged.");
+        theme_manager_refresh_themes(app);
+        theme_manager_idle_kick(app->idle);
+    } else {
+        furi_string_printf(
+            app->text_box_text, "Save failed\n\n%s\nCheck free space on SD.\n", job->name);
+    }
+
+    theme_manager_pack_job_free(job);
+    theme_manager_show_text(app);
+}
+
+static void theme_manager_actions_save_confirm(DialogExResult result, void* context) {
+    ThemeManagerApp* app = context;
+
+    if(result != DialogExResultLeft && result != DialogExResultRight) {
+        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSubmenu);
+        return;
+    }
+
+    PackJob* job = theme_manager_pack_job_alloc(DOLPHIN_PATH, app->name_input_text);
+    job->type = ThemeTypePack;
+    job->save_move = result == DialogExResultRight;
+    theme_manager_pack_job_start(
+        app,
+        "Saving theme",
+        theme_manager_actions_save_job,
+        theme_manager_actions_save_done,
+        job);
+}
+
+static bool theme_manager_actions_save_validator(
+    const char* text,
+    FuriString* error,
+    void* context) {
+    ThemeManagerApp* app = context;
+
+    if(text[0] == '\0' || text[0] == '.' || strchr(text, '/') != NULL) {
+        furi_string_set_str(error, "Invalid\nname");
+        return false;
+    }
+
+    FuriString* path = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, text);
+    bool exists = storage_common_exists(app->storage, furi_string_get_cstr(path));
+    furi_string_free(path);
+    if(exists) {
+        furi_string_set_str(error, "Name\nalready\nused");
+        return false;
+    }
+    return true;
+}
+
+static void theme_manager_actions_save_named(void* context) {
+    ThemeManagerApp* app = context;
+
+    dialog_ex_set_header(app->save_dialog, app->name_input_text, 64, 0, AlignCenter, AlignTop);
+    dialog_ex_set_text(
+        app->save_dialog,
+        "Move is instant but leaves\nnothing installed.",
+        64,
+        26,
+        AlignCenter,
+        AlignTop);
+    dialog_ex_set_left_button_text(app->save_dialog, "Copy");
+    dialog_ex_set_right_button_text(app->save_dialog, "Move");
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSaveConfirm);
+}
+
+void theme_manager_actions_save_installed(ThemeManagerApp* app) {
+    strncpy(app->name_input_text, "my_dolphin", sizeof(app->name_input_text));
+    text_input_reset(app->name_input);
+    text_input_set_header_text(app->name_input, "Theme name");
+    text_input_set_validator(app->name_input, theme_manager_actions_save_validator, app);
+    text_input_set_result_callback(
+        app->name_input,
+        theme_manager_actions_save_named,
+        app,
+        app->name_input_text,
+        sizeof(app->name_input_text),
+        false);
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewNameInput);
+}
+
+// -------------------------------------------------------------------
+// Menu
+// -------------------------------------------------------------------
+static void theme_manager_actions_callback(void* context, uint32_t index) {
+    ThemeManagerApp* app = context;
+    uint32_t theme = app->selected_index;
+    if(theme >= app->theme_count) return;
+
+    if(index == ActionsIndexDelete) {
+        theme_manager_show_delete_confirm(app);
+        return;
+    }
+
+    if(index == ActionsIndexImport) {
+        theme_manager_actions_import(app);
+        return;
+    }
+
+    FuriString* pack_dir = furi_string_alloc();
+    theme_manager_get_pack_dir(
+        pack_dir, ANIMATION_PACKS_PATH, app->theme_names[theme], app->theme_types[theme]);
+    PackJob* job =
+        theme_manager_pack_job_alloc(furi_string_get_cstr(pack_dir), app->theme_names[theme]);
+    furi_string_free(pack_dir);
+    job->type = app->theme_types[theme];
+
+    switch(index) {
+    case ActionsIndexOptimize:
+        theme_manager_pack_job_start(
+            app,
+            "Optimizing",
+            theme_manager_actions_optimize_job,
+            theme_manager_actions_optimize_done,
+            job);
+        break;
+    case ActionsIndexCompress:
+        job->compress_resume = theme_manager_compress_load_state(
+            app->storage,
+            furi_string_get_cstr(job->pack_dir),
+            &job->compress_params,
+            &job->compress.anims_done);
+        theme_manager_pack_job_start(
+            app,
+            "Compressing",
+            theme_manager_actions_compress_job,
+            theme_manager_actions_compress_done,
+            job);
+        break;
+    case ActionsIndexLibrary:
+        theme_manager_pack_job_start(
+            app,
+            "Moving to library",
+            theme_manager_actions_library_job,
+            theme_manager_actions_library_done,
+            job);
+        break;
+    case ActionsIndexVerify:
+        theme_manager_actions_verify(app, job);
+        break;
+    case ActionsIndexContainer:
+        theme_manager_pack_job_start(
+            app,
+            "Packing",
+            theme_manager_actions_container_job,
+            theme_manager_actions_container_done,
+            job);
+        break;
+    case ActionsIndexPatch:
+        job->patch_path = furi_string_alloc();
+        theme_manager_patch_path(job->patch_path, job->name);
+        theme_manager_pack_job_start(
+            app,
+            "Updating",
+            theme_manager_actions_patch_job,
+            theme_manager_actions_patch_done,
+            job);
+        break;
+    case ActionsIndexExport:
+    case ActionsIndexExportCompressed:
+        theme_manager_actions_export(app, job, index == ActionsIndexExportCompressed);
+        break;
+    case ActionsIndexCost:
+        job->report = furi_string_alloc();
+        theme_manager_pack_job_start(
+            app,
+            "Estimating",
+            theme_manager_actions_cost_job,
+            theme_manager_actions_cost_done,
+            job);
+        break;
+    default:
+        theme_manager_pack_job_free(job);
+        break;
+    }
+}
+
+static uint32_t theme_manager_actions_nav_info(void* context) {
+    UNUSED(context);
+    return ThemeManagerViewInfo;
+}
+
+static uint32_t theme_manager_actions_nav_submenu(void* context) {
+    UNUSED(context);
+    return ThemeManagerViewSubmenu;
+}
+
+void theme_manager_actions_init(ThemeManagerApp* app) {
+    app->actions_menu = submenu_alloc();
+    view_set_previous_callback(
+        submenu_get_view(app->actions_menu), theme_manager_actions_nav_info);
+    view_dispatcher_add_view(
+        app->view_dispatcher, ThemeManagerViewActions, submenu_get_view(app->actions_menu));
+
+    app->cleanup_dialog = dialog_ex_alloc();
+    dialog_ex_set_result_callback(app->cleanup_dialog, theme_manager_actions_cleanup_confirm);
+    dialog_ex_set_context(app->cleanup_dialog, app);
+    view_set_previous_callback(
+        dialog_ex_get_view(app->cleanup_dialog), theme_manager_actions_nav_submenu);
+    view_dispatcher_add_view(
+        app->view_dispatcher,
+        ThemeManagerViewCleanupConfirm,
+        dialog_ex_get_view(app->cleanup_dialog));
+
+    app->name_input = text_input_alloc();
+    view_set_previous_callback(
+        text_input_get_view(app->name_input), theme_manager_actions_nav_submenu);
+    view_dispatcher_add_view(
+        app->view_dispatcher, ThemeManagerViewNameInput, text_input_get_view(app->name_input));
+
+    app->save_dialog = dialog_ex_alloc();
+    dialog_ex_set_result_callback(app->save_dialog, theme_manager_actions_save_confirm);
+    dialog_ex_set_context(app->save_dialog, app);
+    view_set_previous_callback(
+        dialog_ex_get_view(app->save_dialog), theme_manager_actions_nav_submenu);
+    view_dispatcher_add_view(
+        app->view_dispatcher, ThemeManagerViewSaveConfirm, dialog_ex_get_view(app->save_dialog));
+}
+
+void theme_manager_actions_deinit(ThemeManagerApp* app) {
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewSaveConfirm);
+    dialog_ex_free(app->save_dialog);
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewNameInput);
+    text_input_free(app->name_input);
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewCleanupConfirm);
+    dialog_ex_free(app->cleanup_dialog);
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewActions);
+    submenu_free(app->actions_menu);
+}
+
+void theme_manager_actions_show(ThemeManagerApp* app) {
+    uint32_t theme = app->selected_index;
+    if(theme >= app->theme_count) return;
+
+    /* An interrupted compress run on this pack can be resumed */
+    FuriString* pack_dir = furi_string_alloc();
+    theme_manager_get_pack_dir(
+        pack_dir, ANIMATION_PACKS_PATH, app->theme_names[theme], app->theme_types[theme]);
+    ThemeCompressParams params;
+    uint32_t anims_done;
+    bool resume = theme_manager_compress_load_state(
+        app->storage, furi_string_get_cstr(pack_dir), &params, &anims_done);
+    theme_manager_patch_path(pack_dir, app->theme_names[theme]);
+    bool patch = storage_file_exists(app->storage, furi_string_get_cstr(pack_dir));
+    furi_string_free(pack_dir);
+
+    submenu_reset(app->actions_menu);
+    submenu_set_header(app->actions_menu, app->theme_names[theme]);
+
+    if(app->theme_types[theme] == ThemeTypeArchive ||
+       app->theme_types[theme] == ThemeTypeContainer) {
+        if(app->theme_types[theme] == ThemeTypeArchive) {
+            submenu_add_item(
+                app->actions_menu,
+                "Import",
+                ActionsIndexImport,
+                theme_manager_actions_callback,
+                app);
+        }
+        submenu_add_item(
+            app->actions_menu, "Delete", ActionsIndexDelete, theme_manager_actions_callback, app);
+        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewActions);
+        return;
+    }
+
+    /* Store entries are shared and named by content: leave them alone */
+    if(app->theme_types[theme] != ThemeTypeLibrary) {
+        submenu_add_item(
+            app->actions_menu,
+            "Optimize pack",
+            ActionsIndexOptimize,
+            theme_manager_actions_callback,
+            app);
+        submenu_add_item(
+            app->actions_menu,
+            resume ? "Compress pack (resume)" : "Compress pack",
+            ActionsIndexCompress,
+            theme_manager_actions_callback,
+            app);
+        submenu_add_item(
+            app->actions_menu,
+            "Move to library",
+            ActionsIndexLibrary,
+            theme_manager_actions_callback,
+            app);
+        if(patch) {
+            submenu_add_item(
+                app->actions_menu,
+                "Apply update",
+                ActionsIndexPatch,
+                theme_manager_actions_callback,
+                app);
+        }
+    }
+    submenu_add_item(
+        app->actions_menu, "Verify", ActionsIndexVerify, theme_manager_actions_callback, app);
+    submenu_add_item(
+        app->actions_menu, "Load cost", ActionsIndexCost, theme_manager_actions_callback, app);
+    submenu_add_item(
+        app->actions_menu, "Export .tar", ActionsIndexExport, theme_manager_actions_callback, app);
+    submenu_add_item(
+        app->actions_menu,
+        "Export .tar.heatshrink",
+        ActionsIndexExportCompressed,
+        theme_manager_actions_callback,
+        app);
+    if(app->theme_types[theme] != ThemeTypeSingle) {
+        submenu_add_item(
+            app->actions_menu,
+            "Pack to .tpk",
+            ActionsIndexContainer,
+            theme_manager_actions_callback,
+            app);
+    }
+    submenu_add_item(
+        app->actions_menu, "Delete", ActionsIndexDelete, theme_manager_actions_callback, app);
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewActions);
+}
@@ -0,0 +1,20 @@
+#include <flipper_application/api_hashtable/api_hashtable.h>
+#include <flipper_application/api_hashtable/compilesort.hpp>
+
+/* The app's symbols, resolved by name when a plugin is loaded */
+#include "theme_manager_api_table_i.h"
+
+static_assert(!has_hash_collisions(theme_manager_api_table), "API method hash collision");
+
+extern "C" constexpr HashtableApiInterface theme_manager_hashtable_api_interface{
+    {
+        .api_version_major = 0,
+        .api_version_minor = 0,
+        .resolver_callback = &elf_resolve_from_hashtable,
+    },
+    theme_manager_api_table.cbegin(),
+    theme_manager_api_table.cend(),
+};
+
+extern "C" const ElfApiInterface* const theme_manager_api_interface =
+    &theme_manager_hashtable_api_interface;
@@ -0,0 +1,62 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+#include "theme_manager_bitmap.h"
+
+/* Symbols of the app that plugins may call (theme_manager_plugin.h).
+ * A plugin that calls anything else fails to load, so keep this in step
+ * with what the plugin sources use. */
+static constexpr auto theme_manager_api_table = sort(create_array_t<sym_entry>(
+    API_METHOD(theme_manager_read_text, bool, (Storage*, const char*, FuriString*)),
+    API_METHOD(theme_manager_parse_meta, bool, (Storage*, const char*, ThemeAnimMeta*)),
+    API_METHOD(
+        theme_manager_get_theme_size,
+        bool,
+        (Storage*,
+         const char*,
+         const char*,
+         ThemeType,
+         ThemeManagerStopCallback,
+         void*,
+         uint64_t*)),
+    API_METHOD(
+        theme_manager_detect_type,
+        bool,
+        (Storage*, const char*, const char*, ThemeType*)),
+    API_METHOD(
+        theme_manager_get_manifest_path,
+        bool,
+        (FuriString*, const char*, const char*, ThemeType)),
+    API_METHOD(
+        theme_manager_foreach_anim,
+        uint32_t,
+        (Storage*, const char*, ThemeManagerAnimCallback, void*)),
+    API_METHOD(
+        theme_manager_foreach_manifest_anim,
+        bool,
+        (Storage*,
+         const char*,
+         const char*,
+         ThemeType,
+         ThemeManagerManifestCallback,
+         void*,
+         uint32_t*)),
+    API_METHOD(theme_manager_archive_ext_len, size_t, (const char*)),
+    API_METHOD(
+        theme_manager_archive_free_name,
+        bool,
+        (Storage*, const char*, const char*, const char*, char*, size_t)),
+    API_METHOD(theme_manager_trash_move, bool, (Storage*, const char*)),
+    API_METHOD(theme_manager_bitmap_equal, bool, (const uint8_t*, const uint8_t*, size_t)),
+    API_METHOD(theme_manager_prefetch_alloc, ThemePrefetch*, (Storage*)),
+    API_METHOD(theme_manager_prefetch_free, void, (ThemePrefetch*)),
+    API_METHOD(
+        theme_manager_prefetch_start,
+        void,
+        (ThemePrefetch*, const char*, const uint8_t*, uint32_t)),
+    API_METHOD(theme_manager_prefetch_take, ThemePrefetchSlot*, (ThemePrefetch*)),
+    API_METHOD(theme_manager_prefetch_release, void, (ThemePrefetch*, ThemePrefetchSlot*)),
+    API_METHOD(theme_manager_prefetch_cancel, void, (ThemePrefetch*)),
+    API_METHOD(
+        theme_manager_compress_save_state,
+        void,
+        (Storage*, const char*, const ThemeCompressParams*, uint32_t))));
@@ -0,0 +1,700 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#include <toolbox/tar/tar_archive.h>
+
+#define TAG "ThemeManagerArchive"
+
+/* Theme bundles: a theme folder packed as .tar, or as a heatshrink
+ * compressed tar (.tar.heatshrink, or .ths as the firmware calls its own
+ * resource bundles). One file copies to and from the SD card far faster
+ * than thousands of small frames. Import streams the archive through the SDK
+ * tar reader into a hidden folder next to the themes, then recognizes
+ * the result with the same detection as a plain folder: the extracted
+ * tree itself, or its single top-level folder. */
+
+#define ARCHIVE_IMPORT_DIRNAME ".import"
+
+static TarOpenMode theme_manager_archive_mode(const char* name) {
+    size_t len = strlen(name);
+    return (len > 4 && strcasecmp(name + len - 4, ".tar") == 0) ? TarOpenModeRead :
+                                                                   TarOpenModeReadHeatshrink;
+}
+
+// -------------------------------------------------------------------
+// Extraction: progress, cancel, and no paths that leave the folder
+// -------------------------------------------------------------------
+typedef struct {
+    TarArchive* tar;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    uint32_t files;
+    uint32_t skipped;
+    bool stopped;
+} ArchiveImport;
+
+static bool
+    theme_manager_archive_file_callback(const char* name, bool is_directory, void* context) {
+    ArchiveImport* import = context;
+
+    if(!import->stopped && import->stop_callback && import->stop_callback(import->context)) {
+        import->stopped = true;
+    }
+    /* Once cancelled, the remaining entries are only skipped over */
+    if(import->stopped) return false;
+
+    if(name[0] == '/' || strstr(name, "..") != NULL) {
+        FURI_LOG_W(TAG, "Skipping unsafe entry %s", name);
+        import->skipped++;
+        return false;
+    }
+
+    if(!is_directory) import->files++;
+    if(import->progress_callback) {
+        int32_t done = 0;
+        int32_t total = 0;
+        if(!tar_archive_get_read_progress(import->tar, &done, &total)) {
+            done = import->files;
+            total = 0;
+        }
+        const char* base = strrchr(name, '/');
+        import->progress_callback(done, total, base ? base + 1 : name, import->context);
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Find the theme folder in the extracted tree: the tree itself, or its
+// only subfolder. Returns the parent dir and folder name to detect
+// -------------------------------------------------------------------
+static bool theme_manager_archive_find_theme(
+    Storage* storage,
+    const char* root,
+    FuriString* out_parent,
+    FuriString* out_name) {
+    ThemeType type;
+
+    furi_string_set_str(out_parent, root);
+    furi_string_set_str(out_name, ARCHIVE_IMPORT_DIRNAME);
+    if(theme_manager_detect_type(storage, root, ARCHIVE_IMPORT_DIRNAME, &type)) return true;
+
+    FuriString* tmp_dir = furi_string_alloc_printf("%s/%s", root, ARCHIVE_IMPORT_DIRNAME);
+    File* dir = storage_file_alloc(storage);
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    uint32_t subdirs = 0;
+
+    if(storage_dir_open(dir, furi_string_get_cstr(tmp_dir))) {
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            if(!(file_info.flags & FSF_DIRECTORY)) continue;
+            if(subdirs++ == 0) furi_string_set_str(out_name, name);
+        }
+        storage_dir_close(dir);
+    }
+    storage_file_free(dir);
+
+    furi_string_set(out_parent, tmp_dir);
+    furi_string_free(tmp_dir);
+
+    return subdirs == 1 &&
+           theme_manager_detect_type(
+               storage, furi_string_get_cstr(out_parent), furi_string_get_cstr(out_name), &type);
+}
+
+// -------------------------------------------------------------------
+// Import a bundle from root into a theme folder of root
+// out_name receives the new theme's folder name
+// -------------------------------------------------------------------
+bool theme_manager_archive_import(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    char* out_name,
+    size_t out_name_size,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    FuriString* archive_path = furi_string_alloc_printf("%s/%s", root, name);
+    FuriString* tmp_dir = furi_string_alloc_printf("%s/%s", root, ARCHIVE_IMPORT_DIRNAME);
+    FuriString* parent = furi_string_alloc();
+    FuriString* theme = furi_string_alloc();
+    FuriString* src = furi_string_alloc();
+    FuriString* dst = furi_string_alloc();
+    bool ok = false;
+
+    ArchiveImport import = {
+        .tar = tar_archive_alloc(storage),
+        .progress_callback = progress_callback,
+        .stop_callback = stop_callback,
+        .context = context,
+    };
+
+    /* Leftovers of an interrupted import */
+    if(storage_common_exists(storage, furi_string_get_cstr(tmp_dir))) {
+        theme_manager_trash_move(storage, furi_string_get_cstr(tmp_dir));
+    }
+
+    do {
+        if(!tar_archive_open(
+               import.tar, furi_string_get_cstr(archive_path), theme_manager_archive_mode(name))) {
+            FURI_LOG_E(TAG, "Can't open %s", name);
+            break;
+        }
+
+        storage_simply_mkdir(storage, furi_string_get_cstr(tmp_dir));
+        tar_archive_set_file_callback(import.tar, theme_manager_archive_file_callback, &import);
+        bool unpacked = tar_archive_unpack_to(import.tar, furi_string_get_cstr(tmp_dir), NULL);
+        if(import.stopped) break;
+        if(!unpacked) {
+            FURI_LOG_E(TAG, "Extract of %s failed", name);
+            break;
+        }
+
+        if(!theme_manager_archive_find_theme(storage, root, parent, theme)) {
+            FURI_LOG_E(TAG, "%s: no theme found in the archive", name);
+            break;
+        }
+
+        /* Named after its top-level folder, or after the archive */
+        char base[MAX_NAME_LEN];
+        if(furi_string_cmp_str(theme, ARCHIVE_IMPORT_DIRNAME) != 0) {
+            snprintf(base, sizeof(base), "%s", furi_string_get_cstr(theme));
+        } else {
+            size_t len = strlen(name) - theme_manager_archive_ext_len(name);
+            if(len >= sizeof(base)) len = sizeof(base) - 1;
+            memcpy(base, name, len);
+            base[len] = '\0';
+        }
+
+        /* Never overwrite an existing theme */
+        if(!theme_manager_archive_free_name(storage, root, base, "", out_name, out_name_size)) {
+            FURI_LOG_E(TAG, "%s: no free name for %s", name, base);
+            break;
+        }
+
+        furi_string_printf(dst, "%s/%s", root, out_name);
+        furi_string_printf(
+            src, "%s/%s", furi_string_get_cstr(parent), furi_string_get_cstr(theme));
+        ok = storage_common_rename(
+                 storage, furi_string_get_cstr(src), furi_string_get_cstr(dst)) == FSE_OK;
+    } while(false);
+
+    /* Whatever is left (wrapper folder, cancelled extract) goes */
+    if(storage_common_exists(storage, furi_string_get_cstr(tmp_dir))) {
+        theme_manager_trash_move(storage, furi_string_get_cstr(tmp_dir));
+    }
+
+    FURI_LOG_I(
+        TAG,
+        "Import %s: %s, %lu files, %lu skipped",
+        name,
+        ok ? out_name : (import.stopped ? "cancelled" : "failed"),
+        import.files,
+        import.skipped);
+
+    tar_archive_free(import.tar);
+    furi_string_free(dst);
+    furi_string_free(src);
+    furi_string_free(theme);
+    furi_string_free(parent);
+    furi_string_free(tmp_dir);
+    furi_string_free(archive_path);
+    return ok;
+}
+
+/* Export writes the tar stream itself (ustar headers, 512 byte blocks)
+ * so that it can go straight through the heatshrink encoder below: one
+ * pass over the files, one sequential write, no temporary .tar. The
+ * compressed file is the firmware's .ths layout, a small header naming
+ * the window and lookahead followed by a single heatshrink stream. */
+
+#define TAR_BLOCK_SIZE 512
+#define TAR_NAME_MAX   100
+
+#define HS_MAGIC         "HSDS"
+#define HS_VERSION       1
+#define HS_WINDOW_SZ2    10
+#define HS_LOOKAHEAD_SZ2 5
+#define HS_WINDOW        (1 << HS_WINDOW_SZ2)
+#define HS_LOOKAHEAD     (1 << HS_LOOKAHEAD_SZ2)
+#define HS_MIN_MATCH     3 /* a backref costs 16 bits, a literal 9 */
+#define HS_HASH_SIZE     1024
+#define HS_CHAIN_MAX     16
+#define HS_NIL           0xFFFF
+
+#define EXPORT_OUT_SIZE 512
+
+// -------------------------------------------------------------------
+// Streaming heatshrink encoder: a two-window buffer with hash chains,
+// emitting the bit format the firmware decoder reads (1 + byte for a
+// literal, 0 + offset-1 + count-1 for a backref, MSB first)
+// -------------------------------------------------------------------
+typedef struct {
+    uint8_t buf[2 * HS_WINDOW];
+    uint16_t head[HS_HASH_SIZE];
+    uint16_t prev[2 * HS_WINDOW];
+    size_t fill;
+    size_t pos;
+    uint8_t bit_buf;
+    uint8_t bit_count;
+} ArchiveEncoder;
+
+typedef struct {
+    Storage* storage;
+    File* file;
+    ArchiveEncoder* encoder; /* NULL for a plain .tar */
+    uint8_t out[EXPORT_OUT_SIZE];
+    size_t out_len;
+    bool ok;
+
+    ThemeExportStats* stats;
+    uint32_t total_kb;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    bool stopped;
+} ArchiveExport;
+
+static void theme_manager_archive_out_flush(ArchiveExport* export) {
+    if(export->out_len == 0) return;
+    if(export->ok &&
+       storage_file_write(export->file, export->out, export->out_len) != export->out_len) {
+        export->ok = false;
+    }
+    export->stats->bytes_out += export->out_len;
+    export->out_len = 0;
+}
+
+static void theme_manager_archive_out_byte(ArchiveExport* export, uint8_t byte) {
+    export->out[export->out_len++] = byte;
+    if(export->out_len == sizeof(export->out)) theme_manager_archive_out_flush(export);
+}
+
+static void theme_manager_archive_enc_bits(ArchiveExport* export, uint32_t value, uint8_t count) {
+    ArchiveEncoder* enc = export->encoder;
+    while(count--) {
+        enc->bit_buf = (enc->bit_buf << 1) | ((value >> count) & 1);
+        if(++enc->bit_count == 8) {
+            theme_manager_archive_out_byte(export, enc->bit_buf);
+            enc->bit_buf = 0;
+            enc->bit_count = 0;
+        }
+    }
+}
+
+static inline uint16_t theme_manager_archive_enc_hash(const uint8_t* p) {
+    return ((p[0] << 5) ^ (p[1] << 2) ^ p[2]) & (HS_HASH_SIZE - 1);
+}
+
+static void theme_manager_archive_enc_insert(ArchiveEncoder* enc, size_t pos) {
+    if(pos + HS_MIN_MATCH > enc->fill) return;
+    uint16_t hash = theme_manager_archive_enc_hash(&enc->buf[pos]);
+    enc->prev[pos] = enc->head[hash];
+    enc->head[hash] = pos;
+}
+
+/* Drop the older window: positions shift down, links into it are cut */
+static void theme_manager_archive_enc_slide(ArchiveEncoder* enc) {
+    memmove(enc->buf, enc->buf + HS_WINDOW, enc->fill - HS_WINDOW);
+    memmove(enc->prev, enc->prev + HS_WINDOW, HS_WINDOW * sizeof(uint16_t));
+    enc->fill -= HS_WINDOW;
+    enc->pos -= HS_WINDOW;
+
+    for(size_t i = 0; i < HS_HASH_SIZE; i++) {
+        enc->head[i] = (enc->head[i] != HS_NIL && enc->head[i] >= HS_WINDOW) ?
+                           enc->head[i] - HS_WINDOW :
+                           HS_NIL;
+    }
+    for(size_t i = 0; i < HS_WINDOW; i++) {
+        enc->prev[i] = (enc->prev[i] != HS_NIL && enc->prev[i] >= HS_WINDOW) ?
+                           enc->prev[i] - HS_WINDOW :
+                           HS_NIL;
+    }
+}
+
+/* Encode buffered input, keeping a full lookahead unless finishing */
+static void theme_manager_archive_enc_process(ArchiveExport* export, bool finish) {
+    ArchiveEncoder* enc = export->encoder;
+
+    while(enc->pos < enc->fill && (finish || enc->fill - enc->pos >= HS_LOOKAHEAD)) {
+        size_t max_len = MIN(enc->fill - enc->pos, (size_t)HS_LOOKAHEAD);
+        size_t best_len = 0;
+        size_t best_offset = 0;
+
+        if(max_len >= HS_MIN_MATCH) {
+            uint16_t candidate = enc->head[theme_manager_archive_enc_hash(&enc->buf[enc->pos])];
+            for(uint32_t chain = 0; candidate != HS_NIL && chain < HS_CHAIN_MAX; chain++) {
+                size_t offset = enc->pos - candidate;
+                if(offset == 0 || offset > HS_WINDOW) break;
+
+                size_t len = 0;
+                while(len < max_len && enc->buf[candidate + len] == enc->buf[enc->pos + len])
+                    len++;
+                if(len > best_len) {
+                    best_len = len;
+                    best_offset = offset;
+                    if(len == max_len) break;
+                }
+                candidate = enc->prev[candidate];
+            }
+        }
+
+        if(best_len >= HS_MIN_MATCH) {
+            theme_manager_archive_enc_bits(export, 0, 1);
+            theme_manager_archive_enc_bits(export, best_offset - 1, HS_WINDOW_SZ2);
+            theme_manager_archive_enc_bits(export, best_len - 1, HS_LOOKAHEAD_SZ2);
+        } else {
+            best_len = 1;
+            theme_manager_archive_enc_bits(export, 1, 1);
+            theme_manager_archive_enc_bits(export, enc->buf[enc->pos], 8);
+        }
+
+        for(size_t i = 0; i < best_len; i++) {
+            theme_manager_archive_enc_insert(enc, enc->pos++);
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Archive byte sink: straight to the file, or through the encoder
+// -------------------------------------------------------------------
+static void
+    theme_manager_archive_write(ArchiveExport* export, const uint8_t* data, size_t size) {
+    ArchiveEncoder* enc = export->encoder;
+
+    if(!enc) {
+        while(size--)
+            theme_manager_archive_out_byte(export, *data++);
+        return;
+    }
+
+    while(size > 0) {
+        if(enc->fill == sizeof(enc->buf)) theme_manager_archive_enc_slide(enc);
+        size_t chunk = MIN(size, sizeof(enc->buf) - enc->fill);
+        memcpy(enc->buf + enc->fill, data, chunk);
+        enc->fill += chunk;
+        data += chunk;
+        size -= chunk;
+        theme_manager_archive_enc_process(export, false);
+    }
+}
+
+static const uint8_t tar_zero_block[TAR_BLOCK_SIZE] = {0};
+
+static void theme_manager_archive_write_padding(ArchiveExport* export, uint64_t size) {
+    size_t pad = (TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+    theme_manager_archive_write(export, tar_zero_block, pad);
+}
+
+// -------------------------------------------------------------------
+// One ustar header block, as the firmware's tar reader expects it
+// -------------------------------------------------------------------
+static bool theme_manager_archive_write_header(
+    ArchiveExport* export,
+    const char* path,
+    bool is_directory,
+    uint64_t size) {
+    if(strlen(path) >= TAR_NAME_MAX) {
+        FURI_LOG_E(TAG, "Path too long for tar: %s", path);
+        return false;
+    }
+
+    uint8_t header[TAR_BLOCK_SIZE] = {0};
+    snprintf((char*)header, TAR_NAME_MAX, "%s", path);
+    snprintf((char*)header + 100, 8, "%07o", is_directory ? 0755 : 0644);
+    snprintf((char*)header + 108, 8, "%07o", 0);
+    snprintf((char*)header + 116, 8, "%07o", 0);
+    snprintf((char*)header + 124, 12, "%011lo", is_directory ? 0UL : (unsigned long)size);
+    snprintf((char*)header + 136, 12, "%011o", 0);
+    header[156] = is_directory ? '5' : '0';
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+
+    /* Checksum over the block with its own field taken as spaces */
+    memset(header + 148, ' ', 8);
+    uint32_t checksum = 0;
+    for(size_t i = 0; i < sizeof(header); i++)
+        checksum += header[i];
+    snprintf((char*)header + 148, 8, "%06lo", checksum);
+
+    theme_manager_archive_write(export, header, sizeof(header));
+    return true;
+}
+
+static bool theme_manager_archive_add_file(
+    ArchiveExport* export,
+    const char* fs_path,
+    const char* tar_path,
+    uint64_t size) {
+    if(!theme_manager_archive_write_header(export, tar_path, false, size)) return false;
+
+    File* file = storage_file_alloc(export->storage);
+    uint8_t buf[TAR_BLOCK_SIZE];
+    uint64_t done = 0;
+
+    if(storage_file_open(file, fs_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        while(done < size) {
+            size_t read = storage_file_read(file, buf, MIN(sizeof(buf), size - done));
+            if(read == 0) break;
+            theme_manager_archive_write(export, buf, read);
+            done += read;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    /* The header promised size bytes: a short read would corrupt the rest */
+    if(done != size) {
+        FURI_LOG_E(TAG, "Short read: %s", fs_path);
+        return false;
+    }
+    theme_manager_archive_write_padding(export, size);
+
+    export->stats->files++;
+    export->stats->bytes_in += size;
+    if(export->progress_callback) {
+        const char* base = strrchr(tar_path, '/');
+        export->progress_callback(
+            export->stats->bytes_in / 1024,
+            export->total_kb,
+            base ? base + 1 : tar_path,
+            export->context);
+    }
+    return export->ok;
+}
+
+static bool theme_manager_archive_add_dir(
+    ArchiveExport* export,
+    const char* fs_path,
+    const char* tar_path) {
+    FuriString* tar_dir = furi_string_alloc_printf("%s/", tar_path);
+    bool ok = theme_manager_archive_write_header(export, furi_string_get_cstr(tar_dir), true, 0);
+    furi_string_free(tar_dir);
+    if(!ok) return false;
+
+    File* dir = storage_file_alloc(export->storage);
+    if(!storage_dir_open(dir, fs_path)) {
+        storage_file_free(dir);
+        return false;
+    }
+
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    FuriString* child_fs = furi_string_alloc();
+    FuriString* child_tar = furi_string_alloc();
+
+    while(ok && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+        if(export->stop_callback && export->stop_callback(export->context)) {
+            export->stopped = true;
+            ok = false;
+            break;
+        }
+
+        furi_string_printf(child_fs, "%s/%s", fs_path, name);
+        furi_string_printf(child_tar, "%s/%s", tar_path, name);
+        if(file_info.flags & FSF_DIRECTORY) {
+            ok = theme_manager_archive_add_dir(
+                export, furi_string_get_cstr(child_fs), furi_string_get_cstr(child_tar));
+        } else {
+            ok = theme_manager_archive_add_file(
+                export,
+                furi_string_get_cstr(child_fs),
+                furi_string_get_cstr(child_tar),
+                file_info.size);
+        }
+    }
+
+    furi_string_free(child_tar);
+    furi_string_free(child_fs);
+    storage_dir_close(dir);
+    storage_file_free(dir);
+    return ok;
+}
+
+/* Library themes: their animations come out of the store by name */
+typedef struct {
+    ArchiveExport* export;
+    const char* top;
+    FuriString* tar_path;
+    bool ok;
+} ArchiveLibraryExport;
+
+static bool theme_manager_archive_library_anim(
+    const char* anim_name,
+    const char* anim_dir,
+    void* context) {
+    ArchiveLibraryExport* library = context;
+    if(!anim_dir) {
+        FURI_LOG_E(TAG, "%s missing from the library store", anim_name);
+        library->ok = false;
+        return false;
+    }
+
+    furi_string_printf(library->tar_path, "%s/%s", library->top, anim_name);
+    library->ok = theme_manager_archive_add_dir(
+        library->export, anim_dir, furi_string_get_cstr(library->tar_path));
+    return library->ok;
+}
+
+// -------------------------------------------------------------------
+// Export theme <root>/<name> as a bundle in ANIMATION_PACKS_PATH
+// Archive entries sit under a <name>/ folder, so importing the bundle
+// gives back a theme of the same name and type (library themes come
+// out as plain packs). out_name receives the bundle's file name
+// -------------------------------------------------------------------
+bool theme_manager_archive_export(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    bool compress,
+    char* out_name,
+    size_t out_name_size,
+    ThemeExportStats* stats,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    memset(stats, 0, sizeof(ThemeExportStats));
+
+    ArchiveExport* export = malloc(sizeof(ArchiveExport));
+    memset(export, 0, sizeof(ArchiveExport));
+    export->storage = storage;
+    export->file = storage_file_alloc(storage);
+    export->ok = true;
+    export->stats = stats;
+    export->progress_callback = progress_callback;
+    export->stop_callback = stop_callback;
+    export->context = context;
+
+    FuriString* src = furi_string_alloc_printf("%s/%s", root, name);
+    FuriString* out_path = furi_string_alloc();
+    FuriString* tmp_path = furi_string_alloc();
+    bool ok = false;
+
+    do {
+        uint64_t total = 0;
+        if(!theme_manager_get_theme_size(
+               storage, root, name, type, stop_callback, context, &total)) {
+            export->stopped = true;
+            break;
+        }
+        export->total_kb = total / 1024;
+
+        if(!theme_manager_archive_free_name(
+               storage,
+               ANIMATION_PACKS_PATH,
+               name,
+               compress ? ARCHIVE_EXTENSION_HEATSHRINK : ARCHIVE_EXTENSION,
+               out_name,
+               out_name_size)) {
+            FURI_LOG_E(TAG, "No free bundle name for %s", name);
+            break;
+        }
+        furi_string_printf(out_path, "%s/%s", ANIMATION_PACKS_PATH, out_name);
+
+        /* Written under a name the theme list ignores until complete */
+        furi_string_printf(tmp_path, "%s.tmp", furi_string_get_cstr(out_path));
+        if(!storage_file_open(
+               export->file, furi_string_get_cstr(tmp_path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+            FURI_LOG_E(TAG, "Can't create %s", furi_string_get_cstr(tmp_path));
+            break;
+        }
+
+        if(compress) {
+            export->encoder = malloc(sizeof(ArchiveEncoder));
+            memset(export->encoder, 0, sizeof(ArchiveEncoder));
+            memset(export->encoder->head, 0xFF, sizeof(export->encoder->head));
+            memset(export->encoder->prev, 0xFF, sizeof(export->encoder->prev));
+
+            memcpy(export->out, HS_MAGIC, 4);
+            export->out[4] = HS_VERSION;
+            export->out[5] = HS_WINDOW_SZ2;
+            export->out[6] = HS_LOOKAHEAD_SZ2;
+            export->out_len = 7;
+        }
+
+        bool added;
+        if(type == ThemeTypeLibrary) {
+            FuriString* manifest = furi_string_alloc();
+            FuriString* tar_path = furi_string_alloc_printf("%s/", name);
+            FileInfo file_info;
+            theme_manager_get_manifest_path(manifest, root, name, type);
+
+            added = theme_manager_archive_write_header(
+                export, furi_string_get_cstr(tar_path), true, 0);
+            furi_string_cat_str(tar_path, MANIFEST_FILENAME);
+            added = added &&
+                    storage_common_stat(storage, furi_string_get_cstr(manifest), &file_info) ==
+                        FSE_OK &&
+                    theme_manager_archive_add_file(
+                        export,
+                        furi_string_get_cstr(manifest),
+                        furi_string_get_cstr(tar_path),
+                        file_info.size);
+            if(added) {
+                ArchiveLibraryExport library = {
+                    .export = export,
+                    .top = name,
+                    .tar_path = tar_path,
+                    .ok = true,
+                };
+                added = theme_manager_foreach_manifest_anim(
+                            storage,
+                            root,
+                            name,
+                            type,
+                            theme_manager_archive_library_anim,
+                            &library,
+                            NULL) &&
+                        library.ok;
+            }
+
+            furi_string_free(tar_path);
+            furi_string_free(manifest);
+        } else {
+            added = theme_manager_archive_add_dir(export, furi_string_get_cstr(src), name);
+        }
+
+        /* End of archive: two zero blocks */
+        if(added) {
+            theme_manager_archive_write(export, tar_zero_block, TAR_BLOCK_SIZE);
+            theme_manager_archive_write(export, tar_zero_block, TAR_BLOCK_SIZE);
+        }
+        if(export->encoder) {
+            theme_manager_archive_enc_process(export, true);
+            if(export->encoder->bit_count) {
+                theme_manager_archive_enc_bits(export, 0, 8 - export->encoder->bit_count);
+            }
+        }
+        theme_manager_archive_out_flush(export);
+        storage_file_close(export->file);
+
+        if(!added || !export->ok) {
+            storage_common_remove(storage, furi_string_get_cstr(tmp_path));
+            break;
+        }
+
+        ok = storage_common_rename(
+                 storage, furi_string_get_cstr(tmp_path), furi_string_get_cstr(out_path)) ==
+             FSE_OK;
+    } while(false);
+
+    FURI_LOG_I(
+        TAG,
+        "Export %s: %s, %lu files, %llu -> %llu bytes",
+        name,
+        ok ? out_name : (export->stopped ? "cancelled" : "failed"),
+        stats->files,
+        stats->bytes_in,
+        stats->bytes_out);
+
+    furi_string_free(tmp_path);
+    furi_string_free(out_path);
+    furi_string_free(src);
+    if(export->encoder) free(export->encoder);
+    storage_file_free(export->file);
+    free(export);
+    return ok;
+}
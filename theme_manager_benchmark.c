@@ -0,0 +1,414 @@
+#include "theme_manager_i.h"
+
+#include <toolbox/version.h>
+
+/* Hidden benchmark: shown in the menu only with Settings > System > Debug on.
+ * Runs scripted cycles against the bundled test pack so SD cards and firmware
+ * builds can be compared on-device. Results are appended to BENCHMARK_RESULTS_PATH. */
+
+#define BENCHMARK_PACKS_PATH   APP_ASSETS_PATH("bench")
+#define BENCHMARK_SCRATCH_PATH APP_DATA_PATH("bench_scratch")
+#define BENCHMARK_IO_FILE      APP_DATA_PATH("bench_io.tmp")
+#define BENCHMARK_RESULTS_PATH APP_DATA_PATH("benchmark.txt")
+
+#define BENCHMARK_RUNS     10
+#define BENCHMARK_IO_SIZE  (128 * 1024)
+#define BENCHMARK_IO_CHUNK 4096
+
+typedef enum {
+    BenchmarkStepScan,
+    BenchmarkStepInfo,
+    BenchmarkStepPreview,
+    BenchmarkStepApply,
+    BenchmarkStepDelete,
+    BenchmarkStepWrite,
+    BenchmarkStepRead,
+    BenchmarkStepTreeRead,
+    BenchmarkStepTreeReadPlain,
+    BenchmarkStepCount,
+} BenchmarkStep;
+
+static const char* const benchmark_step_names[BenchmarkStepCount] = {
+    "scan",
+    "info",
+    "preview",
+    "apply",
+    "delete",
+    "sd write",
+    "sd read",
+    "tree read",
+    "tree read, no prealloc",
+};
+
+typedef struct {
+    uint32_t samples[BenchmarkStepCount][BENCHMARK_RUNS];
+    uint32_t runs_done;
+
+    char names[MAX_THEMES][MAX_NAME_LEN];
+    ThemeType types[MAX_THEMES];
+    uint32_t count;
+} Benchmark;
+
+// -------------------------------------------------------------------
+// Microsecond stopwatch on the DWT cycle counter
+// Differences are taken in cycles, so wrap-around is harmless
+// -------------------------------------------------------------------
+static inline uint32_t theme_manager_benchmark_start_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t theme_manager_benchmark_elapsed_us(uint32_t start) {
+    return (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+}
+
+// -------------------------------------------------------------------
+// Read every file under path, folder by folder as the firmware loads
+// an installed theme; bytes read are added to *bytes
+// -------------------------------------------------------------------
+static void theme_manager_benchmark_read_tree(
+    Storage* storage,
+    const char* path,
+    uint8_t* buf,
+    uint64_t* bytes) {
+    File* dir = storage_file_alloc(storage);
+    File* file = storage_file_alloc(storage);
+    FuriString* child = furi_string_alloc();
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+
+    if(storage_dir_open(dir, path)) {
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            furi_string_printf(child, "%s/%s", path, name);
+            if(file_info.flags & FSF_DIRECTORY) {
+                theme_manager_benchmark_read_tree(
+                    storage, furi_string_get_cstr(child), buf, bytes);
+            } else if(storage_file_open(
+                          file, furi_string_get_cstr(child), FSAM_READ, FSOM_OPEN_EXISTING)) {
+                size_t bytes_read;
+                while((bytes_read = storage_file_read(file, buf, BENCHMARK_IO_CHUNK)) > 0) {
+                    *bytes += bytes_read;
+                }
+                storage_file_close(file);
+            }
+        }
+        storage_dir_close(dir);
+    }
+
+    furi_string_free(child);
+    storage_file_free(file);
+    storage_file_free(dir);
+}
+
+// -------------------------------------------------------------------
+// Read speed of the installed scratch tree, in KB/s
+// -------------------------------------------------------------------
+static uint32_t theme_manager_benchmark_tree_speed(ThemeManagerApp* app) {
+    uint8_t* buf = malloc(BENCHMARK_IO_CHUNK);
+    uint64_t bytes = 0;
+
+    uint32_t start = theme_manager_benchmark_start_cycles();
+    theme_manager_benchmark_read_tree(app->storage, BENCHMARK_SCRATCH_PATH, buf, &bytes);
+    uint32_t us = theme_manager_benchmark_elapsed_us(start);
+
+    free(buf);
+    return (uint32_t)(bytes * 1000000 / 1024 / (us ? us : 1));
+}
+
+// -------------------------------------------------------------------
+// One scripted cycle: scan, info, preview, apply, read back, delete,
+// then the same apply and read back without preallocation to compare
+// -------------------------------------------------------------------
+static bool theme_manager_benchmark_cycle(ThemeManagerApp* app, Benchmark* bench, uint32_t run) {
+    uint32_t start;
+
+    start = theme_manager_benchmark_start_cycles();
+    bench->count = theme_manager_scan_dir(
+        app->storage, BENCHMARK_PACKS_PATH, bench->names, bench->types, MAX_THEMES);
+    bench->samples[BenchmarkStepScan][run] = theme_manager_benchmark_elapsed_us(start);
+
+    if(bench->count == 0) {
+        FURI_LOG_E(TAG, "Benchmark: test pack missing in %s", BENCHMARK_PACKS_PATH);
+        return false;
+    }
+
+    const char* name = bench->names[0];
+    ThemeType type = bench->types[0];
+    FuriString* path = furi_string_alloc();
+    FuriString* frame_path = furi_string_alloc();
+
+    /* Info: what theme_manager_show_info() does — manifest count and size walk */
+    start = theme_manager_benchmark_start_cycles();
+    uint32_t anim_count = 0;
+    if(theme_manager_get_manifest_path(path, BENCHMARK_PACKS_PATH, name, type)) {
+        theme_manager_parse_manifest(app->storage, furi_string_get_cstr(path), &anim_count);
+    }
+    furi_string_printf(path, "%s/%s", BENCHMARK_PACKS_PATH, name);
+    theme_manager_get_dir_size(app->storage, furi_string_get_cstr(path));
+    bench->samples[BenchmarkStepInfo][run] = theme_manager_benchmark_elapsed_us(start);
+
+    /* Preview: resolve first frame, parse meta and decode */
+    start = theme_manager_benchmark_start_cycles();
+    bool ok = false;
+    uint8_t w = 0, h = 0;
+    if(theme_manager_get_preview_paths(
+           app->storage, BENCHMARK_PACKS_PATH, name, type, path, frame_path) &&
+       theme_manager_parse_meta_dimensions(app->storage, furi_string_get_cstr(path), &w, &h)) {
+        size_t decoded_size = ((size_t)((w + 7) / 8)) * h;
+        uint8_t* decoded = malloc(decoded_size);
+        ok = theme_manager_decode_frame(
+            app->storage, furi_string_get_cstr(frame_path), w, h, decoded, decoded_size);
+        free(decoded);
+    }
+    bench->samples[BenchmarkStepPreview][run] = theme_manager_benchmark_elapsed_us(start);
+
+    furi_string_free(frame_path);
+    furi_string_free(path);
+
+    if(!ok) {
+        FURI_LOG_E(TAG, "Benchmark: preview decode failed");
+        return false;
+    }
+
+    /* Apply into a scratch directory, never the live dolphin folder */
+    start = theme_manager_benchmark_start_cycles();
+    ok = theme_manager_install_theme(
+        app->storage, BENCHMARK_PACKS_PATH, name, type, BENCHMARK_SCRATCH_PATH);
+    bench->samples[BenchmarkStepApply][run] = theme_manager_benchmark_elapsed_us(start);
+    if(ok) bench->samples[BenchmarkStepTreeRead][run] = theme_manager_benchmark_tree_speed(app);
+
+    start = theme_manager_benchmark_start_cycles();
+    storage_simply_remove_recursive(app->storage, BENCHMARK_SCRATCH_PATH);
+    bench->samples[BenchmarkStepDelete][run] = theme_manager_benchmark_elapsed_us(start);
+
+    if(ok) {
+        theme_manager_copy_set_preallocate(false);
+        ok = theme_manager_install_theme(
+            app->storage, BENCHMARK_PACKS_PATH, name, type, BENCHMARK_SCRATCH_PATH);
+        theme_manager_copy_set_preallocate(true);
+        if(ok) {
+            bench->samples[BenchmarkStepTreeReadPlain][run] =
+                theme_manager_benchmark_tree_speed(app);
+        }
+        storage_simply_remove_recursive(app->storage, BENCHMARK_SCRATCH_PATH);
+    }
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Raw SD throughput: sequential write then read of BENCHMARK_IO_SIZE
+// Samples are stored as KB/s
+// -------------------------------------------------------------------
+static bool theme_manager_benchmark_io(ThemeManagerApp* app, Benchmark* bench, uint32_t run) {
+    uint8_t* buf = malloc(BENCHMARK_IO_CHUNK);
+    for(size_t i = 0; i < BENCHMARK_IO_CHUNK; i++) {
+        buf[i] = (uint8_t)(i * 31 + run);
+    }
+
+    File* file = storage_file_alloc(app->storage);
+    bool ok = false;
+
+    do {
+        if(!storage_file_open(file, BENCHMARK_IO_FILE, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        uint32_t start = theme_manager_benchmark_start_cycles();
+        size_t total = 0;
+        while(total < BENCHMARK_IO_SIZE) {
+            if(storage_file_write(file, buf, BENCHMARK_IO_CHUNK) != BENCHMARK_IO_CHUNK) break;
+            total += BENCHMARK_IO_CHUNK;
+        }
+        storage_file_sync(file);
+        uint32_t write_us = theme_manager_benchmark_elapsed_us(start);
+        storage_file_close(file);
+        if(total != BENCHMARK_IO_SIZE) break;
+
+        if(!storage_file_open(file, BENCHMARK_IO_FILE, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+
+        start = theme_manager_benchmark_start_cycles();
+        total = 0;
+        size_t bytes_read;
+        while((bytes_read = storage_file_read(file, buf, BENCHMARK_IO_CHUNK)) > 0) {
+            total += bytes_read;
+        }
+        uint32_t read_us = theme_manager_benchmark_elapsed_us(start);
+        storage_file_close(file);
+        if(total != BENCHMARK_IO_SIZE) break;
+
+        /* KB/s = (bytes / 1024) / (us / 1e6) */
+        bench->samples[BenchmarkStepWrite][run] =
+            (uint32_t)((uint64_t)BENCHMARK_IO_SIZE * 1000000 / 1024 / (write_us ? write_us : 1));
+        bench->samples[BenchmarkStepRead][run] =
+            (uint32_t)((uint64_t)BENCHMARK_IO_SIZE * 1000000 / 1024 / (read_us ? read_us : 1));
+        ok = true;
+    } while(false);
+
+    storage_file_free(file);
+    storage_simply_remove(app->storage, BENCHMARK_IO_FILE);
+    free(buf);
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Sort samples in place (n <= BENCHMARK_RUNS, insertion sort is plenty)
+// -------------------------------------------------------------------
+static void theme_manager_benchmark_sort(uint32_t* samples, uint32_t n) {
+    for(uint32_t i = 1; i < n; i++) {
+        uint32_t v = samples[i];
+        uint32_t j = i;
+        while(j > 0 && samples[j - 1] > v) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = v;
+    }
+}
+
+// -------------------------------------------------------------------
+// Nearest-rank percentile of sorted samples
+// -------------------------------------------------------------------
+static uint32_t
+    theme_manager_benchmark_percentile(const uint32_t* sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (n * pct + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static uint32_t theme_manager_benchmark_median(const uint32_t* sorted, uint32_t n) {
+    return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+// -------------------------------------------------------------------
+// Format report into app->text_box_text
+// -------------------------------------------------------------------
+static void theme_manager_benchmark_report(ThemeManagerApp* app, Benchmark* bench) {
+    FuriString* report = app->text_box_text;
+    furi_string_reset(report);
+
+    const Version* version = furi_hal_version_get_firmware_version();
+    furi_string_cat_printf(
+        report,
+        "FW: %s (%s)\n",
+        version ? version_get_version(version) : "?",
+        version ? version_get_githash(version) : "?");
+
+    SDInfo sd_info;
+    if(storage_sd_info(app->storage, &sd_info) == FSE_OK) {
+        furi_string_cat_printf(
+            report,
+            "SD: %02X %.2s %.5s v%u.%u\nSN: %08lX %u/%u\n",
+            sd_info.manufacturer_id,
+            sd_info.oem_id,
+            sd_info.product_name,
+            sd_info.product_revision_major,
+            sd_info.product_revision_minor,
+            sd_info.product_serial_number,
+            sd_info.manufacturing_month,
+            sd_info.manufacturing_year);
+    }
+
+    furi_string_cat_printf(
+        report, "Copy buffer: %u B\n", theme_manager_copy_get_buffer_size(app->storage));
+
+    uint32_t n = bench->runs_done;
+    furi_string_cat_printf(report, "Runs: %lu\n", n);
+    if(n == 0) return;
+
+    furi_string_cat_printf(report, "Step: median / p95 (us)\n");
+    for(uint32_t step = 0; step < BenchmarkStepWrite; step++) {
+        uint32_t* samples = bench->samples[step];
+        theme_manager_benchmark_sort(samples, n);
+        furi_string_cat_printf(
+            report,
+            "%s: %lu / %lu\n",
+            benchmark_step_names[step],
+            theme_manager_benchmark_median(samples, n),
+            theme_manager_benchmark_percentile(samples, n, 95));
+    }
+
+    /* Higher is better for throughput: the slow tail is the 5th percentile */
+    furi_string_cat_printf(report, "SD: median / p5 (KB/s)\n");
+    for(uint32_t step = BenchmarkStepWrite; step < BenchmarkStepCount; step++) {
+        uint32_t* samples = bench->samples[step];
+        theme_manager_benchmark_sort(samples, n);
+        furi_string_cat_printf(
+            report,
+            "%s: %lu / %lu\n",
+            benchmark_step_names[step],
+            theme_manager_benchmark_median(samples, n),
+            theme_manager_benchmark_percentile(samples, n, 5));
+    }
+}
+
+static bool theme_manager_benchmark_save(ThemeManagerApp* app) {
+    File* file = storage_file_alloc(app->storage);
+    bool ok = false;
+
+    if(storage_file_open(file, BENCHMARK_RESULTS_PATH, FSAM_WRITE, FSOM_OPEN_APPEND)) {
+        FuriString* header = furi_string_alloc_printf(
+            "== Theme Manager benchmark @%lu ==\n", furi_hal_rtc_get_timestamp());
+        size_t len = furi_string_size(header);
+        ok = storage_file_write(file, furi_string_get_cstr(header), len) == len;
+        furi_string_free(header);
+
+        len = furi_string_size(app->text_box_text);
+        ok = ok && storage_file_write(file, furi_string_get_cstr(app->text_box_text), len) == len;
+        ok = ok && storage_file_write(file, "\n", 1) == 1;
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Job body — runs on the job thread
+// -------------------------------------------------------------------
+static bool theme_manager_benchmark_job(ThemeManagerApp* app, void* context) {
+    Benchmark* bench = context;
+    char status[MAX_LABEL_LEN];
+    bool ok = true;
+
+    storage_simply_remove_recursive(app->storage, BENCHMARK_SCRATCH_PATH);
+
+    for(uint32_t run = 0; run < BENCHMARK_RUNS && ok; run++) {
+        if(theme_manager_job_is_cancelled(app)) break;
+
+        snprintf(status, sizeof(status), "Run %lu/%d", run + 1, BENCHMARK_RUNS);
+        theme_manager_job_set_progress(app, run, BENCHMARK_RUNS, status);
+
+        ok = theme_manager_benchmark_cycle(app, bench, run) &&
+             theme_manager_benchmark_io(app, bench, run);
+        if(ok) bench->runs_done++;
+    }
+
+    theme_manager_job_set_progress(app, BENCHMARK_RUNS, BENCHMARK_RUNS, "Saving");
+    theme_manager_benchmark_report(app, bench);
+    if(bench->runs_done > 0 && !theme_manager_benchmark_save(app)) {
+        FURI_LOG_E(TAG, "Benchmark: can't write %s", BENCHMARK_RESULTS_PATH);
+    }
+
+    return ok;
+}
+
+static void theme_manager_benchmark_done(ThemeManagerApp* app, bool success, void* context) {
+    Benchmark* bench = context;
+
+    if(!success && bench->runs_done == 0) {
+        free(bench);
+        theme_manager_show_error(app, "Benchmark failed!\nTest pack missing?");
+        return;
+    }
+
+    free(bench);
+    theme_manager_show_text(app);
+}
+
+void theme_manager_benchmark_start(ThemeManagerApp* app) {
+    Benchmark* bench = malloc(sizeof(Benchmark));
+    memset(bench, 0, sizeof(Benchmark));
+
+    if(!theme_manager_job_start(
+           app, "Benchmark", theme_manager_benchmark_job, theme_manager_benchmark_done, bench)) {
+        free(bench);
+    }
+}
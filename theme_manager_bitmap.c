@@ -0,0 +1,121 @@
+#include "theme_manager_bitmap.h"
+
+#include <string.h>
+
+#if defined(__ARM_ARCH_7EM__)
+#include <cmsis_compiler.h>
+#define BITMAP_CORTEX_M4 1
+#else
+#define BITMAP_CORTEX_M4 0
+#endif
+
+#define BITMAP_ROW_WORDS ((UINT8_MAX + 32) / 32) /* widest uint8_t row */
+
+/* Row bytes from offset as a little-endian word: bit n is pixel
+ * offset * 8 + n. Past the end of the row reads as 0 */
+static inline uint32_t bitmap_load(const uint8_t* row, size_t offset, size_t row_bytes) {
+    if(offset + 4 <= row_bytes) {
+        return (uint32_t)row[offset] | ((uint32_t)row[offset + 1] << 8) |
+               ((uint32_t)row[offset + 2] << 16) | ((uint32_t)row[offset + 3] << 24);
+    }
+
+    uint32_t word = 0;
+    for(size_t i = 0; offset + i < row_bytes; i++) {
+        word |= (uint32_t)row[offset + i] << (i * 8);
+    }
+    return word;
+}
+
+/* Index of the lowest set bit; word must not be 0 */
+static inline uint8_t bitmap_lowest(uint32_t word) {
+#if BITMAP_CORTEX_M4
+    return __CLZ(__RBIT(word));
+#else
+    static const uint8_t debruijn[32] = {
+        0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9,
+    };
+    return debruijn[((word & -word) * 0x077CB531U) >> 27];
+#endif
+}
+
+// -------------------------------------------------------------------
+// Downscale. Each output column samples one source column, and scaling
+// down never samples one twice, so a table maps sampled source columns
+// to output columns and a mask per source word says which they are.
+// A row is then a few word loads, and only its set, sampled pixels are
+// written: sprites are mostly empty
+// -------------------------------------------------------------------
+void theme_manager_bitmap_downscale(
+    const uint8_t* src,
+    uint8_t src_w,
+    uint8_t src_h,
+    uint8_t* dst,
+    uint8_t max_w,
+    uint8_t max_h,
+    uint8_t* out_w,
+    uint8_t* out_h) {
+    uint8_t dst_w = src_w < max_w ? src_w : max_w;
+    uint8_t dst_h = src_h < max_h ? src_h : max_h;
+    uint8_t src_row_bytes = (src_w + 7) / 8;
+    uint8_t dst_row_bytes = (dst_w + 7) / 8;
+    uint8_t src_words = (src_row_bytes + 3) / 4;
+
+    uint8_t column[BITMAP_ROW_WORDS * 32];
+    uint32_t sampled[BITMAP_ROW_WORDS] = {0};
+    for(uint8_t px = 0; px < dst_w; px++) {
+        uint8_t sx = (src_w > max_w) ? (uint8_t)(px * src_w / max_w) : px;
+        column[sx] = px;
+        sampled[sx / 32] |= 1U << (sx % 32);
+    }
+
+    memset(dst, 0, (size_t)dst_row_bytes * dst_h);
+
+    for(uint8_t py = 0; py < dst_h; py++) {
+        uint8_t sy = (src_h > max_h) ? (uint8_t)(py * src_h / max_h) : py;
+        const uint8_t* src_row = src + (uint32_t)sy * src_row_bytes;
+        uint8_t* dst_row = dst + (uint32_t)py * dst_row_bytes;
+
+        for(uint8_t word_index = 0; word_index < src_words; word_index++) {
+            uint32_t word = bitmap_load(src_row, word_index * 4, src_row_bytes) &
+                            sampled[word_index];
+            while(word) {
+                uint8_t px = column[word_index * 32 + bitmap_lowest(word)];
+                dst_row[px / 8] |= 1 << (px % 8);
+                word &= word - 1;
+            }
+        }
+    }
+
+    *out_w = dst_w;
+    *out_h = dst_h;
+}
+
+// -------------------------------------------------------------------
+// Equality, four words per step. Byte order doesn't matter here, so
+// words are loaded as they lie: one LDR each, the M4 allows unaligned
+// ones
+// -------------------------------------------------------------------
+static inline uint32_t bitmap_word(const uint8_t* bytes) {
+    uint32_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+bool theme_manager_bitmap_equal(const uint8_t* a, const uint8_t* b, size_t size) {
+    size_t offset = 0;
+    for(; offset + 16 <= size; offset += 16) {
+        uint32_t diff = (bitmap_word(a + offset) ^ bitmap_word(b + offset)) |
+                        (bitmap_word(a + offset + 4) ^ bitmap_word(b + offset + 4)) |
+                        (bitmap_word(a + offset + 8) ^ bitmap_word(b + offset + 8)) |
+                        (bitmap_word(a + offset + 12) ^ bitmap_word(b + offset + 12));
+        if(diff) return false;
+    }
+    for(; offset + 4 <= size; offset += 4) {
+        if(bitmap_word(a + offset) != bitmap_word(b + offset)) return false;
+    }
+    for(; offset < size; offset++) {
+        if(a[offset] != b[offset]) return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bitmap kernels for 1 bpp frames: rows padded to a whole byte, the
+ * leftmost pixel in bit 0, as in .bm files and XBM. They work on 32-bit
+ * words and only visit set pixels, finding them with __RBIT/__CLZ on
+ * the Cortex-M4. Other targets get a plain C bit scan with the same
+ * results, so the host build (host/theme_manager_bench) checks the
+ * kernels against the per-pixel code. */
+
+/* Nearest-neighbour downscale into at most max_w x max_h, never up:
+ * pixel p samples floor(p * src / max) on each axis, as the info view
+ * always has. dst gets ((out_w + 7) / 8) * out_h bytes */
+void theme_manager_bitmap_downscale(
+    const uint8_t* src,
+    uint8_t src_w,
+    uint8_t src_h,
+    uint8_t* dst,
+    uint8_t max_w,
+    uint8_t max_h,
+    uint8_t* out_w,
+    uint8_t* out_h);
+
+/* memcmp(a, b, size) == 0, a word at a time */
+bool theme_manager_bitmap_equal(const uint8_t* a, const uint8_t* b, size_t size);
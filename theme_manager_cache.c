@@ -0,0 +1,682 @@
+#include "theme_manager_cache.h"
+#include "theme_manager_bitmap.h"
+
+#define TAG "ThemeManagerCache"
+
+#define INDEX_MAX_LINE 128
+#define INDEX_READ_CHUNK 256
+
+#define THUMB_MAGIC_0 'T'
+#define THUMB_MAGIC_1 'H'
+#define THUMB_VERSION 1
+#define THUMB_HEADER_SIZE 9 /* magic, version, w, h, stamp (LE) */
+
+#define TRASH_RECLAIM_BATCH 8
+
+// -------------------------------------------------------------------
+// Stamp of a theme: directory and key file (manifest or meta)
+// timestamps and key file size, then per animation folder the name and
+// size of every file, as the directory listing gives them, and the
+// timestamp of its meta.txt, folded together. FAT doesn't touch a
+// folder's time when a file in it changes, so the listing is what
+// catches a truncated, added or deleted frame
+// -------------------------------------------------------------------
+static uint32_t theme_manager_stamp_mix(uint32_t hash, uint32_t value) {
+    for(uint8_t i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static uint32_t theme_manager_stamp_mix_str(uint32_t hash, const char* str) {
+    for(; *str; str++) {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619UL;
+    }
+    return theme_manager_stamp_mix(hash, 0);
+}
+
+typedef struct {
+    Storage* storage;
+    File* dir;
+    FuriString* path;
+    uint32_t hash;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    bool stopped;
+} ThemeStampContext;
+
+static bool
+    theme_manager_stamp_anim(const char* anim_name, const char* anim_dir, void* context) {
+    ThemeStampContext* ctx = context;
+    ctx->hash = theme_manager_stamp_mix_str(ctx->hash, anim_name);
+
+    if(!anim_dir) return true;
+
+    uint32_t timestamp = 0;
+    furi_string_printf(ctx->path, "%s/%s", anim_dir, META_FILENAME);
+    storage_common_timestamp(ctx->storage, furi_string_get_cstr(ctx->path), &timestamp);
+    ctx->hash = theme_manager_stamp_mix(ctx->hash, timestamp);
+
+    FileInfo info;
+    char name[MAX_NAME_LEN];
+    bool ok = storage_dir_open(ctx->dir, anim_dir);
+    while(ok && storage_dir_read(ctx->dir, &info, name, sizeof(name))) {
+        if(ctx->stop_callback && ctx->stop_callback(ctx->context)) {
+            ctx->stopped = true;
+            break;
+        }
+        if(info.flags & FSF_DIRECTORY) continue;
+
+        ctx->hash = theme_manager_stamp_mix_str(ctx->hash, name);
+        ctx->hash = theme_manager_stamp_mix(ctx->hash, (uint32_t)info.size);
+    }
+    storage_dir_close(ctx->dir);
+    return !ctx->stopped;
+}
+
+bool theme_manager_theme_stamp(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint32_t* out_stamp) {
+    FuriString* path = furi_string_alloc_printf("%s/%s", root, name);
+    uint32_t hash = 2166136261UL;
+    uint32_t timestamp = 0;
+
+    storage_common_timestamp(storage, furi_string_get_cstr(path), &timestamp);
+    hash = theme_manager_stamp_mix(hash, timestamp);
+
+    /* Bundles and containers are stamped by the file itself */
+    if(type != ThemeTypeArchive && type != ThemeTypeContainer &&
+       !theme_manager_get_manifest_path(path, root, name, type)) {
+        furi_string_printf(path, "%s/%s/%s", root, name, META_FILENAME);
+    }
+
+    FileInfo info = {0};
+    timestamp = 0;
+    storage_common_timestamp(storage, furi_string_get_cstr(path), &timestamp);
+    storage_common_stat(storage, furi_string_get_cstr(path), &info);
+    hash = theme_manager_stamp_mix(hash, timestamp);
+    hash = theme_manager_stamp_mix(hash, (uint32_t)info.size);
+
+    ThemeStampContext ctx = {
+        .storage = storage,
+        .path = path,
+        .hash = hash,
+        .stop_callback = stop_callback,
+        .context = context,
+    };
+    if(type != ThemeTypeArchive && type != ThemeTypeContainer) {
+        ctx.dir = storage_file_alloc(storage);
+        theme_manager_foreach_manifest_anim(
+            storage, root, name, type, theme_manager_stamp_anim, &ctx, NULL);
+        storage_file_free(ctx.dir);
+    }
+
+    furi_string_free(path);
+    *out_stamp = ctx.hash;
+    return !ctx.stopped;
+}
+
+// -------------------------------------------------------------------
+// Index file: one theme per line
+//   <name>\t<stamp>\t<anim count>\t<size>\t<flags>\t<load ms>
+// Lines without the load cost (older index files) are accepted
+// -------------------------------------------------------------------
+static void theme_manager_index_parse_line(ThemeIndex* index, char* line) {
+    char* fields[6];
+    uint8_t count = 0;
+
+    fields[count++] = line;
+    for(char* ptr = line; *ptr && count < COUNT_OF(fields); ptr++) {
+        if(*ptr == '\t') {
+            *ptr = '\0';
+            fields[count++] = ptr + 1;
+        }
+    }
+    if(count < COUNT_OF(fields) - 1 || fields[0][0] == '\0') return;
+
+    ThemeIndexEntry* entry =
+        theme_manager_index_update(index, fields[0], strtoul(fields[1], NULL, 16));
+    if(!entry) return;
+
+    entry->anim_count = strtoul(fields[2], NULL, 10);
+    entry->size = strtoull(fields[3], NULL, 10);
+    entry->flags = strtoul(fields[4], NULL, 10);
+    if(count == COUNT_OF(fields)) {
+        entry->load_ms = strtoul(fields[5], NULL, 10);
+    } else {
+        entry->flags &= ~(ThemeIndexHasCost | ThemeIndexCostHeavy);
+    }
+}
+
+void theme_manager_index_load(Storage* storage, ThemeIndex* index) {
+    memset(index, 0, sizeof(ThemeIndex));
+
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, THEME_INDEX_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        storage_file_free(file);
+        return;
+    }
+
+    char chunk[INDEX_READ_CHUNK];
+    char line[INDEX_MAX_LINE];
+    size_t len = 0;
+    size_t bytes_read;
+
+    while((bytes_read = storage_file_read(file, chunk, sizeof(chunk))) > 0) {
+        for(size_t i = 0; i < bytes_read; i++) {
+            if(chunk[i] != '\n') {
+                if(len < sizeof(line) - 1) line[len++] = chunk[i];
+                continue;
+            }
+            line[len] = '\0';
+            len = 0;
+            theme_manager_index_parse_line(index, line);
+        }
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    index->dirty = false;
+    FURI_LOG_I(TAG, "Index: %lu entries", index->count);
+}
+
+void theme_manager_index_format(const ThemeIndex* index, FuriString* content) {
+    furi_string_reset(content);
+    for(uint32_t i = 0; i < index->count; i++) {
+        const ThemeIndexEntry* entry = &index->entries[i];
+        furi_string_cat_printf(
+            content,
+            "%s\t%08lX\t%lu\t%llu\t%u\t%lu\n",
+            entry->name,
+            entry->stamp,
+            entry->anim_count,
+            entry->size,
+            entry->flags,
+            entry->load_ms);
+    }
+}
+
+bool theme_manager_index_write(Storage* storage, const FuriString* content) {
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, THEME_INDEX_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS);
+    if(ok) {
+        size_t len = furi_string_size(content);
+        ok = storage_file_write(file, furi_string_get_cstr(content), len) == len;
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(!ok) FURI_LOG_E(TAG, "Index: save failed");
+    return ok;
+}
+
+bool theme_manager_index_save(Storage* storage, ThemeIndex* index) {
+    FuriString* content = furi_string_alloc();
+    theme_manager_index_format(index, content);
+    bool ok = theme_manager_index_write(storage, content);
+    furi_string_free(content);
+
+    if(ok) index->dirty = false;
+    return ok;
+}
+
+ThemeIndexEntry* theme_manager_index_find(ThemeIndex* index, const char* name) {
+    for(uint32_t i = 0; i < index->count; i++) {
+        if(strcmp(index->entries[i].name, name) == 0) return &index->entries[i];
+    }
+    return NULL;
+}
+
+// -------------------------------------------------------------------
+// Entry for name at the given stamp; a stale entry is reset
+// Returns NULL if the index is full
+// -------------------------------------------------------------------
+ThemeIndexEntry*
+    theme_manager_index_update(ThemeIndex* index, const char* name, uint32_t stamp) {
+    ThemeIndexEntry* entry = theme_manager_index_find(index, name);
+
+    if(!entry) {
+        if(index->count >= MAX_THEMES) return NULL;
+        entry = &index->entries[index->count++];
+        memset(entry, 0, sizeof(ThemeIndexEntry));
+        strncpy(entry->name, name, MAX_NAME_LEN - 1);
+        entry->stamp = stamp;
+        index->dirty = true;
+    } else if(entry->stamp != stamp) {
+        entry->stamp = stamp;
+        entry->anim_count = 0;
+        entry->size = 0;
+        entry->load_ms = 0;
+        entry->flags = 0;
+        index->dirty = true;
+    }
+
+    return entry;
+}
+
+// -------------------------------------------------------------------
+// Forget what is known about a theme whose content changed in place
+// (its stamp alone wouldn't tell)
+// -------------------------------------------------------------------
+void theme_manager_index_invalidate(ThemeIndex* index, const char* name) {
+    ThemeIndexEntry* entry = theme_manager_index_find(index, name);
+    if(entry && entry->flags) {
+        entry->flags = 0;
+        index->dirty = true;
+    }
+}
+
+// -------------------------------------------------------------------
+// Drop entries of themes that are no longer on the card
+// -------------------------------------------------------------------
+void theme_manager_index_prune(
+    ThemeIndex* index,
+    const char (*names)[MAX_NAME_LEN],
+    uint32_t count) {
+    uint32_t kept = 0;
+
+    for(uint32_t i = 0; i < index->count; i++) {
+        bool present = false;
+        for(uint32_t j = 0; j < count && !present; j++) {
+            present = strcmp(index->entries[i].name, names[j]) == 0;
+        }
+
+        if(present) {
+            if(kept != i) index->entries[kept] = index->entries[i];
+            kept++;
+        }
+    }
+
+    if(kept != index->count) {
+        index->count = kept;
+        index->dirty = true;
+    }
+}
+
+// -------------------------------------------------------------------
+// Thumbnails: first shown frame, downscaled to the preview box
+// -------------------------------------------------------------------
+static void theme_manager_thumb_path(FuriString* out, const char* name) {
+    furi_string_printf(out, "%s/%s.bin", THEME_THUMBS_DIR, name);
+}
+
+bool theme_manager_thumb_render(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    uint8_t* out,
+    uint8_t* out_w,
+    uint8_t* out_h) {
+    FuriString* meta_path = furi_string_alloc();
+    FuriString* frame_path = furi_string_alloc();
+    ThemeAnimMeta* meta = malloc(sizeof(ThemeAnimMeta));
+    uint8_t* frame = malloc(FRAME_MAX_SIZE);
+    bool ok = false;
+
+    do {
+        if(!theme_manager_get_preview_paths(storage, root, name, type, meta_path, frame_path))
+            break;
+        if(!theme_manager_parse_meta(storage, furi_string_get_cstr(meta_path), meta)) break;
+
+        size_t slash = furi_string_search_rchar(meta_path, '/', 0);
+        furi_string_left(meta_path, slash);
+        furi_string_printf(
+            frame_path, "%s/frame_%u.bm", furi_string_get_cstr(meta_path), meta->frame_order[0]);
+
+        if(!theme_manager_decode_frame(
+               storage,
+               furi_string_get_cstr(frame_path),
+               meta->width,
+               meta->height,
+               frame,
+               FRAME_MAX_SIZE)) {
+            break;
+        }
+
+        theme_manager_bitmap_downscale(
+            frame, meta->width, meta->height, out, THUMB_MAX_W, THUMB_MAX_H, out_w, out_h);
+        ok = true;
+    } while(false);
+
+    free(frame);
+    free(meta);
+    furi_string_free(frame_path);
+    furi_string_free(meta_path);
+
+    return ok;
+}
+
+bool theme_manager_thumb_build(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    uint32_t stamp,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    uint8_t thumb[THUMB_HEADER_SIZE + THUMB_MAX_SIZE];
+    uint8_t w, h;
+
+    if(stop_callback && stop_callback(context)) return false;
+    if(!theme_manager_thumb_render(storage, root, name, type, thumb + THUMB_HEADER_SIZE, &w, &h)) {
+        return false;
+    }
+    if(stop_callback && stop_callback(context)) return false;
+
+    thumb[0] = THUMB_MAGIC_0;
+    thumb[1] = THUMB_MAGIC_1;
+    thumb[2] = THUMB_VERSION;
+    thumb[3] = w;
+    thumb[4] = h;
+    for(uint8_t i = 0; i < 4; i++) {
+        thumb[5 + i] = (stamp >> (i * 8)) & 0xFF;
+    }
+    size_t size = THUMB_HEADER_SIZE + (size_t)((w + 7) / 8) * h;
+
+    storage_simply_mkdir(storage, THEME_THUMBS_DIR);
+    FuriString* path = furi_string_alloc();
+    theme_manager_thumb_path(path, name);
+
+    bool ok = false;
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, furi_string_get_cstr(path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        ok = storage_file_write(file, thumb, size) == size;
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    furi_string_free(path);
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Load a thumbnail; false if missing, corrupt or built for another stamp
+// -------------------------------------------------------------------
+bool theme_manager_thumb_load(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    uint8_t* out,
+    size_t out_size,
+    uint8_t* out_w,
+    uint8_t* out_h) {
+    FuriString* path = furi_string_alloc();
+    theme_manager_thumb_path(path, name);
+
+    File* file = storage_file_alloc(storage);
+    uint8_t header[THUMB_HEADER_SIZE];
+    bool ok = false;
+
+    if(storage_file_open(file, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        do {
+            if(storage_file_read(file, header, sizeof(header)) != sizeof(header)) break;
+            if(header[0] != THUMB_MAGIC_0 || header[1] != THUMB_MAGIC_1 ||
+               header[2] != THUMB_VERSION)
+                break;
+
+            uint32_t file_stamp = 0;
+            for(uint8_t i = 0; i < 4; i++) {
+                file_stamp |= (uint32_t)header[5 + i] << (i * 8);
+            }
+            if(file_stamp != stamp) break;
+
+            uint8_t w = header[3];
+            uint8_t h = header[4];
+            size_t size = (size_t)((w + 7) / 8) * h;
+            if(w == 0 || h == 0 || w > THUMB_MAX_W || h > THUMB_MAX_H || size > out_size) break;
+            if(storage_file_read(file, out, size) != size) break;
+
+            *out_w = w;
+            *out_h = h;
+            ok = true;
+        } while(false);
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    furi_string_free(path);
+    return ok;
+}
+
+void theme_manager_thumb_remove(Storage* storage, const char* name) {
+    FuriString* path = furi_string_alloc();
+    theme_manager_thumb_path(path, name);
+    storage_common_remove(storage, furi_string_get_cstr(path));
+    furi_string_free(path);
+}
+
+// -------------------------------------------------------------------
+// Move a tree into the trash (a rename, so instant on FAT)
+// Falls back to deleting in place if the rename fails
+// -------------------------------------------------------------------
+bool theme_manager_trash_move(Storage* storage, const char* path) {
+    storage_simply_mkdir(storage, THEME_TRASH_DIR);
+
+    FuriString* trash_path = furi_string_alloc();
+    uint32_t tick = furi_get_tick();
+    uint32_t attempt = 0;
+
+    do {
+        furi_string_printf(trash_path, "%s/%08lX_%lu", THEME_TRASH_DIR, tick, attempt++);
+    } while(storage_common_exists(storage, furi_string_get_cstr(trash_path)));
+
+    FS_Error err = storage_common_rename(storage, path, furi_string_get_cstr(trash_path));
+    bool ok = err == FSE_OK;
+
+    if(ok) {
+        FURI_LOG_I(TAG, "Trashed %s -> %s", path, furi_string_get_cstr(trash_path));
+    } else {
+        FURI_LOG_W(TAG, "Trash rename failed (err %d), deleting %s", err, path);
+        ok = storage_simply_remove_recursive(storage, path);
+    }
+
+    furi_string_free(trash_path);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Reclaim a little of the trash: descend to the first leaf directory,
+// delete up to TRASH_RECLAIM_BATCH files there, or the leaf itself once
+// it is empty. Returns true while there is work left.
+// -------------------------------------------------------------------
+bool theme_manager_trash_reclaim_step(
+    Storage* storage,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    FuriString* path = furi_string_alloc_set_str(THEME_TRASH_DIR);
+    FuriString* file_path = furi_string_alloc();
+    char (*files)[MAX_NAME_LEN] = malloc(TRASH_RECLAIM_BATCH * MAX_NAME_LEN);
+    char name[MAX_NAME_LEN];
+    FileInfo info;
+    bool more = false;
+
+    while(true) {
+        File* dir = storage_file_alloc(storage);
+        if(!storage_dir_open(dir, furi_string_get_cstr(path))) {
+            storage_file_free(dir);
+            break;
+        }
+
+        uint32_t file_count = 0;
+        bool descend = false;
+        while(storage_dir_read(dir, &info, name, sizeof(name))) {
+            if(info.flags & FSF_DIRECTORY) {
+                furi_string_cat_printf(path, "/%s", name);
+                descend = true;
+                break;
+            }
+            if(file_count < TRASH_RECLAIM_BATCH) {
+                strncpy(files[file_count], name, MAX_NAME_LEN);
+                file_count++;
+            }
+        }
+
+        storage_dir_close(dir);
+        storage_file_free(dir);
+
+        if(descend) continue;
+
+        if(file_count > 0) {
+            more = true;
+            for(uint32_t i = 0; i < file_count; i++) {
+                if(stop_callback && stop_callback(context)) break;
+                furi_string_printf(file_path, "%s/%s", furi_string_get_cstr(path), files[i]);
+                if(storage_common_remove(storage, furi_string_get_cstr(file_path)) != FSE_OK) {
+                    FURI_LOG_E(TAG, "Reclaim: can't remove %s", furi_string_get_cstr(file_path));
+                    more = false;
+                    break;
+                }
+            }
+        } else if(furi_string_cmp_str(path, THEME_TRASH_DIR) != 0) {
+            /* Empty leaf directory */
+            more = storage_common_remove(storage, furi_string_get_cstr(path)) == FSE_OK;
+        }
+        break;
+    }
+
+    free(files);
+    furi_string_free(file_path);
+    furi_string_free(path);
+
+    return more;
+}
+
+// -------------------------------------------------------------------
+// Resume state: "<pack dir>\n<min gain> <animations done>\n"
+// -------------------------------------------------------------------
+bool theme_manager_compress_load_state(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeCompressParams* params,
+    uint32_t* anims_done) {
+    FuriString* text = furi_string_alloc();
+    bool found = false;
+
+    if(theme_manager_read_text(storage, COMPRESS_STATE_PATH, text)) {
+        size_t eol = furi_string_search_char(text, '\n', 0);
+        unsigned gain = 0;
+        unsigned long done = 0;
+
+        if(eol != FURI_STRING_FAILURE && eol == strlen(pack_dir) &&
+           strncmp(furi_string_get_cstr(text), pack_dir, eol) == 0 &&
+           sscanf(furi_string_get_cstr(text) + eol + 1, "%u %lu", &gain, &done) == 2 &&
+           gain < 100) {
+            params->min_gain_pct = gain;
+            *anims_done = done;
+            found = true;
+        }
+    }
+
+    furi_string_free(text);
+    return found;
+}
+
+void theme_manager_compress_save_state(
+    Storage* storage,
+    const char* pack_dir,
+    const ThemeCompressParams* params,
+    uint32_t anims_done) {
+    FuriString* text = furi_string_alloc_printf(
+        "%s\n%u %lu\n", pack_dir, params->min_gain_pct, anims_done);
+
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, COMPRESS_STATE_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        storage_file_write(file, furi_string_get_cstr(text), furi_string_size(text));
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    furi_string_free(text);
+}
+
+// -------------------------------------------------------------------
+// Result cache: VERIFY_CACHE_DIR/<name>.txt
+//   <stamp>\t<anims>\t<bad>\t<frames>\t<errors>\t<unlisted>\n<report>
+// -------------------------------------------------------------------
+static void theme_manager_verify_cache_path(FuriString* out, const char* name) {
+    furi_string_printf(out, "%s/%s.txt", VERIFY_CACHE_DIR, name);
+}
+
+bool theme_manager_verify_cache_load(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    ThemeVerifyStats* stats,
+    FuriString* report) {
+    FuriString* path = furi_string_alloc();
+    theme_manager_verify_cache_path(path, name);
+
+    bool ok = theme_manager_read_text(storage, furi_string_get_cstr(path), report);
+    if(ok) {
+        const char* text = furi_string_get_cstr(report);
+        uint32_t cached_stamp = 0;
+        int consumed = 0;
+
+        ok = sscanf(
+                 text,
+                 "%lx\t%lu\t%lu\t%lu\t%lu\t%lu\n%n",
+                 &cached_stamp,
+                 &stats->anims_checked,
+                 &stats->anims_bad,
+                 &stats->frames_checked,
+                 &stats->errors,
+                 &stats->anims_unlisted,
+                 &consumed) == 6 &&
+             consumed > 0 && cached_stamp == stamp;
+        if(ok) furi_string_right(report, consumed);
+    }
+
+    if(!ok) {
+        memset(stats, 0, sizeof(ThemeVerifyStats));
+        furi_string_reset(report);
+    }
+
+    furi_string_free(path);
+    return ok;
+}
+
+void theme_manager_verify_cache_save(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    const ThemeVerifyStats* stats,
+    FuriString* report) {
+    storage_simply_mkdir(storage, VERIFY_CACHE_DIR);
+
+    FuriString* path = furi_string_alloc();
+    FuriString* text = furi_string_alloc_printf(
+        "%08lX\t%lu\t%lu\t%lu\t%lu\t%lu\n",
+        stamp,
+        stats->anims_checked,
+        stats->anims_bad,
+        stats->frames_checked,
+        stats->errors,
+        stats->anims_unlisted);
+    furi_string_cat(text, report);
+    theme_manager_verify_cache_path(path, name);
+
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, furi_string_get_cstr(path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        storage_file_write(file, furi_string_get_cstr(text), furi_string_size(text));
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    furi_string_free(text);
+    furi_string_free(path);
+}
+
+void theme_manager_verify_cache_remove(Storage* storage, const char* name) {
+    FuriString* path = furi_string_alloc();
+    theme_manager_verify_cache_path(path, name);
+    storage_common_remove(storage, furi_string_get_cstr(path));
+    furi_string_free(path);
+}
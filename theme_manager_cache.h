@@ -0,0 +1,128 @@
+#pragma once
+
+#include "theme_manager_core.h"
+
+/* Derived data kept on SD so the UI doesn't have to recompute it:
+ * the theme index (anim counts, sizes), first-frame thumbnails, verify
+ * results, the compress resume point and the trash directory that
+ * deleted trees are moved into until reclaimed.
+ * Entries are keyed by a theme stamp; a changed stamp invalidates them. */
+
+#define THEME_INDEX_PATH APP_DATA_PATH("index.txt")
+#define THEME_THUMBS_DIR APP_DATA_PATH("thumbs")
+#define THEME_TRASH_DIR  APP_DATA_PATH("trash")
+
+#define VERIFY_CACHE_DIR    APP_DATA_PATH("verify")
+#define COMPRESS_STATE_PATH APP_DATA_PATH("compress_state.txt")
+
+#define THUMB_MAX_W 48
+#define THUMB_MAX_H 32
+#define THUMB_MAX_SIZE ((THUMB_MAX_W / 8) * THUMB_MAX_H)
+
+typedef enum {
+    ThemeIndexHasCount = (1 << 0),
+    ThemeIndexHasSize = (1 << 1),
+    ThemeIndexHasThumb = (1 << 2),
+    ThemeIndexHasCost = (1 << 3),
+    ThemeIndexCostHeavy = (1 << 4), /* some animation is over THEME_COST_HEAVY_MS */
+} ThemeIndexFlag;
+
+typedef struct {
+    char name[MAX_NAME_LEN];
+    uint32_t stamp;
+    uint32_t anim_count;
+    uint64_t size;
+    uint32_t load_ms; /* slowest animation, estimated */
+    uint8_t flags;
+} ThemeIndexEntry;
+
+typedef struct {
+    ThemeIndexEntry entries[MAX_THEMES];
+    uint32_t count;
+    bool dirty;
+} ThemeIndex;
+
+/* Index stamp of an entry made without walking the theme */
+#define THEME_STAMP_UNKNOWN 0
+
+/* Changes whenever the theme's files do; walks every animation folder,
+ * so it takes a stop callback. Returns false if stopped */
+bool theme_manager_theme_stamp(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint32_t* out_stamp);
+
+void theme_manager_index_load(Storage* storage, ThemeIndex* index);
+bool theme_manager_index_save(Storage* storage, ThemeIndex* index);
+/* index_save in two halves, so the file can be written without holding
+ * whatever guards the index */
+void theme_manager_index_format(const ThemeIndex* index, FuriString* content);
+bool theme_manager_index_write(Storage* storage, const FuriString* content);
+ThemeIndexEntry* theme_manager_index_find(ThemeIndex* index, const char* name);
+ThemeIndexEntry*
+    theme_manager_index_update(ThemeIndex* index, const char* name, uint32_t stamp);
+void theme_manager_index_invalidate(ThemeIndex* index, const char* name);
+void theme_manager_index_prune(
+    ThemeIndex* index,
+    const char (*names)[MAX_NAME_LEN],
+    uint32_t count);
+
+bool theme_manager_thumb_render(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    uint8_t* out,
+    uint8_t* out_w,
+    uint8_t* out_h);
+bool theme_manager_thumb_build(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    uint32_t stamp,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+bool theme_manager_thumb_load(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    uint8_t* out,
+    size_t out_size,
+    uint8_t* out_w,
+    uint8_t* out_h);
+void theme_manager_thumb_remove(Storage* storage, const char* name);
+
+bool theme_manager_trash_move(Storage* storage, const char* path);
+bool theme_manager_trash_reclaim_step(
+    Storage* storage,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+bool theme_manager_compress_load_state(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeCompressParams* params,
+    uint32_t* anims_done);
+void theme_manager_compress_save_state(
+    Storage* storage,
+    const char* pack_dir,
+    const ThemeCompressParams* params,
+    uint32_t anims_done);
+bool theme_manager_verify_cache_load(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    ThemeVerifyStats* stats,
+    FuriString* report);
+void theme_manager_verify_cache_save(
+    Storage* storage,
+    const char* name,
+    uint32_t stamp,
+    const ThemeVerifyStats* stats,
+    FuriString* report);
+void theme_manager_verify_cache_remove(Storage* storage, const char* name);
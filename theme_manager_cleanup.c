@@ -0,0 +1,232 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManagerCleanup"
+
+/* Installed dolphin cleanup. Merging themes into the dolphin folder never
+ * removes anything, so over time it collects animation folders the
+ * manifest no longer names, and manifest entries whose folder (or its
+ * meta.txt) is gone. The scan cross-references the two; cleanup moves the
+ * orphaned folders to the trash and rewrites the manifest without the
+ * dangling entries (through a temporary file, since FAT can't rename
+ * over an existing one). */
+
+#define CLEANUP_REPORT_MAX 1024
+
+/* Line starting at `ptr` is a manifest entry: return its name */
+static bool theme_manager_cleanup_entry_name(const char* ptr, char* out, size_t out_size) {
+    if(strncmp(ptr, "Name:", 5) != 0) return false;
+
+    ptr += 5;
+    while(*ptr == ' ')
+        ptr++;
+
+    size_t len = 0;
+    while(ptr[len] && ptr[len] != '\n' && ptr[len] != '\r')
+        len++;
+    while(len > 0 && ptr[len - 1] == ' ')
+        len--;
+    if(len == 0 || len >= out_size) return false;
+
+    memcpy(out, ptr, len);
+    out[len] = '\0';
+    return true;
+}
+
+static void theme_manager_cleanup_report(FuriString* report, const char* tag, const char* name) {
+    if(!report) return;
+    if(furi_string_size(report) >= CLEANUP_REPORT_MAX) return;
+    furi_string_cat_printf(report, "%s %s\n", tag, name);
+}
+
+// -------------------------------------------------------------------
+// Drop the entry blocks (from their Name: line up to the next one)
+// whose name is in `dangling` and write the manifest back
+// -------------------------------------------------------------------
+static bool theme_manager_cleanup_rewrite_manifest(
+    Storage* storage,
+    const char* manifest_path,
+    FuriString* text,
+    FuriString* dangling) {
+    FuriString* out = furi_string_alloc();
+    FuriString* key = furi_string_alloc();
+    char name[MAX_NAME_LEN];
+    bool keep = true;
+
+    const char* line = furi_string_get_cstr(text);
+    while(*line) {
+        const char* eol = strchr(line, '\n');
+        size_t len = eol ? (size_t)(eol - line + 1) : strlen(line);
+
+        if(theme_manager_cleanup_entry_name(line, name, sizeof(name))) {
+            furi_string_printf(key, "\n%s\n", name);
+            keep = furi_string_search(dangling, key, 0) == FURI_STRING_FAILURE;
+        }
+        if(keep) furi_string_cat_printf(out, "%.*s", (int)len, line);
+
+        line += len;
+    }
+
+    /* The original is moved aside, not removed, until the new one is in
+     * place: whatever fails, one of them is left as manifest.txt */
+    FuriString* tmp_path = furi_string_alloc_printf("%s.tmp", manifest_path);
+    FuriString* old_path = furi_string_alloc_printf("%s.old", manifest_path);
+    File* file = storage_file_alloc(storage);
+    bool ok = false;
+
+    if(storage_file_open(file, furi_string_get_cstr(tmp_path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        size_t size = furi_string_size(out);
+        ok = storage_file_write(file, furi_string_get_cstr(out), size) == size;
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(ok) {
+        storage_common_remove(storage, furi_string_get_cstr(old_path));
+        ok = storage_common_rename(storage, manifest_path, furi_string_get_cstr(old_path)) ==
+             FSE_OK;
+    }
+    if(ok) {
+        ok = storage_common_rename(storage, furi_string_get_cstr(tmp_path), manifest_path) ==
+             FSE_OK;
+        if(ok) {
+            storage_common_remove(storage, furi_string_get_cstr(old_path));
+        } else if(
+            storage_common_rename(storage, furi_string_get_cstr(old_path), manifest_path) !=
+            FSE_OK) {
+            /* Neither is manifest.txt now: leave both for a manual fix */
+            FURI_LOG_E(TAG, "Manifest left as %s", furi_string_get_cstr(tmp_path));
+            furi_string_reset(tmp_path);
+        }
+    }
+    if(!ok) {
+        FURI_LOG_E(TAG, "Manifest rewrite failed");
+        if(!furi_string_empty(tmp_path)) {
+            storage_common_remove(storage, furi_string_get_cstr(tmp_path));
+        }
+    }
+
+    furi_string_free(old_path);
+    furi_string_free(tmp_path);
+    furi_string_free(key);
+    furi_string_free(out);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Scan the installed dolphin folder, and clean it up if `apply` is set
+// Returns false if stopped during the scan (nothing is changed then)
+// or if the cleanup failed
+// -------------------------------------------------------------------
+bool theme_manager_cleanup_dolphin(
+    Storage* storage,
+    const char* dolphin_dir,
+    bool apply,
+    ThemeCleanupStats* stats,
+    FuriString* report,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    memset(stats, 0, sizeof(ThemeCleanupStats));
+    if(report) furi_string_reset(report);
+
+    FuriString* manifest_path = furi_string_alloc_printf("%s/%s", dolphin_dir, MANIFEST_FILENAME);
+    FuriString* text = furi_string_alloc();
+    FuriString* valid = furi_string_alloc_set_str("\n"); /* "\n<name>\n..." */
+    FuriString* dangling = furi_string_alloc_set_str("\n");
+    FuriString* orphans = furi_string_alloc(); /* "<name>\n..." */
+    FuriString* path = furi_string_alloc();
+    FuriString* key = furi_string_alloc();
+    char name[MAX_NAME_LEN];
+    bool ok = false;
+
+    do {
+        if(!theme_manager_read_text(storage, furi_string_get_cstr(manifest_path), text)) break;
+        if(strstr(furi_string_get_cstr(text), MANIFEST_HEADER) == NULL) break;
+
+        /* Manifest entries: live if the folder has a meta.txt */
+        const char* line = furi_string_get_cstr(text);
+        while(line) {
+            if(theme_manager_cleanup_entry_name(line, name, sizeof(name))) {
+                stats->manifest_entries++;
+                furi_string_printf(path, "%s/%s/%s", dolphin_dir, name, META_FILENAME);
+                if(storage_file_exists(storage, furi_string_get_cstr(path))) {
+                    furi_string_cat_printf(valid, "%s\n", name);
+                } else {
+                    stats->dangling_entries++;
+                    furi_string_cat_printf(dangling, "%s\n", name);
+                    theme_manager_cleanup_report(report, "Dangling:", name);
+                }
+            }
+            line = strchr(line, '\n');
+            if(line) line++;
+        }
+
+        /* Folders no live entry names */
+        bool stopped = false;
+        File* dir = storage_file_alloc(storage);
+        if(storage_dir_open(dir, dolphin_dir)) {
+            FileInfo file_info;
+            while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+                if(!(file_info.flags & FSF_DIRECTORY)) continue;
+
+                furi_string_printf(key, "\n%s\n", name);
+                if(furi_string_search(valid, key, 0) != FURI_STRING_FAILURE) continue;
+
+                furi_string_printf(path, "%s/%s", dolphin_dir, name);
+                if(!theme_manager_get_dir_size_ex(
+                       storage,
+                       furi_string_get_cstr(path),
+                       stop_callback,
+                       context,
+                       &stats->orphan_bytes)) {
+                    stopped = true;
+                    break;
+                }
+                stats->orphan_dirs++;
+                furi_string_cat_printf(orphans, "%s\n", name);
+                theme_manager_cleanup_report(report, "Orphan:", name);
+            }
+            storage_dir_close(dir);
+        }
+        storage_file_free(dir);
+        if(stopped) break;
+
+        ok = true;
+        if(!apply) break;
+
+        /* Manifest first: an interrupted cleanup leaves orphans, which
+         * are harmless, rather than entries without a folder */
+        if(stats->dangling_entries > 0) {
+            ok = theme_manager_cleanup_rewrite_manifest(
+                storage, furi_string_get_cstr(manifest_path), text, dangling);
+            if(!ok) break;
+        }
+
+        const char* cursor = furi_string_get_cstr(orphans);
+        while(*cursor) {
+            const char* eol = strchr(cursor, '\n');
+            furi_string_printf(path, "%s/%.*s", dolphin_dir, (int)(eol - cursor), cursor);
+            theme_manager_trash_move(storage, furi_string_get_cstr(path));
+            cursor = eol + 1;
+        }
+    } while(false);
+
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu entries, %lu dangling, %lu orphans (%llu bytes)%s",
+        dolphin_dir,
+        stats->manifest_entries,
+        stats->dangling_entries,
+        stats->orphan_dirs,
+        stats->orphan_bytes,
+        apply && ok ? ", cleaned" : "");
+
+    furi_string_free(key);
+    furi_string_free(path);
+    furi_string_free(orphans);
+    furi_string_free(dangling);
+    furi_string_free(valid);
+    furi_string_free(text);
+    furi_string_free(manifest_path);
+    return ok;
+}
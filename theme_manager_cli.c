@@ -0,0 +1,516 @@
+#include "theme_manager_i.h"
+#include "theme_manager_plugin.h"
+
+#include <cli/cli.h>
+#include <toolbox/args.h>
+
+/* `theme` CLI command, registered while the app runs, so scripts can
+ * drive it over USB serial. list and info read the app's theme list and
+ * the SD card directly. Operations that write go through the job engine
+ * like their GUI counterparts: the command hands its request to the GUI
+ * thread, which starts it as soon as no other job runs, and blocks until
+ * it is done. A script can queue any number of commands in one session;
+ * they run one after another. Ctrl+C cancels the waiting or running job.
+ *
+ * Output is one tab-separated record per line, then a status line:
+ * "ok", or "error\t<reason>". */
+
+#define CLI_COMMAND "theme"
+#define CLI_POLL_MS 100
+
+typedef enum {
+    ThemeManagerCliOpApply,
+    ThemeManagerCliOpRestore,
+    ThemeManagerCliOpDelete,
+    ThemeManagerCliOpVerify,
+    ThemeManagerCliOpPatch,
+} ThemeManagerCliOp;
+
+typedef struct {
+    ThemeManagerCliOp op;
+    char name[MAX_NAME_LEN];
+    ThemeType type;
+    char new_name[MAX_NAME_LEN]; /* patch: the new version */
+    ThemeType new_type;
+
+    FuriString* output; /* records, filled by the job */
+    const char* error; /* reason on failure */
+    bool result;
+    FuriSemaphore* done;
+} ThemeManagerCliRequest;
+
+struct ThemeManagerCli {
+    ThemeManagerApp* app;
+    Cli* cli;
+    FuriMutex* mutex; /* guards pending, running, busy and closing */
+    ThemeManagerCliRequest* pending; /* waiting for the job engine */
+    ThemeManagerCliRequest* running; /* started, done callback not run yet */
+    bool busy; /* a command is running on the CLI thread */
+    bool closing;
+};
+
+static const char* const cli_op_titles[] = {
+    [ThemeManagerCliOpApply] = "CLI: Applying",
+    [ThemeManagerCliOpRestore] = "CLI: Restoring",
+    [ThemeManagerCliOpDelete] = "CLI: Deleting",
+    [ThemeManagerCliOpVerify] = "CLI: Verifying",
+    [ThemeManagerCliOpPatch] = "CLI: Making patch",
+};
+
+static void theme_manager_cli_print_usage(void) {
+    printf("Usage:\r\n");
+    printf(CLI_COMMAND " <cmd> <args>\r\n");
+    printf("Cmd list:\r\n");
+    printf("\tlist\t - themes: name, type, anims, size (- if not indexed yet)\r\n");
+    printf("\tinfo <name>\t - type, animations and size of one theme\r\n");
+    printf("\tapply <name>\t - back up the dolphin folder, then install\r\n");
+    printf("\trestore\t - put the backup back\r\n");
+    printf("\tdelete <name>\t - move a theme to the trash\r\n");
+    printf("\tverify <name>\t - decode every frame, report problems\r\n");
+    printf("\tpatch <name> <new>\t - write <name>.tpatch updating name to new\r\n");
+}
+
+// ===================================================================
+// Job side: job thread, then GUI thread
+// ===================================================================
+static bool theme_manager_cli_job(ThemeManagerApp* app, void* context) {
+    ThemeManagerCliRequest* request = context;
+    FuriString* path = furi_string_alloc();
+    bool ok = false;
+
+    switch(request->op) {
+    case ThemeManagerCliOpApply:
+        if(request->type == ThemeTypeArchive) {
+            request->error = "bundle: import it first";
+        } else if(!theme_manager_backup_dolphin(app->storage)) {
+            request->error = "backup failed";
+        } else {
+            ok = theme_manager_install_theme(
+                app->storage, ANIMATION_PACKS_PATH, request->name, request->type, DOLPHIN_PATH);
+            if(!ok) request->error = "install failed";
+        }
+        break;
+
+    case ThemeManagerCliOpRestore:
+        ok = theme_manager_restore_backup(app->storage);
+        if(!ok) request->error = "no backup";
+        break;
+
+    case ThemeManagerCliOpDelete:
+        ok = theme_manager_delete_theme(app->storage, ANIMATION_PACKS_PATH, request->name);
+        if(ok && request->type == ThemeTypeLibrary) {
+            ThemeLibraryStats library;
+            theme_manager_library_scan(app->storage, ANIMATION_PACKS_PATH, true, &library);
+        }
+        if(!ok) request->error = "delete failed";
+        break;
+
+    case ThemeManagerCliOpVerify: {
+        ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginVerify);
+        if(!plugin) {
+            request->error = "verify plugin missing";
+            break;
+        }
+        const ThemeVerifyPlugin* verify = theme_manager_plugin_get(plugin);
+        ThemeVerifyStats stats;
+        FuriString* report = furi_string_alloc();
+        uint32_t stamp = 0;
+
+        ok = theme_manager_theme_stamp(
+                 app->storage,
+                 ANIMATION_PACKS_PATH,
+                 request->name,
+                 request->type,
+                 theme_manager_job_stop_callback,
+                 app,
+                 &stamp) &&
+             verify->verify_theme(
+                 app->storage,
+                 ANIMATION_PACKS_PATH,
+                 request->name,
+                 request->type,
+                 &stats,
+                 report,
+                 theme_manager_job_progress_callback,
+                 theme_manager_job_stop_callback,
+                 app);
+        theme_manager_plugin_free(plugin);
+
+        if(ok) {
+            theme_manager_verify_cache_save(app->storage, request->name, stamp, &stats, report);
+            furi_string_printf(
+                request->output,
+                "anims\t%lu\r\nanims_bad\t%lu\r\nframes\t%lu\r\nproblems\t%lu\r\n",
+                stats.anims_checked,
+                stats.anims_bad,
+                stats.frames_checked,
+                stats.errors);
+            /* Report lines are for people: keep them out of the records */
+            furi_string_trim(report, "\n");
+            furi_string_replace_all_str(report, "\n", "\r\n# ");
+            if(furi_string_size(report)) {
+                furi_string_cat_printf(request->output, "# %s\r\n", furi_string_get_cstr(report));
+            }
+        } else {
+            request->error = "cancelled";
+        }
+        furi_string_free(report);
+        break;
+    }
+
+    case ThemeManagerCliOpPatch: {
+        ThemeManagerPlugin* plugin = theme_manager_plugin_load(ThemeManagerPluginPatch);
+        if(!plugin) {
+            request->error = "patch plugin missing";
+            break;
+        }
+        const ThemePatchPlugin* patch = theme_manager_plugin_get(plugin);
+        FuriString* old_dir = furi_string_alloc();
+        FuriString* new_dir = furi_string_alloc();
+        ThemePatchStats stats;
+
+        theme_manager_get_pack_dir(old_dir, ANIMATION_PACKS_PATH, request->name, request->type);
+        theme_manager_get_pack_dir(
+            new_dir, ANIMATION_PACKS_PATH, request->new_name, request->new_type);
+        furi_string_printf(
+            path, "%s/%s%s", ANIMATION_PACKS_PATH, request->name, PATCH_EXTENSION);
+
+        theme_manager_job_set_progress(app, 0, 0, "Comparing");
+        ok = patch->create(
+            app->storage,
+            furi_string_get_cstr(old_dir),
+            furi_string_get_cstr(new_dir),
+            furi_string_get_cstr(path),
+            &stats);
+        theme_manager_plugin_free(plugin);
+
+        if(ok) {
+            furi_string_printf(
+                request->output,
+                "patch\t%s\r\nadded\t%lu\r\nchanged\t%lu\r\ndeltas\t%lu\r\n"
+                "removed\t%lu\r\nbytes\t%lu\r\n",
+                furi_string_get_cstr(path),
+                stats.added,
+                stats.changed,
+                stats.deltas,
+                stats.removed,
+                stats.bytes);
+        } else {
+            request->error = "patch failed";
+        }
+        furi_string_free(new_dir);
+        furi_string_free(old_dir);
+        break;
+    }
+    }
+
+    furi_string_free(path);
+    return ok;
+}
+
+static void theme_manager_cli_job_done(ThemeManagerApp* app, bool success, void* context) {
+    ThemeManagerCliRequest* request = context;
+
+    furi_mutex_acquire(app->cli->mutex, FuriWaitForever);
+    app->cli->running = NULL;
+    furi_mutex_release(app->cli->mutex);
+
+    if(success && request->op == ThemeManagerCliOpDelete) {
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        theme_manager_index_invalidate(app->index, request->name);
+        furi_mutex_release(app->index_mutex);
+        theme_manager_verify_cache_remove(app->storage, request->name);
+    }
+
+    /* Whatever the GUI showed may be stale now */
+    theme_manager_refresh_themes(app);
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSubmenu);
+
+    request->result = success;
+    furi_semaphore_release(request->done);
+}
+
+// -------------------------------------------------------------------
+// GUI thread: start the waiting request, unless a job is running. Called
+// for a new request and again whenever a job finishes
+// -------------------------------------------------------------------
+void theme_manager_cli_start_pending(ThemeManagerCli* instance) {
+    ThemeManagerApp* app = instance->app;
+
+    furi_mutex_acquire(instance->mutex, FuriWaitForever);
+    ThemeManagerCliRequest* request = app->job_callback ? NULL : instance->pending;
+    if(request) {
+        instance->pending = NULL;
+        instance->running = request;
+    }
+    furi_mutex_release(instance->mutex);
+
+    if(request && !theme_manager_job_start(
+                      app,
+                      cli_op_titles[request->op],
+                      theme_manager_cli_job,
+                      theme_manager_cli_job_done,
+                      request)) {
+        furi_mutex_acquire(instance->mutex, FuriWaitForever);
+        instance->running = NULL;
+        furi_mutex_release(instance->mutex);
+
+        request->error = "busy";
+        furi_semaphore_release(request->done);
+    }
+}
+
+// ===================================================================
+// Command side: CLI thread
+// ===================================================================
+
+/* Look a theme up in the app's list */
+static bool theme_manager_cli_find(ThemeManagerApp* app, const char* name, ThemeType* out_type) {
+    bool found = false;
+
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    for(uint32_t i = 0; i < app->theme_count && !found; i++) {
+        if(strcmp(app->theme_names[i], name) == 0) {
+            *out_type = app->theme_types[i];
+            found = true;
+        }
+    }
+    furi_mutex_release(app->index_mutex);
+
+    return found;
+}
+
+// -------------------------------------------------------------------
+// Queue a request for the job engine and wait for it
+// -------------------------------------------------------------------
+static void theme_manager_cli_run(
+    ThemeManagerCli* instance,
+    Cli* cli,
+    ThemeManagerCliRequest* request) {
+    ThemeManagerApp* app = instance->app;
+    request->output = furi_string_alloc();
+    request->done = furi_semaphore_alloc(1, 0);
+
+    furi_mutex_acquire(instance->mutex, FuriWaitForever);
+    instance->pending = request;
+    furi_mutex_release(instance->mutex);
+    view_dispatcher_send_custom_event(app->view_dispatcher, ThemeManagerEventCliRequest);
+
+    bool finished = true;
+    bool cancelled = false;
+    while(furi_semaphore_acquire(request->done, CLI_POLL_MS) != FuriStatusOk) {
+        if(!cancelled && !cli_cmd_interrupt_received(cli)) continue;
+        cancelled = true;
+
+        /* Not started yet: withdraw it; started: cancel like Back does,
+         * repeatedly, as job start clears the flag */
+        furi_mutex_acquire(instance->mutex, FuriWaitForever);
+        if(instance->pending == request) {
+            instance->pending = NULL;
+            finished = false;
+        } else {
+            app->job_cancel = true;
+        }
+        furi_mutex_release(instance->mutex);
+        if(!finished) break;
+    }
+
+    printf("%s", furi_string_get_cstr(request->output));
+    if(finished && request->result) {
+        printf("ok\r\n");
+    } else {
+        printf("error\t%s\r\n", finished && request->error ? request->error : "cancelled");
+    }
+
+    furi_semaphore_free(request->done);
+    furi_string_free(request->output);
+}
+
+static void theme_manager_cli_list(ThemeManagerApp* app) {
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    for(uint32_t i = 0; i < app->theme_count; i++) {
+        ThemeIndexEntry* entry = theme_manager_index_find(app->index, app->theme_names[i]);
+        printf("%s\t%s\t", app->theme_names[i], theme_manager_type_name(app->theme_types[i]));
+        if(entry && (entry->flags & ThemeIndexHasCount)) {
+            printf("%lu\t", entry->anim_count);
+        } else {
+            printf("-\t");
+        }
+        if(entry && (entry->flags & ThemeIndexHasSize)) {
+            printf("%llu\r\n", entry->size);
+        } else {
+            printf("-\r\n");
+        }
+    }
+    furi_mutex_release(app->index_mutex);
+    printf("ok\r\n");
+}
+
+static void theme_manager_cli_info(ThemeManagerApp* app, const char* name, ThemeType type) {
+    uint32_t anims = 0;
+    uint64_t size = 0;
+
+    if(type == ThemeTypeSingle) {
+        anims = 1;
+    } else if(type == ThemeTypeContainer) {
+        ThemeContainerInfo info;
+        FuriString* path = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, name);
+        if(theme_manager_container_read_info(
+               app->storage, furi_string_get_cstr(path), &info, NULL)) {
+            anims = info.anim_count;
+        }
+        furi_string_free(path);
+    } else if(type != ThemeTypeArchive) {
+        theme_manager_foreach_manifest_anim(
+            app->storage, ANIMATION_PACKS_PATH, name, type, NULL, NULL, &anims);
+    }
+    theme_manager_get_theme_size(
+        app->storage, ANIMATION_PACKS_PATH, name, type, NULL, NULL, &size);
+
+    printf("name\t%s\r\n", name);
+    printf("type\t%s\r\n", theme_manager_type_name(type));
+    printf("anims\t%lu\r\n", anims);
+    printf("size\t%llu\r\n", size);
+    printf("ok\r\n");
+}
+
+static void theme_manager_cli_command(Cli* cli, FuriString* args, void* context) {
+    ThemeManagerCli* instance = context;
+    ThemeManagerApp* app = instance->app;
+
+    furi_mutex_acquire(instance->mutex, FuriWaitForever);
+    bool closing = instance->closing;
+    instance->busy = !closing;
+    furi_mutex_release(instance->mutex);
+    if(closing) {
+        printf("error\tapp closing\r\n");
+        return;
+    }
+
+    FuriString* cmd = furi_string_alloc();
+    FuriString* name = furi_string_alloc();
+    FuriString* new_name = furi_string_alloc();
+
+    do {
+        if(!args_read_string_and_trim(args, cmd)) {
+            theme_manager_cli_print_usage();
+            break;
+        }
+
+        if(furi_string_cmp_str(cmd, "list") == 0) {
+            theme_manager_cli_list(app);
+            break;
+        }
+
+        ThemeManagerCliRequest request = {0};
+        if(furi_string_cmp_str(cmd, "restore") == 0) {
+            request.op = ThemeManagerCliOpRestore;
+            theme_manager_cli_run(instance, cli, &request);
+            break;
+        }
+
+        /* Everything else names a theme */
+        if(!args_read_probably_quoted_string_and_trim(args, name)) {
+            theme_manager_cli_print_usage();
+            break;
+        }
+        strncpy(request.name, furi_string_get_cstr(name), MAX_NAME_LEN - 1);
+        if(!theme_manager_cli_find(app, request.name, &request.type)) {
+            printf("error\tno theme %s\r\n", request.name);
+            break;
+        }
+
+        if(furi_string_cmp_str(cmd, "info") == 0) {
+            theme_manager_cli_info(app, request.name, request.type);
+        } else if(furi_string_cmp_str(cmd, "apply") == 0) {
+            request.op = ThemeManagerCliOpApply;
+            theme_manager_cli_run(instance, cli, &request);
+        } else if(furi_string_cmp_str(cmd, "delete") == 0) {
+            request.op = ThemeManagerCliOpDelete;
+            theme_manager_cli_run(instance, cli, &request);
+        } else if(furi_string_cmp_str(cmd, "verify") == 0) {
+            request.op = ThemeManagerCliOpVerify;
+            theme_manager_cli_run(instance, cli, &request);
+        } else if(furi_string_cmp_str(cmd, "patch") == 0) {
+            request.op = ThemeManagerCliOpPatch;
+            if(!args_read_probably_quoted_string_and_trim(args, new_name)) {
+                theme_manager_cli_print_usage();
+                break;
+            }
+            strncpy(request.new_name, furi_string_get_cstr(new_name), MAX_NAME_LEN - 1);
+            if(!theme_manager_cli_find(app, request.new_name, &request.new_type)) {
+                printf("error\tno theme %s\r\n", request.new_name);
+                break;
+            }
+            theme_manager_cli_run(instance, cli, &request);
+        } else {
+            theme_manager_cli_print_usage();
+        }
+    } while(false);
+
+    furi_string_free(new_name);
+    furi_string_free(name);
+    furi_string_free(cmd);
+
+    furi_mutex_acquire(instance->mutex, FuriWaitForever);
+    instance->busy = false;
+    furi_mutex_release(instance->mutex);
+}
+
+// -------------------------------------------------------------------
+// Registered for the lifetime of the app
+// -------------------------------------------------------------------
+ThemeManagerCli* theme_manager_cli_alloc(ThemeManagerApp* app) {
+    ThemeManagerCli* instance = malloc(sizeof(ThemeManagerCli));
+    instance->app = app;
+    instance->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    instance->pending = NULL;
+    instance->running = NULL;
+
+    instance->cli = furi_record_open(RECORD_CLI);
+    cli_add_command(
+        instance->cli, CLI_COMMAND, CliCommandFlagDefault, theme_manager_cli_command, instance);
+    return instance;
+}
+
+// -------------------------------------------------------------------
+// After the GUI loop has stopped: a request still waiting for the job
+// engine never gets it, and a running one never gets its done callback.
+// Fail both, then let the command finish
+// -------------------------------------------------------------------
+void theme_manager_cli_free(ThemeManagerCli* instance) {
+    ThemeManagerApp* app = instance->app;
+    cli_delete_command(instance->cli, CLI_COMMAND);
+
+    furi_mutex_acquire(instance->mutex, FuriWaitForever);
+    instance->closing = true;
+    if(instance->pending) {
+        instance->pending->error = "app closing";
+        furi_semaphore_release(instance->pending->done);
+        instance->pending = NULL;
+    }
+    ThemeManagerCliRequest* running = instance->running;
+    instance->running = NULL;
+    furi_mutex_release(instance->mutex);
+
+    /* The job writes into the request until it returns */
+    if(running) {
+        app->job_cancel = true;
+        furi_thread_join(app->job_thread);
+        running->result = false;
+        running->error = "app closing";
+        furi_semaphore_release(running->done);
+    }
+
+    while(true) {
+        furi_mutex_acquire(instance->mutex, FuriWaitForever);
+        bool busy = instance->busy;
+        furi_mutex_release(instance->mutex);
+        if(!busy) break;
+        furi_delay_ms(CLI_POLL_MS);
+    }
+
+    furi_record_close(RECORD_CLI);
+    furi_mutex_free(instance->mutex);
+    free(instance);
+}
@@ -0,0 +1,386 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+#include "theme_manager_bitmap.h"
+
+#include <furi_hal.h>
+#include <toolbox/compress.h>
+
+#define TAG "ThemeManagerCompress"
+
+/* Pack recompressor. Raw .bm frames are re-encoded with heatshrink through
+ * the SDK encoder. The firmware decodes every compressed frame with the
+ * default icon configuration, so window and lookahead can't vary per pack;
+ * what is tuned per pack is how much a frame must shrink before it is
+ * stored compressed, since a compressed frame trades SD bytes for decode
+ * time on every playback. A sample of the pack's frames is timed (read
+ * cost per byte, decode time per frame) and the threshold with the lowest
+ * estimated playback cost wins.
+ *
+ * Frames are swapped through frame_N.tmp, and the position in the pack is
+ * saved after every animation in COMPRESS_STATE_PATH, so an interrupted
+ * run resumes where it stopped. */
+
+#define COMPRESS_ENC_SIZE       (FRAME_MAX_SIZE + 64)
+#define COMPRESS_SAMPLE_ANIMS   4
+#define COMPRESS_SAMPLE_FRAMES  2 /* per sampled animation */
+#define COMPRESS_TIMING_ROUNDS  8
+#define COMPRESS_DEFAULT_GAIN   10
+
+static const uint8_t compress_gain_candidates[] = {0, 10, 25, 50};
+
+typedef struct {
+    Storage* storage;
+    Compress* compress;
+    CompressIcon* icon;
+    ThemeAnimMeta meta;
+    uint8_t raw[PREVIEW_MAX_BM_SIZE];
+    uint8_t enc[COMPRESS_ENC_SIZE];
+    FuriString* path;
+    FuriString* tmp_path;
+
+    /* Pack run */
+    const char* pack_dir;
+    const ThemeCompressParams* params;
+    ThemeCompressStats* stats;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    uint32_t anim_index;
+    uint32_t anim_total;
+    bool stopped;
+
+    /* Tuning */
+    uint32_t sample_anims;
+    uint32_t sample_frames;
+    uint32_t read_us;
+    uint32_t read_bytes;
+    uint32_t raw_bytes[COUNT_OF(compress_gain_candidates)];
+    uint32_t stored_bytes[COUNT_OF(compress_gain_candidates)];
+    uint32_t decode_us[COUNT_OF(compress_gain_candidates)]; /* one decode per frame */
+} CompressWork;
+
+static CompressWork* theme_manager_compress_work_alloc(Storage* storage) {
+    CompressWork* work = malloc(sizeof(CompressWork));
+    memset(work, 0, sizeof(CompressWork));
+
+    work->storage = storage;
+    work->compress = compress_alloc(CompressTypeHeatshrink, &compress_config_heatshrink_default);
+    work->icon = compress_icon_alloc(FRAME_MAX_SIZE);
+    work->path = furi_string_alloc();
+    work->tmp_path = furi_string_alloc();
+
+    return work;
+}
+
+static void theme_manager_compress_work_free(CompressWork* work) {
+    furi_string_free(work->tmp_path);
+    furi_string_free(work->path);
+    compress_icon_free(work->icon);
+    compress_free(work->compress);
+    free(work);
+}
+
+// -------------------------------------------------------------------
+// Read frame file into work->raw; returns its size, 0 on failure
+// -------------------------------------------------------------------
+static size_t theme_manager_compress_read(CompressWork* work, const char* path) {
+    File* file = storage_file_alloc(work->storage);
+    size_t size = 0;
+
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        uint64_t file_size = storage_file_size(file);
+        if(file_size >= 2 && file_size <= PREVIEW_MAX_BM_SIZE &&
+           storage_file_read(file, work->raw, file_size) == file_size) {
+            size = file_size;
+        }
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    return size;
+}
+
+// -------------------------------------------------------------------
+// Encode the raw frame in work->raw into work->enc (.bm with header)
+// Returns the encoded file size, 0 if heatshrink didn't shrink it or the
+// result doesn't decode back to the same bitmap
+// -------------------------------------------------------------------
+static size_t theme_manager_compress_encode(CompressWork* work, size_t decoded_size) {
+    size_t enc_size = 0;
+    if(!compress_encode(
+           work->compress, work->raw + 1, decoded_size, work->enc, sizeof(work->enc), &enc_size)) {
+        return 0;
+    }
+    if(enc_size == 0 || work->enc[0] != 0x01 || enc_size >= decoded_size + 1) return 0;
+
+    uint8_t* decoded = NULL;
+    compress_icon_decode(work->icon, work->enc, &decoded);
+    if(!decoded || !theme_manager_bitmap_equal(decoded, work->raw + 1, decoded_size)) {
+        FURI_LOG_E(TAG, "Round trip mismatch, frame kept raw");
+        return 0;
+    }
+
+    return enc_size;
+}
+
+static bool theme_manager_compress_worth_it(size_t raw_size, size_t enc_size, uint8_t min_gain) {
+    return enc_size > 0 && enc_size * 100 <= raw_size * (100 - min_gain);
+}
+
+// -------------------------------------------------------------------
+// Write work->enc over a frame: frame_N.tmp, then swap it in
+// -------------------------------------------------------------------
+static bool theme_manager_compress_replace(CompressWork* work, size_t enc_size) {
+    const char* path = furi_string_get_cstr(work->path);
+    const char* tmp_path = furi_string_get_cstr(work->tmp_path);
+
+    File* file = storage_file_alloc(work->storage);
+    bool ok = storage_file_open(file, tmp_path, FSAM_WRITE, FSOM_CREATE_ALWAYS);
+    if(ok) {
+        ok = storage_file_write(file, work->enc, enc_size) == enc_size;
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(!ok) {
+        storage_common_remove(work->storage, tmp_path);
+        return false;
+    }
+
+    return storage_common_remove(work->storage, path) == FSE_OK &&
+           storage_common_rename(work->storage, tmp_path, path) == FSE_OK;
+}
+
+static bool theme_manager_compress_parse_meta(CompressWork* work, const char* anim_dir) {
+    furi_string_printf(work->path, "%s/%s", anim_dir, META_FILENAME);
+    return theme_manager_parse_meta(work->storage, furi_string_get_cstr(work->path), &work->meta);
+}
+
+static uint32_t theme_manager_compress_max_frame(const ThemeAnimMeta* meta) {
+    uint32_t max_frame = 0;
+    for(uint32_t p = 0; p < meta->frame_order_count; p++) {
+        if(meta->frame_order[p] > max_frame) max_frame = meta->frame_order[p];
+    }
+    return max_frame;
+}
+
+// -------------------------------------------------------------------
+// Tuning: time a few raw frames per sampled animation. A decode takes
+// well under a tick, so timing is in microseconds on the DWT cycle
+// counter; differences are taken in cycles, so wrap-around is harmless
+// -------------------------------------------------------------------
+static inline uint32_t theme_manager_compress_elapsed_us(uint32_t start) {
+    return (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+}
+
+static bool theme_manager_compress_sample_anim(const char* anim_dir, void* context) {
+    CompressWork* work = context;
+    if(!theme_manager_compress_parse_meta(work, anim_dir)) return true;
+
+    size_t decoded_size = ((size_t)(work->meta.width + 7) / 8) * work->meta.height;
+    uint32_t max_frame = theme_manager_compress_max_frame(&work->meta);
+    uint32_t sampled = 0;
+
+    for(uint32_t i = 0; i <= max_frame && sampled < COMPRESS_SAMPLE_FRAMES; i++) {
+        furi_string_printf(work->path, "%s/frame_%lu.bm", anim_dir, i);
+        const char* path = furi_string_get_cstr(work->path);
+
+        uint32_t start = DWT->CYCCNT;
+        size_t raw_size = 0;
+        for(uint32_t round = 0; round < COMPRESS_TIMING_ROUNDS; round++) {
+            raw_size = theme_manager_compress_read(work, path);
+        }
+        uint32_t read_us = theme_manager_compress_elapsed_us(start);
+
+        if(raw_size < decoded_size + 1 || work->raw[0] != 0x00) continue;
+        work->read_us += read_us;
+        work->read_bytes += raw_size * COMPRESS_TIMING_ROUNDS;
+
+        size_t enc_size = theme_manager_compress_encode(work, decoded_size);
+
+        /* Averaged over the rounds: stored bytes count a single pass */
+        uint32_t decode_us = 0;
+        if(enc_size) {
+            uint8_t* decoded;
+            start = DWT->CYCCNT;
+            for(uint32_t round = 0; round < COMPRESS_TIMING_ROUNDS; round++) {
+                compress_icon_decode(work->icon, work->enc, &decoded);
+            }
+            decode_us = theme_manager_compress_elapsed_us(start) / COMPRESS_TIMING_ROUNDS;
+        }
+
+        for(size_t c = 0; c < COUNT_OF(compress_gain_candidates); c++) {
+            work->raw_bytes[c] += raw_size;
+            if(theme_manager_compress_worth_it(raw_size, enc_size, compress_gain_candidates[c])) {
+                work->stored_bytes[c] += enc_size;
+                work->decode_us[c] += decode_us;
+            } else {
+                work->stored_bytes[c] += raw_size;
+            }
+        }
+
+        sampled++;
+        work->sample_frames++;
+    }
+
+    return ++work->sample_anims < COMPRESS_SAMPLE_ANIMS;
+}
+
+// -------------------------------------------------------------------
+// Pick the size threshold with the lowest estimated playback cost:
+// bytes read at the measured SD rate plus measured decode time
+// -------------------------------------------------------------------
+bool theme_manager_compress_tune(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeCompressParams* params) {
+    CompressWork* work = theme_manager_compress_work_alloc(storage);
+    theme_manager_foreach_anim(storage, pack_dir, theme_manager_compress_sample_anim, work);
+
+    params->min_gain_pct = COMPRESS_DEFAULT_GAIN;
+    bool sampled = work->sample_frames > 0 && work->read_bytes > 0;
+
+    if(sampled) {
+        uint64_t best_cost = UINT64_MAX;
+        for(size_t c = 0; c < COUNT_OF(compress_gain_candidates); c++) {
+            /* Everything in us * read_bytes to stay integer */
+            uint64_t cost = (uint64_t)work->stored_bytes[c] * work->read_us +
+                            (uint64_t)work->decode_us[c] * work->read_bytes;
+            FURI_LOG_I(
+                TAG,
+                "Gain >= %u%%: %lu -> %lu B, decode %lu us",
+                compress_gain_candidates[c],
+                work->raw_bytes[c],
+                work->stored_bytes[c],
+                work->decode_us[c]);
+
+            /* Ties go to the smaller pack */
+            if(cost < best_cost) {
+                best_cost = cost;
+                params->min_gain_pct = compress_gain_candidates[c];
+            }
+        }
+    }
+
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu sample frames, min gain %u%%",
+        pack_dir,
+        work->sample_frames,
+        params->min_gain_pct);
+
+    theme_manager_compress_work_free(work);
+    return sampled;
+}
+
+// -------------------------------------------------------------------
+// Recompress all frames of one animation
+// -------------------------------------------------------------------
+static bool theme_manager_compress_anim(const char* anim_dir, void* context) {
+    CompressWork* work = context;
+    ThemeCompressStats* stats = work->stats;
+
+    /* Already done in an earlier run */
+    if(work->anim_index++ < stats->anims_done) return true;
+
+    if(work->stop_callback && work->stop_callback(work->context)) {
+        work->stopped = true;
+        return false;
+    }
+
+    const char* anim_name = strrchr(anim_dir, '/');
+    anim_name = anim_name ? anim_name + 1 : anim_dir;
+    if(work->progress_callback) {
+        work->progress_callback(stats->anims_done, work->anim_total, anim_name, work->context);
+    }
+
+    if(theme_manager_compress_parse_meta(work, anim_dir)) {
+        size_t decoded_size = ((size_t)(work->meta.width + 7) / 8) * work->meta.height;
+        uint32_t max_frame = theme_manager_compress_max_frame(&work->meta);
+
+        for(uint32_t i = 0; i <= max_frame; i++) {
+            furi_string_printf(work->path, "%s/frame_%lu.bm", anim_dir, i);
+            furi_string_printf(work->tmp_path, "%s/frame_%lu.tmp", anim_dir, i);
+
+            size_t raw_size = theme_manager_compress_read(work, furi_string_get_cstr(work->path));
+            if(raw_size == 0) {
+                /* Interrupted between remove and rename: finish the swap */
+                if(storage_common_rename(
+                       work->storage,
+                       furi_string_get_cstr(work->tmp_path),
+                       furi_string_get_cstr(work->path)) == FSE_OK) {
+                    FURI_LOG_W(TAG, "Recovered %s", furi_string_get_cstr(work->path));
+                }
+                continue;
+            }
+
+            stats->bytes_before += raw_size;
+
+            if(work->raw[0] != 0x00 || raw_size < decoded_size + 1) {
+                stats->bytes_after += raw_size;
+                continue;
+            }
+
+            size_t enc_size = theme_manager_compress_encode(work, decoded_size);
+            if(theme_manager_compress_worth_it(raw_size, enc_size, work->params->min_gain_pct) &&
+               theme_manager_compress_replace(work, enc_size)) {
+                stats->frames_compressed++;
+                stats->bytes_after += enc_size;
+            } else {
+                stats->frames_raw++;
+                stats->bytes_after += raw_size;
+            }
+        }
+    } else {
+        FURI_LOG_W(TAG, "%s: bad meta, skipped", anim_dir);
+    }
+
+    stats->anims_done++;
+    theme_manager_compress_save_state(
+        work->storage, work->pack_dir, work->params, stats->anims_done);
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Recompress a pack directory (or a single animation)
+// stats->anims_done is the resume point on entry and the progress on
+// return. Returns false if stopped; the saved state allows resuming.
+// -------------------------------------------------------------------
+bool theme_manager_compress_pack(
+    Storage* storage,
+    const char* pack_dir,
+    const ThemeCompressParams* params,
+    ThemeCompressStats* stats,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    CompressWork* work = theme_manager_compress_work_alloc(storage);
+    work->pack_dir = pack_dir;
+    work->params = params;
+    work->stats = stats;
+    work->progress_callback = progress_callback;
+    work->stop_callback = stop_callback;
+    work->context = context;
+    work->anim_total = theme_manager_foreach_anim(storage, pack_dir, NULL, NULL);
+
+    theme_manager_compress_save_state(storage, pack_dir, params, stats->anims_done);
+    theme_manager_foreach_anim(storage, pack_dir, theme_manager_compress_anim, work);
+
+    bool complete = !work->stopped;
+    if(progress_callback) progress_callback(stats->anims_done, work->anim_total, NULL, context);
+    if(complete) storage_common_remove(storage, COMPRESS_STATE_PATH);
+
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu frames compressed, %lu kept raw, %llu -> %llu B%s",
+        pack_dir,
+        stats->frames_compressed,
+        stats->frames_raw,
+        stats->bytes_before,
+        stats->bytes_after,
+        complete ? "" : " (stopped)");
+
+    theme_manager_compress_work_free(work);
+    return complete;
+}
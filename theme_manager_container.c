@@ -0,0 +1,513 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManagerContainer"
+
+/* Packed container (.tpk): the installable tree of a theme in one file,
+ * so that listing and previewing it costs one open and a short read
+ * instead of a directory walk, and applying it is one sequential read.
+ *
+ *   header     32 bytes, little endian:
+ *              "TPK1", version, thumb w, thumb h, reserved,
+ *              u16 anim count, u16 entry count,
+ *              u32 directory offset, u32 data offset, u32 data size
+ *   thumbnail  first shown frame, downscaled (thumbnail cache format)
+ *   data       file contents, in directory order
+ *   directory  per file: u32 offset in data, u32 size, path[56]
+ *
+ * The directory goes last so the writer can stream the data without a
+ * counting pass; it is spooled to a side file meanwhile. Unpacking keeps
+ * two cursors, one on the directory and one on the data, so both are
+ * read front to back. Paths are relative to the dolphin folder. */
+
+#define CONTAINER_MAGIC       "TPK1"
+#define CONTAINER_VERSION     1
+#define CONTAINER_HEADER_SIZE 32
+#define CONTAINER_PATH_LEN    56
+#define CONTAINER_ENTRY_SIZE  (8 + CONTAINER_PATH_LEN)
+#define CONTAINER_MAX_ENTRIES 0xFFFF
+#define CONTAINER_CHUNK_SIZE  512
+
+static void theme_manager_container_put_u16(uint8_t* p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+static void theme_manager_container_put_u32(uint8_t* p, uint32_t value) {
+    for(uint8_t i = 0; i < 4; i++) {
+        p[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static uint16_t theme_manager_container_get_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t theme_manager_container_get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool theme_manager_is_container(const char* name) {
+    size_t len = strlen(name);
+    size_t ext_len = strlen(CONTAINER_EXTENSION);
+    return len > ext_len && strcasecmp(name + len - ext_len, CONTAINER_EXTENSION) == 0;
+}
+
+typedef struct {
+    ThemeContainerInfo info;
+    uint32_t dir_offset;
+    uint32_t data_offset;
+} ContainerHeader;
+
+static bool theme_manager_container_parse_header(const uint8_t* raw, ContainerHeader* header) {
+    if(memcmp(raw, CONTAINER_MAGIC, 4) != 0 || raw[4] != CONTAINER_VERSION) return false;
+
+    header->info.thumb_w = raw[5];
+    header->info.thumb_h = raw[6];
+    header->info.anim_count = theme_manager_container_get_u16(raw + 8);
+    header->info.entry_count = theme_manager_container_get_u16(raw + 10);
+    header->dir_offset = theme_manager_container_get_u32(raw + 12);
+    header->data_offset = theme_manager_container_get_u32(raw + 16);
+    header->info.data_size = theme_manager_container_get_u32(raw + 20);
+
+    return header->info.thumb_w <= THUMB_MAX_W && header->info.thumb_h <= THUMB_MAX_H &&
+           (uint64_t)header->data_offset + header->info.data_size == header->dir_offset;
+}
+
+// -------------------------------------------------------------------
+// Header and thumbnail of a container: one open, one read
+// thumb may be NULL; otherwise it must hold THUMB_MAX_SIZE bytes
+// -------------------------------------------------------------------
+bool theme_manager_container_read_info(
+    Storage* storage,
+    const char* path,
+    ThemeContainerInfo* info,
+    uint8_t* thumb) {
+    File* file = storage_file_alloc(storage);
+    uint8_t raw[CONTAINER_HEADER_SIZE];
+    ContainerHeader header;
+    bool ok = false;
+
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        ok = storage_file_read(file, raw, sizeof(raw)) == sizeof(raw) &&
+             theme_manager_container_parse_header(raw, &header);
+        if(ok && thumb) {
+            size_t size = (size_t)((header.info.thumb_w + 7) / 8) * header.info.thumb_h;
+            ok = storage_file_read(file, thumb, size) == size;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(ok) *info = header.info;
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Writer: data into the container, directory entries into a side file
+// -------------------------------------------------------------------
+typedef struct {
+    Storage* storage;
+    File* out;
+    File* dir;
+    uint8_t buf[CONTAINER_CHUNK_SIZE];
+    uint32_t data_size;
+    uint32_t entries;
+
+    uint32_t total_kb;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    bool stopped;
+    bool failed; /* a library animation didn't resolve */
+} ContainerWriter;
+
+static bool theme_manager_container_add_file(
+    ContainerWriter* writer,
+    const char* fs_path,
+    const char* rel_path,
+    uint32_t size) {
+    if(strlen(rel_path) >= CONTAINER_PATH_LEN || writer->entries >= CONTAINER_MAX_ENTRIES) {
+        FURI_LOG_E(TAG, "Can't store %s", rel_path);
+        return false;
+    }
+
+    File* file = storage_file_alloc(writer->storage);
+    uint32_t done = 0;
+    bool ok = true;
+
+    if(storage_file_open(file, fs_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        while(ok && done < size) {
+            size_t chunk = MIN(sizeof(writer->buf), size - done);
+            size_t read = storage_file_read(file, writer->buf, chunk);
+            if(read == 0) break;
+            ok = storage_file_write(writer->out, writer->buf, read) == read;
+            done += read;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    if(!ok || done != size) {
+        FURI_LOG_E(TAG, "Copy failed: %s", fs_path);
+        return false;
+    }
+
+    uint8_t entry[CONTAINER_ENTRY_SIZE] = {0};
+    theme_manager_container_put_u32(entry, writer->data_size);
+    theme_manager_container_put_u32(entry + 4, size);
+    strncpy((char*)entry + 8, rel_path, CONTAINER_PATH_LEN - 1);
+    if(storage_file_write(writer->dir, entry, sizeof(entry)) != sizeof(entry)) return false;
+
+    writer->data_size += size;
+    writer->entries++;
+    if(writer->progress_callback) {
+        const char* base = strrchr(rel_path, '/');
+        writer->progress_callback(
+            writer->data_size / 1024,
+            writer->total_kb,
+            base ? base + 1 : rel_path,
+            writer->context);
+    }
+    return true;
+}
+
+static bool theme_manager_container_add_dir(
+    ContainerWriter* writer,
+    const char* fs_path,
+    const char* rel_path) {
+    File* dir = storage_file_alloc(writer->storage);
+    if(!storage_dir_open(dir, fs_path)) {
+        storage_file_free(dir);
+        return false;
+    }
+
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    FuriString* child_fs = furi_string_alloc();
+    FuriString* child_rel = furi_string_alloc();
+    bool ok = true;
+
+    while(ok && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+        if(writer->stop_callback && writer->stop_callback(writer->context)) {
+            writer->stopped = true;
+            ok = false;
+            break;
+        }
+
+        furi_string_printf(child_fs, "%s/%s", fs_path, name);
+        if(rel_path[0]) {
+            furi_string_printf(child_rel, "%s/%s", rel_path, name);
+        } else {
+            furi_string_set_str(child_rel, name);
+        }
+
+        if(file_info.flags & FSF_DIRECTORY) {
+            ok = theme_manager_container_add_dir(
+                writer, furi_string_get_cstr(child_fs), furi_string_get_cstr(child_rel));
+        } else {
+            ok = theme_manager_container_add_file(
+                writer,
+                furi_string_get_cstr(child_fs),
+                furi_string_get_cstr(child_rel),
+                file_info.size);
+        }
+    }
+
+    furi_string_free(child_rel);
+    furi_string_free(child_fs);
+    storage_dir_close(dir);
+    storage_file_free(dir);
+    return ok;
+}
+
+static bool theme_manager_container_library_anim(
+    const char* anim_name,
+    const char* anim_dir,
+    void* context) {
+    ContainerWriter* writer = context;
+    if(!anim_dir) {
+        FURI_LOG_E(TAG, "%s missing from the library store", anim_name);
+        writer->failed = true;
+        return false;
+    }
+    writer->failed = !theme_manager_container_add_dir(writer, anim_dir, anim_name);
+    return !writer->failed;
+}
+
+/* Append the spooled directory to the container */
+static bool theme_manager_container_append_dir(ContainerWriter* writer, const char* dir_path) {
+    storage_file_close(writer->dir);
+    if(!storage_file_open(writer->dir, dir_path, FSAM_READ, FSOM_OPEN_EXISTING)) return false;
+
+    bool ok = true;
+    size_t read;
+    while(ok && (read = storage_file_read(writer->dir, writer->buf, sizeof(writer->buf))) > 0) {
+        ok = storage_file_write(writer->out, writer->buf, read) == read;
+    }
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Pack theme <root>/<name> into <root>/<name>.tpk
+// Single animations have no installable tree of their own: not packed
+// -------------------------------------------------------------------
+bool theme_manager_container_create(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    char* out_name,
+    size_t out_name_size,
+    ThemeContainerInfo* info,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    memset(info, 0, sizeof(ThemeContainerInfo));
+    if(type == ThemeTypeSingle || type == ThemeTypeArchive || type == ThemeTypeContainer) {
+        return false;
+    }
+
+    ContainerWriter* writer = malloc(sizeof(ContainerWriter));
+    memset(writer, 0, sizeof(ContainerWriter));
+    writer->storage = storage;
+    writer->out = storage_file_alloc(storage);
+    writer->dir = storage_file_alloc(storage);
+    writer->progress_callback = progress_callback;
+    writer->stop_callback = stop_callback;
+    writer->context = context;
+
+    uint8_t header[CONTAINER_HEADER_SIZE] = {0};
+    uint8_t thumb[THUMB_MAX_SIZE];
+    FuriString* out_path = furi_string_alloc();
+    FuriString* tmp_path = furi_string_alloc();
+    FuriString* dir_path = furi_string_alloc();
+    FuriString* src = furi_string_alloc();
+    bool ok = false;
+
+    do {
+        uint32_t anim_count = 0;
+        if(!theme_manager_foreach_manifest_anim(
+               storage, root, name, type, NULL, NULL, &anim_count)) {
+            FURI_LOG_E(TAG, "%s: no manifest", name);
+            break;
+        }
+        info->anim_count = anim_count;
+
+        uint64_t total = 0;
+        if(!theme_manager_get_theme_size(
+               storage, root, name, type, stop_callback, context, &total)) {
+            writer->stopped = true;
+            break;
+        }
+        writer->total_kb = total / 1024;
+
+        if(!theme_manager_thumb_render(
+               storage, root, name, type, thumb, &info->thumb_w, &info->thumb_h)) {
+            info->thumb_w = info->thumb_h = 0;
+        }
+        uint32_t thumb_size = (uint32_t)((info->thumb_w + 7) / 8) * info->thumb_h;
+
+        if(!theme_manager_archive_free_name(
+               storage, root, name, CONTAINER_EXTENSION, out_name, out_name_size)) {
+            FURI_LOG_E(TAG, "No free container name for %s", name);
+            break;
+        }
+        furi_string_printf(out_path, "%s/%s", root, out_name);
+        furi_string_printf(tmp_path, "%s.tmp", furi_string_get_cstr(out_path));
+        furi_string_printf(dir_path, "%s.dir", furi_string_get_cstr(out_path));
+
+        if(!storage_file_open(
+               writer->out, furi_string_get_cstr(tmp_path), FSAM_WRITE, FSOM_CREATE_ALWAYS) ||
+           !storage_file_open(
+               writer->dir, furi_string_get_cstr(dir_path), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+            FURI_LOG_E(TAG, "Can't create %s", furi_string_get_cstr(tmp_path));
+            break;
+        }
+
+        /* Header is rewritten once the offsets are known */
+        if(storage_file_write(writer->out, header, sizeof(header)) != sizeof(header) ||
+           storage_file_write(writer->out, thumb, thumb_size) != thumb_size) {
+            break;
+        }
+
+        bool added;
+        if(type == ThemeTypeLibrary) {
+            FileInfo file_info;
+            theme_manager_get_manifest_path(src, root, name, type);
+            added = storage_common_stat(storage, furi_string_get_cstr(src), &file_info) ==
+                        FSE_OK &&
+                    theme_manager_container_add_file(
+                        writer, furi_string_get_cstr(src), MANIFEST_FILENAME, file_info.size) &&
+                    theme_manager_foreach_manifest_anim(
+                        storage,
+                        root,
+                        name,
+                        type,
+                        theme_manager_container_library_anim,
+                        writer,
+                        NULL);
+        } else {
+            theme_manager_get_pack_dir(src, root, name, type);
+            added = theme_manager_container_add_dir(writer, furi_string_get_cstr(src), "");
+        }
+        if(!added || writer->failed || writer->stopped) break;
+
+        uint32_t data_offset = CONTAINER_HEADER_SIZE + thumb_size;
+        info->entry_count = writer->entries;
+        info->data_size = writer->data_size;
+
+        memcpy(header, CONTAINER_MAGIC, 4);
+        header[4] = CONTAINER_VERSION;
+        header[5] = info->thumb_w;
+        header[6] = info->thumb_h;
+        theme_manager_container_put_u16(header + 8, info->anim_count);
+        theme_manager_container_put_u16(header + 10, info->entry_count);
+        theme_manager_container_put_u32(header + 12, data_offset + writer->data_size);
+        theme_manager_container_put_u32(header + 16, data_offset);
+        theme_manager_container_put_u32(header + 20, writer->data_size);
+
+        ok = theme_manager_container_append_dir(writer, furi_string_get_cstr(dir_path)) &&
+             storage_file_seek(writer->out, 0, true) &&
+             storage_file_write(writer->out, header, sizeof(header)) == sizeof(header);
+    } while(false);
+
+    if(storage_file_is_open(writer->out)) storage_file_close(writer->out);
+    if(storage_file_is_open(writer->dir)) storage_file_close(writer->dir);
+    storage_common_remove(storage, furi_string_get_cstr(dir_path));
+
+    if(ok) {
+        ok = storage_common_rename(
+                 storage, furi_string_get_cstr(tmp_path), furi_string_get_cstr(out_path)) ==
+             FSE_OK;
+    }
+    if(!ok && !furi_string_empty(tmp_path)) {
+        storage_common_remove(storage, furi_string_get_cstr(tmp_path));
+    }
+
+    FURI_LOG_I(
+        TAG,
+        "Pack %s: %s, %u anims, %u files, %lu bytes",
+        name,
+        ok ? out_name : (writer->stopped ? "cancelled" : "failed"),
+        info->anim_count,
+        info->entry_count,
+        info->data_size);
+
+    furi_string_free(src);
+    furi_string_free(dir_path);
+    furi_string_free(tmp_path);
+    furi_string_free(out_path);
+    storage_file_free(writer->dir);
+    storage_file_free(writer->out);
+    free(writer);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Unpack a container into dst_dir, overwriting files of the same name
+// (a merge, like applying a pack folder)
+// -------------------------------------------------------------------
+bool theme_manager_container_unpack(Storage* storage, const char* path, const char* dst_dir) {
+    File* dir = storage_file_alloc(storage);
+    File* data = storage_file_alloc(storage);
+    File* file = storage_file_alloc(storage);
+    size_t buf_size = theme_manager_copy_get_buffer_size(storage);
+    uint8_t* buf = malloc(buf_size);
+    FuriString* dst = furi_string_alloc();
+    FuriString* parent = furi_string_alloc();
+    ContainerHeader header;
+    bool ok = false;
+
+    do {
+        uint8_t raw[CONTAINER_HEADER_SIZE];
+        if(!storage_file_open(dir, path, FSAM_READ, FSOM_OPEN_EXISTING) ||
+           storage_file_read(dir, raw, sizeof(raw)) != sizeof(raw) ||
+           !theme_manager_container_parse_header(raw, &header)) {
+            FURI_LOG_E(TAG, "Not a container: %s", path);
+            break;
+        }
+        if(!storage_file_seek(dir, header.dir_offset, true) ||
+           !storage_file_open(data, path, FSAM_READ, FSOM_OPEN_EXISTING) ||
+           !storage_file_seek(data, header.data_offset, true)) {
+            break;
+        }
+
+        storage_common_mkdir(storage, dst_dir);
+
+        uint32_t position = 0;
+        ok = true;
+        for(uint32_t i = 0; ok && i < header.info.entry_count; i++) {
+            uint8_t entry[CONTAINER_ENTRY_SIZE];
+            if(storage_file_read(dir, entry, sizeof(entry)) != sizeof(entry)) {
+                ok = false;
+                break;
+            }
+            uint32_t offset = theme_manager_container_get_u32(entry);
+            uint32_t size = theme_manager_container_get_u32(entry + 4);
+            char* rel = (char*)entry + 8;
+            rel[CONTAINER_PATH_LEN - 1] = '\0';
+
+            /* Written so that a huge offset or size can't wrap around */
+            if(rel[0] == '/' || strstr(rel, "..") != NULL || size > header.info.data_size ||
+               offset > header.info.data_size - size) {
+                FURI_LOG_E(TAG, "Bad entry %s", rel);
+                ok = false;
+                break;
+            }
+            if(offset != position) {
+                if(!storage_file_seek(data, header.data_offset + offset, true)) {
+                    ok = false;
+                    break;
+                }
+                position = offset;
+            }
+
+            /* Create each folder, with every folder above it, once: when
+             * the entries move into it */
+            furi_string_printf(dst, "%s/%s", dst_dir, rel);
+            const char* slash = strrchr(rel, '/');
+            if(slash) {
+                size_t len = strlen(dst_dir) + 1 + (slash - rel);
+                if(furi_string_size(parent) != len ||
+                   strncmp(furi_string_get_cstr(parent), furi_string_get_cstr(dst), len) != 0) {
+                    for(const char* sep = strchr(rel, '/'); sep; sep = strchr(sep + 1, '/')) {
+                        furi_string_printf(parent, "%s/%.*s", dst_dir, (int)(sep - rel), rel);
+                        storage_common_mkdir(storage, furi_string_get_cstr(parent));
+                    }
+                }
+            }
+
+            if(!storage_file_open(
+                   file, furi_string_get_cstr(dst), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+                ok = false;
+                break;
+            }
+            uint32_t left = size;
+            while(ok && left > 0) {
+                size_t chunk = MIN(buf_size, left);
+                ok = storage_file_read(data, buf, chunk) == chunk &&
+                     storage_file_write(file, buf, chunk) == chunk;
+                left -= chunk;
+            }
+            storage_file_close(file);
+            position += size;
+        }
+    } while(false);
+
+    if(storage_file_is_open(data)) storage_file_close(data);
+    if(storage_file_is_open(dir)) storage_file_close(dir);
+
+    if(ok) {
+        FURI_LOG_I(TAG, "Unpacked %s -> %s (%u files)", path, dst_dir, header.info.entry_count);
+    } else {
+        FURI_LOG_E(TAG, "Unpack failed: %s -> %s", path, dst_dir);
+    }
+
+    furi_string_free(parent);
+    furi_string_free(dst);
+    free(buf);
+    storage_file_free(file);
+    storage_file_free(data);
+    storage_file_free(dir);
+    return ok;
+}
@@ -0,0 +1,335 @@
+#include "theme_manager_core.h"
+#include <furi_hal.h>
+
+#define TAG "ThemeManagerCopy"
+
+/* Copy engine used by theme install. storage_common_merge copies with a
+ * fixed internal chunk; FAT over SPI is very sensitive to transfer size and
+ * the sweet spot differs per card, so the chunk size is probed once per SD
+ * card (by CID) and cached in COPY_TUNING_PATH.
+ *
+ * Each destination file gets its final size allocated before the first
+ * write, in one contiguous run of clusters, and a folder's files are
+ * written before its subfolders. Otherwise FAT hands out clusters one at
+ * a time wherever the last freed ones were, and repeated applies leave
+ * the dolphin folder scattered over the card. */
+
+#define COPY_TUNING_PATH     APP_DATA_PATH("copy_tuning.txt")
+#define COPY_PROBE_SRC       APP_DATA_PATH("copy_probe_src.tmp")
+#define COPY_PROBE_DST       APP_DATA_PATH("copy_probe_dst.tmp")
+#define COPY_PROBE_SIZE      (32 * 1024)
+#define COPY_PROBE_ROUNDS    5
+#define COPY_BUFFER_MIN      512
+#define COPY_BUFFER_MAX      (16 * 1024)
+#define COPY_BUFFER_FALLBACK 4096
+#define COPY_TUNING_MAX_LINE 48
+
+static size_t copy_buffer_size = 0;
+static char copy_card_key[16];
+static bool copy_preallocate = true;
+
+// -------------------------------------------------------------------
+// Card key: manufacturer, OEM and serial from the SD CID
+// -------------------------------------------------------------------
+static bool theme_manager_copy_card_key(Storage* storage, char* out, size_t out_size) {
+    SDInfo info;
+    if(storage_sd_info(storage, &info) != FSE_OK) return false;
+
+    snprintf(
+        out,
+        out_size,
+        "%02X%c%c%08lX",
+        info.manufacturer_id,
+        info.oem_id[0] ? info.oem_id[0] : '-',
+        info.oem_id[1] ? info.oem_id[1] : '-',
+        info.product_serial_number);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Largest buffer we dare allocate right now (power of two, clamped)
+// -------------------------------------------------------------------
+static size_t theme_manager_copy_heap_limit(void) {
+    /* Leave at least half of the largest free block to everyone else */
+    size_t limit = memmgr_heap_get_max_free_block() / 2;
+    size_t size = COPY_BUFFER_MAX;
+    while(size > COPY_BUFFER_MIN && size > limit) {
+        size /= 2;
+    }
+    return size;
+}
+
+// -------------------------------------------------------------------
+// Copy one file with the given buffer
+// -------------------------------------------------------------------
+static bool theme_manager_copy_file_buf(
+    Storage* storage,
+    const char* src,
+    const char* dst,
+    uint8_t* buf,
+    size_t buf_size) {
+    File* src_file = storage_file_alloc(storage);
+    File* dst_file = storage_file_alloc(storage);
+    bool ok = false;
+
+    do {
+        if(!storage_file_open(src_file, src, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+        if(!storage_file_open(dst_file, dst, FSAM_WRITE, FSOM_CREATE_ALWAYS)) break;
+
+        /* Not fatal: without a free run that long FAT allocates as it goes */
+        uint64_t size = storage_file_size(src_file);
+        if(copy_preallocate && size > 0 && !storage_file_expand(dst_file, size)) {
+            FURI_LOG_D(TAG, "No contiguous space for %s", dst);
+        }
+
+        /* A read error looks like end of file; only the count tells. It
+         * matters after an expand, which already gave dst its full size */
+        uint64_t total = 0;
+        size_t bytes_read;
+        ok = true;
+        while((bytes_read = storage_file_read(src_file, buf, buf_size)) > 0) {
+            if(storage_file_write(dst_file, buf, bytes_read) != bytes_read) {
+                ok = false;
+                break;
+            }
+            total += bytes_read;
+        }
+        if(total != size) ok = false;
+    } while(false);
+
+    if(!ok) FURI_LOG_E(TAG, "Copy failed: %s -> %s", src, dst);
+
+    storage_file_close(dst_file);
+    storage_file_close(src_file);
+    storage_file_free(dst_file);
+    storage_file_free(src_file);
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Measure copy throughput for each candidate size, keep the fastest.
+// Each size is copied COPY_PROBE_ROUNDS times and scored by its median,
+// timed in microseconds on the DWT cycle counter. The probe buffer is
+// COPY_BUFFER_MAX whatever the heap has free now: the tuned size is a
+// property of the card, and the caller clamps it per copy
+// -------------------------------------------------------------------
+static inline uint32_t theme_manager_copy_elapsed_us(uint32_t start) {
+    return (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+}
+
+static bool theme_manager_copy_probe(Storage* storage, size_t* out_size) {
+    uint8_t* buf = malloc(COPY_BUFFER_MAX);
+    memset(buf, 0xA5, COPY_BUFFER_MAX);
+
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, COPY_PROBE_SRC, FSAM_WRITE, FSOM_CREATE_ALWAYS);
+    for(size_t total = 0; ok && total < COPY_PROBE_SIZE; total += COPY_BUFFER_MAX) {
+        ok = storage_file_write(file, buf, COPY_BUFFER_MAX) == COPY_BUFFER_MAX;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+
+    uint32_t best_us = UINT32_MAX;
+
+    for(size_t size = COPY_BUFFER_MIN; ok && size <= COPY_BUFFER_MAX; size *= 2) {
+        uint32_t rounds_us[COPY_PROBE_ROUNDS];
+
+        for(uint32_t round = 0; ok && round < COPY_PROBE_ROUNDS; round++) {
+            uint32_t start = DWT->CYCCNT;
+            ok = theme_manager_copy_file_buf(storage, COPY_PROBE_SRC, COPY_PROBE_DST, buf, size);
+            uint32_t us = theme_manager_copy_elapsed_us(start);
+
+            /* Insertion sort: the median is the middle round */
+            uint32_t i = round;
+            for(; i > 0 && rounds_us[i - 1] > us; i--) {
+                rounds_us[i] = rounds_us[i - 1];
+            }
+            rounds_us[i] = us;
+        }
+        if(!ok) break;
+
+        uint32_t median_us = rounds_us[COPY_PROBE_ROUNDS / 2];
+        FURI_LOG_I(TAG, "Probe %u B: %lu us", size, median_us);
+
+        /* Ties go to the smaller buffer — less heap pressure for the same speed */
+        if(median_us < best_us) {
+            best_us = median_us;
+            *out_size = size;
+        }
+    }
+
+    storage_simply_remove(storage, COPY_PROBE_SRC);
+    storage_simply_remove(storage, COPY_PROBE_DST);
+    free(buf);
+
+    if(!ok) FURI_LOG_W(TAG, "Copy probe failed");
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Look up the tuned size for this card in COPY_TUNING_PATH
+// Line format: "<card key> <buffer size>"
+// -------------------------------------------------------------------
+static size_t theme_manager_copy_load_tuning(Storage* storage, const char* key) {
+    File* file = storage_file_alloc(storage);
+    size_t found = 0;
+
+    if(storage_file_open(file, COPY_TUNING_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        char line[COPY_TUNING_MAX_LINE];
+        size_t len = 0;
+        char c;
+
+        while(!found && storage_file_read(file, &c, 1) == 1) {
+            if(c != '\n' && len < sizeof(line) - 1) {
+                line[len++] = c;
+                continue;
+            }
+            line[len] = '\0';
+            len = 0;
+
+            char* space = strchr(line, ' ');
+            if(!space) continue;
+            *space = '\0';
+            if(strcmp(line, key) == 0) {
+                found = strtoul(space + 1, NULL, 10);
+            }
+        }
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+
+    if(found < COPY_BUFFER_MIN || found > COPY_BUFFER_MAX) found = 0;
+    return found;
+}
+
+static void theme_manager_copy_save_tuning(Storage* storage, const char* key, size_t size) {
+    File* file = storage_file_alloc(storage);
+
+    if(storage_file_open(file, COPY_TUNING_PATH, FSAM_WRITE, FSOM_OPEN_APPEND)) {
+        char line[COPY_TUNING_MAX_LINE];
+        int len = snprintf(line, sizeof(line), "%s %u\n", key, size);
+        storage_file_write(file, line, len);
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+}
+
+// -------------------------------------------------------------------
+// Buffer size to use for the inserted card: cached, loaded, or probed
+// Always clamped to what the heap can spare right now
+// -------------------------------------------------------------------
+size_t theme_manager_copy_get_buffer_size(Storage* storage) {
+    char key[sizeof(copy_card_key)];
+    if(!theme_manager_copy_card_key(storage, key, sizeof(key))) {
+        return COPY_BUFFER_FALLBACK;
+    }
+
+    if(copy_buffer_size == 0 || strcmp(key, copy_card_key) != 0) {
+        size_t size = theme_manager_copy_load_tuning(storage, key);
+        if(size == 0) {
+            /* A failed probe proves nothing about the card: use the
+             * fallback for now and probe again next launch */
+            if(theme_manager_copy_probe(storage, &size)) {
+                theme_manager_copy_save_tuning(storage, key, size);
+                FURI_LOG_I(TAG, "Card %s: tuned copy buffer %u B", key, size);
+            } else {
+                size = COPY_BUFFER_FALLBACK;
+            }
+        }
+        copy_buffer_size = size;
+        strncpy(copy_card_key, key, sizeof(copy_card_key) - 1);
+    }
+
+    size_t limit = theme_manager_copy_heap_limit();
+    return copy_buffer_size < limit ? copy_buffer_size : limit;
+}
+
+// -------------------------------------------------------------------
+// Recursive merge of src directory into dst with one shared buffer
+// Existing destination files are overwritten. Two passes over the
+// listing: files first, in listing order, then the subfolders, so each
+// folder's files are allocated together
+// -------------------------------------------------------------------
+static bool theme_manager_copy_dir(
+    Storage* storage,
+    const char* src,
+    const char* dst,
+    uint8_t* buf,
+    size_t buf_size) {
+    File* dir = storage_file_alloc(storage);
+    if(!storage_dir_open(dir, src)) {
+        storage_file_free(dir);
+        return false;
+    }
+
+    storage_common_mkdir(storage, dst);
+
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    FuriString* src_path = furi_string_alloc();
+    FuriString* dst_path = furi_string_alloc();
+    bool ok = true;
+
+    for(uint8_t pass = 0; ok && pass < 2; pass++) {
+        bool directories = pass == 1;
+        if(directories) ok = storage_dir_rewind(dir);
+
+        while(ok && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            bool is_dir = file_info.flags & FSF_DIRECTORY;
+            if(is_dir != directories) continue;
+
+            furi_string_printf(src_path, "%s/%s", src, name);
+            furi_string_printf(dst_path, "%s/%s", dst, name);
+
+            if(is_dir) {
+                ok = theme_manager_copy_dir(
+                    storage,
+                    furi_string_get_cstr(src_path),
+                    furi_string_get_cstr(dst_path),
+                    buf,
+                    buf_size);
+            } else {
+                ok = theme_manager_copy_file_buf(
+                    storage,
+                    furi_string_get_cstr(src_path),
+                    furi_string_get_cstr(dst_path),
+                    buf,
+                    buf_size);
+            }
+        }
+    }
+
+    furi_string_free(dst_path);
+    furi_string_free(src_path);
+    storage_dir_close(dir);
+    storage_file_free(dir);
+
+    return ok;
+}
+
+bool theme_manager_copy_tree(Storage* storage, const char* src, const char* dst) {
+    size_t buf_size = theme_manager_copy_get_buffer_size(storage);
+    uint8_t* buf = malloc(buf_size);
+
+    bool ok = theme_manager_copy_dir(storage, src, dst, buf, buf_size);
+
+    free(buf);
+    return ok;
+}
+
+bool theme_manager_copy_file(Storage* storage, const char* src, const char* dst) {
+    size_t buf_size = theme_manager_copy_get_buffer_size(storage);
+    uint8_t* buf = malloc(buf_size);
+
+    bool ok = theme_manager_copy_file_buf(storage, src, dst, buf, buf_size);
+
+    free(buf);
+    return ok;
+}
+
+void theme_manager_copy_set_preallocate(bool preallocate) {
+    copy_preallocate = preallocate;
+}
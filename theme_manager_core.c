@@ -0,0 +1,1093 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManager"
+
+// -------------------------------------------------------------------
+// Read a small text file completely into a FuriString
+// -------------------------------------------------------------------
+bool theme_manager_read_text(Storage* storage, const char* path, FuriString* out) {
+    furi_string_reset(out);
+
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        storage_file_free(file);
+        return false;
+    }
+
+    char buf[128];
+    uint16_t bytes_read;
+
+    while((bytes_read = storage_file_read(file, buf, sizeof(buf) - 1)) > 0) {
+        buf[bytes_read] = '\0';
+        furi_string_cat_str(out, buf);
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Parse manifest.txt — validate header and count "Name:" entries
+// Returns true if manifest is valid, writes animation count to *out_count
+// -------------------------------------------------------------------
+bool theme_manager_parse_manifest(Storage* storage, const char* path, uint32_t* out_count) {
+    *out_count = 0;
+
+    FuriString* accum = furi_string_alloc();
+    if(!theme_manager_read_text(storage, path, accum)) {
+        furi_string_free(accum);
+        return false;
+    }
+
+    const char* str = furi_string_get_cstr(accum);
+
+    if(strstr(str, MANIFEST_HEADER) == NULL) {
+        furi_string_free(accum);
+        return false;
+    }
+
+    const char* ptr = str;
+    while((ptr = strstr(ptr, "Name:")) != NULL) {
+        if(ptr == str || *(ptr - 1) == '\n') {
+            (*out_count)++;
+        }
+        ptr += 5;
+    }
+
+    furi_string_free(accum);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Parse meta.txt — extract Width and Height values
+// Returns true if both dimensions found
+// -------------------------------------------------------------------
+bool theme_manager_parse_meta_dimensions(
+    Storage* storage,
+    const char* path,
+    uint8_t* out_w,
+    uint8_t* out_h) {
+    *out_w = 0;
+    *out_h = 0;
+
+    FuriString* accum = furi_string_alloc();
+    if(!theme_manager_read_text(storage, path, accum)) {
+        furi_string_free(accum);
+        return false;
+    }
+
+    const char* text = furi_string_get_cstr(accum);
+    bool found_w = false;
+    bool found_h = false;
+
+    const char* w_ptr = strstr(text, "Width:");
+    if(w_ptr) {
+        uint32_t val = 0;
+        if(sscanf(w_ptr, "Width: %lu", &val) == 1 && val > 0 && val <= 128) {
+            *out_w = (uint8_t)val;
+            found_w = true;
+        }
+    }
+
+    const char* h_ptr = strstr(text, "Height:");
+    if(h_ptr) {
+        uint32_t val = 0;
+        if(sscanf(h_ptr, "Height: %lu", &val) == 1 && val > 0 && val <= 64) {
+            *out_h = (uint8_t)val;
+            found_h = true;
+        }
+    }
+
+    furi_string_free(accum);
+    return found_w && found_h;
+}
+
+// -------------------------------------------------------------------
+// Read "<key>: <number>" from meta text, false if missing
+// -------------------------------------------------------------------
+static bool theme_manager_meta_get_uint(const char* text, const char* key, uint32_t* out) {
+    const char* ptr = strstr(text, key);
+    if(!ptr) return false;
+
+    ptr += strlen(key);
+    if(*ptr != ':') return false;
+
+    char* end;
+    uint32_t val = strtoul(ptr + 1, &end, 10);
+    if(end == ptr + 1) return false;
+
+    *out = val;
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Parse full meta.txt: dimensions, frame counts, rate and Frames order
+// Returns false if the file is missing or inconsistent
+// -------------------------------------------------------------------
+bool theme_manager_parse_meta(Storage* storage, const char* path, ThemeAnimMeta* meta) {
+    memset(meta, 0, sizeof(ThemeAnimMeta));
+
+    FuriString* accum = furi_string_alloc();
+    if(!theme_manager_read_text(storage, path, accum)) {
+        furi_string_free(accum);
+        return false;
+    }
+
+    const char* text = furi_string_get_cstr(accum);
+    uint32_t w = 0, h = 0, passive = 0, active = 0, rate = 0;
+    bool ok = theme_manager_meta_get_uint(text, "Width", &w) &&
+              theme_manager_meta_get_uint(text, "Height", &h) &&
+              theme_manager_meta_get_uint(text, "Passive frames", &passive) &&
+              theme_manager_meta_get_uint(text, "Frame rate", &rate);
+    theme_manager_meta_get_uint(text, "Active frames", &active);
+
+    if(ok && w > 0 && w <= 128 && h > 0 && h <= 64 && passive + active <= META_MAX_FRAMES) {
+        meta->width = w;
+        meta->height = h;
+        meta->passive_frames = passive;
+        meta->active_frames = active;
+        meta->frame_rate = rate;
+
+        const char* ptr = strstr(text, "Frames order:");
+        if(ptr) {
+            ptr += strlen("Frames order:");
+            while(meta->frame_order_count < passive + active) {
+                while(*ptr == ' ')
+                    ptr++;
+                if(*ptr < '0' || *ptr > '9') break;
+
+                char* end;
+                uint32_t index = strtoul(ptr, &end, 10);
+                if(index >= META_MAX_FRAMES) break;
+                meta->frame_order[meta->frame_order_count++] = index;
+                ptr = end;
+            }
+        }
+
+        ok = meta->frame_order_count > 0 && meta->frame_order_count == passive + active;
+    } else {
+        ok = false;
+    }
+
+    furi_string_free(accum);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Get the first animation name from manifest.txt
+// Returns true if found, writes name to out_name
+// -------------------------------------------------------------------
+bool theme_manager_get_first_anim_name(
+    Storage* storage,
+    const char* manifest_path,
+    char* out_name,
+    size_t out_name_size) {
+    FuriString* accum = furi_string_alloc();
+    if(!theme_manager_read_text(storage, manifest_path, accum)) {
+        furi_string_free(accum);
+        return false;
+    }
+
+    const char* text = furi_string_get_cstr(accum);
+    const char* name_ptr = strstr(text, "Name:");
+    bool found = false;
+
+    if(name_ptr) {
+        name_ptr += 5; /* skip "Name:" */
+        while(*name_ptr == ' ')
+            name_ptr++; /* skip spaces */
+
+        size_t i = 0;
+        while(name_ptr[i] != '\0' && name_ptr[i] != '\n' && name_ptr[i] != '\r' &&
+              i < out_name_size - 1) {
+            out_name[i] = name_ptr[i];
+            i++;
+        }
+        out_name[i] = '\0';
+        if(i > 0) found = true;
+    }
+
+    furi_string_free(accum);
+    return found;
+}
+
+// -------------------------------------------------------------------
+// Calculate total size of a directory (recursive)
+// stop_callback is polled per entry; returns false if the walk was stopped
+// -------------------------------------------------------------------
+bool theme_manager_get_dir_size_ex(
+    Storage* storage,
+    const char* path,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size) {
+    File* dir = storage_file_alloc(storage);
+
+    if(!storage_dir_open(dir, path)) {
+        storage_file_free(dir);
+        return true;
+    }
+
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    FuriString* child_path = furi_string_alloc();
+    bool complete = true;
+
+    while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+        if(stop_callback && stop_callback(context)) {
+            complete = false;
+            break;
+        }
+
+        if(file_info.flags & FSF_DIRECTORY) {
+            furi_string_printf(child_path, "%s/%s", path, name);
+            complete = theme_manager_get_dir_size_ex(
+                storage, furi_string_get_cstr(child_path), stop_callback, context, out_size);
+            if(!complete) break;
+        } else {
+            *out_size += file_info.size;
+        }
+    }
+
+    furi_string_free(child_path);
+    storage_dir_close(dir);
+    storage_file_free(dir);
+
+    return complete;
+}
+
+uint64_t theme_manager_get_dir_size(Storage* storage, const char* path) {
+    uint64_t total = 0;
+    theme_manager_get_dir_size_ex(storage, path, NULL, NULL, &total);
+    return total;
+}
+
+// -------------------------------------------------------------------
+// Space a theme takes: its folder, or for a library theme everything it
+// references in the store. Returns false if stopped.
+// -------------------------------------------------------------------
+bool theme_manager_get_theme_size(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size) {
+    *out_size = 0;
+
+    if(type == ThemeTypeLibrary) {
+        return theme_manager_library_get_size(
+            storage, root, name, stop_callback, context, out_size);
+    }
+
+    FuriString* path = furi_string_alloc_printf("%s/%s", root, name);
+    if(type == ThemeTypeArchive || type == ThemeTypeContainer) {
+        FileInfo file_info;
+        if(storage_common_stat(storage, furi_string_get_cstr(path), &file_info) == FSE_OK) {
+            *out_size = file_info.size;
+        }
+        furi_string_free(path);
+        return true;
+    }
+
+    bool complete = theme_manager_get_dir_size_ex(
+        storage, furi_string_get_cstr(path), stop_callback, context, out_size);
+    furi_string_free(path);
+    return complete;
+}
+
+// -------------------------------------------------------------------
+// Human readable size: "1.2 MB", "340 KB", "12 B"
+// -------------------------------------------------------------------
+void theme_manager_format_size(uint64_t size_bytes, char* out, size_t out_size) {
+    if(size_bytes >= 1024 * 1024) {
+        snprintf(
+            out,
+            out_size,
+            "%lu.%lu MB",
+            (uint32_t)(size_bytes / (1024 * 1024)),
+            (uint32_t)((size_bytes % (1024 * 1024)) * 10 / (1024 * 1024)));
+    } else if(size_bytes >= 1024) {
+        snprintf(out, out_size, "%lu KB", (uint32_t)(size_bytes / 1024));
+    } else {
+        snprintf(out, out_size, "%lu B", (uint32_t)size_bytes);
+    }
+}
+
+// -------------------------------------------------------------------
+// Detect theme format of <root>/<name>: Pack, Anim Pack, Single or Library
+// -------------------------------------------------------------------
+bool theme_manager_detect_type(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType* out_type) {
+    FuriString* check_path = furi_string_alloc();
+    bool found = false;
+
+    /* Library themes also carry a manifest: check refs first */
+    furi_string_printf(check_path, "%s/%s/%s", root, name, LIBRARY_REFS_FILENAME);
+    if(storage_file_exists(storage, furi_string_get_cstr(check_path))) {
+        *out_type = ThemeTypeLibrary;
+        found = true;
+    }
+
+    if(!found) {
+        furi_string_printf(check_path, "%s/%s/%s", root, name, MANIFEST_FILENAME);
+        if(storage_file_exists(storage, furi_string_get_cstr(check_path))) {
+            *out_type = ThemeTypePack;
+            found = true;
+        }
+    }
+
+    if(!found) {
+        furi_string_printf(
+            check_path, "%s/%s/%s/%s", root, name, ANIMS_DIRNAME, MANIFEST_FILENAME);
+        if(storage_file_exists(storage, furi_string_get_cstr(check_path))) {
+            *out_type = ThemeTypeAnimsPack;
+            found = true;
+        }
+    }
+
+    if(!found) {
+        furi_string_printf(check_path, "%s/%s/%s", root, name, META_FILENAME);
+        if(storage_file_exists(storage, furi_string_get_cstr(check_path))) {
+            *out_type = ThemeTypeSingle;
+            found = true;
+        }
+    }
+
+    furi_string_free(check_path);
+    return found;
+}
+
+#define ARCHIVE_NAME_TRIES 9 /* "<name>", then "<name>_2".."<name>_9" */
+
+static const char* const archive_extensions[] = {
+    ARCHIVE_EXTENSION_HEATSHRINK,
+    ".ths",
+    ARCHIVE_EXTENSION,
+};
+
+// -------------------------------------------------------------------
+// Length of the bundle extension of a file name, 0 if it isn't one
+// -------------------------------------------------------------------
+size_t theme_manager_archive_ext_len(const char* name) {
+    size_t len = strlen(name);
+    for(size_t i = 0; i < COUNT_OF(archive_extensions); i++) {
+        size_t ext_len = strlen(archive_extensions[i]);
+        if(len > ext_len && strcasecmp(name + len - ext_len, archive_extensions[i]) == 0) {
+            return ext_len;
+        }
+    }
+    return 0;
+}
+
+bool theme_manager_archive_is_bundle(const char* name) {
+    return theme_manager_archive_ext_len(name) > 0;
+}
+
+// -------------------------------------------------------------------
+// First free "<base><ext>", "<base>_2<ext>"... in dir
+// -------------------------------------------------------------------
+bool theme_manager_archive_free_name(
+    Storage* storage,
+    const char* dir,
+    const char* base,
+    const char* ext,
+    char* out_name,
+    size_t out_name_size) {
+    FuriString* path = furi_string_alloc();
+    int base_len = (int)(out_name_size - strlen(ext) - 3);
+    bool named = false;
+
+    for(uint32_t n = 1; n <= ARCHIVE_NAME_TRIES && !named; n++) {
+        if(n == 1) {
+            snprintf(out_name, out_name_size, "%.*s%s", base_len, base, ext);
+        } else {
+            snprintf(out_name, out_name_size, "%.*s_%lu%s", base_len, base, n, ext);
+        }
+        furi_string_printf(path, "%s/%s", dir, out_name);
+        named = !storage_common_exists(storage, furi_string_get_cstr(path));
+    }
+
+    furi_string_free(path);
+    return named;
+}
+
+// -------------------------------------------------------------------
+// Short type tag for logs and machine-readable output
+// -------------------------------------------------------------------
+const char* theme_manager_type_name(ThemeType type) {
+    static const char* const type_names[] = {
+        "Pack", "AnimsPack", "Single", "Library", "Archive", "Container"};
+    return type < COUNT_OF(type_names) ? type_names[type] : "Unknown";
+}
+
+// -------------------------------------------------------------------
+// Scan root directory for all 3 formats
+// Returns number of themes written to names/types
+// -------------------------------------------------------------------
+uint32_t theme_manager_scan_dir(
+    Storage* storage,
+    const char* root,
+    char (*names)[MAX_NAME_LEN],
+    ThemeType* types,
+    uint32_t max_count) {
+    uint32_t count = 0;
+
+    if(!storage_dir_exists(storage, root)) {
+        FURI_LOG_W(TAG, "Directory %s not found", root);
+        return 0;
+    }
+
+    File* dir = storage_file_alloc(storage);
+
+    if(!storage_dir_open(dir, root)) {
+        FURI_LOG_E(TAG, "Failed to open %s", root);
+        storage_file_free(dir);
+        return 0;
+    }
+
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+
+    while(count < max_count && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+        /* Hidden folders: the library store, an import in progress */
+        if(name[0] == '.') continue;
+
+        ThemeType detected_type;
+        bool detected;
+        if(file_info.flags & FSF_DIRECTORY) {
+            detected = theme_manager_detect_type(storage, root, name, &detected_type);
+        } else if(theme_manager_archive_is_bundle(name)) {
+            detected_type = ThemeTypeArchive;
+            detected = true;
+        } else if(theme_manager_is_container(name)) {
+            detected_type = ThemeTypeContainer;
+            detected = true;
+        } else {
+            continue;
+        }
+
+        if(detected) {
+            FURI_LOG_I(TAG, "[%s] %s", theme_manager_type_name(detected_type), name);
+
+            strncpy(names[count], name, MAX_NAME_LEN - 1);
+            names[count][MAX_NAME_LEN - 1] = '\0';
+            types[count] = detected_type;
+            count++;
+        } else {
+            FURI_LOG_W(TAG, "Skipping %s (unknown format)", name);
+        }
+    }
+
+    storage_dir_close(dir);
+    storage_file_free(dir);
+
+    return count;
+}
+
+// -------------------------------------------------------------------
+// Path of a theme's manifest.txt (Single has none)
+// -------------------------------------------------------------------
+bool theme_manager_get_manifest_path(
+    FuriString* out,
+    const char* root,
+    const char* name,
+    ThemeType type) {
+    switch(type) {
+    case ThemeTypePack:
+    case ThemeTypeLibrary:
+        furi_string_printf(out, "%s/%s/%s", root, name, MANIFEST_FILENAME);
+        return true;
+    case ThemeTypeAnimsPack:
+        furi_string_printf(out, "%s/%s/%s/%s", root, name, ANIMS_DIRNAME, MANIFEST_FILENAME);
+        return true;
+    case ThemeTypeSingle:
+    case ThemeTypeArchive:
+    case ThemeTypeContainer:
+        break;
+    }
+
+    furi_string_reset(out);
+    return false;
+}
+
+// -------------------------------------------------------------------
+// Directory holding a theme's animation folders
+// (for Single, the animation folder itself)
+// -------------------------------------------------------------------
+void theme_manager_get_pack_dir(
+    FuriString* out,
+    const char* root,
+    const char* name,
+    ThemeType type) {
+    if(type == ThemeTypeAnimsPack) {
+        furi_string_printf(out, "%s/%s/%s", root, name, ANIMS_DIRNAME);
+    } else {
+        furi_string_printf(out, "%s/%s", root, name);
+    }
+}
+
+// -------------------------------------------------------------------
+// Folder of the animation named anim_name (a manifest Name:) of a theme
+// Library themes resolve through their refs into the store
+// -------------------------------------------------------------------
+bool theme_manager_get_anim_dir(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const char* anim_name,
+    FuriString* out) {
+    switch(type) {
+    case ThemeTypePack:
+        furi_string_printf(out, "%s/%s/%s", root, name, anim_name);
+        return true;
+    case ThemeTypeAnimsPack:
+        furi_string_printf(out, "%s/%s/%s/%s", root, name, ANIMS_DIRNAME, anim_name);
+        return true;
+    case ThemeTypeSingle:
+        furi_string_printf(out, "%s/%s", root, name);
+        return true;
+    case ThemeTypeLibrary:
+        return theme_manager_library_lookup(storage, root, name, anim_name, out);
+    case ThemeTypeArchive:
+    case ThemeTypeContainer:
+        break;
+    }
+
+    return false;
+}
+
+// -------------------------------------------------------------------
+// Call callback for every animation folder of pack_dir: each subfolder
+// with a meta.txt, or pack_dir itself if it is a single animation.
+// callback may be NULL to just count. Returns the number visited.
+// -------------------------------------------------------------------
+uint32_t theme_manager_foreach_anim(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeManagerAnimCallback callback,
+    void* context) {
+    FuriString* path = furi_string_alloc_printf("%s/%s", pack_dir, META_FILENAME);
+    uint32_t count = 0;
+
+    if(storage_file_exists(storage, furi_string_get_cstr(path))) {
+        furi_string_free(path);
+        if(callback) callback(pack_dir, context);
+        return 1;
+    }
+
+    File* dir = storage_file_alloc(storage);
+    if(storage_dir_open(dir, pack_dir)) {
+        FileInfo file_info;
+        char name[MAX_NAME_LEN];
+
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            if(!(file_info.flags & FSF_DIRECTORY)) continue;
+
+            furi_string_printf(path, "%s/%s/%s", pack_dir, name, META_FILENAME);
+            if(!storage_file_exists(storage, furi_string_get_cstr(path))) continue;
+
+            count++;
+            if(callback) {
+                furi_string_printf(path, "%s/%s", pack_dir, name);
+                if(!callback(furi_string_get_cstr(path), context)) break;
+            }
+        }
+        storage_dir_close(dir);
+    }
+
+    storage_file_free(dir);
+    furi_string_free(path);
+    return count;
+}
+
+// -------------------------------------------------------------------
+// Manifest line reader: one line at a time through a small buffer,
+// overlong lines are truncated
+// -------------------------------------------------------------------
+#define MANIFEST_READ_CHUNK 128
+
+typedef struct {
+    File* file;
+    uint8_t buf[MANIFEST_READ_CHUNK];
+    size_t len;
+    size_t pos;
+} ManifestReader;
+
+static bool theme_manager_manifest_read_line(ManifestReader* reader, char* line, size_t size) {
+    size_t len = 0;
+    bool any = false;
+
+    while(true) {
+        if(reader->pos == reader->len) {
+            reader->len = storage_file_read(reader->file, reader->buf, sizeof(reader->buf));
+            reader->pos = 0;
+            if(reader->len == 0) break;
+        }
+
+        char c = reader->buf[reader->pos++];
+        any = true;
+        if(c == '\n') break;
+        if(c != '\r' && len + 1 < size) line[len++] = c;
+    }
+
+    line[len] = '\0';
+    return any;
+}
+
+/* Animation name of a "Name:" line, NULL for any other line */
+static const char* theme_manager_manifest_anim_name(char* line) {
+    if(strncmp(line, "Name:", 5) != 0) return NULL;
+
+    char* name = line + 5;
+    while(*name == ' ')
+        name++;
+    size_t len = strlen(name);
+    while(len > 0 && name[len - 1] == ' ')
+        name[--len] = '\0';
+
+    return len > 0 ? name : NULL;
+}
+
+// -------------------------------------------------------------------
+// Call callback for every Name: of a theme's manifest, in manifest
+// order, streaming the file. A single animation is its only entry.
+// callback may be NULL to just count. Returns false if the manifest is
+// missing or has no header
+// -------------------------------------------------------------------
+bool theme_manager_foreach_manifest_anim(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerManifestCallback callback,
+    void* context,
+    uint32_t* out_count) {
+    FuriString* path = furi_string_alloc();
+    FuriString* anim_dir = furi_string_alloc();
+    uint32_t count = 0;
+    bool ok = true;
+
+    if(type == ThemeTypeArchive || type == ThemeTypeContainer) {
+        ok = false;
+    } else if(!theme_manager_get_manifest_path(path, root, name, type)) {
+        count = 1;
+        if(callback) {
+            furi_string_printf(anim_dir, "%s/%s", root, name);
+            callback(name, furi_string_get_cstr(anim_dir), context);
+        }
+    } else {
+        ManifestReader* reader = malloc(sizeof(ManifestReader));
+        char line[MAX_NAME_LEN + 16];
+
+        reader->file = storage_file_alloc(storage);
+        reader->len = reader->pos = 0;
+
+        ok = storage_file_open(
+            reader->file, furi_string_get_cstr(path), FSAM_READ, FSOM_OPEN_EXISTING);
+        if(ok) {
+            ok = theme_manager_manifest_read_line(reader, line, sizeof(line)) &&
+                 strstr(line, MANIFEST_HEADER) != NULL;
+
+            while(ok && theme_manager_manifest_read_line(reader, line, sizeof(line))) {
+                const char* anim_name = theme_manager_manifest_anim_name(line);
+                if(!anim_name) continue;
+
+                count++;
+                if(!callback) continue;
+
+                bool found =
+                    theme_manager_get_anim_dir(storage, root, name, type, anim_name, anim_dir);
+                if(!callback(anim_name, found ? furi_string_get_cstr(anim_dir) : NULL, context)) {
+                    break;
+                }
+            }
+            storage_file_close(reader->file);
+        }
+
+        storage_file_free(reader->file);
+        free(reader);
+    }
+
+    if(out_count) *out_count = count;
+
+    furi_string_free(anim_dir);
+    furi_string_free(path);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Resolve meta.txt and frame_0.bm of the first animation of a theme
+// -------------------------------------------------------------------
+bool theme_manager_get_preview_paths(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    FuriString* meta_path,
+    FuriString* frame_path) {
+    furi_string_reset(meta_path);
+    furi_string_reset(frame_path);
+
+    if(type == ThemeTypeSingle) {
+        furi_string_printf(meta_path, "%s/%s/%s", root, name, META_FILENAME);
+        furi_string_printf(frame_path, "%s/%s/frame_0.bm", root, name);
+        return true;
+    }
+
+    FuriString* manifest = furi_string_alloc();
+    theme_manager_get_manifest_path(manifest, root, name, type);
+
+    char first_anim[MAX_NAME_LEN];
+    bool found = theme_manager_get_first_anim_name(
+                     storage, furi_string_get_cstr(manifest), first_anim, sizeof(first_anim)) &&
+                 theme_manager_get_anim_dir(storage, root, name, type, first_anim, manifest);
+
+    if(found) {
+        furi_string_printf(meta_path, "%s/%s", furi_string_get_cstr(manifest), META_FILENAME);
+        furi_string_printf(frame_path, "%s/frame_0.bm", furi_string_get_cstr(manifest));
+    }
+
+    furi_string_free(manifest);
+    return found;
+}
+
+// -------------------------------------------------------------------
+// Load and decode one .bm frame (raw or heatshrink) into out
+// out must hold at least ((w + 7) / 8) * h bytes. This variant works
+// in caller-owned buffers: raw holds the file, compress decodes into
+// its own buffer of at least that size
+// -------------------------------------------------------------------
+bool theme_manager_decode_frame_with(
+    Storage* storage,
+    const char* frame_path,
+    uint8_t w,
+    uint8_t h,
+    uint8_t* raw,
+    size_t raw_size,
+    CompressIcon* compress,
+    uint8_t* out,
+    size_t out_size) {
+    uint32_t decoded_size = ((uint32_t)((w + 7) / 8)) * h;
+    if(decoded_size == 0 || decoded_size > out_size) return false;
+
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, frame_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        FURI_LOG_W(TAG, "Frame: can't open %s", frame_path);
+        storage_file_free(file);
+        return false;
+    }
+
+    uint64_t file_size = storage_file_size(file);
+
+    if(file_size > PREVIEW_MAX_BM_SIZE || file_size > raw_size || file_size < 2) {
+        FURI_LOG_W(TAG, "Frame: bad size %llu", file_size);
+        storage_file_close(file);
+        storage_file_free(file);
+        return false;
+    }
+
+    uint16_t read_bytes = storage_file_read(file, raw, file_size);
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if(read_bytes != file_size) {
+        FURI_LOG_E(TAG, "Frame: read failed");
+        return false;
+    }
+
+    /* Uncompressed frames are decoded in place: make sure the data is there */
+    if(raw[0] == 0x00 && file_size < decoded_size + 1) {
+        FURI_LOG_W(TAG, "Frame: truncated %s", frame_path);
+        return false;
+    }
+
+    uint8_t* decoded = NULL;
+    compress_icon_decode(compress, raw, &decoded);
+
+    if(decoded) {
+        memcpy(out, decoded, decoded_size);
+    } else {
+        FURI_LOG_W(TAG, "Frame: decompress failed for %s", frame_path);
+    }
+
+    return decoded != NULL;
+}
+
+bool theme_manager_decode_frame(
+    Storage* storage,
+    const char* frame_path,
+    uint8_t w,
+    uint8_t h,
+    uint8_t* out,
+    size_t out_size) {
+    uint32_t decoded_size = ((uint32_t)((w + 7) / 8)) * h;
+    if(decoded_size == 0 || decoded_size > out_size) return false;
+
+    uint8_t* raw = malloc(PREVIEW_MAX_BM_SIZE);
+    CompressIcon* compress = compress_icon_alloc(decoded_size);
+
+    bool ok = theme_manager_decode_frame_with(
+        storage, frame_path, w, h, raw, PREVIEW_MAX_BM_SIZE, compress, out, out_size);
+
+    compress_icon_free(compress);
+    free(raw);
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Write a manifest.txt with a single Name: entry
+// -------------------------------------------------------------------
+bool theme_manager_write_single_manifest(
+    Storage* storage,
+    const char* manifest_path,
+    const char* anim_name) {
+    File* manifest = storage_file_alloc(storage);
+    if(!storage_file_open(manifest, manifest_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        FURI_LOG_E(TAG, "Failed to create manifest");
+        storage_file_free(manifest);
+        return false;
+    }
+
+    FuriString* content = furi_string_alloc_printf(
+        "Filetype: Flipper Animation Manifest\n"
+        "Version: 1\n"
+        "\n"
+        "Name: %s\n"
+        "Min butthurt: 0\n"
+        "Max butthurt: 14\n"
+        "Min level: 1\n"
+        "Max level: 30\n"
+        "Weight: 5\n",
+        anim_name);
+
+    const char* str = furi_string_get_cstr(content);
+    uint16_t len = strlen(str);
+    uint16_t written = storage_file_write(manifest, str, len);
+
+    if(written != len) {
+        FURI_LOG_E(TAG, "Manifest write incomplete (%u/%u bytes)", written, len);
+    }
+
+    furi_string_free(content);
+    storage_file_close(manifest);
+    storage_file_free(manifest);
+
+    return written == len;
+}
+
+// -------------------------------------------------------------------
+// Install Single animation (format C):
+//   1. Copy animation folder to <dst_dir>/<name>/
+//   2. Generate manifest.txt with single Name: entry
+// -------------------------------------------------------------------
+static bool theme_manager_install_single(
+    Storage* storage,
+    const char* root,
+    const char* theme_name,
+    const char* dst_root) {
+    FuriString* src_dir = furi_string_alloc_printf("%s/%s", root, theme_name);
+    FuriString* dst_dir = furi_string_alloc_printf("%s/%s", dst_root, theme_name);
+
+    bool copied = theme_manager_copy_tree(
+        storage, furi_string_get_cstr(src_dir), furi_string_get_cstr(dst_dir));
+
+    furi_string_free(src_dir);
+    furi_string_free(dst_dir);
+
+    if(!copied) {
+        FURI_LOG_E(TAG, "Copy single anim failed");
+        return false;
+    }
+
+    FuriString* manifest_path = furi_string_alloc_printf("%s/%s", dst_root, MANIFEST_FILENAME);
+    bool written = theme_manager_write_single_manifest(
+        storage, furi_string_get_cstr(manifest_path), theme_name);
+    furi_string_free(manifest_path);
+
+    if(!written) return false;
+
+    FURI_LOG_I(TAG, "Installed single animation: %s (manifest generated)", theme_name);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Install theme <root>/<name> into dst_dir — routes on theme type
+// Pack formats (A, B) merge their directory into dst_dir
+// -------------------------------------------------------------------
+bool theme_manager_install_theme(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const char* dst_dir) {
+    storage_common_mkdir(storage, dst_dir);
+
+    if(type == ThemeTypeSingle) {
+        return theme_manager_install_single(storage, root, name, dst_dir);
+    }
+
+    if(type == ThemeTypeLibrary) {
+        return theme_manager_library_install(storage, root, name, dst_dir);
+    }
+
+    if(type == ThemeTypeArchive) {
+        FURI_LOG_E(TAG, "%s must be imported before install", name);
+        return false;
+    }
+
+    if(type == ThemeTypeContainer) {
+        FuriString* path = furi_string_alloc_printf("%s/%s", root, name);
+        bool success =
+            theme_manager_container_unpack(storage, furi_string_get_cstr(path), dst_dir);
+        furi_string_free(path);
+        return success;
+    }
+
+    FuriString* src = furi_string_alloc();
+    if(type == ThemeTypePack) {
+        furi_string_printf(src, "%s/%s", root, name);
+    } else {
+        furi_string_printf(src, "%s/%s/%s", root, name, ANIMS_DIRNAME);
+    }
+
+    bool success = theme_manager_copy_tree(storage, furi_string_get_cstr(src), dst_dir);
+
+    if(success) {
+        FURI_LOG_I(TAG, "Merged: %s -> %s", furi_string_get_cstr(src), dst_dir);
+    } else {
+        FURI_LOG_E(TAG, "Merge failed: %s -> %s", furi_string_get_cstr(src), dst_dir);
+    }
+
+    furi_string_free(src);
+    return success;
+}
+
+// -------------------------------------------------------------------
+// Backup entire /ext/dolphin/ → /ext/dolphin_backup/
+// Uses rename (fast on FAT32 — just a metadata change)
+// -------------------------------------------------------------------
+bool theme_manager_backup_dolphin(Storage* storage) {
+    if(!storage_dir_exists(storage, DOLPHIN_PATH)) {
+        return true;
+    }
+
+    if(storage_dir_exists(storage, DOLPHIN_BACKUP_PATH)) {
+        theme_manager_trash_move(storage, DOLPHIN_BACKUP_PATH);
+    }
+
+    FS_Error err = storage_common_rename(storage, DOLPHIN_PATH, DOLPHIN_BACKUP_PATH);
+    if(err != FSE_OK) {
+        FURI_LOG_E(TAG, "Backup rename failed (err %d)", err);
+        return false;
+    }
+
+    FURI_LOG_I(TAG, "Backed up /ext/dolphin/ -> /ext/dolphin_backup/");
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Restore backup: swap /ext/dolphin_backup/ → /ext/dolphin/
+// -------------------------------------------------------------------
+bool theme_manager_restore_backup(Storage* storage) {
+    if(!storage_dir_exists(storage, DOLPHIN_BACKUP_PATH)) {
+        return false;
+    }
+
+    if(storage_dir_exists(storage, DOLPHIN_PATH)) {
+        theme_manager_trash_move(storage, DOLPHIN_PATH);
+    }
+
+    FS_Error err = storage_common_rename(storage, DOLPHIN_BACKUP_PATH, DOLPHIN_PATH);
+    if(err != FSE_OK) {
+        FURI_LOG_E(TAG, "Restore rename failed (err %d)", err);
+        return false;
+    }
+
+    FURI_LOG_I(TAG, "Restored /ext/dolphin_backup/ -> /ext/dolphin/");
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Save the installed dolphin as Pack <root>/<name>. With move the folder
+// is renamed (instant, leaves nothing installed); otherwise, or if the
+// rename fails, it is copied with the copy engine
+// -------------------------------------------------------------------
+bool theme_manager_snapshot_dolphin(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    bool move,
+    bool* out_moved) {
+    *out_moved = false;
+    if(!storage_dir_exists(storage, DOLPHIN_PATH)) return false;
+
+    FuriString* dst = furi_string_alloc_printf("%s/%s", root, name);
+    bool ok = false;
+
+    do {
+        if(storage_common_exists(storage, furi_string_get_cstr(dst))) {
+            FURI_LOG_E(TAG, "Snapshot: %s already exists", name);
+            break;
+        }
+
+        if(move) {
+            FS_Error err = storage_common_rename(storage, DOLPHIN_PATH, furi_string_get_cstr(dst));
+            if(err == FSE_OK) {
+                *out_moved = true;
+                ok = true;
+                break;
+            }
+            FURI_LOG_W(TAG, "Snapshot rename failed (err %d), copying", err);
+        }
+
+        ok = theme_manager_copy_tree(storage, DOLPHIN_PATH, furi_string_get_cstr(dst));
+        if(!ok) {
+            FURI_LOG_E(TAG, "Snapshot copy failed");
+            theme_manager_trash_move(storage, furi_string_get_cstr(dst));
+        }
+    } while(false);
+
+    if(ok) {
+        FURI_LOG_I(
+            TAG,
+            "Snapshot: %s -> %s (%s)",
+            DOLPHIN_PATH,
+            furi_string_get_cstr(dst),
+            *out_moved ? "moved" : "copied");
+    }
+
+    furi_string_free(dst);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Delete theme from SD card
+// The folder is moved to the trash; its files are reclaimed at idle time
+// -------------------------------------------------------------------
+bool theme_manager_delete_theme(Storage* storage, const char* root, const char* name) {
+    FuriString* theme_path = furi_string_alloc_printf("%s/%s", root, name);
+
+    bool success = theme_manager_trash_move(storage, furi_string_get_cstr(theme_path));
+    if(strcmp(root, ANIMATION_PACKS_PATH) == 0) {
+        theme_manager_thumb_remove(storage, name);
+        theme_manager_verify_cache_remove(storage, name);
+    }
+
+    if(success) {
+        FURI_LOG_I(TAG, "Deleted theme: %s", name);
+    } else {
+        FURI_LOG_E(TAG, "Failed to delete: %s", name);
+    }
+
+    furi_string_free(theme_path);
+    return success;
+}
@@ -0,0 +1,521 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+#include <toolbox/compress.h>
+
+/* Paths — override at compile time for custom firmwares:
+ *   ufbt CFLAGS='-DCUSTOM_ANIMATION_PACKS_PATH=EXT_PATH("my_anims")' */
+#ifndef CUSTOM_ANIMATION_PACKS_PATH
+#define ANIMATION_PACKS_PATH EXT_PATH("animation_packs")
+#else
+#define ANIMATION_PACKS_PATH CUSTOM_ANIMATION_PACKS_PATH
+#endif
+
+#ifndef CUSTOM_DOLPHIN_PATH
+#define DOLPHIN_PATH EXT_PATH("dolphin")
+#else
+#define DOLPHIN_PATH CUSTOM_DOLPHIN_PATH
+#endif
+
+#define MANIFEST_FILENAME   "manifest.txt"
+#define META_FILENAME       "meta.txt"
+#define ANIMS_DIRNAME       "Anims"
+#define DOLPHIN_MANIFEST    DOLPHIN_PATH "/" MANIFEST_FILENAME
+#define DOLPHIN_BACKUP_PATH EXT_PATH("dolphin_backup")
+#define MANIFEST_HEADER     "Filetype: Flipper Animation Manifest"
+
+/* Library mode: animation folders stored once under <root>/.store/<hash>,
+ * library themes hold manifest.txt and a refs.txt mapping names to hashes */
+#define LIBRARY_STORE_DIRNAME ".store"
+#define LIBRARY_REFS_FILENAME "refs.txt"
+#define LIBRARY_KEY_LEN       16 /* hex digits of the content hash */
+
+#define MAX_THEMES   64
+#define MAX_NAME_LEN 64
+
+#define PREVIEW_MAX_BM_SIZE 2048 /* max .bm file size (compressed or raw) */
+
+#define META_MAX_FRAMES 256 /* firmware limit on frames per animation */
+#define FRAME_MAX_SIZE  ((128 / 8) * 64) /* decoded 128x64 frame */
+
+typedef enum {
+    ThemeTypePack,
+    ThemeTypeAnimsPack,
+    ThemeTypeSingle,
+    ThemeTypeLibrary,
+    ThemeTypeArchive, /* .tar / .tar.heatshrink bundle, imported before use */
+    ThemeTypeContainer, /* .tpk packed container, applied directly */
+} ThemeType;
+
+/* Parsed meta.txt of one animation */
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint16_t passive_frames;
+    uint16_t active_frames;
+    uint8_t frame_rate;
+    uint16_t frame_order_count;
+    uint8_t frame_order[META_MAX_FRAMES];
+} ThemeAnimMeta;
+
+/* Polled by long-running walks; return true to abort */
+typedef bool (*ThemeManagerStopCallback)(void* context);
+/* Progress of a multi-step operation; status may be NULL */
+typedef void (*ThemeManagerProgressCallback)(
+    uint32_t done,
+    uint32_t total,
+    const char* status,
+    void* context);
+/* One animation folder; return false to stop the iteration */
+typedef bool (*ThemeManagerAnimCallback)(const char* anim_dir, void* context);
+/* One manifest entry; anim_dir is NULL if the name doesn't resolve to a
+ * folder. Return false to stop the iteration */
+typedef bool (*ThemeManagerManifestCallback)(
+    const char* anim_name,
+    const char* anim_dir,
+    void* context);
+
+/* Core theme operations. Everything here talks to Storage only (no GUI),
+ * so it can be driven from the UI, the benchmark and background workers.
+ * `root` is the directory holding the theme folders, normally
+ * ANIMATION_PACKS_PATH. */
+
+bool theme_manager_read_text(Storage* storage, const char* path, FuriString* out);
+
+bool theme_manager_parse_manifest(Storage* storage, const char* path, uint32_t* out_count);
+
+bool theme_manager_parse_meta_dimensions(
+    Storage* storage,
+    const char* path,
+    uint8_t* out_w,
+    uint8_t* out_h);
+
+bool theme_manager_parse_meta(Storage* storage, const char* path, ThemeAnimMeta* meta);
+
+bool theme_manager_get_first_anim_name(
+    Storage* storage,
+    const char* manifest_path,
+    char* out_name,
+    size_t out_name_size);
+
+uint64_t theme_manager_get_dir_size(Storage* storage, const char* path);
+bool theme_manager_get_dir_size_ex(
+    Storage* storage,
+    const char* path,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size);
+
+bool theme_manager_get_theme_size(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size);
+
+void theme_manager_format_size(uint64_t size_bytes, char* out, size_t out_size);
+
+bool theme_manager_detect_type(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType* out_type);
+
+const char* theme_manager_type_name(ThemeType type);
+
+uint32_t theme_manager_scan_dir(
+    Storage* storage,
+    const char* root,
+    char (*names)[MAX_NAME_LEN],
+    ThemeType* types,
+    uint32_t max_count);
+
+bool theme_manager_get_manifest_path(
+    FuriString* out,
+    const char* root,
+    const char* name,
+    ThemeType type);
+
+void theme_manager_get_pack_dir(
+    FuriString* out,
+    const char* root,
+    const char* name,
+    ThemeType type);
+
+bool theme_manager_get_anim_dir(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const char* anim_name,
+    FuriString* out);
+
+uint32_t theme_manager_foreach_anim(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeManagerAnimCallback callback,
+    void* context);
+
+bool theme_manager_foreach_manifest_anim(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerManifestCallback callback,
+    void* context,
+    uint32_t* out_count);
+
+bool theme_manager_get_preview_paths(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    FuriString* meta_path,
+    FuriString* frame_path);
+
+bool theme_manager_decode_frame(
+    Storage* storage,
+    const char* frame_path,
+    uint8_t w,
+    uint8_t h,
+    uint8_t* out,
+    size_t out_size);
+/* Same, without allocating: raw takes the file, compress decodes it */
+bool theme_manager_decode_frame_with(
+    Storage* storage,
+    const char* frame_path,
+    uint8_t w,
+    uint8_t h,
+    uint8_t* raw,
+    size_t raw_size,
+    CompressIcon* compress,
+    uint8_t* out,
+    size_t out_size);
+
+/* Copy engine (theme_manager_copy.c) — chunk size tuned per SD card */
+size_t theme_manager_copy_get_buffer_size(Storage* storage);
+bool theme_manager_copy_tree(Storage* storage, const char* src, const char* dst);
+bool theme_manager_copy_file(Storage* storage, const char* src, const char* dst);
+/* On by default; the benchmark turns it off to compare */
+void theme_manager_copy_set_preallocate(bool preallocate);
+
+/* Frame prefetcher (theme_manager_prefetch.c) — a reader thread loads
+ * an animation's frame files into a small pool while the caller works
+ * on the previous one. Slots come back in the order asked for */
+typedef enum {
+    ThemePrefetchOk,
+    ThemePrefetchMissing,
+    ThemePrefetchBadSize, /* empty or over PREVIEW_MAX_BM_SIZE */
+    ThemePrefetchReadError,
+} ThemePrefetchStatus;
+
+typedef struct {
+    uint8_t index; /* frame_<index>.bm */
+    ThemePrefetchStatus status;
+    uint16_t size;
+    uint8_t data[PREVIEW_MAX_BM_SIZE];
+} ThemePrefetchSlot;
+
+typedef struct ThemePrefetch ThemePrefetch;
+
+ThemePrefetch* theme_manager_prefetch_alloc(Storage* storage);
+void theme_manager_prefetch_free(ThemePrefetch* prefetch);
+/* Only once every slot of the previous run was taken */
+void theme_manager_prefetch_start(
+    ThemePrefetch* prefetch,
+    const char* anim_dir,
+    const uint8_t* indices,
+    uint32_t count);
+/* Next frame, blocking until it is read; NULL after the last one */
+ThemePrefetchSlot* theme_manager_prefetch_take(ThemePrefetch* prefetch);
+void theme_manager_prefetch_release(ThemePrefetch* prefetch, ThemePrefetchSlot* slot);
+/* Stop reading ahead and drop what is left of the run */
+void theme_manager_prefetch_cancel(ThemePrefetch* prefetch);
+
+/* Pack optimizer (theme_manager_optimize.c) */
+typedef struct {
+    uint32_t anims_changed;
+    uint32_t files_removed;
+    uint64_t bytes_saved;
+} ThemeOptimizeStats;
+
+bool theme_manager_optimize_pack(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    ThemeOptimizeStats* stats);
+
+/* Pack recompressor (theme_manager_compress.c) */
+typedef struct {
+    uint8_t min_gain_pct; /* store compressed only if at least this much smaller */
+} ThemeCompressParams;
+
+typedef struct {
+    uint32_t anims_done;
+    uint32_t frames_compressed;
+    uint32_t frames_raw;
+    uint64_t bytes_before;
+    uint64_t bytes_after;
+} ThemeCompressStats;
+
+bool theme_manager_compress_tune(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeCompressParams* params);
+bool theme_manager_compress_pack(
+    Storage* storage,
+    const char* pack_dir,
+    const ThemeCompressParams* params,
+    ThemeCompressStats* stats,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+/* Content-addressed library store (theme_manager_library.c) */
+typedef struct {
+    uint32_t anims_stored; /* new store entries */
+    uint32_t anims_shared; /* already in the store, local copy dropped */
+    uint64_t bytes_reclaimed;
+} ThemeLibraryImportStats;
+
+typedef struct {
+    uint32_t entries;
+    uint32_t refs;
+    uint64_t logical_bytes; /* what the library themes would take as packs */
+    uint64_t stored_bytes; /* what the store actually takes */
+    uint32_t garbage_entries;
+    uint64_t garbage_bytes;
+} ThemeLibraryStats;
+
+bool theme_manager_library_lookup(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    const char* anim_name,
+    FuriString* out_dir);
+bool theme_manager_library_get_size(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size);
+bool theme_manager_library_import(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    ThemeLibraryImportStats* stats);
+bool theme_manager_library_install(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    const char* dst_dir);
+bool theme_manager_library_scan(
+    Storage* storage,
+    const char* root,
+    bool collect_garbage,
+    ThemeLibraryStats* stats);
+
+/* Theme bundles (theme_manager_archive.c; naming in theme_manager_core.c) */
+#define ARCHIVE_EXTENSION            ".tar"
+#define ARCHIVE_EXTENSION_HEATSHRINK ".tar.heatshrink"
+
+size_t theme_manager_archive_ext_len(const char* name);
+bool theme_manager_archive_is_bundle(const char* name);
+bool theme_manager_archive_free_name(
+    Storage* storage,
+    const char* dir,
+    const char* base,
+    const char* ext,
+    char* out_name,
+    size_t out_name_size);
+bool theme_manager_archive_import(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    char* out_name,
+    size_t out_name_size,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+typedef struct {
+    uint32_t files;
+    uint64_t bytes_in; /* file data */
+    uint64_t bytes_out; /* bundle size */
+} ThemeExportStats;
+
+bool theme_manager_archive_export(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    bool compress,
+    char* out_name,
+    size_t out_name_size,
+    ThemeExportStats* stats,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+/* Packed container (theme_manager_container.c) */
+#define CONTAINER_EXTENSION ".tpk"
+
+typedef struct {
+    uint16_t anim_count;
+    uint16_t entry_count;
+    uint32_t data_size; /* unpacked size */
+    uint8_t thumb_w; /* 0 = no thumbnail */
+    uint8_t thumb_h;
+} ThemeContainerInfo;
+
+bool theme_manager_is_container(const char* name);
+bool theme_manager_container_read_info(
+    Storage* storage,
+    const char* path,
+    ThemeContainerInfo* info,
+    uint8_t* thumb);
+bool theme_manager_container_create(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    char* out_name,
+    size_t out_name_size,
+    ThemeContainerInfo* info,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+bool theme_manager_container_unpack(Storage* storage, const char* path, const char* dst_dir);
+
+/* Delta patches (theme_manager_patch.c) */
+#define PATCH_EXTENSION ".tpatch"
+
+typedef struct {
+    uint32_t added;
+    uint32_t changed;
+    uint32_t deltas; /* changed files sent as a delta rather than whole */
+    uint32_t removed;
+    uint32_t bytes;
+} ThemePatchStats;
+
+bool theme_manager_patch_create(
+    Storage* storage,
+    const char* old_dir,
+    const char* new_dir,
+    const char* patch_path,
+    ThemePatchStats* stats);
+bool theme_manager_patch_check(Storage* storage, const char* patch_path, const char* dir);
+bool theme_manager_patch_apply(
+    Storage* storage,
+    const char* patch_path,
+    const char* dir,
+    ThemePatchStats* stats);
+
+/* Pack validator (theme_manager_verify.c) */
+typedef struct {
+    uint32_t anims_checked;
+    uint32_t anims_bad;
+    uint32_t frames_checked;
+    uint32_t errors;
+    uint32_t anims_unlisted; /* bad animations left out of a full report */
+} ThemeVerifyStats;
+
+bool theme_manager_verify_theme(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeVerifyStats* stats,
+    FuriString* report,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+/* Load-cost estimator (theme_manager_cost.c) */
+#define THEME_COST_HEAVY_MS 300 /* an animation loading slower than this is flagged */
+
+typedef struct {
+    uint32_t open_us; /* per frame file */
+    uint32_t read_ns; /* per byte read */
+    uint32_t decode_ns; /* per decoded byte of a compressed frame */
+    bool calibrated;
+} ThemeCostModel;
+
+typedef struct {
+    uint32_t anims;
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t max_decoded; /* largest decode buffer */
+    uint32_t total_ms;
+    uint32_t max_ms; /* slowest animation to load */
+    uint32_t heavy_anims;
+    char heaviest[MAX_NAME_LEN];
+} ThemePackCost;
+
+void theme_manager_cost_load_model(Storage* storage, ThemeCostModel* model);
+bool theme_manager_cost_calibrate(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeCostModel* model);
+bool theme_manager_cost_estimate(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const ThemeCostModel* model,
+    ThemePackCost* cost,
+    FuriString* report,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+/* Installed dolphin cleanup (theme_manager_cleanup.c) */
+typedef struct {
+    uint32_t manifest_entries;
+    uint32_t dangling_entries; /* folder or meta.txt missing */
+    uint32_t orphan_dirs; /* not named by any live entry */
+    uint64_t orphan_bytes;
+} ThemeCleanupStats;
+
+bool theme_manager_cleanup_dolphin(
+    Storage* storage,
+    const char* dolphin_dir,
+    bool apply,
+    ThemeCleanupStats* stats,
+    FuriString* report,
+    ThemeManagerStopCallback stop_callback,
+    void* context);
+
+bool theme_manager_write_single_manifest(
+    Storage* storage,
+    const char* manifest_path,
+    const char* anim_name);
+
+bool theme_manager_install_theme(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const char* dst_dir);
+
+bool theme_manager_backup_dolphin(Storage* storage);
+bool theme_manager_restore_backup(Storage* storage);
+bool theme_manager_snapshot_dolphin(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    bool move,
+    bool* out_moved);
+bool theme_manager_delete_theme(Storage* storage, const char* root, const char* name);
@@ -0,0 +1,357 @@
+#include "theme_manager_core.h"
+
+#define TAG "ThemeManagerCost"
+
+/* Load-cost estimator. When the dolphin picks an animation, the firmware
+ * opens and reads every frame file (frame_0 .. the highest index in
+ * Frames order) into RAM; compressed frames are then decoded on every
+ * displayed frame into a buffer the size of the largest frame. So the
+ * cost of an animation is modelled as
+ *
+ *   load   = (frames + 1) * open + bytes * read
+ *   decode = decoded bytes of a compressed frame * decode
+ *
+ * The three constants are measured on this device by timing raw reads
+ * and theme_manager_decode_frame over a sample of real frames, and kept
+ * in COST_MODEL_PATH. Until then built-in defaults are used. */
+
+#define COST_MODEL_PATH     APP_DATA_PATH("cost_model.txt")
+#define COST_SAMPLE_ANIMS   4
+#define COST_SAMPLE_FRAMES  4 /* per sampled animation */
+#define COST_ROUNDS         8
+#define COST_REPORT_MAX     2048
+
+#define COST_DEFAULT_OPEN_US    1500
+#define COST_DEFAULT_READ_NS    600 /* per byte */
+#define COST_DEFAULT_DECODE_NS  150 /* per decoded byte */
+
+// -------------------------------------------------------------------
+// Model file: "<open us> <read ns/B> <decode ns/B>"
+// -------------------------------------------------------------------
+void theme_manager_cost_load_model(Storage* storage, ThemeCostModel* model) {
+    model->open_us = COST_DEFAULT_OPEN_US;
+    model->read_ns = COST_DEFAULT_READ_NS;
+    model->decode_ns = COST_DEFAULT_DECODE_NS;
+    model->calibrated = false;
+
+    FuriString* text = furi_string_alloc();
+    unsigned long open_us, read_ns, decode_ns;
+
+    if(theme_manager_read_text(storage, COST_MODEL_PATH, text) &&
+       sscanf(furi_string_get_cstr(text), "%lu %lu %lu", &open_us, &read_ns, &decode_ns) == 3) {
+        model->open_us = open_us;
+        model->read_ns = read_ns;
+        model->decode_ns = decode_ns;
+        model->calibrated = true;
+    }
+
+    furi_string_free(text);
+}
+
+static void theme_manager_cost_save_model(Storage* storage, const ThemeCostModel* model) {
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, COST_MODEL_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        char buf[40];
+        int len = snprintf(
+            buf, sizeof(buf), "%lu %lu %lu\n", model->open_us, model->read_ns, model->decode_ns);
+        storage_file_write(file, buf, len);
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+}
+
+// -------------------------------------------------------------------
+// Calibration: time COST_ROUNDS raw reads and COST_ROUNDS decodes of a
+// sample of frames, fit open + read * size to the reads, and charge the
+// rest of each compressed frame's decode time to its decoded bytes
+// -------------------------------------------------------------------
+typedef struct {
+    Storage* storage;
+    ThemeAnimMeta meta;
+    uint8_t raw[PREVIEW_MAX_BM_SIZE];
+    uint8_t frame[FRAME_MAX_SIZE];
+    FuriString* path;
+
+    uint32_t anims;
+    /* Least squares over (size, read ms) */
+    uint32_t samples;
+    float sum_x;
+    float sum_y;
+    float sum_xx;
+    float sum_xy;
+    /* Decode time beyond the read, over decoded bytes */
+    float decode_ms;
+    uint32_t decode_bytes;
+} CostCalibration;
+
+static bool theme_manager_cost_calibrate_anim(
+    const char* anim_name,
+    const char* anim_dir,
+    void* context) {
+    UNUSED(anim_name);
+    CostCalibration* cal = context;
+    if(!anim_dir) return true;
+
+    furi_string_printf(cal->path, "%s/%s", anim_dir, META_FILENAME);
+    if(!theme_manager_parse_meta(cal->storage, furi_string_get_cstr(cal->path), &cal->meta)) {
+        return true;
+    }
+
+    size_t decoded_size = ((size_t)(cal->meta.width + 7) / 8) * cal->meta.height;
+    File* file = storage_file_alloc(cal->storage);
+
+    for(uint32_t i = 0; i < COST_SAMPLE_FRAMES && i < cal->meta.frame_order_count; i++) {
+        furi_string_printf(cal->path, "%s/frame_%u.bm", anim_dir, cal->meta.frame_order[i]);
+        const char* path = furi_string_get_cstr(cal->path);
+
+        uint64_t size = 0;
+        bool compressed = false;
+        uint32_t start = furi_get_tick();
+        for(uint32_t round = 0; round < COST_ROUNDS; round++) {
+            if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+            size = storage_file_size(file);
+            if(size > 0 && size <= PREVIEW_MAX_BM_SIZE) {
+                storage_file_read(file, cal->raw, size);
+                compressed = cal->raw[0] != 0x00;
+            }
+            storage_file_close(file);
+        }
+        float read_ms = (float)(furi_get_tick() - start) / COST_ROUNDS;
+        if(size == 0 || size > PREVIEW_MAX_BM_SIZE) continue;
+
+        /* Same path the preview uses: open, read, decode */
+        start = furi_get_tick();
+        for(uint32_t round = 0; round < COST_ROUNDS; round++) {
+            theme_manager_decode_frame(
+                cal->storage,
+                path,
+                cal->meta.width,
+                cal->meta.height,
+                cal->frame,
+                sizeof(cal->frame));
+        }
+        float decode_ms = (float)(furi_get_tick() - start) / COST_ROUNDS;
+
+        cal->samples++;
+        cal->sum_x += size;
+        cal->sum_y += read_ms;
+        cal->sum_xx += (float)size * size;
+        cal->sum_xy += size * read_ms;
+
+        if(compressed && decode_ms > read_ms) {
+            cal->decode_ms += decode_ms - read_ms;
+            cal->decode_bytes += decoded_size;
+        }
+    }
+
+    storage_file_free(file);
+    return ++cal->anims < COST_SAMPLE_ANIMS;
+}
+
+bool theme_manager_cost_calibrate(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeCostModel* model) {
+    CostCalibration* cal = malloc(sizeof(CostCalibration));
+    memset(cal, 0, sizeof(CostCalibration));
+    cal->storage = storage;
+    cal->path = furi_string_alloc();
+
+    theme_manager_foreach_manifest_anim(
+        storage, root, name, type, theme_manager_cost_calibrate_anim, cal, NULL);
+
+    bool ok = cal->samples >= 2;
+    if(ok) {
+        float n = cal->samples;
+        float denom = n * cal->sum_xx - cal->sum_x * cal->sum_x;
+        float slope = denom > 0 ? (n * cal->sum_xy - cal->sum_x * cal->sum_y) / denom : 0;
+        if(slope < 0) slope = 0;
+        float intercept = (cal->sum_y - slope * cal->sum_x) / n;
+        if(intercept < 0) intercept = 0;
+
+        model->open_us = intercept * 1000;
+        model->read_ns = slope * 1000000;
+        if(cal->decode_bytes > 0) {
+            model->decode_ns = cal->decode_ms * 1000000 / cal->decode_bytes;
+        }
+        model->calibrated = true;
+        theme_manager_cost_save_model(storage, model);
+
+        FURI_LOG_I(
+            TAG,
+            "Calibrated on %lu frames: open %lu us, read %lu ns/B, decode %lu ns/B",
+            cal->samples,
+            model->open_us,
+            model->read_ns,
+            model->decode_ns);
+    }
+
+    furi_string_free(cal->path);
+    free(cal);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Estimate
+// -------------------------------------------------------------------
+typedef struct {
+    Storage* storage;
+    const ThemeCostModel* model;
+    ThemePackCost* cost;
+    FuriString* report;
+    ThemeAnimMeta meta;
+    FuriString* path;
+    uint16_t decode_us[META_MAX_FRAMES];
+
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    uint32_t total;
+    bool stopped;
+} CostContext;
+
+static bool theme_manager_cost_anim(const char* anim_name, const char* anim_dir, void* context) {
+    CostContext* ctx = context;
+    ThemePackCost* cost = ctx->cost;
+
+    if(ctx->progress_callback) {
+        ctx->progress_callback(cost->anims, ctx->total, anim_name, ctx->context);
+    }
+    if(!anim_dir) return true;
+
+    furi_string_printf(ctx->path, "%s/%s", anim_dir, META_FILENAME);
+    if(!theme_manager_parse_meta(ctx->storage, furi_string_get_cstr(ctx->path), &ctx->meta)) {
+        return true;
+    }
+
+    /* The firmware loads frame_0 .. frame_<max> */
+    uint32_t frames = 0;
+    for(uint32_t p = 0; p < ctx->meta.frame_order_count; p++) {
+        if(ctx->meta.frame_order[p] + 1U > frames) frames = ctx->meta.frame_order[p] + 1;
+    }
+
+    uint32_t decoded_size = ((uint32_t)(ctx->meta.width + 7) / 8) * ctx->meta.height;
+    uint32_t bytes = 0;
+    uint32_t compressed = 0;
+    File* file = storage_file_alloc(ctx->storage);
+
+    for(uint32_t i = 0; i < frames; i++) {
+        if(ctx->stop_callback && ctx->stop_callback(ctx->context)) {
+            ctx->stopped = true;
+            break;
+        }
+
+        ctx->decode_us[i] = 0;
+        furi_string_printf(ctx->path, "%s/frame_%lu.bm", anim_dir, i);
+        if(!storage_file_open(
+               file, furi_string_get_cstr(ctx->path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            continue;
+        }
+
+        uint8_t header = 0;
+        bytes += storage_file_size(file);
+        if(storage_file_read(file, &header, 1) == 1 && header != 0x00) {
+            compressed++;
+            ctx->decode_us[i] = decoded_size * ctx->model->decode_ns / 1000;
+        }
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    if(ctx->stopped) return false;
+
+    uint32_t load_ms =
+        ((frames + 1) * ctx->model->open_us + (uint64_t)bytes * ctx->model->read_ns / 1000) /
+        1000;
+
+    /* Average decode per displayed frame, against the frame period */
+    uint32_t decode_total = 0;
+    for(uint32_t p = 0; p < ctx->meta.frame_order_count; p++) {
+        decode_total += ctx->decode_us[ctx->meta.frame_order[p]];
+    }
+    uint32_t decode_us = decode_total / ctx->meta.frame_order_count;
+    uint32_t period_us = ctx->meta.frame_rate ? 1000000 / ctx->meta.frame_rate : 1000000;
+
+    bool heavy = load_ms > THEME_COST_HEAVY_MS || decode_us > period_us / 2;
+
+    cost->anims++;
+    cost->frames += frames;
+    cost->bytes += bytes;
+    cost->total_ms += load_ms;
+    if(decoded_size > cost->max_decoded) cost->max_decoded = decoded_size;
+    if(heavy) cost->heavy_anims++;
+    if(load_ms > cost->max_ms) {
+        cost->max_ms = load_ms;
+        strncpy(cost->heaviest, anim_name, sizeof(cost->heaviest) - 1);
+        cost->heaviest[sizeof(cost->heaviest) - 1] = '\0';
+    }
+
+    if(ctx->report && furi_string_size(ctx->report) < COST_REPORT_MAX) {
+        char size_str[16];
+        theme_manager_format_size(bytes, size_str, sizeof(size_str));
+        furi_string_cat_printf(
+            ctx->report,
+            "%s%s\n %lu ms, %lu fr (%lu hs), %s, %lu us/fr\n",
+            heavy ? "! " : "",
+            anim_name,
+            load_ms,
+            frames,
+            compressed,
+            size_str,
+            decode_us);
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Estimate every animation of a theme. Returns false if stopped early.
+// report (optional) gets one entry per animation, heavy ones marked "!"
+// -------------------------------------------------------------------
+bool theme_manager_cost_estimate(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    const ThemeCostModel* model,
+    ThemePackCost* cost,
+    FuriString* report,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    memset(cost, 0, sizeof(ThemePackCost));
+    if(report) furi_string_reset(report);
+
+    CostContext* ctx = malloc(sizeof(CostContext));
+    memset(ctx, 0, sizeof(CostContext));
+    ctx->storage = storage;
+    ctx->model = model;
+    ctx->cost = cost;
+    ctx->report = report;
+    ctx->path = furi_string_alloc();
+    ctx->progress_callback = progress_callback;
+    ctx->stop_callback = stop_callback;
+    ctx->context = context;
+
+    if(progress_callback) {
+        theme_manager_foreach_manifest_anim(storage, root, name, type, NULL, NULL, &ctx->total);
+    }
+    theme_manager_foreach_manifest_anim(
+        storage, root, name, type, theme_manager_cost_anim, ctx, NULL);
+
+    bool complete = !ctx->stopped;
+    furi_string_free(ctx->path);
+    free(ctx);
+
+    FURI_LOG_D(
+        TAG,
+        "%s: %lu anims, max %lu ms (%s), %lu heavy",
+        name,
+        cost->anims,
+        cost->max_ms,
+        cost->heaviest,
+        cost->heavy_anims);
+    return complete;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <gui/gui.h>
+#include <gui/view_dispatcher.h>
+#include <gui/modules/submenu.h>
+#include <gui/modules/dialog_ex.h>
+#include <gui/modules/popup.h>
+#include <gui/modules/loading.h>
+#include <gui/modules/text_box.h>
+#include <gui/modules/text_input.h>
+#include <gui/view.h>
+#include <storage/storage.h>
+
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManager"
+
+#define MAX_LABEL_LEN 32
+
+#define MENU_INDEX_RESTORE            (MAX_THEMES + 1)
+#define MENU_INDEX_BENCHMARK          (MAX_THEMES + 2)
+#define MENU_INDEX_OPTIMIZE_INSTALLED (MAX_THEMES + 3)
+#define MENU_INDEX_CLEANUP_INSTALLED  (MAX_THEMES + 4)
+#define MENU_INDEX_EXPORT_INSTALLED   (MAX_THEMES + 5)
+#define MENU_INDEX_SAVE_INSTALLED     (MAX_THEMES + 6)
+
+#define PREVIEW_DRAW_X 2
+#define PREVIEW_DRAW_Y 2
+#define PREVIEW_DRAW_W THUMB_MAX_W /* thumbnails draw 1:1 */
+#define PREVIEW_DRAW_H THUMB_MAX_H
+
+#define JOB_THREAD_STACK_SIZE (4 * 1024)
+
+typedef enum {
+    ThemeManagerViewSubmenu,
+    ThemeManagerViewInfo,
+    ThemeManagerViewConfirm,
+    ThemeManagerViewReboot,
+    ThemeManagerViewDeleteConfirm,
+    ThemeManagerViewPopup,
+    ThemeManagerViewLoading,
+    ThemeManagerViewProgress,
+    ThemeManagerViewTextBox,
+    ThemeManagerViewActions,
+    ThemeManagerViewCleanupConfirm,
+    ThemeManagerViewNameInput,
+    ThemeManagerViewSaveConfirm,
+} ThemeManagerView;
+
+typedef enum {
+    ThemeManagerEventJobDone,
+    ThemeManagerEventCliRequest,
+} ThemeManagerEvent;
+
+/* Already scaled into the preview box, drawn as is */
+typedef struct {
+    uint8_t data[THUMB_MAX_SIZE];
+    uint8_t w; /* 0 = no frame */
+    uint8_t h;
+} PreviewFrame;
+
+typedef struct ThemeManagerPreview ThemeManagerPreview;
+
+typedef struct {
+    char name[MAX_NAME_LEN];
+    char type_label[16];
+    uint32_t anim_count;
+    char size_str[16];
+    char cost_str[16]; /* estimated load time, empty until known */
+    bool is_archive; /* Right imports instead of applying */
+
+    ThemeManagerPreview* preview;
+} InfoViewModel;
+
+typedef struct {
+    char title[MAX_LABEL_LEN];
+    char status[MAX_LABEL_LEN];
+    uint32_t done;
+    uint32_t total;
+    bool cancelling;
+} ProgressViewModel;
+
+typedef struct ThemeManagerApp ThemeManagerApp;
+typedef struct ThemeManagerIdle ThemeManagerIdle;
+typedef struct ThemeManagerCli ThemeManagerCli;
+
+/* Runs on the job thread; returns overall success */
+typedef bool (*ThemeManagerJobCallback)(ThemeManagerApp* app, void* context);
+/* Runs on the GUI thread once the job thread has finished */
+typedef void (*ThemeManagerJobDoneCallback)(ThemeManagerApp* app, bool success, void* context);
+
+struct ThemeManagerApp {
+    Storage* storage;
+    Gui* gui;
+
+    ViewDispatcher* view_dispatcher;
+    Submenu* submenu;
+    View* info_view;
+    DialogEx* confirm_dialog;
+    DialogEx* reboot_dialog;
+    DialogEx* delete_dialog;
+    Popup* popup;
+    Loading* loading;
+    View* progress_view;
+    TextBox* text_box;
+    Submenu* actions_menu;
+    DialogEx* cleanup_dialog;
+    TextInput* name_input;
+    char name_input_text[MAX_NAME_LEN];
+    DialogEx* save_dialog;
+
+    char theme_names[MAX_THEMES][MAX_NAME_LEN];
+    char menu_labels[MAX_THEMES][MAX_LABEL_LEN];
+    ThemeType theme_types[MAX_THEMES];
+    uint32_t theme_count;
+    uint32_t selected_index;
+    bool has_backup;
+
+    FuriString* dialog_text;
+    FuriString* text_box_text;
+
+    ThemeManagerPreview* preview;
+
+    /* Theme index, shared with the idle thread. index_mutex also guards
+     * theme_names/theme_types/theme_count against rescans */
+    ThemeIndex* index;
+    FuriMutex* index_mutex;
+    ThemeManagerIdle* idle;
+
+    FuriThread* job_thread;
+    ThemeManagerJobCallback job_callback;
+    ThemeManagerJobDoneCallback job_done_callback;
+    void* job_context;
+    volatile bool job_cancel;
+    bool job_result;
+
+    ThemeManagerCli* cli;
+};
+
+/* Background jobs (theme_manager_job.c) */
+void theme_manager_job_init(ThemeManagerApp* app);
+void theme_manager_job_deinit(ThemeManagerApp* app);
+bool theme_manager_job_start(
+    ThemeManagerApp* app,
+    const char* title,
+    ThemeManagerJobCallback callback,
+    ThemeManagerJobDoneCallback done_callback,
+    void* context);
+void theme_manager_job_set_progress(
+    ThemeManagerApp* app,
+    uint32_t done,
+    uint32_t total,
+    const char* status);
+bool theme_manager_job_is_cancelled(ThemeManagerApp* app);
+void theme_manager_job_progress_callback(
+    uint32_t done,
+    uint32_t total,
+    const char* status,
+    void* context);
+bool theme_manager_job_stop_callback(void* context);
+bool theme_manager_job_custom_event(ThemeManagerApp* app, uint32_t event);
+
+/* Preview decoder thread (theme_manager_preview.c) */
+ThemeManagerPreview* theme_manager_preview_alloc(Storage* storage, View* view);
+void theme_manager_preview_free(ThemeManagerPreview* preview);
+void theme_manager_preview_load(ThemeManagerPreview* preview, const char* name, ThemeType type);
+void theme_manager_preview_stop(ThemeManagerPreview* preview);
+const PreviewFrame* theme_manager_preview_acquire(ThemeManagerPreview* preview);
+
+/* Idle-time maintenance (theme_manager_idle.c) */
+ThemeManagerIdle* theme_manager_idle_alloc(ThemeManagerApp* app);
+void theme_manager_idle_free(ThemeManagerIdle* idle);
+/* kick: themes changed, start a new pass. rescan: the list was scanned
+ * again, a pass cut short resumes if it is the same list */
+void theme_manager_idle_kick(ThemeManagerIdle* idle);
+void theme_manager_idle_rescan(ThemeManagerIdle* idle);
+void theme_manager_idle_set_busy(ThemeManagerIdle* idle, bool busy);
+
+/* Per-theme actions menu and maintenance jobs (theme_manager_actions.c) */
+void theme_manager_actions_init(ThemeManagerApp* app);
+void theme_manager_actions_deinit(ThemeManagerApp* app);
+void theme_manager_actions_show(ThemeManagerApp* app);
+void theme_manager_actions_optimize_installed(ThemeManagerApp* app);
+void theme_manager_actions_cleanup_installed(ThemeManagerApp* app);
+void theme_manager_actions_import(ThemeManagerApp* app);
+void theme_manager_actions_export_installed(ThemeManagerApp* app);
+void theme_manager_actions_save_installed(ThemeManagerApp* app);
+
+/* `theme` CLI command (theme_manager_cli.c) */
+ThemeManagerCli* theme_manager_cli_alloc(ThemeManagerApp* app);
+void theme_manager_cli_free(ThemeManagerCli* cli);
+void theme_manager_cli_start_pending(ThemeManagerCli* cli);
+
+/* Benchmark (theme_manager_benchmark.c) */
+void theme_manager_benchmark_start(ThemeManagerApp* app);
+
+/* UI helpers (theme_manager.c) */
+void theme_manager_show_error(ThemeManagerApp* app, const char* message);
+void theme_manager_show_text(ThemeManagerApp* app);
+void theme_manager_show_delete_confirm(ThemeManagerApp* app);
+void theme_manager_refresh_themes(ThemeManagerApp* app);
@@ -0,0 +1,445 @@
+#include "theme_manager_i.h"
+
+#include <input/input.h>
+
+/* Idle-time maintenance. A low priority thread does housekeeping only once
+ * no key has been pressed for IDLE_DELAY_MS and no foreground operation is
+ * running. Work is cut into small steps (one theme, or a handful of files);
+ * any key press stops the current step at its next poll. The scheduler
+ * position is persisted in IDLE_STATE_PATH so an interrupted pass resumes
+ * on the next launch, and every result (index, thumbnails, reclaimed
+ * trash) is itself kept on SD. */
+
+#define IDLE_THREAD_STACK_SIZE (3 * 1024)
+#define IDLE_DELAY_MS          5000
+#define IDLE_STATE_PATH        APP_DATA_PATH("idle_state.txt")
+
+typedef enum {
+    IdleFlagInput = (1 << 0),
+    IdleFlagKick = (1 << 1),
+    IdleFlagRescan = (1 << 2),
+    IdleFlagExit = (1 << 3),
+} IdleFlag;
+
+#define IDLE_FLAGS_ALL (IdleFlagInput | IdleFlagKick | IdleFlagRescan | IdleFlagExit)
+
+typedef enum {
+    IdleJobTrash, /* reclaim trashed trees */
+    IdleJobIndex, /* anim counts and stamps */
+    IdleJobSizes, /* directory sizes */
+    IdleJobThumbs, /* first frame thumbnails */
+    IdleJobCost, /* estimated load cost */
+    IdleJobCount,
+} IdleJob;
+
+static const char* const idle_job_names[] = {"trash", "index", "sizes", "thumbs", "cost"};
+
+/* Index flag each per-theme job fills in */
+static const uint8_t idle_job_flags[] = {
+    0,
+    ThemeIndexHasCount,
+    ThemeIndexHasSize,
+    ThemeIndexHasThumb,
+    ThemeIndexHasCost,
+};
+
+struct ThemeManagerIdle {
+    ThemeManagerApp* app;
+    FuriThread* thread;
+
+    FuriPubSub* input_events;
+    FuriPubSubSubscription* input_subscription;
+    volatile uint32_t last_input;
+    volatile int32_t busy;
+
+    /* Scheduler position, owned by the idle thread. The cursor counts
+     * into the theme list it was saved with, fingerprinted by list_hash */
+    uint32_t job;
+    uint32_t cursor;
+    uint32_t list_hash;
+    bool state_dirty;
+
+    ThemeCostModel cost_model; /* reloaded on every kick */
+    ThemePackCost cost;
+};
+
+// -------------------------------------------------------------------
+// Input events from every app and the system: reset the idle timer
+// and preempt the running step
+// -------------------------------------------------------------------
+static void theme_manager_idle_input_callback(const void* message, void* context) {
+    UNUSED(message);
+    ThemeManagerIdle* idle = context;
+
+    idle->last_input = furi_get_tick();
+    furi_thread_flags_set(furi_thread_get_id(idle->thread), IdleFlagInput);
+}
+
+static bool theme_manager_idle_should_stop(void* context) {
+    ThemeManagerIdle* idle = context;
+    return (furi_thread_flags_get() & (IdleFlagInput | IdleFlagExit)) ||
+           __atomic_load_n(&idle->busy, __ATOMIC_ACQUIRE) > 0;
+}
+
+// -------------------------------------------------------------------
+// Fingerprint of the scanned theme list: names and types in order
+// -------------------------------------------------------------------
+static uint32_t theme_manager_idle_list_hash(ThemeManagerApp* app) {
+    uint32_t hash = 2166136261UL;
+
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    for(uint32_t i = 0; i < app->theme_count; i++) {
+        for(const char* c = app->theme_names[i]; *c; c++) {
+            hash = (hash ^ (uint8_t)*c) * 16777619UL;
+        }
+        hash = (hash ^ (0x80 | app->theme_types[i])) * 16777619UL;
+    }
+    furi_mutex_release(app->index_mutex);
+
+    return hash;
+}
+
+// -------------------------------------------------------------------
+// Persisted scheduler position: "<job> <cursor> <list hash>"
+// -------------------------------------------------------------------
+static void theme_manager_idle_load_state(ThemeManagerIdle* idle) {
+    File* file = storage_file_alloc(idle->app->storage);
+    char buf[24] = {0};
+
+    if(storage_file_open(file, IDLE_STATE_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        storage_file_read(file, buf, sizeof(buf) - 1);
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    /* Without a list hash (older state files) the position is dropped
+     * by the first rescan */
+    unsigned long job = 0, cursor = 0, list_hash = 0;
+    if(sscanf(buf, "%lu %lu %lx", &job, &cursor, &list_hash) >= 2 && job <= IdleJobCount) {
+        idle->job = job;
+        idle->cursor = cursor;
+        idle->list_hash = list_hash;
+    }
+}
+
+static void theme_manager_idle_save_state(ThemeManagerIdle* idle) {
+    ThemeManagerApp* app = idle->app;
+
+    /* Formatted under the lock, written after it: the GUI thread takes
+     * the same lock to show a theme */
+    FuriString* content = NULL;
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    if(app->index->dirty) {
+        content = furi_string_alloc();
+        theme_manager_index_format(app->index, content);
+        app->index->dirty = false;
+    }
+    furi_mutex_release(app->index_mutex);
+
+    if(content) {
+        if(!theme_manager_index_write(app->storage, content)) {
+            furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+            app->index->dirty = true;
+            furi_mutex_release(app->index_mutex);
+        }
+        furi_string_free(content);
+    }
+
+    if(!idle->state_dirty) return;
+
+    File* file = storage_file_alloc(app->storage);
+    if(storage_file_open(file, IDLE_STATE_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        char buf[40];
+        int len = snprintf(
+            buf, sizeof(buf), "%lu %lu %08lx\n", idle->job, idle->cursor, idle->list_hash);
+        storage_file_write(file, buf, len);
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    idle->state_dirty = false;
+}
+
+// -------------------------------------------------------------------
+// One step of a per-theme job on the theme under the cursor
+// Returns false if the step was preempted and must be retried
+// -------------------------------------------------------------------
+static bool theme_manager_idle_theme_step(
+    ThemeManagerIdle* idle,
+    const char* name,
+    ThemeType type) {
+    ThemeManagerApp* app = idle->app;
+    uint32_t stamp = THEME_STAMP_UNKNOWN;
+    uint8_t flags = 0;
+
+    /* The index job stamps every theme once per pass; later jobs trust
+     * that stamp unless a foreground operation dropped the entry since */
+    furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+    ThemeIndexEntry* entry = NULL;
+    if(idle->job != IdleJobIndex) entry = theme_manager_index_find(app->index, name);
+    if(entry) {
+        stamp = entry->stamp;
+        flags = entry->flags;
+    }
+    furi_mutex_release(app->index_mutex);
+
+    if(stamp == THEME_STAMP_UNKNOWN) {
+        if(!theme_manager_theme_stamp(
+               app->storage,
+               ANIMATION_PACKS_PATH,
+               name,
+               type,
+               theme_manager_idle_should_stop,
+               idle,
+               &stamp)) {
+            return false;
+        }
+
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        entry = theme_manager_index_update(app->index, name, stamp);
+        flags = entry ? entry->flags : 0xFF;
+        furi_mutex_release(app->index_mutex);
+    }
+
+    if(flags & idle_job_flags[idle->job]) return true;
+
+    FuriString* path = furi_string_alloc();
+    uint32_t anim_count = 0;
+    uint64_t size = 0;
+    uint8_t done_flag = 0;
+    bool complete = true;
+
+    switch(idle->job) {
+    case IdleJobIndex:
+        if(theme_manager_get_manifest_path(path, ANIMATION_PACKS_PATH, name, type)) {
+            theme_manager_parse_manifest(app->storage, furi_string_get_cstr(path), &anim_count);
+        } else if(type == ThemeTypeSingle) {
+            anim_count = 1;
+        } else if(type == ThemeTypeContainer) {
+            ThemeContainerInfo container;
+            furi_string_printf(path, "%s/%s", ANIMATION_PACKS_PATH, name);
+            if(theme_manager_container_read_info(
+                   app->storage, furi_string_get_cstr(path), &container, NULL)) {
+                anim_count = container.anim_count;
+            }
+        }
+        done_flag = ThemeIndexHasCount;
+        break;
+    case IdleJobSizes:
+        complete = theme_manager_get_theme_size(
+            app->storage,
+            ANIMATION_PACKS_PATH,
+            name,
+            type,
+            theme_manager_idle_should_stop,
+            idle,
+            &size);
+        if(complete) done_flag = ThemeIndexHasSize;
+        break;
+    case IdleJobThumbs:
+        /* A theme without a usable frame is not retried until the next pass */
+        if(theme_manager_thumb_build(
+               app->storage,
+               ANIMATION_PACKS_PATH,
+               name,
+               type,
+               stamp,
+               theme_manager_idle_should_stop,
+               idle)) {
+            done_flag = ThemeIndexHasThumb;
+        } else {
+            complete = !theme_manager_idle_should_stop(idle);
+        }
+        break;
+    case IdleJobCost:
+        /* Bundles and containers have no frame files to load */
+        if(type == ThemeTypeArchive || type == ThemeTypeContainer) break;
+        complete = theme_manager_cost_estimate(
+            app->storage,
+            ANIMATION_PACKS_PATH,
+            name,
+            type,
+            &idle->cost_model,
+            &idle->cost,
+            NULL,
+            NULL,
+            theme_manager_idle_should_stop,
+            idle);
+        if(complete) done_flag = ThemeIndexHasCost;
+        break;
+    default:
+        break;
+    }
+
+    furi_string_free(path);
+
+    if(done_flag) {
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        entry = theme_manager_index_update(app->index, name, stamp);
+        if(entry) {
+            if(done_flag == ThemeIndexHasCount) entry->anim_count = anim_count;
+            if(done_flag == ThemeIndexHasSize) entry->size = size;
+            if(done_flag == ThemeIndexHasCost) {
+                entry->load_ms = idle->cost.max_ms;
+                if(idle->cost.heavy_anims) entry->flags |= ThemeIndexCostHeavy;
+            }
+            entry->flags |= done_flag;
+            app->index->dirty = true;
+        }
+        furi_mutex_release(app->index_mutex);
+    }
+
+    return complete;
+}
+
+// -------------------------------------------------------------------
+// Run one step of the current job and advance the scheduler
+// -------------------------------------------------------------------
+static void theme_manager_idle_step(ThemeManagerIdle* idle) {
+    ThemeManagerApp* app = idle->app;
+    bool job_done = false;
+
+    if(idle->job == IdleJobTrash) {
+        job_done = !theme_manager_trash_reclaim_step(
+            app->storage, theme_manager_idle_should_stop, idle);
+    } else {
+        char name[MAX_NAME_LEN];
+        ThemeType type = ThemeTypePack;
+
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        job_done = idle->cursor >= app->theme_count;
+        if(!job_done) {
+            strncpy(name, app->theme_names[idle->cursor], sizeof(name));
+            type = app->theme_types[idle->cursor];
+        }
+        furi_mutex_release(app->index_mutex);
+
+        if(!job_done && theme_manager_idle_theme_step(idle, name, type)) {
+            idle->cursor++;
+            idle->state_dirty = true;
+        }
+    }
+
+    if(!job_done) return;
+
+    FURI_LOG_D(TAG, "Idle: %s done", idle_job_names[idle->job]);
+    idle->job++;
+    idle->cursor = 0;
+    idle->state_dirty = true;
+
+    if(idle->job == IdleJobCount) {
+        furi_mutex_acquire(app->index_mutex, FuriWaitForever);
+        theme_manager_index_prune(
+            app->index, (const char(*)[MAX_NAME_LEN])app->theme_names, app->theme_count);
+        furi_mutex_release(app->index_mutex);
+
+        theme_manager_idle_save_state(idle);
+        FURI_LOG_I(TAG, "Idle: pass complete");
+    }
+}
+
+// -------------------------------------------------------------------
+// Idle thread: sleep until the user has been idle long enough, then
+// run steps back to back until preempted or the pass is complete
+// -------------------------------------------------------------------
+static int32_t theme_manager_idle_worker(void* context) {
+    ThemeManagerIdle* idle = context;
+    uint32_t delay = furi_ms_to_ticks(IDLE_DELAY_MS);
+
+    theme_manager_idle_load_state(idle);
+    theme_manager_cost_load_model(idle->app->storage, &idle->cost_model);
+
+    while(true) {
+        uint32_t timeout = FuriWaitForever;
+        if(idle->job < IdleJobCount) {
+            uint32_t since = furi_get_tick() - idle->last_input;
+            timeout = since >= delay ? 0 : delay - since;
+            if(idle->busy > 0) timeout = delay;
+        }
+
+        uint32_t flags = furi_thread_flags_wait(IDLE_FLAGS_ALL, FuriFlagWaitAny, timeout);
+
+        if(!(flags & FuriFlagError)) {
+            if(flags & IdleFlagExit) break;
+            if(flags & IdleFlagInput) theme_manager_idle_save_state(idle);
+            if(flags & (IdleFlagKick | IdleFlagRescan)) {
+                /* A pass cut short resumes unless the list it counts into
+                 * changed; otherwise a new pass starts and skips whatever
+                 * is still fresh */
+                uint32_t list_hash = theme_manager_idle_list_hash(idle->app);
+                bool resume = !(flags & IdleFlagKick) && list_hash == idle->list_hash &&
+                              idle->job < IdleJobCount;
+                if(resume) {
+                    FURI_LOG_I(
+                        TAG,
+                        "Idle: resuming %s at %lu",
+                        idle_job_names[idle->job],
+                        idle->cursor);
+                } else {
+                    idle->job = 0;
+                    idle->cursor = 0;
+                    idle->list_hash = list_hash;
+                    idle->state_dirty = true;
+                }
+                theme_manager_cost_load_model(idle->app->storage, &idle->cost_model);
+            }
+            continue;
+        }
+
+        if(idle->job >= IdleJobCount || idle->busy > 0) continue;
+        if(furi_get_tick() - idle->last_input < delay) continue;
+
+        theme_manager_idle_step(idle);
+    }
+
+    theme_manager_idle_save_state(idle);
+    return 0;
+}
+
+// -------------------------------------------------------------------
+// GUI side
+// -------------------------------------------------------------------
+ThemeManagerIdle* theme_manager_idle_alloc(ThemeManagerApp* app) {
+    ThemeManagerIdle* idle = malloc(sizeof(ThemeManagerIdle));
+    memset(idle, 0, sizeof(ThemeManagerIdle));
+
+    idle->app = app;
+    idle->last_input = furi_get_tick();
+
+    idle->thread = furi_thread_alloc_ex(
+        "ThemeManagerIdle", IDLE_THREAD_STACK_SIZE, theme_manager_idle_worker, idle);
+    furi_thread_set_priority(idle->thread, FuriThreadPriorityLow);
+    furi_thread_start(idle->thread);
+
+    idle->input_events = furi_record_open(RECORD_INPUT_EVENTS);
+    idle->input_subscription =
+        furi_pubsub_subscribe(idle->input_events, theme_manager_idle_input_callback, idle);
+
+    return idle;
+}
+
+void theme_manager_idle_free(ThemeManagerIdle* idle) {
+    furi_pubsub_unsubscribe(idle->input_events, idle->input_subscription);
+    furi_record_close(RECORD_INPUT_EVENTS);
+
+    furi_thread_flags_set(furi_thread_get_id(idle->thread), IdleFlagExit);
+    furi_thread_join(idle->thread);
+    furi_thread_free(idle->thread);
+
+    free(idle);
+}
+
+void theme_manager_idle_kick(ThemeManagerIdle* idle) {
+    furi_thread_flags_set(furi_thread_get_id(idle->thread), IdleFlagKick);
+}
+
+void theme_manager_idle_rescan(ThemeManagerIdle* idle) {
+    furi_thread_flags_set(furi_thread_get_id(idle->thread), IdleFlagRescan);
+}
+
+// -------------------------------------------------------------------
+// Foreground operations that touch the SD card hold off idle work
+// -------------------------------------------------------------------
+void theme_manager_idle_set_busy(ThemeManagerIdle* idle, bool busy) {
+    __atomic_add_fetch(&idle->busy, busy ? 1 : -1, __ATOMIC_RELAXED);
+}
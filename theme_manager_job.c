@@ -0,0 +1,199 @@
+#include "theme_manager_i.h"
+
+// -------------------------------------------------------------------
+// Progress view — draw callback
+// Title, status line, progress bar and cancel hint
+// -------------------------------------------------------------------
+static void theme_manager_progress_draw(Canvas* canvas, void* _model) {
+    ProgressViewModel* model = _model;
+
+    canvas_clear(canvas);
+    canvas_set_color(canvas, ColorBlack);
+
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str_aligned(canvas, 64, 2, AlignCenter, AlignTop, model->title);
+
+    canvas_set_font(canvas, FontSecondary);
+    canvas_draw_str_aligned(canvas, 64, 22, AlignCenter, AlignTop, model->status);
+
+    canvas_draw_frame(canvas, 4, 36, 120, 8);
+    if(model->total > 0) {
+        uint32_t fill = (uint32_t)((uint64_t)model->done * 116 / model->total);
+        if(fill > 116) fill = 116;
+        canvas_draw_box(canvas, 6, 38, fill, 4);
+    }
+
+    canvas_draw_str_aligned(
+        canvas,
+        64,
+        63,
+        AlignCenter,
+        AlignBottom,
+        model->cancelling ? "Cancelling..." : "Back to cancel");
+}
+
+// -------------------------------------------------------------------
+// Progress view — input callback
+// Back requests cancellation; the job stops at its next check
+// -------------------------------------------------------------------
+static bool theme_manager_progress_input(InputEvent* event, void* context) {
+    ThemeManagerApp* app = context;
+
+    if(event->key == InputKeyBack && event->type == InputTypeShort) {
+        app->job_cancel = true;
+        with_view_model(
+            app->progress_view, ProgressViewModel * model, { model->cancelling = true; }, true);
+    }
+
+    /* Swallow everything: navigation away is not allowed while a job runs */
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Job thread body
+// -------------------------------------------------------------------
+static int32_t theme_manager_job_worker(void* context) {
+    ThemeManagerApp* app = context;
+
+    app->job_result = app->job_callback(app, app->job_context);
+    view_dispatcher_send_custom_event(app->view_dispatcher, ThemeManagerEventJobDone);
+
+    return 0;
+}
+
+void theme_manager_job_init(ThemeManagerApp* app) {
+    app->progress_view = view_alloc();
+    view_allocate_model(app->progress_view, ViewModelTypeLocking, sizeof(ProgressViewModel));
+    view_set_draw_callback(app->progress_view, theme_manager_progress_draw);
+    view_set_input_callback(app->progress_view, theme_manager_progress_input);
+    view_set_context(app->progress_view, app);
+    view_dispatcher_add_view(app->view_dispatcher, ThemeManagerViewProgress, app->progress_view);
+
+    app->job_thread = furi_thread_alloc_ex(
+        "ThemeManagerJob", JOB_THREAD_STACK_SIZE, theme_manager_job_worker, app);
+}
+
+void theme_manager_job_deinit(ThemeManagerApp* app) {
+    /* The view dispatcher can't stop while the progress view swallows Back,
+     * but be defensive: never free a thread that is still running */
+    if(app->job_callback) {
+        app->job_cancel = true;
+        furi_thread_join(app->job_thread);
+    }
+
+    furi_thread_free(app->job_thread);
+
+    view_dispatcher_remove_view(app->view_dispatcher, ThemeManagerViewProgress);
+    view_free(app->progress_view);
+}
+
+// -------------------------------------------------------------------
+// Start a job on the worker thread and show the progress view
+// Returns false if another job is still running
+// -------------------------------------------------------------------
+bool theme_manager_job_start(
+    ThemeManagerApp* app,
+    const char* title,
+    ThemeManagerJobCallback callback,
+    ThemeManagerJobDoneCallback done_callback,
+    void* context) {
+    if(app->job_callback) {
+        FURI_LOG_W(TAG, "Job already running");
+        return false;
+    }
+
+    app->job_callback = callback;
+    app->job_done_callback = done_callback;
+    app->job_context = context;
+    app->job_cancel = false;
+    app->job_result = false;
+
+    with_view_model(
+        app->progress_view,
+        ProgressViewModel * model,
+        {
+            strncpy(model->title, title, sizeof(model->title) - 1);
+            model->title[sizeof(model->title) - 1] = '\0';
+            model->status[0] = '\0';
+            model->done = 0;
+            model->total = 0;
+            model->cancelling = false;
+        },
+        true);
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewProgress);
+    theme_manager_idle_set_busy(app->idle, true);
+    furi_thread_start(app->job_thread);
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Called from the job thread to report progress
+// status may be NULL to keep the previous line
+// -------------------------------------------------------------------
+void theme_manager_job_set_progress(
+    ThemeManagerApp* app,
+    uint32_t done,
+    uint32_t total,
+    const char* status) {
+    with_view_model(
+        app->progress_view,
+        ProgressViewModel * model,
+        {
+            model->done = done;
+            model->total = total;
+            if(status) {
+                strncpy(model->status, status, sizeof(model->status) - 1);
+                model->status[sizeof(model->status) - 1] = '\0';
+            }
+        },
+        true);
+}
+
+bool theme_manager_job_is_cancelled(ThemeManagerApp* app) {
+    return app->job_cancel;
+}
+
+// -------------------------------------------------------------------
+// Adapters for core operations taking progress/stop callbacks
+// context is the app
+// -------------------------------------------------------------------
+void theme_manager_job_progress_callback(
+    uint32_t done,
+    uint32_t total,
+    const char* status,
+    void* context) {
+    theme_manager_job_set_progress(context, done, total, status);
+}
+
+bool theme_manager_job_stop_callback(void* context) {
+    return theme_manager_job_is_cancelled(context);
+}
+
+// -------------------------------------------------------------------
+// Custom event handler part for jobs — runs on the GUI thread
+// Joins the worker, then hands the result to the done callback
+// -------------------------------------------------------------------
+bool theme_manager_job_custom_event(ThemeManagerApp* app, uint32_t event) {
+    if(event != ThemeManagerEventJobDone) return false;
+
+    furi_thread_join(app->job_thread);
+    theme_manager_idle_set_busy(app->idle, false);
+
+    ThemeManagerJobDoneCallback done_callback = app->job_done_callback;
+    void* context = app->job_context;
+    bool result = app->job_result;
+
+    app->job_callback = NULL;
+    app->job_done_callback = NULL;
+    app->job_context = NULL;
+
+    if(done_callback) {
+        done_callback(app, result, context);
+    } else {
+        view_dispatcher_switch_to_view(app->view_dispatcher, ThemeManagerViewSubmenu);
+    }
+
+    return true;
+}
@@ -0,0 +1,573 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManagerLibrary"
+
+/* Content-addressed library store. Importing a theme hashes each of its
+ * animation folders (file names and contents), moves folders the store
+ * doesn't have yet to <root>/.store/<hash> and drops local copies of ones
+ * it already has. The theme folder keeps manifest.txt and gets refs.txt:
+ *
+ *   <animation name>\t<hash>
+ *
+ * Apply materializes only the referenced folders into the destination.
+ * Store entries are shared between themes and are only removed by a
+ * library scan with garbage collection, once nothing references them. */
+
+#define LIBRARY_HASH_CHUNK 512
+
+// -------------------------------------------------------------------
+// refs.txt helpers
+// -------------------------------------------------------------------
+static void theme_manager_library_store_path(FuriString* out, const char* root, const char* key) {
+    furi_string_printf(out, "%s/%s/%s", root, LIBRARY_STORE_DIRNAME, key);
+}
+
+static bool theme_manager_library_read_refs(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    FuriString* out) {
+    FuriString* path =
+        furi_string_alloc_printf("%s/%s/%s", root, name, LIBRARY_REFS_FILENAME);
+    bool ok = theme_manager_read_text(storage, furi_string_get_cstr(path), out);
+    furi_string_free(path);
+    return ok;
+}
+
+/* Next "<anim>\t<key>" line from *cursor; false at the end */
+static bool theme_manager_library_next_ref(
+    const char** cursor,
+    char* anim,
+    size_t anim_size,
+    char* key) {
+    const char* line = *cursor;
+
+    while(*line) {
+        const char* eol = strchr(line, '\n');
+        size_t len = eol ? (size_t)(eol - line) : strlen(line);
+        *cursor = eol ? eol + 1 : line + len;
+
+        const char* tab = memchr(line, '\t', len);
+        size_t anim_len = tab ? (size_t)(tab - line) : 0;
+        size_t key_len = tab ? len - anim_len - 1 : 0;
+        if(key_len > 0 && line[len - 1] == '\r') key_len--;
+
+        if(anim_len > 0 && anim_len < anim_size && key_len == LIBRARY_KEY_LEN) {
+            memcpy(anim, line, anim_len);
+            anim[anim_len] = '\0';
+            memcpy(key, tab + 1, LIBRARY_KEY_LEN);
+            key[LIBRARY_KEY_LEN] = '\0';
+            return true;
+        }
+
+        line = *cursor;
+    }
+
+    return false;
+}
+
+// -------------------------------------------------------------------
+// Store folder of one animation of a library theme
+// -------------------------------------------------------------------
+bool theme_manager_library_lookup(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    const char* anim_name,
+    FuriString* out_dir) {
+    FuriString* refs = furi_string_alloc();
+    bool found = false;
+
+    if(theme_manager_library_read_refs(storage, root, name, refs)) {
+        const char* cursor = furi_string_get_cstr(refs);
+        char anim[MAX_NAME_LEN];
+        char key[LIBRARY_KEY_LEN + 1];
+
+        while(!found && theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+            if(strcmp(anim, anim_name) == 0) {
+                theme_manager_library_store_path(out_dir, root, key);
+                found = true;
+            }
+        }
+    }
+
+    furi_string_free(refs);
+    return found;
+}
+
+// -------------------------------------------------------------------
+// Size of everything a library theme references
+// -------------------------------------------------------------------
+bool theme_manager_library_get_size(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    uint64_t* out_size) {
+    FuriString* refs = furi_string_alloc();
+    FuriString* path = furi_string_alloc();
+    bool complete = true;
+
+    if(theme_manager_library_read_refs(storage, root, name, refs)) {
+        const char* cursor = furi_string_get_cstr(refs);
+        char anim[MAX_NAME_LEN];
+        char key[LIBRARY_KEY_LEN + 1];
+
+        while(complete && theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+            theme_manager_library_store_path(path, root, key);
+            complete = theme_manager_get_dir_size_ex(
+                storage, furi_string_get_cstr(path), stop_callback, context, out_size);
+        }
+    }
+
+    furi_string_free(path);
+    furi_string_free(refs);
+    return complete;
+}
+
+// -------------------------------------------------------------------
+// Content hash of an animation folder: 64-bit FNV-1a of each file's
+// name and data, summed so the result doesn't depend on directory order
+// -------------------------------------------------------------------
+typedef struct {
+    Storage* storage;
+    FuriString* refs; /* "<anim>\t<key>\t<size>\n" per hashed folder */
+    FuriString* path;
+    uint8_t buf[LIBRARY_HASH_CHUNK];
+
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    uint32_t done;
+    uint32_t total;
+    bool stopped;
+} LibraryImport;
+
+static uint64_t theme_manager_library_fnv(uint64_t hash, const uint8_t* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool theme_manager_library_hash_dir(
+    LibraryImport* import,
+    const char* dir_path,
+    uint64_t* out_hash,
+    uint64_t* out_size) {
+    File* dir = storage_file_alloc(import->storage);
+    File* file = storage_file_alloc(import->storage);
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+    uint64_t sum = 0;
+    uint32_t count = 0;
+    bool ok = storage_dir_open(dir, dir_path);
+
+    while(ok && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+        if(file_info.flags & FSF_DIRECTORY) continue;
+        if(import->stop_callback && import->stop_callback(import->context)) {
+            import->stopped = true;
+            ok = false;
+            break;
+        }
+
+        uint64_t hash = theme_manager_library_fnv(
+            14695981039346656037ULL, (const uint8_t*)name, strlen(name) + 1);
+
+        furi_string_printf(import->path, "%s/%s", dir_path, name);
+        if(!storage_file_open(
+               file, furi_string_get_cstr(import->path), FSAM_READ, FSOM_OPEN_EXISTING)) {
+            ok = false;
+            break;
+        }
+        size_t bytes_read;
+        while((bytes_read = storage_file_read(file, import->buf, sizeof(import->buf))) > 0) {
+            hash = theme_manager_library_fnv(hash, import->buf, bytes_read);
+        }
+        storage_file_close(file);
+
+        sum += hash;
+        count++;
+        *out_size += file_info.size;
+    }
+
+    storage_dir_close(dir);
+    storage_file_free(file);
+    storage_file_free(dir);
+
+    *out_hash = theme_manager_library_fnv(sum, (const uint8_t*)&count, sizeof(count));
+    return ok && count > 0;
+}
+
+static bool theme_manager_library_hash_anim(const char* anim_dir, void* context) {
+    LibraryImport* import = context;
+
+    const char* anim_name = strrchr(anim_dir, '/');
+    anim_name = anim_name ? anim_name + 1 : anim_dir;
+    if(import->progress_callback) {
+        import->progress_callback(import->done, import->total, anim_name, import->context);
+    }
+    import->done++;
+
+    uint64_t hash = 0;
+    uint64_t size = 0;
+    if(!theme_manager_library_hash_dir(import, anim_dir, &hash, &size)) {
+        if(!import->stopped) FURI_LOG_E(TAG, "Can't hash %s", anim_dir);
+        import->stopped = true;
+        return false;
+    }
+
+    furi_string_cat_printf(
+        import->refs,
+        "%s\t%08lX%08lX\t%llu\n",
+        anim_name,
+        (uint32_t)(hash >> 32),
+        (uint32_t)hash,
+        size);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Convert a theme to library mode
+// Hashing is cancellable; once every folder is hashed the conversion
+// runs to the end (renames only) and is rolled back if a move fails
+// -------------------------------------------------------------------
+bool theme_manager_library_import(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    ThemeLibraryImportStats* stats) {
+    memset(stats, 0, sizeof(ThemeLibraryImportStats));
+    if(type == ThemeTypeLibrary) return true;
+
+    LibraryImport* import = malloc(sizeof(LibraryImport));
+    memset(import, 0, sizeof(LibraryImport));
+    import->storage = storage;
+    import->refs = furi_string_alloc();
+    import->path = furi_string_alloc();
+    import->progress_callback = progress_callback;
+    import->stop_callback = stop_callback;
+    import->context = context;
+
+    FuriString* theme_dir = furi_string_alloc_printf("%s/%s", root, name);
+    FuriString* pack_dir = furi_string_alloc();
+    FuriString* src = furi_string_alloc();
+    FuriString* dst = furi_string_alloc();
+    FuriString* refs = furi_string_alloc(); /* final refs.txt */
+    bool ok = false;
+
+    theme_manager_get_pack_dir(pack_dir, root, name, type);
+    const char* pack_path = furi_string_get_cstr(pack_dir);
+    import->total = theme_manager_foreach_anim(storage, pack_path, NULL, NULL);
+    theme_manager_foreach_anim(storage, pack_path, theme_manager_library_hash_anim, import);
+
+    do {
+        if(import->stopped || import->total == 0) break;
+        if(progress_callback) progress_callback(import->total, import->total, "Moving", context);
+
+        furi_string_printf(src, "%s/%s", root, LIBRARY_STORE_DIRNAME);
+        storage_simply_mkdir(storage, furi_string_get_cstr(src));
+
+        /* 1. Move new folders into the store */
+        const char* cursor = furi_string_get_cstr(import->refs);
+        char anim[MAX_NAME_LEN];
+        char key[LIBRARY_KEY_LEN + 1];
+        uint32_t moved = 0;
+        ok = true;
+
+        while(ok && theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+            furi_string_cat_printf(refs, "%s\t%s\n", anim, key);
+
+            theme_manager_library_store_path(dst, root, key);
+            if(storage_dir_exists(storage, furi_string_get_cstr(dst))) continue;
+
+            theme_manager_get_anim_dir(storage, root, name, type, anim, src);
+            ok = storage_common_rename(
+                     storage, furi_string_get_cstr(src), furi_string_get_cstr(dst)) == FSE_OK;
+            if(ok) {
+                moved++;
+            } else {
+                FURI_LOG_E(TAG, "Can't move %s to the store", furi_string_get_cstr(src));
+            }
+        }
+
+        if(!ok) {
+            /* Roll back: the first `moved` new entries go home */
+            cursor = furi_string_get_cstr(import->refs);
+            while(moved > 0 && theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+                theme_manager_get_anim_dir(storage, root, name, type, anim, src);
+                if(storage_dir_exists(storage, furi_string_get_cstr(src))) continue;
+                theme_manager_library_store_path(dst, root, key);
+                storage_common_rename(
+                    storage, furi_string_get_cstr(dst), furi_string_get_cstr(src));
+                moved--;
+            }
+            break;
+        }
+        stats->anims_stored = moved;
+
+        /* 2. Theme folder becomes manifest.txt + refs.txt */
+        if(type == ThemeTypeSingle) {
+            /* The theme folder was the animation: recreate it */
+            if(storage_dir_exists(storage, furi_string_get_cstr(theme_dir))) {
+                stats->anims_shared++;
+                theme_manager_get_dir_size_ex(
+                    storage, furi_string_get_cstr(theme_dir), NULL, NULL, &stats->bytes_reclaimed);
+                theme_manager_trash_move(storage, furi_string_get_cstr(theme_dir));
+            }
+            storage_simply_mkdir(storage, furi_string_get_cstr(theme_dir));
+            furi_string_printf(src, "%s/%s", furi_string_get_cstr(theme_dir), MANIFEST_FILENAME);
+            theme_manager_write_single_manifest(storage, furi_string_get_cstr(src), name);
+        } else if(type == ThemeTypeAnimsPack) {
+            furi_string_printf(
+                src, "%s/%s", furi_string_get_cstr(pack_dir), MANIFEST_FILENAME);
+            furi_string_printf(
+                dst, "%s/%s", furi_string_get_cstr(theme_dir), MANIFEST_FILENAME);
+            storage_common_rename(storage, furi_string_get_cstr(src), furi_string_get_cstr(dst));
+        }
+
+        furi_string_printf(src, "%s/%s", furi_string_get_cstr(theme_dir), LIBRARY_REFS_FILENAME);
+        File* file = storage_file_alloc(storage);
+        ok = storage_file_open(file, furi_string_get_cstr(src), FSAM_WRITE, FSOM_CREATE_ALWAYS);
+        if(ok) {
+            size_t len = furi_string_size(refs);
+            ok = storage_file_write(file, furi_string_get_cstr(refs), len) == len;
+            storage_file_close(file);
+        }
+        storage_file_free(file);
+        if(!ok) {
+            FURI_LOG_E(TAG, "Can't write %s", furi_string_get_cstr(src));
+            break;
+        }
+
+        /* 3. Local copies of folders the store already had */
+        if(type != ThemeTypeSingle) {
+            cursor = furi_string_get_cstr(import->refs);
+            while(theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+                furi_string_printf(src, "%s/%s", furi_string_get_cstr(pack_dir), anim);
+                if(!storage_dir_exists(storage, furi_string_get_cstr(src))) continue;
+
+                stats->anims_shared++;
+                theme_manager_get_dir_size_ex(
+                    storage, furi_string_get_cstr(src), NULL, NULL, &stats->bytes_reclaimed);
+                theme_manager_trash_move(storage, furi_string_get_cstr(src));
+            }
+            if(type == ThemeTypeAnimsPack) {
+                theme_manager_trash_move(storage, furi_string_get_cstr(pack_dir));
+            }
+        }
+    } while(false);
+
+    FURI_LOG_I(
+        TAG,
+        "Import %s: %lu stored, %lu shared, %llu bytes reclaimed",
+        name,
+        stats->anims_stored,
+        stats->anims_shared,
+        stats->bytes_reclaimed);
+
+    furi_string_free(refs);
+    furi_string_free(dst);
+    furi_string_free(src);
+    furi_string_free(pack_dir);
+    furi_string_free(theme_dir);
+    furi_string_free(import->path);
+    furi_string_free(import->refs);
+    free(import);
+
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Apply a library theme: manifest plus the referenced store folders
+// -------------------------------------------------------------------
+bool theme_manager_library_install(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    const char* dst_dir) {
+    FuriString* refs = furi_string_alloc();
+    FuriString* src = furi_string_alloc_printf("%s/%s/%s", root, name, MANIFEST_FILENAME);
+    FuriString* dst = furi_string_alloc_printf("%s/%s", dst_dir, MANIFEST_FILENAME);
+
+    bool ok = theme_manager_library_read_refs(storage, root, name, refs) &&
+              theme_manager_copy_file(
+                  storage, furi_string_get_cstr(src), furi_string_get_cstr(dst));
+
+    const char* cursor = furi_string_get_cstr(refs);
+    char anim[MAX_NAME_LEN];
+    char key[LIBRARY_KEY_LEN + 1];
+
+    while(ok && theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+        theme_manager_library_store_path(src, root, key);
+        furi_string_printf(dst, "%s/%s", dst_dir, anim);
+        ok = theme_manager_copy_tree(
+            storage, furi_string_get_cstr(src), furi_string_get_cstr(dst));
+    }
+
+    if(!ok) FURI_LOG_E(TAG, "Install of library theme %s failed", name);
+
+    furi_string_free(dst);
+    furi_string_free(src);
+    furi_string_free(refs);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Library scan: what the store holds, what the themes reference, and
+// optionally trash entries nobody references any more
+// -------------------------------------------------------------------
+static int theme_manager_library_key_cmp(const void* a, const void* b) {
+    uint64_t ka = *(const uint64_t*)a;
+    uint64_t kb = *(const uint64_t*)b;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static bool theme_manager_library_parse_key(const char* text, uint64_t* out) {
+    if(strlen(text) != LIBRARY_KEY_LEN) return false;
+
+    char* end;
+    *out = strtoull(text, &end, 16);
+    return *end == '\0';
+}
+
+bool theme_manager_library_scan(
+    Storage* storage,
+    const char* root,
+    bool collect_garbage,
+    ThemeLibraryStats* stats) {
+    memset(stats, 0, sizeof(ThemeLibraryStats));
+
+    FuriString* path = furi_string_alloc();
+    FuriString* refs = furi_string_alloc();
+    File* dir = storage_file_alloc(storage);
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+
+    uint64_t* keys = NULL;
+    size_t key_count = 0;
+    size_t key_capacity = 0;
+
+    /* Every key referenced by a library theme, with repeats */
+    if(storage_dir_open(dir, root)) {
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            if(!(file_info.flags & FSF_DIRECTORY) || name[0] == '.') continue;
+            if(!theme_manager_library_read_refs(storage, root, name, refs)) continue;
+
+            const char* cursor = furi_string_get_cstr(refs);
+            char anim[MAX_NAME_LEN];
+            char key[LIBRARY_KEY_LEN + 1];
+            uint64_t value;
+
+            while(theme_manager_library_next_ref(&cursor, anim, sizeof(anim), key)) {
+                if(!theme_manager_library_parse_key(key, &value)) continue;
+                if(key_count == key_capacity) {
+                    key_capacity = key_capacity ? key_capacity * 2 : 64;
+                    keys = realloc(keys, key_capacity * sizeof(uint64_t));
+                }
+                keys[key_count++] = value;
+            }
+        }
+        storage_dir_close(dir);
+    }
+
+    if(key_count > 1) qsort(keys, key_count, sizeof(uint64_t), theme_manager_library_key_cmp);
+
+    /* Walk the store and match entries against the references */
+    furi_string_printf(path, "%s/%s", root, LIBRARY_STORE_DIRNAME);
+    FuriString* store_dir = furi_string_alloc_set(path);
+
+    if(storage_dir_open(dir, furi_string_get_cstr(store_dir))) {
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            uint64_t value;
+            if(!(file_info.flags & FSF_DIRECTORY)) continue;
+            if(!theme_manager_library_parse_key(name, &value)) continue;
+
+            uint64_t* found =
+                key_count ? bsearch(
+                                &value,
+                                keys,
+                                key_count,
+                                sizeof(uint64_t),
+                                theme_manager_library_key_cmp) :
+                            NULL;
+            uint32_t ref_count = 0;
+            if(found) {
+                uint64_t* first = found;
+                while(first > keys && first[-1] == value)
+                    first--;
+                while(first + ref_count < keys + key_count && first[ref_count] == value)
+                    ref_count++;
+            }
+
+            uint64_t size = 0;
+            furi_string_printf(path, "%s/%s", furi_string_get_cstr(store_dir), name);
+            theme_manager_get_dir_size_ex(storage, furi_string_get_cstr(path), NULL, NULL, &size);
+
+            if(ref_count == 0) {
+                stats->garbage_entries++;
+                stats->garbage_bytes += size;
+            } else {
+                stats->entries++;
+                stats->refs += ref_count;
+                stats->stored_bytes += size;
+                stats->logical_bytes += size * ref_count;
+            }
+        }
+        storage_dir_close(dir);
+    }
+
+    /* Trash after the walk: don't rename entries out of an open directory */
+    if(collect_garbage && stats->garbage_entries > 0 &&
+       storage_dir_open(dir, furi_string_get_cstr(store_dir))) {
+        FuriString* garbage = furi_string_alloc();
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            uint64_t value;
+            if(!(file_info.flags & FSF_DIRECTORY)) continue;
+            if(!theme_manager_library_parse_key(name, &value)) continue;
+            if(key_count &&
+               bsearch(&value, keys, key_count, sizeof(uint64_t), theme_manager_library_key_cmp))
+                continue;
+            furi_string_cat_printf(garbage, "%s\n", name);
+        }
+        storage_dir_close(dir);
+
+        const char* cursor = furi_string_get_cstr(garbage);
+        while(*cursor) {
+            const char* eol = strchr(cursor, '\n');
+            furi_string_printf(
+                path,
+                "%s/%.*s",
+                furi_string_get_cstr(store_dir),
+                (int)(eol - cursor),
+                cursor);
+            theme_manager_trash_move(storage, furi_string_get_cstr(path));
+            cursor = eol + 1;
+        }
+        furi_string_free(garbage);
+    }
+
+    FURI_LOG_I(
+        TAG,
+        "Store: %lu entries, %lu refs, %llu/%llu bytes, %lu unreferenced",
+        stats->entries,
+        stats->refs,
+        stats->stored_bytes,
+        stats->logical_bytes,
+        stats->garbage_entries);
+
+    free(keys);
+    furi_string_free(store_dir);
+    storage_file_free(dir);
+    furi_string_free(refs);
+    furi_string_free(path);
+
+    return true;
+}
@@ -0,0 +1,426 @@
+#include "theme_manager_core.h"
+#include "theme_manager_bitmap.h"
+
+#define TAG "ThemeManagerOptimize"
+
+/* Pack optimizer. Per animation: hash every frame referenced by the
+ * Frames order, keep one canonical copy of identical frames, renumber the
+ * survivors densely (the firmware loads frame_0 .. frame_<max> without
+ * gaps), rewrite Frames order and delete duplicate and unreferenced
+ * frame files. An animation with a missing or oversized frame is left
+ * untouched, and so is one whose rewrite fails part way: frames going
+ * away are only set aside until the new meta.txt is in place, and every
+ * step is undone if a later one fails. */
+
+#define FRAMES_ORDER_KEY "Frames order:"
+
+typedef struct {
+    Storage* storage;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    ThemeOptimizeStats* stats;
+
+    uint32_t done;
+    uint32_t total;
+    bool stopped;
+
+    ThemeAnimMeta meta;
+    ThemePrefetch* prefetch;
+    uint8_t cmp_buf[PREVIEW_MAX_BM_SIZE];
+
+    /* Per-frame state, indexed by original frame number */
+    uint32_t hash[META_MAX_FRAMES];
+    uint16_t size[META_MAX_FRAMES];
+    int16_t remap[META_MAX_FRAMES]; /* -1 = not referenced */
+    uint8_t exists[META_MAX_FRAMES / 8];
+    uint8_t set_aside[META_MAX_FRAMES / 8]; /* renamed to frame_N.old */
+
+    /* Canonical frames by new index -> original frame number */
+    uint8_t canon[META_MAX_FRAMES];
+    uint32_t canon_count;
+
+    uint8_t referenced[META_MAX_FRAMES]; /* ascending, for the prefetcher */
+} OptimizeContext;
+
+static uint32_t theme_manager_optimize_hash(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261UL;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// -------------------------------------------------------------------
+// Read a whole frame file into buf, false if missing or too large
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_read(
+    Storage* storage,
+    const char* path,
+    uint8_t* buf,
+    uint16_t* out_size) {
+    File* file = storage_file_alloc(storage);
+    bool ok = false;
+
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        uint64_t size = storage_file_size(file);
+        if(size > 0 && size <= PREVIEW_MAX_BM_SIZE) {
+            ok = storage_file_read(file, buf, size) == size;
+            *out_size = size;
+        }
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Mark which frame_N.bm files exist in the animation folder
+// -------------------------------------------------------------------
+static void theme_manager_optimize_list_frames(OptimizeContext* ctx, const char* anim_dir) {
+    memset(ctx->exists, 0, sizeof(ctx->exists));
+
+    File* dir = storage_file_alloc(ctx->storage);
+    if(storage_dir_open(dir, anim_dir)) {
+        FileInfo file_info;
+        char name[MAX_NAME_LEN];
+
+        while(storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            if(file_info.flags & FSF_DIRECTORY) continue;
+
+            if(strncmp(name, "frame_", 6) != 0) continue;
+
+            char* end;
+            uint32_t index = strtoul(name + 6, &end, 10);
+            if(end == name + 6 || strcmp(end, ".bm") != 0) continue;
+            if(index < META_MAX_FRAMES) ctx->exists[index / 8] |= 1 << (index % 8);
+        }
+        storage_dir_close(dir);
+    }
+
+    storage_file_free(dir);
+}
+
+// -------------------------------------------------------------------
+// Hash referenced frames and assign canonical indices; the prefetcher
+// reads ahead while frames are hashed. A hash match is confirmed
+// against the earlier frame, read again
+// Returns false if the animation can't be optimized safely
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_dedup(
+    OptimizeContext* ctx,
+    const char* anim_dir,
+    FuriString* path) {
+    for(uint32_t i = 0; i < META_MAX_FRAMES; i++) {
+        ctx->remap[i] = -1;
+    }
+    for(uint32_t p = 0; p < ctx->meta.frame_order_count; p++) {
+        ctx->remap[ctx->meta.frame_order[p]] = 0;
+    }
+
+    ctx->canon_count = 0;
+
+    uint32_t referenced_count = 0;
+    for(uint32_t i = 0; i < META_MAX_FRAMES; i++) {
+        if(ctx->remap[i] >= 0) ctx->referenced[referenced_count++] = i;
+    }
+    theme_manager_prefetch_start(ctx->prefetch, anim_dir, ctx->referenced, referenced_count);
+
+    ThemePrefetchSlot* slot;
+    while((slot = theme_manager_prefetch_take(ctx->prefetch))) {
+        uint8_t i = slot->index;
+        uint16_t size = slot->size;
+        if(slot->status != ThemePrefetchOk) {
+            FURI_LOG_W(TAG, "%s: frame %u missing or too large, skipped", anim_dir, i);
+            theme_manager_prefetch_release(ctx->prefetch, slot);
+            theme_manager_prefetch_cancel(ctx->prefetch);
+            return false;
+        }
+
+        ctx->hash[i] = theme_manager_optimize_hash(slot->data, size);
+        ctx->size[i] = size;
+        ctx->remap[i] = -1;
+
+        for(uint32_t c = 0; c < ctx->canon_count; c++) {
+            uint8_t other = ctx->canon[c];
+            if(ctx->hash[other] != ctx->hash[i] || ctx->size[other] != size) continue;
+
+            /* Same hash: confirm byte by byte */
+            uint16_t other_size = 0;
+            furi_string_printf(path, "%s/frame_%u.bm", anim_dir, other);
+            if(theme_manager_optimize_read(
+                   ctx->storage, furi_string_get_cstr(path), ctx->cmp_buf, &other_size) &&
+               other_size == size && theme_manager_bitmap_equal(slot->data, ctx->cmp_buf, size)) {
+                ctx->remap[i] = c;
+                break;
+            }
+        }
+
+        if(ctx->remap[i] < 0) {
+            ctx->remap[i] = ctx->canon_count;
+            ctx->canon[ctx->canon_count++] = i;
+        }
+        theme_manager_prefetch_release(ctx->prefetch, slot);
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Write meta.txt with its Frames order line remapped to out_path
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_write_meta(
+    OptimizeContext* ctx,
+    const char* meta_path,
+    const char* out_path) {
+    FuriString* text = furi_string_alloc();
+    FuriString* order = furi_string_alloc_set_str(FRAMES_ORDER_KEY);
+    bool ok = false;
+
+    do {
+        if(!theme_manager_read_text(ctx->storage, meta_path, text)) break;
+
+        size_t start = furi_string_search_str(text, FRAMES_ORDER_KEY, 0);
+        if(start == FURI_STRING_FAILURE) break;
+        size_t end = furi_string_search_char(text, '\n', start);
+        if(end == FURI_STRING_FAILURE) end = furi_string_size(text);
+        if(end > start && furi_string_get_char(text, end - 1) == '\r') end--;
+
+        for(uint32_t p = 0; p < ctx->meta.frame_order_count; p++) {
+            furi_string_cat_printf(order, " %d", ctx->remap[ctx->meta.frame_order[p]]);
+        }
+        furi_string_replace_at(text, start, end - start, furi_string_get_cstr(order));
+
+        File* file = storage_file_alloc(ctx->storage);
+        if(storage_file_open(file, out_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+            size_t len = furi_string_size(text);
+            ok = storage_file_write(file, furi_string_get_cstr(text), len) == len;
+            storage_file_close(file);
+        }
+        storage_file_free(file);
+    } while(false);
+
+    furi_string_free(order);
+    furi_string_free(text);
+    return ok;
+}
+
+static bool theme_manager_optimize_is_kept(OptimizeContext* ctx, uint32_t i) {
+    return ctx->remap[i] >= 0 && ctx->canon[ctx->remap[i]] == i;
+}
+
+static void theme_manager_optimize_frame_path(
+    FuriString* out,
+    const char* anim_dir,
+    uint32_t index,
+    const char* ext) {
+    furi_string_printf(out, "%s/frame_%lu.%s", anim_dir, index, ext);
+}
+
+// -------------------------------------------------------------------
+// Replace meta_path with the remapped meta through .tmp, keeping the
+// original as .old until the new one is in place
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_replace_meta(
+    OptimizeContext* ctx,
+    const char* meta_path,
+    FuriString* tmp_path,
+    FuriString* old_path) {
+    furi_string_printf(tmp_path, "%s.tmp", meta_path);
+    furi_string_printf(old_path, "%s.old", meta_path);
+    const char* tmp = furi_string_get_cstr(tmp_path);
+    const char* old = furi_string_get_cstr(old_path);
+
+    bool ok = theme_manager_optimize_write_meta(ctx, meta_path, tmp);
+    if(ok) {
+        storage_common_remove(ctx->storage, old);
+        ok = storage_common_rename(ctx->storage, meta_path, old) == FSE_OK;
+    }
+    if(ok) {
+        ok = storage_common_rename(ctx->storage, tmp, meta_path) == FSE_OK;
+        if(ok) {
+            storage_common_remove(ctx->storage, old);
+        } else if(storage_common_rename(ctx->storage, old, meta_path) != FSE_OK) {
+            FURI_LOG_E(TAG, "%s left as .old and .tmp", meta_path);
+            return false;
+        }
+    }
+
+    if(!ok) storage_common_remove(ctx->storage, tmp);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Make the animation folder match the remapped meta: frames that go
+// are set aside, survivors renamed down, then meta.txt replaced. On a
+// failure the steps done are undone in reverse; once everything is in
+// place the set-aside frames are deleted
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_rewrite(
+    OptimizeContext* ctx,
+    const char* anim_dir,
+    const char* meta_path) {
+    FuriString* from = furi_string_alloc();
+    FuriString* to = furi_string_alloc();
+    uint32_t renamed = 0;
+    bool ok = true;
+
+    memset(ctx->set_aside, 0, sizeof(ctx->set_aside));
+    for(uint32_t i = 0; i < META_MAX_FRAMES && ok; i++) {
+        if(!(ctx->exists[i / 8] & (1 << (i % 8)))) continue;
+        if(theme_manager_optimize_is_kept(ctx, i)) continue;
+
+        theme_manager_optimize_frame_path(from, anim_dir, i, "bm");
+        theme_manager_optimize_frame_path(to, anim_dir, i, "old");
+        storage_common_remove(ctx->storage, furi_string_get_cstr(to));
+        ok = storage_common_rename(
+                 ctx->storage, furi_string_get_cstr(from), furi_string_get_cstr(to)) == FSE_OK;
+        if(ok) ctx->set_aside[i / 8] |= 1 << (i % 8);
+    }
+
+    /* New index never exceeds the old one, so ascending renames
+     * always target a name that is already free */
+    for(; renamed < ctx->canon_count && ok; renamed++) {
+        if(ctx->canon[renamed] == renamed) continue;
+        theme_manager_optimize_frame_path(from, anim_dir, ctx->canon[renamed], "bm");
+        theme_manager_optimize_frame_path(to, anim_dir, renamed, "bm");
+        ok = storage_common_rename(
+                 ctx->storage, furi_string_get_cstr(from), furi_string_get_cstr(to)) == FSE_OK;
+        if(!ok) break;
+    }
+
+    if(ok) ok = theme_manager_optimize_replace_meta(ctx, meta_path, from, to);
+
+    if(!ok) {
+        while(renamed-- > 0) {
+            if(ctx->canon[renamed] == renamed) continue;
+            theme_manager_optimize_frame_path(from, anim_dir, renamed, "bm");
+            theme_manager_optimize_frame_path(to, anim_dir, ctx->canon[renamed], "bm");
+            if(storage_common_rename(
+                   ctx->storage, furi_string_get_cstr(from), furi_string_get_cstr(to)) !=
+               FSE_OK) {
+                FURI_LOG_E(TAG, "%s: can't restore frame %u", anim_dir, ctx->canon[renamed]);
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < META_MAX_FRAMES; i++) {
+        if(!(ctx->set_aside[i / 8] & (1 << (i % 8)))) continue;
+
+        theme_manager_optimize_frame_path(from, anim_dir, i, "old");
+        if(ok) {
+            FileInfo info = {0};
+            storage_common_stat(ctx->storage, furi_string_get_cstr(from), &info);
+            if(storage_common_remove(ctx->storage, furi_string_get_cstr(from)) == FSE_OK) {
+                ctx->stats->files_removed++;
+                ctx->stats->bytes_saved += info.size;
+            }
+        } else {
+            theme_manager_optimize_frame_path(to, anim_dir, i, "bm");
+            if(storage_common_rename(
+                   ctx->storage, furi_string_get_cstr(from), furi_string_get_cstr(to)) !=
+               FSE_OK) {
+                FURI_LOG_E(TAG, "%s: can't restore frame %lu", anim_dir, i);
+            }
+        }
+    }
+
+    furi_string_free(to);
+    furi_string_free(from);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Optimize one animation folder
+// -------------------------------------------------------------------
+static bool theme_manager_optimize_anim(const char* anim_dir, void* context) {
+    OptimizeContext* ctx = context;
+
+    if(ctx->stop_callback && ctx->stop_callback(ctx->context)) {
+        ctx->stopped = true;
+        return false;
+    }
+
+    const char* anim_name = strrchr(anim_dir, '/');
+    anim_name = anim_name ? anim_name + 1 : anim_dir;
+    if(ctx->progress_callback) {
+        ctx->progress_callback(ctx->done, ctx->total, anim_name, ctx->context);
+    }
+    ctx->done++;
+
+    FuriString* meta_path = furi_string_alloc_printf("%s/%s", anim_dir, META_FILENAME);
+    FuriString* path = furi_string_alloc();
+
+    do {
+        if(!theme_manager_parse_meta(ctx->storage, furi_string_get_cstr(meta_path), &ctx->meta)) {
+            FURI_LOG_W(TAG, "%s: bad meta, skipped", anim_dir);
+            break;
+        }
+
+        theme_manager_optimize_list_frames(ctx, anim_dir);
+        if(!theme_manager_optimize_dedup(ctx, anim_dir, path)) break;
+
+        /* Anything other than dense canonical frames 0..canon_count-1 goes */
+        bool changed = false;
+        for(uint32_t i = 0; i < META_MAX_FRAMES && !changed; i++) {
+            bool is_file = ctx->exists[i / 8] & (1 << (i % 8));
+            changed = (i < ctx->canon_count) ? ctx->canon[i] != i : is_file;
+        }
+        if(!changed) break;
+
+        if(!theme_manager_optimize_rewrite(ctx, anim_dir, furi_string_get_cstr(meta_path))) {
+            FURI_LOG_E(TAG, "%s: rewrite failed, left as it was", anim_dir);
+            break;
+        }
+
+        ctx->stats->anims_changed++;
+        FURI_LOG_I(TAG, "%s: %lu unique frames", anim_name, ctx->canon_count);
+    } while(false);
+
+    furi_string_free(path);
+    furi_string_free(meta_path);
+
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Optimize every animation of a pack directory (or a single animation)
+// Returns false if stopped early; stats cover the work done so far
+// -------------------------------------------------------------------
+bool theme_manager_optimize_pack(
+    Storage* storage,
+    const char* pack_dir,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context,
+    ThemeOptimizeStats* stats) {
+    OptimizeContext* ctx = malloc(sizeof(OptimizeContext));
+    memset(ctx, 0, sizeof(OptimizeContext));
+    memset(stats, 0, sizeof(ThemeOptimizeStats));
+
+    ctx->storage = storage;
+    ctx->progress_callback = progress_callback;
+    ctx->stop_callback = stop_callback;
+    ctx->context = context;
+    ctx->stats = stats;
+    ctx->total = theme_manager_foreach_anim(storage, pack_dir, NULL, NULL);
+    ctx->prefetch = theme_manager_prefetch_alloc(storage);
+
+    theme_manager_foreach_anim(storage, pack_dir, theme_manager_optimize_anim, ctx);
+    if(progress_callback) progress_callback(ctx->done, ctx->total, NULL, context);
+
+    bool complete = !ctx->stopped;
+    theme_manager_prefetch_free(ctx->prefetch);
+    free(ctx);
+
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu files, %llu bytes saved%s",
+        pack_dir,
+        stats->files_removed,
+        stats->bytes_saved,
+        complete ? "" : " (stopped)");
+    return complete;
+}
@@ -0,0 +1,699 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#define TAG "ThemeManagerPatch"
+
+/* Theme update patches (.tpatch). A patch turns one version of a theme's
+ * installable tree into the next: files added or replaced whole, files
+ * or folders removed, and changed files (frames, mostly) as small binary
+ * deltas against the old content. Updating a pack where a few frames
+ * changed then costs the size of those deltas, not of the pack.
+ *
+ *   header  "TPT1", version, 3 reserved, u32 base manifest hash
+ *   ops     u8 op, u8 path length, path, then
+ *           'A' add:    u32 size, data
+ *           'R' remove: nothing (file or folder)
+ *           'D' delta:  u32 old size, u32 old hash, u32 new size,
+ *                       u32 delta length, delta
+ *   delta   0x00 u16 offset u16 length: copy from the old file
+ *           0x01 u16 length, bytes:     insert
+ *
+ * All numbers little endian, hashes FNV-1a 32. A tree is patched only
+ * if its manifest.txt hashes to the base hash (0 = any) and every delta
+ * source matches, all checked before anything is written; files are
+ * replaced through a .new file, as FAT can't rename over one. */
+
+#define PATCH_MAGIC        "TPT1"
+#define PATCH_VERSION      1
+#define PATCH_HEADER_SIZE  12
+#define PATCH_PATH_MAX     128
+#define PATCH_DELTA_MAX    4096 /* larger files are sent whole */
+#define PATCH_CHUNK_SIZE   256
+#define PATCH_MIN_COPY     8
+#define PATCH_HASH_SIZE    512
+#define PATCH_CHAIN_MAX    32
+#define PATCH_OP_ADD       'A'
+#define PATCH_OP_REMOVE    'R'
+#define PATCH_OP_DELTA     'D'
+#define PATCH_DELTA_COPY   0x00
+#define PATCH_DELTA_INSERT 0x01
+
+static uint32_t theme_manager_patch_fnv(uint32_t hash, const uint8_t* data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void theme_manager_patch_put_u32(uint8_t* p, uint32_t value) {
+    for(uint8_t i = 0; i < 4; i++) {
+        p[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static uint32_t theme_manager_patch_get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// -------------------------------------------------------------------
+// Whole file into buf (at most max bytes); false if missing or larger
+// -------------------------------------------------------------------
+static bool theme_manager_patch_load(
+    Storage* storage,
+    const char* path,
+    uint8_t* buf,
+    size_t max,
+    uint32_t* out_size) {
+    File* file = storage_file_alloc(storage);
+    bool ok = false;
+
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        uint64_t size = storage_file_size(file);
+        if(size <= max) {
+            ok = storage_file_read(file, buf, size) == size;
+            *out_size = size;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    return ok;
+}
+
+/* FNV-1a of a file, streamed; 0 if it can't be read */
+static uint32_t
+    theme_manager_patch_hash_file(Storage* storage, const char* path, uint32_t* out_size) {
+    File* file = storage_file_alloc(storage);
+    uint8_t buf[PATCH_CHUNK_SIZE];
+    uint32_t hash = 0;
+    uint32_t size = 0;
+
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        hash = 2166136261UL;
+        size_t read;
+        while((read = storage_file_read(file, buf, sizeof(buf))) > 0) {
+            hash = theme_manager_patch_fnv(hash, buf, read);
+            size += read;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(out_size) *out_size = size;
+    return hash;
+}
+
+static uint32_t theme_manager_patch_manifest_hash(Storage* storage, const char* dir) {
+    FuriString* path = furi_string_alloc_printf("%s/%s", dir, MANIFEST_FILENAME);
+    uint32_t hash = theme_manager_patch_hash_file(storage, furi_string_get_cstr(path), NULL);
+    furi_string_free(path);
+    return hash;
+}
+
+// ===================================================================
+// Create
+// ===================================================================
+typedef struct {
+    Storage* storage;
+    const char* old_dir;
+    const char* new_dir;
+    File* out;
+    ThemePatchStats* stats;
+    bool ok;
+
+    uint8_t* old_buf;
+    uint8_t* new_buf;
+    uint8_t* delta;
+    int16_t head[PATCH_HASH_SIZE];
+    int16_t prev[PATCH_DELTA_MAX];
+    FuriString* old_path;
+    FuriString* new_path;
+} PatchWriter;
+
+static void theme_manager_patch_write(PatchWriter* writer, const void* data, size_t size) {
+    if(writer->ok && storage_file_write(writer->out, data, size) != size) {
+        FURI_LOG_E(TAG, "Patch write failed");
+        writer->ok = false;
+    }
+    writer->stats->bytes += size;
+}
+
+static void theme_manager_patch_write_op(PatchWriter* writer, char op, const char* rel_path) {
+    uint8_t head[2] = {op, strlen(rel_path)};
+    theme_manager_patch_write(writer, head, sizeof(head));
+    theme_manager_patch_write(writer, rel_path, head[1]);
+}
+
+static inline uint16_t theme_manager_patch_block_hash(const uint8_t* p) {
+    return ((p[0] << 6) ^ (p[1] << 4) ^ (p[2] << 2) ^ p[3]) & (PATCH_HASH_SIZE - 1);
+}
+
+// -------------------------------------------------------------------
+// Delta of new_buf against old_buf into writer->delta
+// Returns its length, 0 if it wouldn't be smaller than the new file
+// -------------------------------------------------------------------
+static size_t
+    theme_manager_patch_diff(PatchWriter* writer, uint32_t old_size, uint32_t new_size) {
+    const uint8_t* old_buf = writer->old_buf;
+    const uint8_t* new_buf = writer->new_buf;
+    uint8_t* delta = writer->delta;
+    size_t len = 0;
+
+    memset(writer->head, 0xFF, sizeof(writer->head));
+    for(uint32_t i = 0; i + 4 <= old_size; i++) {
+        uint16_t hash = theme_manager_patch_block_hash(&old_buf[i]);
+        writer->prev[i] = writer->head[hash];
+        writer->head[hash] = i;
+    }
+
+    uint32_t insert_start = 0;
+    uint32_t pos = 0;
+    while(pos < new_size) {
+        uint32_t best_len = 0;
+        uint32_t best_offset = 0;
+
+        if(pos + 4 <= new_size) {
+            int16_t candidate = writer->head[theme_manager_patch_block_hash(&new_buf[pos])];
+            for(uint32_t chain = 0; candidate >= 0 && chain < PATCH_CHAIN_MAX; chain++) {
+                uint32_t match = 0;
+                while(candidate + match < old_size && pos + match < new_size &&
+                      old_buf[candidate + match] == new_buf[pos + match])
+                    match++;
+                if(match > best_len) {
+                    best_len = match;
+                    best_offset = candidate;
+                }
+                candidate = writer->prev[candidate];
+            }
+        }
+
+        if(best_len < PATCH_MIN_COPY) {
+            pos++;
+            continue;
+        }
+
+        /* Every command is at most 5 + its literal bytes */
+        uint32_t literal = pos - insert_start;
+        if(len + 5 + literal + 5 >= new_size) return 0;
+        if(literal) {
+            delta[len++] = PATCH_DELTA_INSERT;
+            delta[len++] = literal & 0xFF;
+            delta[len++] = literal >> 8;
+            memcpy(&delta[len], &new_buf[insert_start], literal);
+            len += literal;
+        }
+        delta[len++] = PATCH_DELTA_COPY;
+        delta[len++] = best_offset & 0xFF;
+        delta[len++] = best_offset >> 8;
+        delta[len++] = best_len & 0xFF;
+        delta[len++] = best_len >> 8;
+
+        pos += best_len;
+        insert_start = pos;
+    }
+
+    uint32_t literal = new_size - insert_start;
+    if(literal) {
+        if(len + 3 + literal >= new_size) return 0;
+        delta[len++] = PATCH_DELTA_INSERT;
+        delta[len++] = literal & 0xFF;
+        delta[len++] = literal >> 8;
+        memcpy(&delta[len], &new_buf[insert_start], literal);
+        len += literal;
+    }
+
+    return len;
+}
+
+/* Whole file as an 'A' op, streamed */
+static void theme_manager_patch_add_whole(
+    PatchWriter* writer,
+    const char* fs_path,
+    const char* rel_path,
+    uint32_t size) {
+    uint8_t raw[4];
+    theme_manager_patch_write_op(writer, PATCH_OP_ADD, rel_path);
+    theme_manager_patch_put_u32(raw, size);
+    theme_manager_patch_write(writer, raw, sizeof(raw));
+
+    File* file = storage_file_alloc(writer->storage);
+    uint8_t buf[PATCH_CHUNK_SIZE];
+    uint32_t done = 0;
+    if(storage_file_open(file, fs_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        size_t read;
+        while(done < size && (read = storage_file_read(file, buf, sizeof(buf))) > 0) {
+            read = MIN(read, size - done);
+            theme_manager_patch_write(writer, buf, read);
+            done += read;
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    if(done != size) {
+        FURI_LOG_E(TAG, "Short read: %s", fs_path);
+        writer->ok = false;
+    }
+}
+
+/* One file of the new tree against the old one */
+static void theme_manager_patch_diff_file(PatchWriter* writer, const char* rel_path) {
+    const char* old_path = furi_string_get_cstr(writer->old_path);
+    const char* new_path = furi_string_get_cstr(writer->new_path);
+    uint32_t old_size = 0;
+    uint32_t new_size = 0;
+
+    FileInfo file_info;
+    if(storage_common_stat(writer->storage, old_path, &file_info) != FSE_OK) {
+        storage_common_stat(writer->storage, new_path, &file_info);
+        theme_manager_patch_add_whole(writer, new_path, rel_path, file_info.size);
+        writer->stats->added++;
+        return;
+    }
+
+    bool small =
+        theme_manager_patch_load(
+            writer->storage, old_path, writer->old_buf, PATCH_DELTA_MAX, &old_size) &&
+        theme_manager_patch_load(
+            writer->storage, new_path, writer->new_buf, PATCH_DELTA_MAX, &new_size);
+    if(!small) {
+        /* Too large to diff: compare by hash, send whole if changed */
+        uint32_t new_hash =
+            theme_manager_patch_hash_file(writer->storage, new_path, &new_size);
+        if(theme_manager_patch_hash_file(writer->storage, old_path, &old_size) != new_hash ||
+           old_size != new_size) {
+            theme_manager_patch_add_whole(writer, new_path, rel_path, new_size);
+            writer->stats->changed++;
+        }
+        return;
+    }
+
+    if(old_size == new_size && memcmp(writer->old_buf, writer->new_buf, new_size) == 0) return;
+
+    size_t delta_len = theme_manager_patch_diff(writer, old_size, new_size);
+    if(delta_len == 0) {
+        theme_manager_patch_add_whole(writer, new_path, rel_path, new_size);
+        writer->stats->changed++;
+        return;
+    }
+
+    uint8_t raw[16];
+    theme_manager_patch_write_op(writer, PATCH_OP_DELTA, rel_path);
+    theme_manager_patch_put_u32(raw, old_size);
+    theme_manager_patch_put_u32(
+        raw + 4, theme_manager_patch_fnv(2166136261UL, writer->old_buf, old_size));
+    theme_manager_patch_put_u32(raw + 8, new_size);
+    theme_manager_patch_put_u32(raw + 12, delta_len);
+    theme_manager_patch_write(writer, raw, sizeof(raw));
+    theme_manager_patch_write(writer, writer->delta, delta_len);
+    writer->stats->changed++;
+    writer->stats->deltas++;
+}
+
+// -------------------------------------------------------------------
+// Walk one tree (rel_path below its root). With adding set this is the
+// new tree and each file is diffed; otherwise the old tree, and whatever
+// the new one lacks is removed
+// -------------------------------------------------------------------
+static void theme_manager_patch_walk(PatchWriter* writer, const char* rel_path, bool adding) {
+    FuriString* dir_path = furi_string_alloc_printf(
+        "%s%s%s", adding ? writer->new_dir : writer->old_dir, rel_path[0] ? "/" : "", rel_path);
+    FuriString* child = furi_string_alloc();
+    File* dir = storage_file_alloc(writer->storage);
+    FileInfo file_info;
+    char name[MAX_NAME_LEN];
+
+    if(storage_dir_open(dir, furi_string_get_cstr(dir_path))) {
+        while(writer->ok && storage_dir_read(dir, &file_info, name, sizeof(name))) {
+            if(rel_path[0]) {
+                furi_string_printf(child, "%s/%s", rel_path, name);
+            } else {
+                furi_string_set_str(child, name);
+            }
+            const char* rel = furi_string_get_cstr(child);
+            if(strlen(rel) >= PATCH_PATH_MAX) {
+                FURI_LOG_E(TAG, "Path too long: %s", rel);
+                writer->ok = false;
+                break;
+            }
+
+            furi_string_printf(writer->old_path, "%s/%s", writer->old_dir, rel);
+            furi_string_printf(writer->new_path, "%s/%s", writer->new_dir, rel);
+
+            if(!adding) {
+                const char* new_path = furi_string_get_cstr(writer->new_path);
+                if(!storage_common_exists(writer->storage, new_path)) {
+                    theme_manager_patch_write_op(writer, PATCH_OP_REMOVE, rel);
+                    writer->stats->removed++;
+                } else if(file_info.flags & FSF_DIRECTORY) {
+                    theme_manager_patch_walk(writer, rel, false);
+                }
+            } else if(file_info.flags & FSF_DIRECTORY) {
+                theme_manager_patch_walk(writer, rel, true);
+            } else {
+                theme_manager_patch_diff_file(writer, rel);
+            }
+        }
+        storage_dir_close(dir);
+    } else {
+        writer->ok = false;
+    }
+
+    storage_file_free(dir);
+    furi_string_free(child);
+    furi_string_free(dir_path);
+}
+
+// -------------------------------------------------------------------
+// Patch from installable tree old_dir to new_dir, written to patch_path
+// -------------------------------------------------------------------
+bool theme_manager_patch_create(
+    Storage* storage,
+    const char* old_dir,
+    const char* new_dir,
+    const char* patch_path,
+    ThemePatchStats* stats) {
+    memset(stats, 0, sizeof(ThemePatchStats));
+
+    PatchWriter* writer = malloc(sizeof(PatchWriter));
+    memset(writer, 0, sizeof(PatchWriter));
+    writer->storage = storage;
+    writer->old_dir = old_dir;
+    writer->new_dir = new_dir;
+    writer->stats = stats;
+    writer->out = storage_file_alloc(storage);
+    writer->old_buf = malloc(PATCH_DELTA_MAX);
+    writer->new_buf = malloc(PATCH_DELTA_MAX);
+    writer->delta = malloc(PATCH_DELTA_MAX);
+    writer->old_path = furi_string_alloc();
+    writer->new_path = furi_string_alloc();
+
+    if(storage_file_open(writer->out, patch_path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        writer->ok = true;
+
+        uint8_t header[PATCH_HEADER_SIZE] = {0};
+        memcpy(header, PATCH_MAGIC, 4);
+        header[4] = PATCH_VERSION;
+        theme_manager_patch_put_u32(
+            header + 8, theme_manager_patch_manifest_hash(storage, old_dir));
+        theme_manager_patch_write(writer, header, sizeof(header));
+
+        /* Removals first, so a replaced folder is gone before it is added */
+        theme_manager_patch_walk(writer, "", false);
+        theme_manager_patch_walk(writer, "", true);
+        storage_file_close(writer->out);
+    }
+
+    bool ok = writer->ok;
+    if(!ok) storage_common_remove(storage, patch_path);
+
+    FURI_LOG_I(
+        TAG,
+        "Patch %s -> %s: %lu added, %lu changed (%lu deltas), %lu removed, %lu bytes",
+        old_dir,
+        new_dir,
+        stats->added,
+        stats->changed,
+        stats->deltas,
+        stats->removed,
+        stats->bytes);
+
+    furi_string_free(writer->new_path);
+    furi_string_free(writer->old_path);
+    free(writer->delta);
+    free(writer->new_buf);
+    free(writer->old_buf);
+    storage_file_free(writer->out);
+    free(writer);
+    return ok;
+}
+
+// ===================================================================
+// Apply
+// ===================================================================
+typedef struct {
+    char op;
+    char path[PATCH_PATH_MAX];
+    uint32_t size; /* A: data size; D: old size */
+    uint32_t old_hash;
+    uint32_t new_size;
+    uint32_t delta_len;
+} PatchOp;
+
+/* Next op header; the payload (if any) follows in the file */
+static bool theme_manager_patch_read_op(File* patch, PatchOp* op, bool* out_error) {
+    uint8_t head[2];
+    size_t read = storage_file_read(patch, head, sizeof(head));
+    *out_error = false;
+    if(read == 0) return false;
+
+    *out_error = true;
+    if(read != sizeof(head) || head[1] == 0 || head[1] >= PATCH_PATH_MAX) return false;
+    if(storage_file_read(patch, op->path, head[1]) != head[1]) return false;
+    op->op = head[0];
+    op->path[head[1]] = '\0';
+    if(op->path[0] == '/' || strstr(op->path, "..") != NULL) return false;
+
+    uint8_t raw[16];
+    switch(op->op) {
+    case PATCH_OP_ADD:
+        if(storage_file_read(patch, raw, 4) != 4) return false;
+        op->size = theme_manager_patch_get_u32(raw);
+        break;
+    case PATCH_OP_DELTA:
+        if(storage_file_read(patch, raw, 16) != 16) return false;
+        op->size = theme_manager_patch_get_u32(raw);
+        op->old_hash = theme_manager_patch_get_u32(raw + 4);
+        op->new_size = theme_manager_patch_get_u32(raw + 8);
+        op->delta_len = theme_manager_patch_get_u32(raw + 12);
+        if(op->size > PATCH_DELTA_MAX) return false;
+        break;
+    case PATCH_OP_REMOVE:
+        break;
+    default:
+        return false;
+    }
+
+    *out_error = false;
+    return true;
+}
+
+static bool theme_manager_patch_skip(File* patch, const PatchOp* op) {
+    uint32_t skip = op->op == PATCH_OP_ADD ? op->size :
+                    op->op == PATCH_OP_DELTA ? op->delta_len :
+                                               0;
+    return skip == 0 || storage_file_seek(patch, storage_file_tell(patch) + skip, true);
+}
+
+static bool theme_manager_patch_open(File* patch, const char* patch_path) {
+    uint8_t header[PATCH_HEADER_SIZE];
+    return storage_file_open(patch, patch_path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+           storage_file_read(patch, header, sizeof(header)) == sizeof(header) &&
+           memcmp(header, PATCH_MAGIC, 4) == 0 && header[4] == PATCH_VERSION;
+}
+
+// -------------------------------------------------------------------
+// Can the patch be applied to dir? Reads the manifest and the old
+// version of every delta target, nothing else
+// -------------------------------------------------------------------
+bool theme_manager_patch_check(Storage* storage, const char* patch_path, const char* dir) {
+    File* patch = storage_file_alloc(storage);
+    FuriString* path = furi_string_alloc();
+    PatchOp op;
+    bool error = false;
+    bool ok = false;
+
+    if(theme_manager_patch_open(patch, patch_path)) {
+        uint8_t raw[4];
+        storage_file_seek(patch, 8, true);
+        storage_file_read(patch, raw, sizeof(raw));
+        uint32_t base = theme_manager_patch_get_u32(raw);
+
+        ok = base == 0 || theme_manager_patch_manifest_hash(storage, dir) == base;
+        if(!ok) FURI_LOG_W(TAG, "%s: manifest is not the patch base", dir);
+
+        while(ok && theme_manager_patch_read_op(patch, &op, &error)) {
+            if(op.op == PATCH_OP_DELTA) {
+                uint32_t size = 0;
+                furi_string_printf(path, "%s/%s", dir, op.path);
+                uint32_t hash =
+                    theme_manager_patch_hash_file(storage, furi_string_get_cstr(path), &size);
+                if(hash != op.old_hash || size != op.size) {
+                    FURI_LOG_W(TAG, "%s: %s is not the patch base", dir, op.path);
+                    ok = false;
+                }
+            }
+            if(ok) ok = theme_manager_patch_skip(patch, &op);
+        }
+        if(error) ok = false;
+        storage_file_close(patch);
+    }
+
+    furi_string_free(path);
+    storage_file_free(patch);
+    return ok;
+}
+
+/* Replace path with path.new */
+static bool theme_manager_patch_commit(Storage* storage, const char* path, const char* tmp_path) {
+    if(storage_file_exists(storage, path) && storage_common_remove(storage, path) != FSE_OK) {
+        return false;
+    }
+    return storage_common_rename(storage, tmp_path, path) == FSE_OK;
+}
+
+static void theme_manager_patch_mkdirs(Storage* storage, const char* dir, const char* rel) {
+    FuriString* path = furi_string_alloc();
+    for(const char* slash = strchr(rel, '/'); slash; slash = strchr(slash + 1, '/')) {
+        furi_string_printf(path, "%s/%.*s", dir, (int)(slash - rel), rel);
+        storage_common_mkdir(storage, furi_string_get_cstr(path));
+    }
+    furi_string_free(path);
+}
+
+/* One 'A' or 'D' op into tmp_path */
+static bool theme_manager_patch_write_file(
+    Storage* storage,
+    File* patch,
+    const PatchOp* op,
+    const char* path,
+    const char* tmp_path,
+    uint8_t* old_buf) {
+    File* out = storage_file_alloc(storage);
+    uint8_t buf[PATCH_CHUNK_SIZE];
+    bool ok = storage_file_open(out, tmp_path, FSAM_WRITE, FSOM_CREATE_ALWAYS);
+
+    if(ok && op->op == PATCH_OP_ADD) {
+        uint32_t left = op->size;
+        while(ok && left > 0) {
+            size_t chunk = MIN(sizeof(buf), left);
+            ok = storage_file_read(patch, buf, chunk) == chunk &&
+                 storage_file_write(out, buf, chunk) == chunk;
+            left -= chunk;
+        }
+    } else if(ok) {
+        uint32_t old_size = 0;
+        ok = theme_manager_patch_load(storage, path, old_buf, PATCH_DELTA_MAX, &old_size) &&
+             old_size == op->size;
+
+        uint32_t left = op->delta_len;
+        uint32_t written = 0;
+        while(ok && left > 0) {
+            uint8_t cmd[5];
+            if(storage_file_read(patch, cmd, 3) != 3) {
+                ok = false;
+                break;
+            }
+            left -= 3;
+
+            if(cmd[0] == PATCH_DELTA_COPY) {
+                if(storage_file_read(patch, cmd + 3, 2) != 2) {
+                    ok = false;
+                    break;
+                }
+                left -= 2;
+                uint32_t offset = cmd[1] | (cmd[2] << 8);
+                uint32_t len = cmd[3] | (cmd[4] << 8);
+                ok = offset + len <= old_size &&
+                     storage_file_write(out, old_buf + offset, len) == len;
+                written += len;
+            } else if(cmd[0] == PATCH_DELTA_INSERT) {
+                uint32_t len = cmd[1] | (cmd[2] << 8);
+                ok = len <= left;
+                left -= MIN(len, left);
+                written += len;
+                while(ok && len > 0) {
+                    size_t chunk = MIN(sizeof(buf), len);
+                    ok = storage_file_read(patch, buf, chunk) == chunk &&
+                         storage_file_write(out, buf, chunk) == chunk;
+                    len -= chunk;
+                }
+            } else {
+                ok = false;
+            }
+        }
+        ok = ok && written == op->new_size;
+    }
+
+    if(storage_file_is_open(out)) storage_file_close(out);
+    storage_file_free(out);
+    if(!ok) storage_common_remove(storage, tmp_path);
+    return ok;
+}
+
+// -------------------------------------------------------------------
+// Apply the patch to installable tree dir. Call patch_check first:
+// a failure here leaves the files patched so far
+// -------------------------------------------------------------------
+bool theme_manager_patch_apply(
+    Storage* storage,
+    const char* patch_path,
+    const char* dir,
+    ThemePatchStats* stats) {
+    memset(stats, 0, sizeof(ThemePatchStats));
+
+    File* patch = storage_file_alloc(storage);
+    FuriString* path = furi_string_alloc();
+    FuriString* tmp_path = furi_string_alloc();
+    uint8_t* old_buf = malloc(PATCH_DELTA_MAX);
+    PatchOp op;
+    bool error = false;
+    bool ok = theme_manager_patch_open(patch, patch_path);
+
+    while(ok && theme_manager_patch_read_op(patch, &op, &error)) {
+        furi_string_printf(path, "%s/%s", dir, op.path);
+        furi_string_printf(tmp_path, "%s.new", furi_string_get_cstr(path));
+
+        if(op.op == PATCH_OP_REMOVE) {
+            if(storage_common_exists(storage, furi_string_get_cstr(path))) {
+                theme_manager_trash_move(storage, furi_string_get_cstr(path));
+            }
+            stats->removed++;
+            continue;
+        }
+
+        bool existed = storage_file_exists(storage, furi_string_get_cstr(path));
+        theme_manager_patch_mkdirs(storage, dir, op.path);
+        ok = theme_manager_patch_write_file(
+                 storage,
+                 patch,
+                 &op,
+                 furi_string_get_cstr(path),
+                 furi_string_get_cstr(tmp_path),
+                 old_buf) &&
+             theme_manager_patch_commit(
+                 storage, furi_string_get_cstr(path), furi_string_get_cstr(tmp_path));
+
+        if(!existed) {
+            stats->added++;
+        } else {
+            stats->changed++;
+        }
+        if(op.op == PATCH_OP_ADD) {
+            stats->bytes += op.size;
+        } else {
+            stats->deltas++;
+            stats->bytes += op.delta_len;
+        }
+        if(!ok) FURI_LOG_E(TAG, "Failed on %s", op.path);
+    }
+    if(error) ok = false;
+
+    if(storage_file_is_open(patch)) storage_file_close(patch);
+
+    FURI_LOG_I(
+        TAG,
+        "Patched %s: %lu added, %lu changed, %lu removed, %lu bytes read%s",
+        dir,
+        stats->added,
+        stats->changed,
+        stats->removed,
+        stats->bytes,
+        ok ? "" : " (failed)");
+
+    free(old_buf);
+    furi_string_free(tmp_path);
+    furi_string_free(path);
+    storage_file_free(patch);
+    return ok;
+}
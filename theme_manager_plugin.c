@@ -0,0 +1,64 @@
+#include "theme_manager_plugin.h"
+
+#include <flipper_application/flipper_application.h>
+#include <flipper_application/plugins/plugin_manager.h>
+#include <flipper_application/plugins/composite_resolver.h>
+#include <loader/firmware_api/firmware_api.h>
+
+#define TAG "ThemeManagerPlugin"
+
+/* Defined in theme_manager_api_table.cpp */
+extern const ElfApiInterface* const theme_manager_api_interface;
+
+/* fal_embedded plugins are unpacked next to the other assets */
+static const char* const plugin_paths[ThemeManagerPluginCount] = {
+    [ThemeManagerPluginArchive] = APP_ASSETS_PATH("plugins/theme_manager_archive.fal"),
+    [ThemeManagerPluginTools] = APP_ASSETS_PATH("plugins/theme_manager_tools.fal"),
+    [ThemeManagerPluginVerify] = APP_ASSETS_PATH("plugins/theme_manager_verify.fal"),
+    [ThemeManagerPluginPatch] = APP_ASSETS_PATH("plugins/theme_manager_patch.fal"),
+};
+
+struct ThemeManagerPlugin {
+    CompositeApiResolver* resolver;
+    PluginManager* manager;
+    const void* entry_point;
+};
+
+// -------------------------------------------------------------------
+// Load one plugin: firmware symbols plus the app's own API table
+// -------------------------------------------------------------------
+ThemeManagerPlugin* theme_manager_plugin_load(ThemeManagerPluginId id) {
+    furi_check(id < ThemeManagerPluginCount);
+
+    ThemeManagerPlugin* plugin = malloc(sizeof(ThemeManagerPlugin));
+    plugin->resolver = composite_api_resolver_alloc();
+    composite_api_resolver_add(plugin->resolver, firmware_api_interface);
+    composite_api_resolver_add(plugin->resolver, theme_manager_api_interface);
+
+    plugin->manager = plugin_manager_alloc(
+        THEME_MANAGER_PLUGIN_APP_ID,
+        THEME_MANAGER_PLUGIN_API_VERSION,
+        composite_api_resolver_get(plugin->resolver));
+
+    uint32_t start = furi_get_tick();
+    PluginManagerError error = plugin_manager_load_single(plugin->manager, plugin_paths[id]);
+    if(error != PluginManagerErrorNone) {
+        FURI_LOG_E(TAG, "Can't load %s: %d", plugin_paths[id], error);
+        theme_manager_plugin_free(plugin);
+        return NULL;
+    }
+
+    plugin->entry_point = plugin_manager_get_ep(plugin->manager, 0);
+    FURI_LOG_I(TAG, "Loaded %s in %lu ms", plugin_paths[id], furi_get_tick() - start);
+    return plugin;
+}
+
+const void* theme_manager_plugin_get(ThemeManagerPlugin* plugin) {
+    return plugin->entry_point;
+}
+
+void theme_manager_plugin_free(ThemeManagerPlugin* plugin) {
+    plugin_manager_free(plugin->manager);
+    composite_api_resolver_free(plugin->resolver);
+    free(plugin);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "theme_manager_core.h"
+
+/* Plugins: the heavy, rarely used subsystems (bundles, optimize and
+ * compress, verify, update patches) are built as FAP plugins embedded in
+ * the .fap (see application.fam) instead of being linked into the app.
+ * A job loads the one it needs, runs, and frees it, so browsing and
+ * applying only ever keep the core resident. Plugins call back into the
+ * app through the symbols listed in theme_manager_api_table_i.h. */
+
+#define THEME_MANAGER_PLUGIN_APP_ID      "theme_manager_plugin"
+#define THEME_MANAGER_PLUGIN_API_VERSION 1
+
+typedef enum {
+    ThemeManagerPluginArchive,
+    ThemeManagerPluginTools,
+    ThemeManagerPluginVerify,
+    ThemeManagerPluginPatch,
+    ThemeManagerPluginCount,
+} ThemeManagerPluginId;
+
+/* Entry point of each plugin, by id */
+typedef struct {
+    bool (*import)(
+        Storage* storage,
+        const char* root,
+        const char* name,
+        char* out_name,
+        size_t out_name_size,
+        ThemeManagerProgressCallback progress_callback,
+        ThemeManagerStopCallback stop_callback,
+        void* context);
+    bool (*export)(
+        Storage* storage,
+        const char* root,
+        const char* name,
+        ThemeType type,
+        bool compress,
+        char* out_name,
+        size_t out_name_size,
+        ThemeExportStats* stats,
+        ThemeManagerProgressCallback progress_callback,
+        ThemeManagerStopCallback stop_callback,
+        void* context);
+} ThemeArchivePlugin;
+
+typedef struct {
+    bool (*optimize_pack)(
+        Storage* storage,
+        const char* pack_dir,
+        ThemeManagerProgressCallback progress_callback,
+        ThemeManagerStopCallback stop_callback,
+        void* context,
+        ThemeOptimizeStats* stats);
+    bool (*compress_tune)(Storage* storage, const char* pack_dir, ThemeCompressParams* params);
+    bool (*compress_pack)(
+        Storage* storage,
+        const char* pack_dir,
+        const ThemeCompressParams* params,
+        ThemeCompressStats* stats,
+        ThemeManagerProgressCallback progress_callback,
+        ThemeManagerStopCallback stop_callback,
+        void* context);
+} ThemeToolsPlugin;
+
+typedef struct {
+    bool (*verify_theme)(
+        Storage* storage,
+        const char* root,
+        const char* name,
+        ThemeType type,
+        ThemeVerifyStats* stats,
+        FuriString* report,
+        ThemeManagerProgressCallback progress_callback,
+        ThemeManagerStopCallback stop_callback,
+        void* context);
+} ThemeVerifyPlugin;
+
+typedef struct {
+    bool (*create)(
+        Storage* storage,
+        const char* old_dir,
+        const char* new_dir,
+        const char* patch_path,
+        ThemePatchStats* stats);
+    bool (*check)(Storage* storage, const char* patch_path, const char* dir);
+    bool (*apply)(
+        Storage* storage,
+        const char* patch_path,
+        const char* dir,
+        ThemePatchStats* stats);
+} ThemePatchPlugin;
+
+typedef struct ThemeManagerPlugin ThemeManagerPlugin;
+
+/* NULL if the plugin file is missing or doesn't match this build */
+ThemeManagerPlugin* theme_manager_plugin_load(ThemeManagerPluginId id);
+/* The plugin's entry point struct, of the type matching its id */
+const void* theme_manager_plugin_get(ThemeManagerPlugin* plugin);
+void theme_manager_plugin_free(ThemeManagerPlugin* plugin);
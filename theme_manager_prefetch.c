@@ -0,0 +1,191 @@
+#include "theme_manager_core.h"
+
+#define TAG "ThemeManagerPrefetch"
+
+/* Frame prefetcher for the bulk passes (verify, optimize). Reading a
+ * frame is mostly waiting on the SD card and checking it is mostly CPU,
+ * so a reader thread keeps a few frames ahead of the caller: the pair
+ * takes about as long as the slower of the two instead of their sum.
+ *
+ * Slots go round two queues. The reader takes a free slot, fills it and
+ * puts it on the filled queue; the caller takes it from there and hands
+ * it back once done. With every slot filled or held by the caller the
+ * reader blocks on the free queue, so read-ahead never outgrows the
+ * pool, which is sized from PREFETCH_RAM_BUDGET and the free heap. */
+
+#define PREFETCH_RAM_BUDGET        (8 * 1024)
+#define PREFETCH_SLOTS_MIN         2 /* one being read, one being checked */
+#define PREFETCH_THREAD_STACK_SIZE (2 * 1024)
+
+typedef enum {
+    PrefetchRequestRun,
+    PrefetchRequestExit,
+} PrefetchRequest;
+
+struct ThemePrefetch {
+    Storage* storage;
+    FuriThread* thread;
+    FuriMessageQueue* requests; /* PrefetchRequest */
+    FuriMessageQueue* free_slots; /* ThemePrefetchSlot* */
+    FuriMessageQueue* filled; /* ThemePrefetchSlot*, NULL ends a run */
+    ThemePrefetchSlot* slots;
+    uint32_t slot_count;
+
+    /* The run, set by start while the reader is idle */
+    FuriString* anim_dir;
+    uint8_t indices[META_MAX_FRAMES];
+    uint32_t count;
+    bool cancelled;
+
+    bool running; /* caller side: the run's NULL not taken yet */
+};
+
+// -------------------------------------------------------------------
+// Reader thread
+// -------------------------------------------------------------------
+static void
+    theme_manager_prefetch_read(Storage* storage, const char* path, ThemePrefetchSlot* slot) {
+    File* file = storage_file_alloc(storage);
+    slot->size = 0;
+
+    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        slot->status = ThemePrefetchMissing;
+    } else {
+        uint64_t size = storage_file_size(file);
+        if(size == 0 || size > PREVIEW_MAX_BM_SIZE) {
+            slot->status = ThemePrefetchBadSize;
+        } else if(storage_file_read(file, slot->data, size) != size) {
+            slot->status = ThemePrefetchReadError;
+        } else {
+            slot->status = ThemePrefetchOk;
+            slot->size = size;
+        }
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+}
+
+static int32_t theme_manager_prefetch_worker(void* context) {
+    ThemePrefetch* prefetch = context;
+    FuriString* path = furi_string_alloc();
+    PrefetchRequest request;
+
+    while(furi_message_queue_get(prefetch->requests, &request, FuriWaitForever) ==
+              FuriStatusOk &&
+          request == PrefetchRequestRun) {
+        for(uint32_t i = 0; i < prefetch->count; i++) {
+            ThemePrefetchSlot* slot;
+            furi_message_queue_get(prefetch->free_slots, &slot, FuriWaitForever);
+            if(__atomic_load_n(&prefetch->cancelled, __ATOMIC_ACQUIRE)) {
+                furi_message_queue_put(prefetch->free_slots, &slot, FuriWaitForever);
+                break;
+            }
+
+            slot->index = prefetch->indices[i];
+            furi_string_printf(
+                path, "%s/frame_%u.bm", furi_string_get_cstr(prefetch->anim_dir), slot->index);
+            theme_manager_prefetch_read(prefetch->storage, furi_string_get_cstr(path), slot);
+            furi_message_queue_put(prefetch->filled, &slot, FuriWaitForever);
+        }
+
+        ThemePrefetchSlot* end = NULL;
+        furi_message_queue_put(prefetch->filled, &end, FuriWaitForever);
+    }
+
+    furi_string_free(path);
+    return 0;
+}
+
+// ===================================================================
+// API
+// ===================================================================
+ThemePrefetch* theme_manager_prefetch_alloc(Storage* storage) {
+    ThemePrefetch* prefetch = malloc(sizeof(ThemePrefetch));
+    memset(prefetch, 0, sizeof(ThemePrefetch));
+    prefetch->storage = storage;
+    prefetch->anim_dir = furi_string_alloc();
+
+    /* Leave at least half of the largest free block to everyone else */
+    size_t budget = MIN((size_t)PREFETCH_RAM_BUDGET, memmgr_heap_get_max_free_block() / 2);
+    prefetch->slot_count = MAX(budget / sizeof(ThemePrefetchSlot), (size_t)PREFETCH_SLOTS_MIN);
+    prefetch->slots = malloc(prefetch->slot_count * sizeof(ThemePrefetchSlot));
+
+    prefetch->requests = furi_message_queue_alloc(1, sizeof(PrefetchRequest));
+    prefetch->free_slots =
+        furi_message_queue_alloc(prefetch->slot_count, sizeof(ThemePrefetchSlot*));
+    prefetch->filled =
+        furi_message_queue_alloc(prefetch->slot_count + 1, sizeof(ThemePrefetchSlot*));
+    for(uint32_t i = 0; i < prefetch->slot_count; i++) {
+        ThemePrefetchSlot* slot = &prefetch->slots[i];
+        furi_message_queue_put(prefetch->free_slots, &slot, FuriWaitForever);
+    }
+
+    prefetch->thread = furi_thread_alloc_ex(
+        "ThemeManagerPrefetch",
+        PREFETCH_THREAD_STACK_SIZE,
+        theme_manager_prefetch_worker,
+        prefetch);
+    furi_thread_start(prefetch->thread);
+
+    FURI_LOG_D(TAG, "%lu slots", prefetch->slot_count);
+    return prefetch;
+}
+
+void theme_manager_prefetch_free(ThemePrefetch* prefetch) {
+    theme_manager_prefetch_cancel(prefetch);
+
+    PrefetchRequest request = PrefetchRequestExit;
+    furi_message_queue_put(prefetch->requests, &request, FuriWaitForever);
+    furi_thread_join(prefetch->thread);
+    furi_thread_free(prefetch->thread);
+
+    furi_message_queue_free(prefetch->filled);
+    furi_message_queue_free(prefetch->free_slots);
+    furi_message_queue_free(prefetch->requests);
+    free(prefetch->slots);
+    furi_string_free(prefetch->anim_dir);
+    free(prefetch);
+}
+
+void theme_manager_prefetch_start(
+    ThemePrefetch* prefetch,
+    const char* anim_dir,
+    const uint8_t* indices,
+    uint32_t count) {
+    furi_check(!prefetch->running);
+
+    furi_string_set_str(prefetch->anim_dir, anim_dir);
+    prefetch->count = MIN(count, (uint32_t)META_MAX_FRAMES);
+    memcpy(prefetch->indices, indices, prefetch->count);
+    __atomic_store_n(&prefetch->cancelled, false, __ATOMIC_RELEASE);
+    prefetch->running = true;
+
+    PrefetchRequest request = PrefetchRequestRun;
+    furi_message_queue_put(prefetch->requests, &request, FuriWaitForever);
+}
+
+ThemePrefetchSlot* theme_manager_prefetch_take(ThemePrefetch* prefetch) {
+    if(!prefetch->running) return NULL;
+
+    ThemePrefetchSlot* slot = NULL;
+    furi_message_queue_get(prefetch->filled, &slot, FuriWaitForever);
+    if(!slot) prefetch->running = false;
+    return slot;
+}
+
+void theme_manager_prefetch_release(ThemePrefetch* prefetch, ThemePrefetchSlot* slot) {
+    furi_message_queue_put(prefetch->free_slots, &slot, FuriWaitForever);
+}
+
+// -------------------------------------------------------------------
+// Slots the caller still holds are released as usual, before or after
+// -------------------------------------------------------------------
+void theme_manager_prefetch_cancel(ThemePrefetch* prefetch) {
+    __atomic_store_n(&prefetch->cancelled, true, __ATOMIC_RELEASE);
+
+    ThemePrefetchSlot* slot;
+    while((slot = theme_manager_prefetch_take(prefetch))) {
+        theme_manager_prefetch_release(prefetch, slot);
+    }
+}
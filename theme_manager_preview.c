@@ -0,0 +1,320 @@
+#include "theme_manager_i.h"
+#include "theme_manager_bitmap.h"
+
+/* Preview decoder. Frames are decoded on a dedicated thread and handed to
+ * the info view's draw callback through a triple buffer: the decoder fills
+ * its back slot and publishes it with one atomic exchange, the draw callback
+ * picks up the newest published slot with another. Neither side blocks, and
+ * the three slots are recycled for the lifetime of the app. */
+
+#define PREVIEW_THREAD_STACK_SIZE (3 * 1024)
+
+#define PREVIEW_SLOT_COUNT 3
+#define PREVIEW_SLOT_MASK  0x03U
+#define PREVIEW_SLOT_FRESH 0x80U
+
+typedef enum {
+    PreviewFlagLoad = (1 << 0),
+    PreviewFlagStop = (1 << 1),
+    PreviewFlagExit = (1 << 2),
+} PreviewFlag;
+
+#define PREVIEW_FLAGS_ALL (PreviewFlagLoad | PreviewFlagStop | PreviewFlagExit)
+
+struct ThemeManagerPreview {
+    Storage* storage;
+    View* view;
+    FuriThread* thread;
+
+    /* Request from the GUI side, guarded by mutex */
+    FuriMutex* mutex;
+    char name[MAX_NAME_LEN];
+    ThemeType type;
+
+    /* Triple buffer: front is owned by the draw callback, back by the
+     * decoder; ready is the slot in between (index | PREVIEW_SLOT_FRESH) */
+    PreviewFrame slots[PREVIEW_SLOT_COUNT];
+    uint32_t front;
+    uint32_t back;
+    uint32_t ready;
+
+    /* Full-size frame before it is scaled into the back slot, and the
+     * file and decoder it comes from, reused for every frame */
+    uint8_t decoded[FRAME_MAX_SIZE];
+    uint8_t raw[PREVIEW_MAX_BM_SIZE];
+    CompressIcon* compress;
+};
+
+// -------------------------------------------------------------------
+// Decoder side: fill and publish
+// -------------------------------------------------------------------
+static void theme_manager_preview_publish(ThemeManagerPreview* preview) {
+    uint32_t prev = __atomic_exchange_n(
+        &preview->ready, preview->back | PREVIEW_SLOT_FRESH, __ATOMIC_ACQ_REL);
+    preview->back = prev & PREVIEW_SLOT_MASK;
+
+    /* The info model is lock-free, so this only asks the GUI for a redraw
+     * and never waits on a draw in progress */
+    view_get_model(preview->view);
+    view_commit_model(preview->view, true);
+}
+
+static void theme_manager_preview_publish_empty(ThemeManagerPreview* preview) {
+    PreviewFrame* frame = &preview->slots[preview->back];
+    frame->w = 0;
+    frame->h = 0;
+    theme_manager_preview_publish(preview);
+}
+
+/* A newer request makes the current lookup moot; the flag stays set for
+ * the worker loop to pick up */
+static bool theme_manager_preview_should_stop(void* context) {
+    UNUSED(context);
+    return (furi_thread_flags_get() & PREVIEW_FLAGS_ALL) != 0;
+}
+
+static bool theme_manager_preview_publish_thumb(
+    ThemeManagerPreview* preview,
+    const char* name,
+    ThemeType type) {
+    PreviewFrame* frame = &preview->slots[preview->back];
+
+    /* A container carries its own thumbnail right after the header */
+    if(type == ThemeTypeContainer) {
+        FuriString* path = furi_string_alloc_printf("%s/%s", ANIMATION_PACKS_PATH, name);
+        ThemeContainerInfo info;
+        bool ok = theme_manager_container_read_info(
+                      preview->storage, furi_string_get_cstr(path), &info, frame->data) &&
+                  info.thumb_w > 0;
+        furi_string_free(path);
+
+        if(ok) {
+            frame->w = info.thumb_w;
+            frame->h = info.thumb_h;
+            theme_manager_preview_publish(preview);
+        } else {
+            theme_manager_preview_publish_empty(preview);
+        }
+        return true;
+    }
+
+    /* The stamp walks the theme: blank the previous one meanwhile */
+    theme_manager_preview_publish_empty(preview);
+    frame = &preview->slots[preview->back];
+
+    uint32_t stamp;
+    if(!theme_manager_theme_stamp(
+           preview->storage,
+           ANIMATION_PACKS_PATH,
+           name,
+           type,
+           theme_manager_preview_should_stop,
+           NULL,
+           &stamp)) {
+        return false;
+    }
+
+    if(theme_manager_thumb_load(
+           preview->storage,
+           name,
+           stamp,
+           frame->data,
+           sizeof(frame->data),
+           &frame->w,
+           &frame->h)) {
+        theme_manager_preview_publish(preview);
+    }
+    return true;
+}
+
+static bool theme_manager_preview_decode(
+    ThemeManagerPreview* preview,
+    const char* anim_dir,
+    const ThemeAnimMeta* meta,
+    uint32_t order_pos,
+    FuriString* frame_path) {
+    PreviewFrame* frame = &preview->slots[preview->back];
+
+    furi_string_printf(frame_path, "%s/frame_%u.bm", anim_dir, meta->frame_order[order_pos]);
+    if(!theme_manager_decode_frame_with(
+           preview->storage,
+           furi_string_get_cstr(frame_path),
+           meta->width,
+           meta->height,
+           preview->raw,
+           sizeof(preview->raw),
+           preview->compress,
+           preview->decoded,
+           sizeof(preview->decoded))) {
+        return false;
+    }
+
+    theme_manager_bitmap_downscale(
+        preview->decoded,
+        meta->width,
+        meta->height,
+        frame->data,
+        PREVIEW_DRAW_W,
+        PREVIEW_DRAW_H,
+        &frame->w,
+        &frame->h);
+    theme_manager_preview_publish(preview);
+    return true;
+}
+
+// -------------------------------------------------------------------
+// Decoder thread: load on request, then loop the passive frames
+// at the animation's frame rate until stopped
+// -------------------------------------------------------------------
+static int32_t theme_manager_preview_worker(void* context) {
+    ThemeManagerPreview* preview = context;
+
+    ThemeAnimMeta* meta = malloc(sizeof(ThemeAnimMeta));
+    FuriString* meta_path = furi_string_alloc();
+    FuriString* frame_path = furi_string_alloc();
+    char name[MAX_NAME_LEN];
+
+    bool animating = false;
+    uint32_t loop_frames = 0;
+    uint32_t order_pos = 0;
+    uint32_t period = 0;
+    uint32_t next_tick = 0;
+
+    while(true) {
+        uint32_t timeout = FuriWaitForever;
+        if(animating) {
+            int32_t left = (int32_t)(next_tick - furi_get_tick());
+            timeout = left > 0 ? (uint32_t)left : 0;
+        }
+
+        uint32_t flags = furi_thread_flags_wait(PREVIEW_FLAGS_ALL, FuriFlagWaitAny, timeout);
+
+        if(flags & FuriFlagError) {
+            /* Timeout: next animation frame */
+            if(!animating) continue;
+
+            order_pos = (order_pos + 1) % loop_frames;
+            next_tick += period;
+            if(!theme_manager_preview_decode(
+                   preview, furi_string_get_cstr(meta_path), meta, order_pos, frame_path)) {
+                animating = false;
+            }
+            continue;
+        }
+
+        if(flags & PreviewFlagExit) break;
+
+        if(flags & PreviewFlagStop) {
+            animating = false;
+        }
+
+        if(flags & PreviewFlagLoad) {
+            animating = false;
+
+            furi_mutex_acquire(preview->mutex, FuriWaitForever);
+            strncpy(name, preview->name, sizeof(name));
+            ThemeType type = preview->type;
+            furi_mutex_release(preview->mutex);
+
+            /* Replace the previous theme's frame right away: with the
+             * cached thumbnail if the idle thread has built one */
+            if(!theme_manager_preview_publish_thumb(preview, name, type)) continue;
+            if(type == ThemeTypeContainer) continue;
+
+            if(!theme_manager_get_preview_paths(
+                   preview->storage, ANIMATION_PACKS_PATH, name, type, meta_path, frame_path) ||
+               !theme_manager_parse_meta(
+                   preview->storage, furi_string_get_cstr(meta_path), meta)) {
+                FURI_LOG_W(TAG, "Preview: can't parse meta for %s", name);
+                continue;
+            }
+
+            /* meta_path becomes the animation directory */
+            size_t slash = furi_string_search_rchar(meta_path, '/', 0);
+            furi_string_left(meta_path, slash);
+
+            order_pos = 0;
+            if(!theme_manager_preview_decode(
+                   preview, furi_string_get_cstr(meta_path), meta, order_pos, frame_path)) {
+                FURI_LOG_W(TAG, "Preview: decode failed for %s", name);
+                continue;
+            }
+
+            FURI_LOG_I(TAG, "Preview loaded: %s (%ux%u)", name, meta->width, meta->height);
+
+            /* Idle loop = passive frames; fall back to everything */
+            loop_frames = meta->passive_frames ? meta->passive_frames : meta->frame_order_count;
+            if(loop_frames > 1 && meta->frame_rate > 0) {
+                period = furi_ms_to_ticks(1000 / meta->frame_rate);
+                next_tick = furi_get_tick() + period;
+                animating = true;
+            }
+        }
+    }
+
+    furi_string_free(frame_path);
+    furi_string_free(meta_path);
+    free(meta);
+
+    return 0;
+}
+
+// -------------------------------------------------------------------
+// GUI side
+// -------------------------------------------------------------------
+ThemeManagerPreview* theme_manager_preview_alloc(Storage* storage, View* view) {
+    ThemeManagerPreview* preview = malloc(sizeof(ThemeManagerPreview));
+    memset(preview, 0, sizeof(ThemeManagerPreview));
+
+    preview->storage = storage;
+    preview->view = view;
+    preview->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    preview->compress = compress_icon_alloc(FRAME_MAX_SIZE);
+
+    preview->front = 0;
+    preview->ready = 1;
+    preview->back = 2;
+
+    preview->thread = furi_thread_alloc_ex(
+        "ThemeManagerPreview", PREVIEW_THREAD_STACK_SIZE, theme_manager_preview_worker, preview);
+    furi_thread_start(preview->thread);
+
+    return preview;
+}
+
+void theme_manager_preview_free(ThemeManagerPreview* preview) {
+    furi_thread_flags_set(furi_thread_get_id(preview->thread), PreviewFlagExit);
+    furi_thread_join(preview->thread);
+    furi_thread_free(preview->thread);
+
+    compress_icon_free(preview->compress);
+    furi_mutex_free(preview->mutex);
+    free(preview);
+}
+
+void theme_manager_preview_load(ThemeManagerPreview* preview, const char* name, ThemeType type) {
+    furi_mutex_acquire(preview->mutex, FuriWaitForever);
+    strncpy(preview->name, name, MAX_NAME_LEN - 1);
+    preview->name[MAX_NAME_LEN - 1] = '\0';
+    preview->type = type;
+    furi_mutex_release(preview->mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(preview->thread), PreviewFlagLoad);
+}
+
+void theme_manager_preview_stop(ThemeManagerPreview* preview) {
+    furi_thread_flags_set(furi_thread_get_id(preview->thread), PreviewFlagStop);
+}
+
+// -------------------------------------------------------------------
+// Draw side: latest complete frame, never blocks
+// Must only be called from the draw callback (single reader)
+// -------------------------------------------------------------------
+const PreviewFrame* theme_manager_preview_acquire(ThemeManagerPreview* preview) {
+    if(__atomic_load_n(&preview->ready, __ATOMIC_ACQUIRE) & PREVIEW_SLOT_FRESH) {
+        uint32_t prev = __atomic_exchange_n(&preview->ready, preview->front, __ATOMIC_ACQ_REL);
+        preview->front = prev & PREVIEW_SLOT_MASK;
+    }
+
+    return &preview->slots[preview->front];
+}
@@ -0,0 +1,247 @@
+#include "theme_manager_core.h"
+#include "theme_manager_cache.h"
+
+#include <toolbox/compress.h>
+
+#define TAG "ThemeManagerVerify"
+
+/* Pack validator. Streams the manifest entry by entry and, for every
+ * Name:, checks that the animation folder exists, that meta.txt parses
+ * and that every frame in Frames order exists and decodes to exactly the
+ * declared Width x Height. Frames are decoded one at a time into a fixed
+ * buffer with the SDK heatshrink decoder, which reports a bad stream or
+ * a wrong output size instead of asserting like the icon decoder does,
+ * while the prefetcher reads the next ones.
+ *
+ * Results of a complete run are cached per theme under VERIFY_CACHE_DIR,
+ * keyed by the theme stamp; jobs that rewrite a pack drop the entry. */
+
+#define VERIFY_ANIM_MAX_ERRORS  3 /* frame errors listed per animation */
+#define VERIFY_REPORT_MAX       2048
+
+typedef struct {
+    Storage* storage;
+    Compress* compress;
+    ThemePrefetch* prefetch;
+    ThemeVerifyStats* stats;
+    FuriString* report;
+    uint32_t total;
+    ThemeManagerProgressCallback progress_callback;
+    ThemeManagerStopCallback stop_callback;
+    void* context;
+    bool stopped;
+
+    ThemeAnimMeta meta;
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t checked[META_MAX_FRAMES / 8];
+    uint8_t unique[META_MAX_FRAMES]; /* frames to check, in order */
+    FuriString* path;
+    FuriString* anim_errors;
+    uint32_t anim_error_count;
+} VerifyContext;
+
+// -------------------------------------------------------------------
+// Report helpers
+// -------------------------------------------------------------------
+static void theme_manager_verify_frame_error(
+    VerifyContext* ctx,
+    uint32_t frame,
+    const char* problem) {
+    if(ctx->anim_error_count++ < VERIFY_ANIM_MAX_ERRORS) {
+        furi_string_cat_printf(ctx->anim_errors, " frame %lu: %s\n", frame, problem);
+    }
+}
+
+static void theme_manager_verify_anim_error(
+    VerifyContext* ctx,
+    const char* anim_name,
+    const char* problem) {
+    ctx->stats->anims_bad++;
+    ctx->stats->errors += problem ? 1 : ctx->anim_error_count;
+
+    if(furi_string_size(ctx->report) >= VERIFY_REPORT_MAX) {
+        ctx->stats->anims_unlisted++;
+        return;
+    }
+
+    furi_string_cat_printf(ctx->report, "%s:\n", anim_name);
+    if(problem) {
+        furi_string_cat_printf(ctx->report, " %s\n", problem);
+    } else {
+        furi_string_cat(ctx->report, ctx->anim_errors);
+        if(ctx->anim_error_count > VERIFY_ANIM_MAX_ERRORS) {
+            furi_string_cat_printf(
+                ctx->report,
+                " +%lu more frames\n",
+                ctx->anim_error_count - VERIFY_ANIM_MAX_ERRORS);
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// Check one frame file as read by the prefetcher, NULL if it is fine
+// -------------------------------------------------------------------
+static const char* theme_manager_verify_frame(VerifyContext* ctx, ThemePrefetchSlot* slot) {
+    switch(slot->status) {
+    case ThemePrefetchMissing:
+        return "missing";
+    case ThemePrefetchBadSize:
+        return "bad file size";
+    case ThemePrefetchReadError:
+        return "read error";
+    case ThemePrefetchOk:
+        break;
+    }
+    if(slot->size < 2) return "bad file size";
+
+    size_t expected = ((size_t)(ctx->meta.width + 7) / 8) * ctx->meta.height;
+    size_t decoded = 0;
+    const char* problem = NULL;
+
+    if(slot->data[0] == 0x00) {
+        /* Raw frame: the firmware only needs the bitmap to be all there */
+        if(slot->size - 1u < expected) problem = "truncated";
+    } else if(slot->data[0] != 0x01 || slot->size < 4) {
+        problem = "unknown encoding";
+    } else if(!compress_decode(
+                  ctx->compress,
+                  slot->data,
+                  slot->size,
+                  ctx->frame,
+                  sizeof(ctx->frame),
+                  &decoded)) {
+        problem = "doesn't decode";
+    } else if(decoded != expected) {
+        problem = "wrong size for meta";
+    }
+
+    return problem;
+}
+
+// -------------------------------------------------------------------
+// Check one animation of the manifest
+// -------------------------------------------------------------------
+static bool theme_manager_verify_anim(const char* anim_name, const char* anim_dir, void* context) {
+    VerifyContext* ctx = context;
+
+    if(ctx->progress_callback) {
+        ctx->progress_callback(ctx->stats->anims_checked, ctx->total, anim_name, ctx->context);
+    }
+    ctx->stats->anims_checked++;
+
+    if(!anim_dir) {
+        theme_manager_verify_anim_error(ctx, anim_name, "not in library refs");
+        return true;
+    }
+
+    do {
+        if(!storage_dir_exists(ctx->storage, anim_dir)) {
+            theme_manager_verify_anim_error(ctx, anim_name, "folder missing");
+            break;
+        }
+
+        furi_string_printf(ctx->path, "%s/%s", anim_dir, META_FILENAME);
+        if(!theme_manager_parse_meta(ctx->storage, furi_string_get_cstr(ctx->path), &ctx->meta)) {
+            theme_manager_verify_anim_error(ctx, anim_name, "meta.txt missing or invalid");
+            break;
+        }
+
+        /* Frames order repeats indices: check each file once */
+        memset(ctx->checked, 0, sizeof(ctx->checked));
+        furi_string_reset(ctx->anim_errors);
+        ctx->anim_error_count = 0;
+
+        uint32_t unique_count = 0;
+        for(uint32_t p = 0; p < ctx->meta.frame_order_count; p++) {
+            uint8_t index = ctx->meta.frame_order[p];
+            if(ctx->checked[index / 8] & (1 << (index % 8))) continue;
+            ctx->checked[index / 8] |= 1 << (index % 8);
+            ctx->unique[unique_count++] = index;
+        }
+
+        theme_manager_prefetch_start(ctx->prefetch, anim_dir, ctx->unique, unique_count);
+        ThemePrefetchSlot* slot;
+        while((slot = theme_manager_prefetch_take(ctx->prefetch))) {
+            if(ctx->stop_callback && ctx->stop_callback(ctx->context)) {
+                theme_manager_prefetch_release(ctx->prefetch, slot);
+                theme_manager_prefetch_cancel(ctx->prefetch);
+                ctx->stopped = true;
+                break;
+            }
+
+            const char* problem = theme_manager_verify_frame(ctx, slot);
+            if(problem) theme_manager_verify_frame_error(ctx, slot->index, problem);
+            ctx->stats->frames_checked++;
+            theme_manager_prefetch_release(ctx->prefetch, slot);
+        }
+
+        if(!ctx->stopped && ctx->anim_error_count > 0) {
+            theme_manager_verify_anim_error(ctx, anim_name, NULL);
+        }
+    } while(false);
+
+    return !ctx->stopped;
+}
+
+// -------------------------------------------------------------------
+// Verify a theme. Returns false if stopped early; the report lists
+// problems per animation, empty when everything checked out
+// -------------------------------------------------------------------
+bool theme_manager_verify_theme(
+    Storage* storage,
+    const char* root,
+    const char* name,
+    ThemeType type,
+    ThemeVerifyStats* stats,
+    FuriString* report,
+    ThemeManagerProgressCallback progress_callback,
+    ThemeManagerStopCallback stop_callback,
+    void* context) {
+    memset(stats, 0, sizeof(ThemeVerifyStats));
+    furi_string_reset(report);
+
+    VerifyContext* ctx = malloc(sizeof(VerifyContext));
+    memset(ctx, 0, sizeof(VerifyContext));
+    ctx->storage = storage;
+    ctx->compress = compress_alloc(CompressTypeHeatshrink, &compress_config_heatshrink_default);
+    ctx->prefetch = theme_manager_prefetch_alloc(storage);
+    ctx->stats = stats;
+    ctx->report = report;
+    ctx->progress_callback = progress_callback;
+    ctx->stop_callback = stop_callback;
+    ctx->context = context;
+    ctx->path = furi_string_alloc();
+    ctx->anim_errors = furi_string_alloc();
+
+    /* Two streaming passes: count for the progress bar, then check */
+    bool manifest_ok =
+        theme_manager_foreach_manifest_anim(storage, root, name, type, NULL, NULL, &ctx->total) &&
+        theme_manager_foreach_manifest_anim(
+            storage, root, name, type, theme_manager_verify_anim, ctx, NULL);
+    if(!manifest_ok) {
+        stats->errors++;
+        furi_string_printf(report, "%s:\n missing or invalid\n", MANIFEST_FILENAME);
+    }
+
+    if(stats->anims_unlisted > 0) {
+        furi_string_cat_printf(report, "...%lu more animations\n", stats->anims_unlisted);
+    }
+
+    bool complete = !ctx->stopped;
+
+    furi_string_free(ctx->anim_errors);
+    furi_string_free(ctx->path);
+    theme_manager_prefetch_free(ctx->prefetch);
+    compress_free(ctx->compress);
+    free(ctx);
+
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu anims, %lu bad, %lu frames%s",
+        name,
+        stats->anims_checked,
+        stats->anims_bad,
+        stats->frames_checked,
+        complete ? "" : " (stopped)");
+    return complete;
+}